@@ -61,6 +61,21 @@ typedef std::tuple<int, float, std::string, int, float, int, float, std::string,
     SetharesDissonanceTableRow;
 typedef std::vector<SetharesDissonanceTableRow> SetharesDissonanceTable;
 
+/**
+ * @brief Harmonic spectra of a batch of chords in contiguous (structure of arrays) buffers
+ * @details Partials are stored note by note, without merging coincident frequencies:
+ *          - The partials of note `n` are at [n * numPartials, (n + 1) * numPartials)
+ *          - The notes of chord `c` are [chordNoteOffsets[c], chordNoteOffsets[c + 1])
+ *
+ *          Reusing the same buffer across calls keeps its allocated capacity.
+ */
+struct HarmonicSpectrumBuffer {
+    int numPartials = 0;
+    std::vector<float> frequencies;
+    std::vector<float> amplitudes;
+    std::vector<size_t> chordNoteOffsets;
+};
+
 /**
  * @brief Represents a musical chord
  * @details The Chord class encapsulates a collection of musical notes, allowing for operations such as stacking
@@ -189,6 +204,23 @@ class Chord {
         return stdev;
     }
 
+    /**
+     * @brief Computes the Sethares dissonance of the default harmonic spectrum from cached note-pair
+     *        roughness tables.
+     * @param numPartialsPerNote Number of partials per note.
+     * @param useMinModel If true, uses the minimum amplitude model; otherwise, uses the product.
+     * @param partialsDecayExpRate Partials decay exponential rate.
+     * @param context Analysis context with the tuning system and A4 reference frequency.
+     * @param dissonance Output: total dissonance value.
+     * @return False if the chord must use the exact (partial pairs) path: rests, or notes sharing a
+     *         partial frequency under the 'min' model.
+     */
+    bool computeSetharesDissonanceFromDyadsTable(const int numPartialsPerNote,
+                                                 const bool useMinModel,
+                                                 const float partialsDecayExpRate,
+                                                 const AnalysisContext& context,
+                                                 float* dissonance) const;
+
    public:
     /**
      * @brief Construct an empty Chord object.
@@ -1308,12 +1340,35 @@ class Chord {
      * @param numPartialsPerNote Number of partials to include for each note.
      * @param amplCallback Optional: function to modify amplitude vector.
      * @param partialsDecayExpRate Optional Partials decay exponential rate (default: 0.88).
+     * @param context Optional analysis context with the tuning system and A4 reference frequency
+     *                (default: equal temperament, A4 = 440 Hz).
      * @return Pair of vectors: frequencies and corresponding amplitudes.
      */
     std::pair<std::vector<float>, std::vector<float>> getHarmonicSpectrum(
         const int numPartialsPerNote = 6,
         const std::function<std::vector<float>(std::vector<float>)> amplCallback = nullptr,
-        const float partialsDecayExpRate = 0.88f) const;
+        const float partialsDecayExpRate = 0.88f,
+        const AnalysisContext& context = AnalysisContext()) const;
+
+    /**
+     * @brief Writes the harmonic spectrum of every note of a batch of chords into flat buffers.
+     * @details The decay weights are computed once for the whole batch and no per-note vectors
+     *          are allocated. Unlike getHarmonicSpectrum(), coincident partials are not merged.
+     * @param chords Chords to process.
+     * @param buffer Output buffer. Its previous content is replaced.
+     * @param numPartialsPerNote Number of partials to include for each note.
+     * @param partialsDecayExpRate Optional Partials decay exponential rate (default: 0.88).
+     * @param batchAmplCallback Optional: function called once with all the batch frequencies,
+     *                          returning their amplitudes (same size).
+     * @param context Optional analysis context with the tuning system and A4 reference frequency
+     *                (default: equal temperament, A4 = 440 Hz).
+     */
+    static void getHarmonicSpectrumBatch(
+        const std::vector<Chord>& chords, HarmonicSpectrumBuffer* buffer,
+        const int numPartialsPerNote = 6, const float partialsDecayExpRate = 0.88f,
+        const std::function<std::vector<float>(const std::vector<float>&)> batchAmplCallback =
+            nullptr,
+        const AnalysisContext& context = AnalysisContext());
 
     /**
      * @brief Calculates the Sethares dissonance value for all dyads in the chord.
@@ -1321,6 +1376,8 @@ class Chord {
      * @param useMinModel If true, uses the minimum amplitude model; otherwise, uses the product.
      * @param amplCallback Optional: function to modify amplitude vector.
      * @param partialsDecayExpRate Optional Partials decay exponential rate (default: 0.88).
+     * @param context Optional analysis context with the tuning system and A4 reference frequency
+     *                (default: equal temperament, A4 = 440 Hz).
      * @return Table with detailed dissonance information for each dyad.
      * @details Computes psychoacoustic sensory dissonance using the Sethares spectral dissonance model,
      *          which quantifies roughness perception arising from critical band interactions between
@@ -1367,23 +1424,36 @@ class Chord {
     SetharesDissonanceTable getSetharesDyadsDissonanceValue(
         const int numPartials = 6, const bool useMinModel = true,
         const std::function<std::vector<float>(std::vector<float>)> amplCallback = nullptr,
-        const float partialsDecayExpRate = 0.88f) const;
+        const float partialsDecayExpRate = 0.88f,
+        const AnalysisContext& context = AnalysisContext()) const;
 
     /**
      * @brief Calculates the total Sethares dissonance for the chord.
      * @details Aggregates the dissonance values for all dyads, optionally using a custom aggregation function.
+     *          Uses the values-only Helper::setharesDissonance() kernel instead of building the full
+     *          SetharesDissonanceTable, so no per-partial pitch names are computed.
+     *
+     *          With the default spectrum (no `amplCallback` and no `dissCallback`) the result depends
+     *          only on the MIDI numbers of the notes. In that case it is computed as a sum over note
+     *          pairs from a cached 128x128 roughness matrix, built once per
+     *          (numPartialsPerNote, useMinModel, partialsDecayExpRate, tuning system, A4) set.
+     *          Custom callbacks use the
+     *          exact partial-pairs path.
      * @param numPartialsPerNote Number of partials per note.
      * @param useMinModel If true, uses the minimum amplitude model; otherwise, uses the product.
      * @param amplCallback Optional: function to modify amplitude vector.
      * @param partialsDecayExpRate Optional Partials decay exponential rate (default: 0.88).
      * @param dissCallback Optional: function to aggregate dissonance values (e.g., mean, max).
+     * @param context Optional analysis context with the tuning system and A4 reference frequency
+     *                (default: equal temperament, A4 = 440 Hz).
      * @return Total dissonance as a float.
      */
     float getSetharesDissonance(
         const int numPartialsPerNote = 6, const bool useMinModel = true,
         const std::function<std::vector<float>(std::vector<float>)> amplCallback = nullptr,
         const float partialsDecayExpRate = 0.88f,
-        const std::function<float(std::vector<float>)> dissCallback = nullptr) const;
+        const std::function<float(std::vector<float>)> dissCallback = nullptr,
+        const AnalysisContext& context = AnalysisContext()) const;
 
     /**
      * @brief Array subscript operator for read-only access to notes in original (unsorted) order.
@@ -1,3 +1,8 @@
+#pragma once
+
+#include <array>
+#include <memory>
+
 /**
  * @file config.h
  * @brief Global configuration for maiacore tuning system selection.
@@ -112,3 +117,77 @@ TuningSystem getTuningSystem();
  * @endcode
  */
 void setTuningSystem(TuningSystem tuningSystem);
+
+/**
+ * @brief Explicit tuning configuration for frequency-dependent analyses.
+ * @details Bundles a tuning system, the A4 reference frequency and the precomputed frequency of
+ *          every MIDI note (0-127) under that tuning. Frequency tables are built once per
+ *          (tuning system, A4 reference) pair and shared by all contexts, so frequency lookups
+ *          are a table read instead of `powf` calls.
+ *
+ *          Unlike setTuningSystem(), a context is passed explicitly to the methods that use it
+ *          (Note::getFrequency(), Note::getHarmonicSpectrum(), Chord::getSetharesDissonance(), ...).
+ *          Contexts are immutable, so concurrent threads can analyze the same score in different
+ *          tunings.
+ *
+ *          Non-equal tunings are built on C (C, C#, D, ... B ratios repeated in every octave) and
+ *          scaled so that A4 sounds at `freqA4`:
+ *          - JUST_INTONATION: 5-limit ratios 1, 16/15, 9/8, 6/5, 5/4, 4/3, 45/32, 3/2, 8/5, 5/3,
+ *            16/9, 15/8
+ *          - PYTHAGOREAN_TUNING: pure fifths from Eb to G#
+ *          - MEANTONE_TEMPERAMENT: quarter-comma meantone fifths (5^(1/4)) from Eb to G#
+ *          - WELL_TEMPERAMENT: Werckmeister III
+ *
+ * @code
+ * const AnalysisContext baroque(TuningSystem::MEANTONE_TEMPERAMENT, 415.0f);
+ * Chord chord({"C4", "E4", "G4"});
+ * float dissonance = chord.getSetharesDissonance(6, true, nullptr, 0.88f, nullptr, baroque);
+ * @endcode
+ */
+class AnalysisContext {
+   public:
+    /**
+     * @brief Frequency of each MIDI note (0-127), in Hz.
+     */
+    typedef std::array<float, 128> FrequencyTable;
+
+    /**
+     * @brief Constructs an analysis context.
+     * @param tuningSystem Tuning system (default: EQUAL_TEMPERAMENT).
+     * @param freqA4 Reference frequency for A4 (default: 440.0 Hz). Must be positive and finite.
+     * @details The frequencies of the non-equal tunings are precomputed in a shared table. Equal
+     *          temperament uses Helper::midiNote2freq() (or a shared table when A4 = 440 Hz).
+     */
+    explicit AnalysisContext(const TuningSystem tuningSystem = TuningSystem::EQUAL_TEMPERAMENT,
+                             const float freqA4 = 440.0f);
+
+    /**
+     * @brief Returns the tuning system of this context.
+     * @return TuningSystem enumeration value.
+     */
+    TuningSystem getTuningSystem() const;
+
+    /**
+     * @brief Returns the A4 reference frequency of this context.
+     * @return Frequency in Hz.
+     */
+    float getFreqA4() const;
+
+    /**
+     * @brief Returns the frequency of a MIDI note in this context tuning.
+     * @param midiNote MIDI note number. Negative values (rests) return 0 Hz.
+     * @return Frequency in Hz.
+     */
+    float getFrequency(const int midiNote) const;
+
+    /**
+     * @brief Returns the frequency table of this context.
+     * @return Frequency of each MIDI note (0-127).
+     */
+    FrequencyTable getFrequencyTable() const;
+
+   private:
+    TuningSystem _tuningSystem;
+    float _freqA4;
+    std::shared_ptr<const FrequencyTable> _frequencyTable;  ///< Null for equal temperament, A4 != 440.
+};
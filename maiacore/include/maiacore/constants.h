@@ -72,6 +72,24 @@ enum class RhythmFigure {
     N1024TH,
 };
 
+/**
+ * @brief Similarity metric of the melody pattern search (Score::findMelodyPattern()).
+ */
+enum class MelodySimilarityMetric {
+    EUCLIDEAN,  ///< Note-by-note alignment: Euclidean distance of intervals and durations.
+    DTW,        ///< Banded Dynamic Time Warping of the pitch contour: ornamented statements.
+};
+
+/**
+ * @brief Kind of melody stream searched by the melody pattern engines (Score::setMelodyStreams()).
+ */
+enum class MelodyStreamType {
+    PART,      ///< Voice 1 of all staves of a part, without chord notes (default).
+    VOICE,     ///< A single (part, staff, voice) line. Chords contribute their highest note.
+    SKYLINE,   ///< Highest note attacked at each onset of a part (all staves and voices).
+    BASSLINE,  ///< Lowest note attacked at each onset of a part (all staves and voices).
+};
+
 const std::map<int, RhythmFigure> c_mapTimeSignatureLower_Duration = {
     {1, RhythmFigure::WHOLE},    {2, RhythmFigure::HALF},      {4, RhythmFigure::QUARTER},
     {8, RhythmFigure::EIGHTH},   {16, RhythmFigure::N16TH},    {32, RhythmFigure::N32ND},
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "maiacore/directory_scanner.h"
+#include "maiacore/score.h"
+
+class MappedFile;
+
+/**
+ * @file corpus_pack.h
+ * @brief Single-file archive of many scores, with a metadata index and random access.
+ */
+
+/**
+ * @brief Archive of many scores in a single file, memory mapped and read on demand.
+ * @details A pack stores the MusicXML document of each score (uncompressed and without
+ *          indentation, as parsed by maiacore) and an index of the metadata of every score: file
+ *          path and name, title, composer, part names and number of measures and notes. The
+ *          header points to the index, so opening a pack only reads the header and the index;
+ *          the metadata can be listed and filtered without parsing any score, and each score is
+ *          parsed from the mapped bytes only when it is loaded. Loading from a pack skips the
+ *          directory scan, the opening of each file and the decompression of *.mxl files.
+ *
+ *          Layout (native byte order, checked by a mark, 8-byte aligned): header, documents,
+ *          entry records, string offsets and string data. The documents are written while the
+ *          scores are parsed, so building a pack keeps only a batch of scores in memory.
+ */
+class CorpusPack {
+   public:
+    /**
+     * @brief Metadata of a score of the pack.
+     */
+    struct Entry {
+        std::string filePath;                 ///< Score::getFilePath() when the pack was built.
+        std::string fileName;                 ///< Score::getFileName().
+        std::string title;                    ///< Score::getTitle().
+        std::string composerName;             ///< Score::getComposerName().
+        std::vector<std::string> partsNames;  ///< Score::getPartsNames().
+        int numParts = 0;                     ///< Score::getNumParts().
+        int numMeasures = 0;                  ///< Score::getNumMeasures().
+        int numNotes = 0;                     ///< Score::getNumNotes().
+        uint64_t documentSize = 0;            ///< Size of the stored document, in bytes.
+    };
+
+    /**
+     * @brief Opens a pack. The file is memory mapped; only the index is read.
+     * @param filePath Path of the pack. Throws std::runtime_error if it is not a valid pack.
+     */
+    explicit CorpusPack(const std::string& filePath);
+
+    ~CorpusPack();
+
+    /**
+     * @brief Writes the scores to a pack file.
+     * @details The documents are produced in parallel. A score loaded from a file stores the
+     *          loaded document; a score built in memory stores Score::toXML().
+     * @param scores Scores to store, in pack order.
+     * @param filePath Path of the pack (replaced if it exists).
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     */
+    static void save(const std::vector<const Score*>& scores, const std::string& filePath,
+                     const int numThreads = 0);
+
+    /**
+     * @brief Builds a pack from the score files of a directory, parsing them in parallel.
+     * @param directoryPath Directory to scan.
+     * @param packPath Path of the pack (replaced if it exists).
+     * @param scanner Recursion and glob filters (default: the MusicXML files of the directory).
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @return Number of stored scores, in path order.
+     */
+    static int build(const std::string& directoryPath, const std::string& packPath,
+                     const DirectoryScanner& scanner = DirectoryScanner(),
+                     const int numThreads = 0);
+
+    /**
+     * @brief Returns the path of the pack file.
+     */
+    const std::string& getFilePath() const;
+
+    /**
+     * @brief Returns the number of scores.
+     */
+    int getNumScores() const;
+
+    /**
+     * @brief Returns the metadata of a score, without parsing it.
+     * @param scoreIdx Index of the score in the pack.
+     */
+    Entry getEntry(const int scoreIdx) const;
+
+    /**
+     * @brief Returns the metadata of all scores, in pack order.
+     */
+    std::vector<Entry> getEntries() const;
+
+    /**
+     * @brief Returns the indices of the scores whose metadata satisfy a predicate.
+     * @details E.g. the scores of a composer, or with at most 4 parts, without parsing them.
+     */
+    std::vector<int> selectScores(const std::function<bool(const Entry&)>& predicate) const;
+
+    /**
+     * @brief Returns the index of the first score with a file name (-1 if there is none).
+     */
+    int findScore(const std::string& fileName) const;
+
+    /**
+     * @brief Returns the stored MusicXML document of a score.
+     */
+    std::string getDocument(const int scoreIdx) const;
+
+    /**
+     * @brief Parses a score of the pack.
+     * @param scoreIdx Index of the score in the pack.
+     */
+    std::shared_ptr<Score> loadScore(const int scoreIdx) const;
+
+    /**
+     * @brief Parses several scores of the pack in parallel.
+     * @param scoreIndices Indices of the scores (empty: all the scores, in pack order).
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @return Scores, in the order of 'scoreIndices'.
+     */
+    std::vector<std::shared_ptr<Score>> loadScores(const std::vector<int>& scoreIndices = {},
+                                                   const int numThreads = 0) const;
+
+   private:
+    struct FileHeader;
+    struct EntryRecord;
+
+    std::string _filePath;
+    std::shared_ptr<MappedFile> _file;
+    const FileHeader* _header = nullptr;
+    const EntryRecord* _entries = nullptr;
+    const uint64_t* _stringOffsets = nullptr;
+    const char* _stringData = nullptr;
+
+    const EntryRecord& getRecord(const int scoreIdx) const;
+    std::string getString(const uint32_t stringId) const;
+
+    /**
+     * @brief Writes a pack, loading the scores in batches on the thread pool.
+     * @param numScores Number of scores.
+     * @param loadScore Called on the worker threads with a score index; returns the score.
+     */
+    static void write(const std::string& filePath, const size_t numScores,
+                      const std::function<std::shared_ptr<const Score>(size_t)>& loadScore,
+                      const int numThreads);
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @file directory_scanner.h
+ * @brief Recursive, glob filtered listing of the score files of a directory.
+ */
+
+/**
+ * @brief Lists the score files of a directory, optionally recursively, filtered by globs.
+ * @details Glob syntax: `*` matches any characters except `/`, `**` matches any characters
+ *          including `/`, `?` matches one character and `[abc]`, `[a-z]` or `[!abc]` match one
+ *          character of a set. A pattern without `/` is matched against the file name; a pattern
+ *          with `/` is matched against the path relative to the scanned directory, always with
+ *          `/` separators. Exclude patterns without `/` are also matched against the name of each
+ *          subdirectory, whose traversal is then skipped (e.g. `drafts` or `.*`).
+ *
+ *          A file is listed when it matches at least one include pattern and no exclude pattern.
+ *          The defaults list the MusicXML files (`*.xml`, `*.mxl` and `*.musicxml`) of the
+ *          directory itself, without subdirectories.
+ */
+class DirectoryScanner {
+   public:
+    /**
+     * @brief Manifest entry of a scanned file.
+     */
+    struct FileInfo {
+        std::string filePath;          ///< Path of the file (directory path + relative path).
+        uint64_t size = 0;             ///< Size in bytes.
+        int64_t modificationTime = 0;  ///< Last write time, in ticks of the file system clock.
+        uint64_t hash = 0;             ///< Content hash (see hashFile()), 0 if not computed.
+    };
+
+    /**
+     * @brief Creates a scanner with the default options (non-recursive MusicXML files).
+     */
+    DirectoryScanner();
+
+    /**
+     * @brief Creates a scanner.
+     * @param recursive If true, the subdirectories are also scanned.
+     * @param includeGlobs Patterns of the listed files.
+     * @param excludeGlobs Patterns of the skipped files and subdirectories.
+     */
+    DirectoryScanner(const bool recursive, const std::vector<std::string>& includeGlobs,
+                     const std::vector<std::string>& excludeGlobs = {});
+
+    /**
+     * @brief Returns true if the subdirectories are scanned.
+     */
+    bool isRecursive() const;
+
+    /**
+     * @brief Returns the include patterns.
+     */
+    const std::vector<std::string>& getIncludeGlobs() const;
+
+    /**
+     * @brief Returns the exclude patterns.
+     */
+    const std::vector<std::string>& getExcludeGlobs() const;
+
+    /**
+     * @brief Returns true if a file path, relative to the scanned directory, is listed.
+     */
+    bool isIncluded(const std::string& relativePath) const;
+
+    /**
+     * @brief Lists the files of a directory.
+     * @details Only the file system metadata is read: the hashes are 0 (see hashFile()). Throws
+     *          std::runtime_error if the directory does not exist.
+     * @param directoryPath Directory to scan.
+     * @return Listed files, sorted by path.
+     */
+    std::vector<FileInfo> scan(const std::string& directoryPath) const;
+
+    /**
+     * @brief Hashes the content of a file (64-bit FNV-1a).
+     * @details Used to tell an edited file from a file whose write time changed without changes
+     *          (e.g. copied or touched). Never returns 0.
+     */
+    static uint64_t hashFile(const std::string& filePath);
+
+    /**
+     * @brief Returns true if a text matches a glob pattern (see the class description).
+     */
+    static bool matchGlob(const std::string& pattern, const std::string& text);
+
+   private:
+    bool _recursive;
+    std::vector<std::string> _includeGlobs;
+    std::vector<std::string> _excludeGlobs;
+
+    bool isExcludedDirectory(const std::string& directoryName) const;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/**
+ * @file harmonic_index.h
+ * @brief Harmonic sequence of a score and chord-progression queries over it.
+ */
+
+/**
+ * @brief Chord slice of the harmonic sequence of a score (see Score::getHarmonicIndex()).
+ */
+struct HarmonicSlice {
+    int measure = 0;              ///< Measure number of the slice (1 = first measure).
+    float floatMeasure = 0.0f;    ///< Slice onset, in measures (same numbering of Score::getChords()).
+    std::string keyName;          ///< Key of the measure (Measure::getKey()).
+    int rootPitchClass = -1;      ///< Pitch class of the chord root (0 = C), -1 if unknown.
+    std::string rootPitch;        ///< Chord root pitch, empty if unknown.
+    std::string quality;          ///< Chord::getQuality(), e.g. "major", "minor", "diminished".
+    int degree = 0;               ///< Scale degree of the root in the key (1-7), 0 if unknown.
+    std::string romanDegree;      ///< Chord::getRomanDegree(), e.g. "V".
+    bool isInRootPosition = false;  ///< True if the bass is the chord root.
+};
+
+/**
+ * @brief Compiled chord-progression query.
+ * @details A query is a sequence of space-separated tokens, one per chord: `HEAD[:QUALITY]`.
+ *
+ *          - `HEAD` is a Roman numeral (`I` to `VII`, case insensitive) matching the degree of
+ *            the root in the measure key; `*` matching any chord; `@` matching any root; or `@+N`
+ *            / `@-N`, a root N semitones above/below the root of the previous chord (modulo 12).
+ *            The `@` form does not depend on the key signature, so it is transposition invariant
+ *            even when the key signature does not follow a modulation.
+ *          - `QUALITY` is an optional Chord::getQuality() value (`major`, `minor`, `diminished`,
+ *            `half-diminished`, `augmented`, ...) or `*`.
+ *
+ *          Examples: `II:minor V:major I` (ii-V-I), `V VI` (deceptive cadence) and
+ *          `@:minor @+5:major @+5:major` (ii-V-I in any key). Chords are matched by their root, so
+ *          any inversion matches.
+ */
+class ChordProgressionQuery {
+   public:
+    /**
+     * @brief Occurrence of the progression: slices [start, start + length).
+     */
+    struct Match {
+        int start = 0;   ///< First slice.
+        int length = 0;  ///< Number of slices.
+    };
+
+    /**
+     * @brief Parses a progression query.
+     * @param progression Query text. Throws std::runtime_error if it is invalid.
+     */
+    explicit ChordProgressionQuery(const std::string& progression);
+
+    /**
+     * @brief Returns the query text.
+     */
+    const std::string& getProgression() const;
+
+    /**
+     * @brief Returns the number of chords of the progression.
+     */
+    int size() const;
+
+    /**
+     * @brief Returns every occurrence of the progression in a harmonic sequence.
+     * @param slices Harmonic sequence.
+     * @return Occurrences (overlapping included), in ascending order of start.
+     */
+    std::vector<Match> findAll(const std::vector<HarmonicSlice>& slices) const;
+
+   private:
+    /**
+     * @brief Condition on a single chord.
+     */
+    struct Token {
+        int degree = 0;              ///< Required degree (0: any).
+        bool isRelative = false;     ///< Root given relative to the previous chord.
+        int rootInterval = 0;        ///< Semitones from the previous root, modulo 12.
+        bool requireRoot = false;    ///< The chord must have a known root.
+        std::string quality;         ///< Required quality (empty: any).
+    };
+
+    std::string _progression;
+    std::vector<Token> _tokens;
+
+    bool tokenMatches(const Token& token, const HarmonicSlice& slice,
+                      const HarmonicSlice* previous) const;
+};
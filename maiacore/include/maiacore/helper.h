@@ -2,6 +2,7 @@
 #define HELPERS_H
 
 #include <math.h>
+#include <cstdint>
 #include <string>
 #include "maiacore/constants.h"
 #include "maiacore/note.h"
@@ -396,6 +397,30 @@ class Helper {
      */
     static float pitchRatio(const std::string& pitch_A, const std::string& pitch_B);
 
+    /**
+     * @brief Computes the Sethares sensory dissonance of a set of spectral partials.
+     * @param freqs Partial frequencies in Hz.
+     * @param ampls Partial amplitudes (same size as freqs).
+     * @param useMinModel If true, uses the minimum amplitude model; otherwise, uses the product.
+     * @param dyadsDissonance Optional output: receives the dissonance of each partial pair, in the
+     *        same row order as Chord::getSetharesDyadsDissonanceValue().
+     * @return Sum of the Plomp-Levelt roughness of every partial pair.
+     * @details Values-only kernel behind Chord::getSetharesDissonance(). It skips the
+     *          SetharesDissonanceTable and the pitch naming of each partial, and evaluates the
+     *          roughness curve 8 (AVX2) or 4 (SSE2) partial pairs at a time with a vectorized
+     *          exponential. The AVX2 path is selected at runtime when the CPU supports it; other
+     *          platforms use the scalar loop.
+     *
+     *          Partials are expected in ascending frequency order (as returned by
+     *          Chord::getHarmonicSpectrum()); unsorted input is sorted internally. Since the
+     *          curve decays exponentially with the frequency difference, pairs far enough apart
+     *          to underflow to zero are skipped when only the total is requested.
+     * @note SIMD results may differ from getSetharesDyadsDissonanceValue() in the last float digits.
+     */
+    static float setharesDissonance(const std::vector<float>& freqs,
+                                    const std::vector<float>& ampls, const bool useMinModel = true,
+                                    std::vector<float>* dyadsDissonance = nullptr);
+
     /**
      * @brief Converts a RhythmFigure to a string.
      * @param rhythmFigure RhythmFigure value.
@@ -525,5 +550,45 @@ class Helper {
      * @return Similarity value in [0,1].
      */
     static float calculateRhythmicEuclideanSimilarity(const std::vector<float>& durationDifferences);
+
+    /**
+     * @brief Packs consecutive semitone intervals (9 bits each) in a single n-gram key.
+     * @details Key of the interval n-gram posting lists of the melody search indices. Intervals
+     *          are taken modulo 512, so the key is exact for intervals in [-256, 255].
+     * @param intervals Pointer to the first interval.
+     * @param gramSize Number of intervals (at most 3).
+     * @return N-gram key.
+     */
+    static uint32_t intervalsGramKey(const int* intervals, const int gramSize);
+
+    /**
+     * @brief Same result of calculateMelodyEuclideanSimilarity() from integer semitone intervals.
+     * @param patternIntervals Intervals of the pattern.
+     * @param segmentIntervals Intervals of the segment.
+     * @param numIntervals Number of intervals.
+     * @return Similarity value in [0,1].
+     */
+    static float intervalsEuclideanSimilarity(const int* patternIntervals,
+                                              const int* segmentIntervals, const int numIntervals);
+
+    /**
+     * @brief Same result of getDurationDifferenceBetweenRhythms() followed by
+     *        calculateRhythmicEuclideanSimilarity(), from quarter durations.
+     * @details Stops as soon as the similarity falls below the threshold: the partial sum of
+     *          squares only grows.
+     * @param patternDurations Quarter durations of the pattern.
+     * @param patternMaxDuration Largest quarter duration of the pattern.
+     * @param segmentDurations Quarter durations of the segment.
+     * @param numNotes Number of notes.
+     * @param threshold Minimum rhythm similarity.
+     * @param durationDifferences Output: normalized duration differences (numNotes values).
+     * @param similarity Output: rhythm similarity, only set if it reaches the threshold.
+     * @return True if the similarity reaches the threshold.
+     */
+    static bool durationsEuclideanSimilarity(const float* patternDurations,
+                                             const float patternMaxDuration,
+                                             const float* segmentDurations, const int numNotes,
+                                             const float threshold, float* durationDifferences,
+                                             float* similarity);
 };
 #endif  // HELPERS_H
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @file mapped_file.h
+ * @brief Read-only memory mapping of a file, used by the on-disk indices of maiacore.
+ */
+
+/**
+ * @brief Maps a whole file in memory, read-only.
+ * @details The operating system loads the pages on demand, so opening a large file is immediate
+ *          and only the parts that are read use memory. The mapping is released by the destructor;
+ *          objects are not copyable (share them with a std::shared_ptr).
+ */
+class MappedFile {
+   public:
+    /**
+     * @brief Maps a file. Throws std::runtime_error if it cannot be opened or is empty.
+     * @param filePath Path of the file.
+     */
+    explicit MappedFile(const std::string& filePath);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Returns the first byte of the file.
+     */
+    const char* data() const;
+
+    /**
+     * @brief Returns the file size, in bytes.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the path of the mapped file.
+     */
+    const std::string& getFilePath() const;
+
+   private:
+    std::string _filePath;
+    const char* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    void* _fileHandle = nullptr;
+    void* _mappingHandle = nullptr;
+#endif
+};
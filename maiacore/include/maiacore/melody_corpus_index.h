@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "maiacore/score.h"
+
+/**
+ * @file melody_corpus_index.h
+ * @brief Persistent melody n-gram index of a corpus, searched without loading the scores.
+ */
+
+/**
+ * @brief Melody search index of many scores, saved to disk and memory mapped at query time.
+ * @details For each indexed score the index stores the melody streams of its melody search index
+ *          (see Score::setMelodyStreams()): semitone intervals, quarter durations, written and
+ *          sounding pitches, key, measure and staff of every note event, plus the posting lists of
+ *          the interval n-grams, whose entries are (stream, offset) pairs. Each stream records its
+ *          score and part, so a posting resolves to (score, part, measure, staff, offset).
+ *          findMelodyPattern() returns the same rows of Score::findMelodyPattern() with the default
+ *          similarities and the EUCLIDEAN metric, without the Score objects.
+ *
+ *          The index is a list of immutable segments: a file opened by the constructor is one
+ *          segment, mapped in memory (see MappedFile), and every addScore() or addScores() call
+ *          appends a small segment in memory. removeScore() only marks the entry as removed.
+ *          save() writes all the live entries in a single compacted file, so updating a saved
+ *          index only analyzes the added scores. Copies share the segments.
+ *
+ *          Entries are identified by a stable id, assigned in insertion order (the entries of an
+ *          opened file are 0 to n - 1) and kept after removals until the index is saved and
+ *          opened again.
+ */
+class MelodyCorpusIndex {
+   public:
+    static const int GRAM_SIZE = 3;  ///< Number of consecutive intervals of each n-gram.
+
+    /**
+     * @brief Metadata of an indexed score.
+     */
+    struct ScoreInfo {
+        std::string fileName;      ///< Score::getFileName().
+        std::string title;         ///< Score::getTitle().
+        std::string composerName;  ///< Score::getComposerName().
+        int numNotes = 0;          ///< Score::getNumNotes().
+        int numStreams = 0;        ///< Number of indexed melody streams.
+    };
+
+    /**
+     * @brief Result row of findMelodyPattern(): entry id and Score::MelodyPatternRow.
+     */
+    struct Row {
+        int entryId = 0;              ///< Entry of the score.
+        Score::MelodyPatternRow row;  ///< Same row of Score::findMelodyPattern().
+    };
+
+    /**
+     * @brief Creates an empty index.
+     */
+    MelodyCorpusIndex();
+
+    /**
+     * @brief Opens an index saved by save(). The file is memory mapped, not read.
+     * @param filePath Path of the index file. Throws std::runtime_error if it is not a valid index.
+     */
+    explicit MelodyCorpusIndex(const std::string& filePath);
+
+    /**
+     * @brief Indexes a score.
+     * @param score Score to index. Its melody search index is built if needed.
+     * @return Entry id of the score.
+     */
+    int addScore(const Score& score);
+
+    /**
+     * @brief Indexes several scores in a single segment, in parallel.
+     * @param scores Scores to index.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @return Entry id of each score.
+     */
+    std::vector<int> addScores(const std::vector<const Score*>& scores, const int numThreads = 0);
+
+    /**
+     * @brief Removes an entry. Its id is not reused.
+     * @param entryId Entry id. Throws std::runtime_error if it is not a live entry.
+     */
+    void removeScore(const int entryId);
+
+    /**
+     * @brief Returns true if the entry exists and was not removed.
+     */
+    bool hasEntry(const int entryId) const;
+
+    /**
+     * @brief Returns the number of live entries.
+     */
+    int getNumScores() const;
+
+    /**
+     * @brief Returns the ids of the live entries, in insertion order.
+     */
+    std::vector<int> getEntryIds() const;
+
+    /**
+     * @brief Returns the metadata of an entry.
+     */
+    ScoreInfo getScoreInfo(const int entryId) const;
+
+    /**
+     * @brief Returns the number of segments (1 for a freshly opened file).
+     */
+    int getNumSegments() const;
+
+    /**
+     * @brief Writes the live entries in a single compacted index file.
+     * @param filePath Path of the index file.
+     */
+    void save(const std::string& filePath) const;
+
+    /**
+     * @brief Searches a melodic pattern in all live entries.
+     * @details Same candidates and similarities of Score::findMelodyPattern() with the default
+     *          similarity functions and MelodySimilarityMetric::EUCLIDEAN: candidate windows come
+     *          from the interval n-gram posting lists when the interval threshold allows it, and
+     *          from a scan of the stored streams otherwise. The streams are verified in parallel.
+     * @param melodyPattern Melodic pattern (at least 2 notes).
+     * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
+     * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @param skippedEntryIds If not null, receives the entries with fewer notes than the pattern,
+     *                        which are skipped. If null, such an entry throws std::runtime_error,
+     *                        like Score::findMelodyPattern().
+     * @return Rows ordered by entry id, then in the order of Score::findMelodyPattern().
+     */
+    std::vector<Row> findMelodyPattern(const std::vector<Note>& melodyPattern,
+                                       const float totalIntervalsSimilarityThreshold = 0.5f,
+                                       const float totalRhythmSimilarityThreshold = 0.5f,
+                                       const int numThreads = 0,
+                                       std::vector<int>* skippedEntryIds = nullptr) const;
+
+   private:
+    class Segment;
+    struct ScoreData;
+
+    std::vector<std::shared_ptr<const Segment>> _segments;
+    std::vector<int> _firstEntryIds;  ///< Entry id of the first score of each segment.
+    std::vector<bool> _removed;       ///< Removal mark of each entry id.
+    int _numLiveEntries = 0;
+
+    void appendSegment(std::shared_ptr<const Segment> segment);
+    std::pair<int, int> locateEntry(const int entryId) const;
+
+    /**
+     * @brief Copies the melody streams of a score (see Score::getMelodySearchIndex()).
+     */
+    static void extractScoreData(const Score& score, ScoreData* data);
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @file melody_regex.h
+ * @brief Regular expressions over melodic event streams (intervals, durations and rests).
+ */
+
+/**
+ * @brief Compiled regular expression over a melody, where each symbol is a note event.
+ * @details Grammar (whitespace is ignored):
+ *
+ *          - `.` any event, `N` any note, `R` any rest.
+ *          - `[cond cond ...]` an event that satisfies all the conditions:
+ *            - `i=+3`, `i=-2..-1`, `i>0`, `i<=-3`: interval in semitones from the previous note of
+ *              the melody (rests are skipped). Intervals make the query transposition invariant.
+ *              An interval condition never matches a rest nor the first note of a melody.
+ *            - `up`, `down` and `same`: shortcuts of `i>0`, `i<0` and `i=0`.
+ *            - `d=1.5`, `d=0.5..1`, `d<1`: quarter duration of the event.
+ *            - `dotted`: event with at least one augmentation dot.
+ *            - `note` or `rest`: event type.
+ *          - `(...)` grouping and `|` alternation.
+ *          - `*`, `+`, `?`, `{n}`, `{n,}` and `{n,m}` quantifiers.
+ *
+ *          Example: `[i=+3] [same]* [i=-2..-1]` is a rising minor third, any number of repeated
+ *          notes and then a descending step.
+ *
+ *          The expression is compiled to a Thompson NFA. The search runs two lazily built DFAs:
+ *          a reverse DFA marks in one backward pass every event where a match starts, and a
+ *          forward DFA then extends each start to its longest match. Each event is mapped once to
+ *          the set of conditions it satisfies, so the DFA transitions are table lookups.
+ */
+class MelodyRegex {
+   public:
+    /**
+     * @brief Symbol of the melody stream.
+     */
+    struct Event {
+        bool isRest = false;          ///< True for rests.
+        bool hasInterval = false;     ///< False for rests and for the first note of the melody.
+        int interval = 0;             ///< Semitones from the previous note (if hasInterval).
+        float quarterDuration = 0.0f; ///< Duration in quarter notes.
+        int numDots = 0;              ///< Number of augmentation dots.
+    };
+
+    /**
+     * @brief Match of the expression: events [start, start + length).
+     */
+    struct Match {
+        int start = 0;   ///< First event of the match.
+        int length = 0;  ///< Number of events of the match.
+    };
+
+    /**
+     * @brief Parses and compiles an expression.
+     * @param pattern Expression text (see the class grammar).
+     * @details Throws std::runtime_error if the expression is invalid or matches an empty melody.
+     */
+    explicit MelodyRegex(const std::string& pattern);
+
+    /**
+     * @brief Returns the expression text.
+     */
+    const std::string& getPattern() const;
+
+    /**
+     * @brief Returns true if the expression matches the single-event melody {event}.
+     */
+    bool matchesEvent(const Event& event) const;
+
+    /**
+     * @brief Returns the leftmost-longest, non-overlapping matches of the expression.
+     * @details Thread safe: the DFA states are built per call.
+     * @param events Melody stream.
+     * @return Matches in ascending order of start.
+     */
+    std::vector<Match> findAll(const std::vector<Event>& events) const;
+
+   private:
+    /**
+     * @brief Conjunction of conditions on a single event.
+     */
+    struct Atom {
+        bool requireNote = false;
+        bool requireRest = false;
+        bool requireDotted = false;
+        bool hasIntervalRange = false;
+        int minInterval = 0;
+        int maxInterval = 0;
+        bool hasDurationRange = false;
+        float minDuration = 0.0f;
+        float maxDuration = 0.0f;
+
+        bool matches(const Event& event) const;
+    };
+
+    /**
+     * @brief Thompson NFA state: an atom transition or a set of epsilon transitions.
+     */
+    struct NfaState {
+        int atomIdx = -1;            ///< Atom consumed by this state (-1: epsilon state).
+        int next = -1;               ///< State reached after consuming the atom.
+        std::vector<int> epsilons;   ///< Epsilon transitions (epsilon states only).
+    };
+
+    /**
+     * @brief Thompson NFA of the expression or of its reverse.
+     */
+    struct Nfa {
+        std::vector<NfaState> states;
+        int start = -1;
+        int final = -1;
+    };
+
+    struct Node;
+    class Parser;
+    class LazyDfa;
+
+    std::string _pattern;
+    std::vector<Atom> _atoms;
+    Nfa _forward;  ///< Anchored NFA: extends a match from its start.
+    Nfa _reverse;  ///< NFA of the reversed expression: finds the match starts.
+
+    /**
+     * @brief Appends the Thompson fragment of an expression node to a NFA.
+     * @param reverse If true, the concatenations are reversed.
+     * @return (start, end) states of the fragment. The end state has no transitions yet.
+     */
+    static std::pair<int, int> compileNode(const Node& node, const bool reverse, Nfa* nfa);
+
+    /**
+     * @brief Compiles the expression tree to a NFA.
+     */
+    static Nfa compile(const Node& root, const bool reverse);
+
+    /**
+     * @brief Returns the set of atoms satisfied by an event, one bit per atom.
+     */
+    uint64_t atomMask(const Event& event) const;
+};
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 
+#include "maiacore/config.h"
 #include "maiacore/constants.h"
 #include "maiacore/duration.h"
 #include "maiacore/key.h"
@@ -548,6 +549,13 @@ class Note {
      */
     float getFrequency(const float freqA4 = 440.0f) const;
 
+    /**
+     * @brief Returns the frequency of the note in Hz, using the tuning of an analysis context.
+     * @param context Analysis context with the tuning system and A4 reference frequency.
+     * @return Frequency in Hz, read from the context precomputed frequency table.
+     */
+    float getFrequency(const AnalysisContext& context) const;
+
     /**
      * @brief Returns the harmonic spectrum of the note (partials and amplitudes).
      * @param numPartials Number of partials.
@@ -562,6 +570,19 @@ class Note {
         const float partialsDecayExpRate = 0.88f,
         const float freqA4 = 440.0f) const;
 
+    /**
+     * @brief Returns the harmonic spectrum of the note, using the tuning of an analysis context.
+     * @param numPartials Number of partials.
+     * @param amplCallback Optional amplitude callback.
+     * @param partialsDecayExpRate Partials decay exponential rate.
+     * @param context Analysis context with the tuning system and A4 reference frequency.
+     * @return Pair of vectors: frequencies and amplitudes.
+     */
+    std::pair<std::vector<float>, std::vector<float>> getHarmonicSpectrum(
+        const int numPartials,
+        const std::function<std::vector<float>(std::vector<float>)> amplCallback,
+        const float partialsDecayExpRate, const AnalysisContext& context) const;
+
     /**
      * @brief Transposes the note by a number of semitones and optional accidental type.
      * @param semitones Number of semitones.
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+
+/**
+ * @file reducers.h
+ * @brief Built-in accumulators of ScoreCollection::mapReduce() and ThreadPool::mapReduce().
+ */
+
+/**
+ * @brief Counts occurrences of keys (e.g. pitch classes, chord qualities, composers).
+ * @tparam Key Counted key type (needs operator<).
+ */
+template <typename Key>
+class CounterReducer {
+   public:
+    /**
+     * @brief Adds `count` occurrences of a key.
+     */
+    void add(const Key& key, const long long count = 1) {
+        _counts[key] += count;
+        _total += count;
+    }
+
+    /**
+     * @brief Adds the counts of another counter (used to merge the per-thread counters).
+     */
+    void merge(CounterReducer&& other) {
+        for (const auto& item : other._counts) {
+            _counts[item.first] += item.second;
+        }
+        _total += other._total;
+    }
+
+    /**
+     * @brief Returns the count of a key (0 if it was never added).
+     */
+    long long getCount(const Key& key) const {
+        const auto it = _counts.find(key);
+        return (it == _counts.end()) ? 0 : it->second;
+    }
+
+    /**
+     * @brief Returns the sum of all counts.
+     */
+    long long getTotal() const { return _total; }
+
+    /**
+     * @brief Returns the count of each key, sorted by key.
+     */
+    const std::map<Key, long long>& getCounts() const { return _counts; }
+
+    /**
+     * @brief Returns the `n` most common keys, by descending count (ties by key).
+     */
+    std::vector<std::pair<Key, long long>> getMostCommon(const size_t n) const {
+        std::vector<std::pair<Key, long long>> items(_counts.begin(), _counts.end());
+        std::stable_sort(items.begin(), items.end(),
+                         [](const auto& a, const auto& b) { return a.second > b.second; });
+        if (items.size() > n) {
+            items.resize(n);
+        }
+        return items;
+    }
+
+   private:
+    std::map<Key, long long> _counts;
+    long long _total = 0;
+};
+
+/**
+ * @brief Histogram of real values in equal-width bins (e.g. durations, intervals, densities).
+ * @details The bins cover [minValue, maxValue); values outside the range are counted apart as
+ *          underflow or overflow. All the accumulators merged together must have the same bins:
+ *          pass a configured histogram as the initial accumulator of mapReduce().
+ */
+class HistogramReducer {
+   public:
+    /**
+     * @brief Creates an empty histogram.
+     * @param minValue Lower edge of the first bin.
+     * @param maxValue Upper edge of the last bin (must be greater than minValue).
+     * @param numBins Number of bins (at least 1).
+     */
+    explicit HistogramReducer(const double minValue = 0.0, const double maxValue = 1.0,
+                              const int numBins = 10);
+
+    /**
+     * @brief Adds a value with an optional weight.
+     */
+    void add(const double value, const double weight = 1.0);
+
+    /**
+     * @brief Adds the bins of another histogram with the same range and number of bins.
+     */
+    void merge(HistogramReducer&& other);
+
+    /**
+     * @brief Returns the total weight of each bin.
+     */
+    const std::vector<double>& getBins() const;
+
+    /**
+     * @brief Returns the numBins + 1 bin edges.
+     */
+    std::vector<double> getBinEdges() const;
+
+    /**
+     * @brief Returns the bins divided by the total weight inside the range (zeros if empty).
+     */
+    std::vector<double> getNormalizedBins() const;
+
+    /**
+     * @brief Returns the total weight of the values below minValue.
+     */
+    double getUnderflow() const;
+
+    /**
+     * @brief Returns the total weight of the values at or above maxValue.
+     */
+    double getOverflow() const;
+
+    /**
+     * @brief Returns the total weight of all values, including underflow and overflow.
+     */
+    double getTotal() const;
+
+   private:
+    double _minValue;
+    double _maxValue;
+    std::vector<double> _bins;
+    double _underflow = 0.0;
+    double _overflow = 0.0;
+};
+
+/**
+ * @brief Concatenates values produced in parallel, restoring the order of their keys.
+ * @details Each value is added with a key, usually the score or task index that produced it.
+ *          Consecutive values with the same key form a chunk; merge() only moves chunks, and
+ *          takeValues() sorts the chunks by key (stable), so the values of each key keep their
+ *          insertion order and the result does not depend on the thread scheduling.
+ * @tparam T Value type.
+ * @tparam Key Ordering key (needs operator< and operator==).
+ */
+template <typename T, typename Key = size_t>
+class ConcatenationReducer {
+   public:
+    /**
+     * @brief Appends a value produced by `key`.
+     */
+    void add(const Key& key, T value) {
+        if (_chunks.empty() || !(_chunks.back().first == key)) {
+            _chunks.emplace_back(key, std::vector<T>());
+        }
+        _chunks.back().second.push_back(std::move(value));
+        _numValues++;
+    }
+
+    /**
+     * @brief Appends the values of another accumulator.
+     */
+    void merge(ConcatenationReducer&& other) {
+        _chunks.insert(_chunks.end(), std::make_move_iterator(other._chunks.begin()),
+                       std::make_move_iterator(other._chunks.end()));
+        _numValues += other._numValues;
+        other._chunks.clear();
+        other._numValues = 0;
+    }
+
+    /**
+     * @brief Returns the number of values.
+     */
+    size_t getNumValues() const { return _numValues; }
+
+    /**
+     * @brief Moves the values out, leaving the accumulator empty.
+     * @param ordered If true (default), the values are sorted by key; otherwise they are in merge
+     *                order, which skips the sorting.
+     */
+    std::vector<T> takeValues(const bool ordered = true) {
+        if (ordered) {
+            std::stable_sort(_chunks.begin(), _chunks.end(),
+                             [](const auto& a, const auto& b) { return a.first < b.first; });
+        }
+
+        std::vector<T> values;
+        values.reserve(_numValues);
+        for (auto& chunk : _chunks) {
+            values.insert(values.end(), std::make_move_iterator(chunk.second.begin()),
+                          std::make_move_iterator(chunk.second.end()));
+        }
+
+        _chunks.clear();
+        _numValues = 0;
+        return values;
+    }
+
+    /**
+     * @brief Returns a copy of the values, sorted by key.
+     */
+    std::vector<T> getValues() const {
+        ConcatenationReducer copy = *this;
+        return copy.takeValues(true);
+    }
+
+   private:
+    std::vector<std::pair<Key, std::vector<T>>> _chunks;
+    size_t _numValues = 0;
+};
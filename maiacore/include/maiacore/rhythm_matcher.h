@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file rhythm_matcher.h
+ * @brief Search of a rhythmic cell in inter-onset interval (IOI) sequences.
+ */
+
+/**
+ * @brief Finds a rhythmic cell, given as inter-onset intervals, in IOI sequences.
+ * @details The intervals are integer ticks of a common grid, so tuplets and dotted values are
+ *          exact. Two modes are available:
+ *
+ *          - Exact (tolerance = 0): Rabin-Karp rolling hash over the IOI windows, with a direct
+ *            comparison on each hash hit. O(n) per sequence.
+ *          - Tolerance (tolerance > 0): each IOI may deviate from the cell by up to
+ *            `tolerance * cellIoi` ticks, which accepts swung pairs or tuplet variants of a cell.
+ *            Cells of up to 64 intervals run a bit-parallel Shift-And matcher, longer cells a
+ *            sliding comparison.
+ */
+class RhythmMatcher {
+   public:
+    /**
+     * @brief Occurrence of the cell: IOIs [start, start + getNumIntervals()) of the sequence.
+     */
+    struct Match {
+        int start = 0;              ///< First IOI of the occurrence.
+        float maxDeviation = 0.0f;  ///< Largest relative deviation of an IOI (0 when exact).
+    };
+
+    /**
+     * @brief Prepares the search of a rhythmic cell.
+     * @param cellIntervals Inter-onset intervals of the cell, in ticks. All must be positive.
+     * @param tolerance Maximum relative deviation of each interval (0: exact search).
+     */
+    explicit RhythmMatcher(const std::vector<int64_t>& cellIntervals, const float tolerance = 0.0f);
+
+    /**
+     * @brief Returns the number of intervals of the cell.
+     */
+    int getNumIntervals() const;
+
+    /**
+     * @brief Returns all occurrences of the cell in a IOI sequence, overlapping included.
+     * @param intervals Inter-onset intervals, in ticks of the same grid of the cell.
+     * @return Occurrences in ascending order of start.
+     */
+    std::vector<Match> findAll(const std::vector<int64_t>& intervals) const;
+
+   private:
+    std::vector<int64_t> _cell;
+    float _tolerance;
+    uint64_t _cellHash = 0;
+    uint64_t _highestPower = 1;  ///< HASH_BASE^(numIntervals - 1), to roll the window hash.
+
+    /**
+     * @brief Relative deviation of an interval from a cell interval.
+     */
+    float deviation(const int64_t interval, const int cellIdx) const;
+
+    std::vector<Match> findExact(const std::vector<int64_t>& intervals) const;
+    std::vector<Match> findApproximate(const std::vector<int64_t>& intervals) const;
+};
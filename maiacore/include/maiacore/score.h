@@ -1,17 +1,25 @@
 #pragma once
 
 #include <initializer_list>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "SQLiteCpp/SQLiteCpp.h"
 #include "maiacore/chord.h"
 #include "maiacore/constants.h"
+#include "maiacore/harmonic_index.h"
 #include "maiacore/key.h"
 #include "maiacore/measure.h"
+#include "maiacore/melody_regex.h"
 #include "maiacore/note.h"
 #include "maiacore/part.h"
+#include "maiacore/rhythm_matcher.h"
+#include "maiacore/score_descriptor.h"
+#include "maiacore/score_fingerprint.h"
 #include "nlohmann/json.hpp"
 #include "pugi/pugixml.hpp"
 
@@ -37,6 +45,7 @@ class Score {
     bool _isValidXML; ///< True if the XML was loaded and parsed successfully.
     bool _haveTypeTag; ///< True if the MusicXML contains <type> tags for notes.
     bool _isLoadedXML; ///< True if the score was loaded from a file.
+    bool _isChangedAfterLoad = false; ///< True if the score changed after its document was loaded.
     std::vector<Chord> _stackedChords; ///< Cached vertical chords.
     int _lcmDivisionsPerQuarterNote; ///< Least common multiple of all 'divisions' tags in the XML file.
     bool _haveAnacrusisMeasure; ///< True if the score contains an anacrusis (pickup) measure.
@@ -69,9 +78,79 @@ class Score {
      */
     std::vector<std::vector<NoteEvent>> collectNoteEventsPerPart() const;
 
+    /**
+     * @brief Same as collectNoteEventsPerPart(), without the cache: safe on a score read by
+     *        several threads (e.g. shared by collections).
+     */
+    std::vector<std::vector<NoteEvent>> buildNoteEventsPerPart() const;
+
+   public:
+    /**
+     * @brief Melody stream searched by the melody pattern engines (see setMelodyStreams()).
+     */
+    struct MelodyStream {
+        MelodyStreamType type = MelodyStreamType::PART;  ///< Kind of stream.
+        int partIdx = 0;          ///< Part index.
+        std::string partName;     ///< Part name.
+        int staveIdx = -1;        ///< Staff of a VOICE stream (-1 for the other types).
+        int voice = -1;           ///< Voice of a VOICE stream (-1 for the other types).
+        int numNoteEvents = 0;    ///< Number of note events (notes and rests) of the stream.
+    };
+
+   private:
+    bool _melodyStreamsPerVoice = false;  ///< Search each (part, staff, voice) line instead of each part.
+    bool _melodySkylineStreams = false;   ///< Also search the skyline of each part.
+    bool _melodyBasslineStreams = false;  ///< Also search the bassline of each part.
+
+    /**
+     * @brief Collects the melody streams selected by setMelodyStreams() and their note events.
+     * @param streams Output: description of each stream.
+     * @param noteEvents Output: note events of each stream.
+     */
+    void collectMelodyStreams(std::vector<MelodyStream>* streams,
+                              std::vector<std::vector<NoteEvent>>* noteEvents) const;
+
+    /**
+     * @brief Inverted index and numeric arrays of each melody stream, used by findMelodyPattern().
+     * @details Maps each sequence of GRAM_SIZE consecutive intervals to the list of note event
+     *          indices where it starts (posting list). The interval and duration arrays let the
+     *          default similarities slide over contiguous memory instead of copying Note objects.
+     */
+    struct MelodySearchIndex {
+        static const int GRAM_SIZE = 3;  ///< Number of consecutive intervals of each n-gram.
+
+        std::vector<MelodyStream> streams;  ///< Searched melody streams (see setMelodyStreams()).
+        std::vector<std::vector<NoteEvent>> noteEvents;  ///< Note events of each stream.
+        std::vector<std::vector<int>> intervals;  ///< Semitones between consecutive events (0 with rests).
+        std::vector<std::vector<float>> quarterDurations;  ///< Quarter duration of each event.
+        std::vector<std::vector<int>> firstNoteOn;  ///< Index of the first non-rest event at or after each event.
+        std::vector<std::unordered_map<uint32_t, std::vector<int>>> postings;  ///< Interval n-gram posting lists.
+        std::vector<std::string> keyNames;  ///< Distinct key names (interned).
+        std::vector<std::vector<int>> keyIds;  ///< Index in 'keyNames' of the key of each event.
+    };
+
+    mutable std::shared_ptr<const MelodySearchIndex> _melodySearchIndex; ///< Cache for the melody search index (atomic: const readers may share the score).
+    /**
+     * @brief Returns the melody search index, building it on the first call.
+     * @return Reference to the cached MelodySearchIndex.
+     */
+    const MelodySearchIndex& getMelodySearchIndex() const;
+    friend class MelodyCorpusIndex;  ///< Copies the melody search index to the persistent index.
+    friend struct ScoreFingerprint;  ///< Hashes the interval and duration arrays of the streams.
+
+    mutable std::shared_ptr<const ScoreFingerprint> _fingerprint; ///< Cache for getFingerprint().
+
+    friend struct ScoreDescriptor;  ///< Reads the notes of the parts in a single pass.
+    mutable std::shared_ptr<const ScoreDescriptor> _descriptor; ///< Cache for getDescriptor().
+
+    std::shared_ptr<const std::vector<HarmonicSlice>> _harmonicIndex; ///< Cache for the harmonic index.
+    std::string _harmonicIndexConfig; ///< getChords() configuration of the cached harmonic index.
+
     /**
      * @brief Removes duplicate melodic patterns from a vector of patterns.
-     * @details Compares patterns by MIDI pitch and duration differences, keeping only unique patterns.
+     * @details Two patterns are duplicates when their consecutive MIDI pitch differences and
+     * duration differences are equal (so transpositions collapse). Patterns are hashed by that
+     * shape in a single pass, keeping the first occurrence of each one in the original order.
      * @param patterns Pointer to the vector of note patterns to be filtered.
      */
     void removeDuplicatePatterns(std::vector<std::vector<Note>>* patterns) const;
@@ -99,6 +178,34 @@ class Score {
      */
     void loadXMLFile(const std::string& filePath);
 
+    /**
+     * @brief Fills the Score object from the parsed MusicXML document (_doc).
+     */
+    void loadXMLDocument();
+
+    /**
+     * @brief Loads a MusicXML document from memory (e.g. an entry of a CorpusPack).
+     * @param xmlData Uncompressed MusicXML document.
+     * @param xmlSize Size of the document, in bytes.
+     * @param filePath Path reported by getFilePath() and getFileName().
+     */
+    void loadXMLBuffer(const char* xmlData, const size_t xmlSize, const std::string& filePath);
+
+    /**
+     * @brief Returns the MusicXML document of the score, without indentation.
+     * @details The loaded document if the score was loaded from a file and not changed since
+     *          (getFile*() and the other methods that read it see the same data), otherwise
+     *          toXML(). Any call to a method that can change the score, including the non-const
+     *          getPart(), counts as a change.
+     */
+    std::string saveXMLDocument() const;
+
+    /**
+     * @brief Constructs a Score object from a MusicXML document in memory (see loadXMLBuffer()).
+     */
+    Score(const char* xmlData, const size_t xmlSize, const std::string& filePath);
+    friend class CorpusPack;  ///< Stores the loaded documents and loads the scores of a pack.
+
     /**
      * @brief Extracts vertical chords for each note event using an in-memory SQLite database.
      * @param db SQLite database with note events.
@@ -514,9 +621,13 @@ class Score {
         _isValidXML = other._isValidXML;
         _haveTypeTag = other._haveTypeTag;
         _isLoadedXML = other._isLoadedXML;
+        _isChangedAfterLoad = other._isChangedAfterLoad;
         _lcmDivisionsPerQuarterNote = other._lcmDivisionsPerQuarterNote;
         _stackedChords = other._stackedChords;
         _haveAnacrusisMeasure = other._haveAnacrusisMeasure;
+        _melodyStreamsPerVoice = other._melodyStreamsPerVoice;
+        _melodySkylineStreams = other._melodySkylineStreams;
+        _melodyBasslineStreams = other._melodyBasslineStreams;
 
         // Deep copy of XML document
         _doc.reset(other._doc);
@@ -526,6 +637,10 @@ class Score {
         _isNoteEventsPerPartCached = false;
         _cachedNoteEvents.clear();
         _cachedNoteEventsPerPart.clear();
+        _melodySearchIndex.reset();
+        _harmonicIndex.reset();
+        _fingerprint.reset();
+        _descriptor.reset();
     }
 
     /**
@@ -547,9 +662,13 @@ class Score {
         _isValidXML = other._isValidXML;
         _haveTypeTag = other._haveTypeTag;
         _isLoadedXML = other._isLoadedXML;
+        _isChangedAfterLoad = other._isChangedAfterLoad;
         _lcmDivisionsPerQuarterNote = other._lcmDivisionsPerQuarterNote;
         _stackedChords = other._stackedChords;
         _haveAnacrusisMeasure = other._haveAnacrusisMeasure;
+        _melodyStreamsPerVoice = other._melodyStreamsPerVoice;
+        _melodySkylineStreams = other._melodySkylineStreams;
+        _melodyBasslineStreams = other._melodyBasslineStreams;
 
         // Deep copy of XML document
         _doc.reset(other._doc);
@@ -559,6 +678,10 @@ class Score {
         _isNoteEventsPerPartCached = false;
         _cachedNoteEvents.clear();
         _cachedNoteEventsPerPart.clear();
+        _melodySearchIndex.reset();
+        _harmonicIndex.reset();
+        _fingerprint.reset();
+        _descriptor.reset();
 
         return *this;
     }
@@ -586,6 +709,9 @@ class Score {
      * @param totalIntervalSimilarityCallback Function to aggregate interval similarity.
      * @param totalRhythmSimilarityCallback Function to aggregate rhythm similarity.
      * @param totalSimilarityCallback Function to combine total similarities.
+     * @param metric Similarity metric (default: MelodySimilarityMetric::EUCLIDEAN).
+     * @param warpingWindow DTW band: maximum distance between aligned pattern and segment note
+     *                      indices, i.e. how many notes an occurrence may add or drop (DTW only).
      * @return Table of results with detailed information about found patterns.
      * @details Performs comprehensive melodic pattern matching across all parts and measures of the score,
      *          supporting flexible similarity metrics for both intervallic contour and rhythmic structure.
@@ -624,8 +750,30 @@ class Score {
      *          - Plagiarism detection (melodic borrowing, paraphrase identification)
      *          - Style analysis (characteristic melodic gestures across composers/periods)
      *
+     *          With the default interval similarity, candidate windows are retrieved from an index of
+     *          interval n-grams built once per score: a window above the interval threshold can only
+     *          differ from the pattern in a few intervals, so at least one block of the pattern
+     *          intervals matches exactly. Candidates are then verified with the same computation of a
+     *          full scan, so the result table does not change.
+     *
+     *          **Approximate matching (MelodySimilarityMetric::DTW)**: the Euclidean metric aligns
+     *          notes one-to-one, so ornamented or rhythmically varied statements of a theme are
+     *          missed. The DTW metric aligns the pitch contour of the pattern (semitones from its
+     *          first note) with the contour of each segment using Dynamic Time Warping inside a
+     *          Sakoe-Chiba band of `warpingWindow` notes; the segment may end up to `warpingWindow`
+     *          notes before or after the pattern length, and the best end is reported. The interval
+     *          similarity is 1 / (1 + sqrt(DTW distance)) and the rhythm similarity uses the
+     *          normalized durations along the same warping path, so `semitonesDiff` and
+     *          `rhythmDiff` have one entry per path step. Candidates are pruned by an LB_Keogh
+     *          lower bound over the contour envelope and the DTW stops early as soon as a row
+     *          exceeds the distance allowed by the interval threshold. Custom interval and rhythm
+     *          callbacks are only supported by the Euclidean metric.
+     *
      * @note Computational complexity is O(n × m) where n = total notes in score, m = pattern length.
-     *       For large scores, consider restricting search to specific parts or measure ranges.
+     *       High interval thresholds (few allowed interval mismatches) only verify the indexed
+     *       candidates. Custom interval callbacks always scan all windows. The DTW metric costs
+     *       O(n × m × warpingWindow) in the worst case, but most segments are rejected by the
+     *       O(m) lower bound.
      */
     MelodyPatternTable findMelodyPattern(
         const std::vector<Note>& melodyPattern, const float totalIntervalsSimilarityThreshold = 0.5,
@@ -638,11 +786,53 @@ class Score {
             nullptr,
         const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback =
             nullptr,
-        const std::function<float(float, float)> totalSimilarityCallback = nullptr) const;
+        const std::function<float(float, float)> totalSimilarityCallback = nullptr,
+        const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+        const int warpingWindow = 2) const;
+
+    /**
+     * @brief Searches for a melodic pattern in a single melody stream of the score.
+     * @details Returns the rows of findMelodyPattern() that belong to getMelodyStreams()[streamIdx]:
+     *          the tables of all streams, in stream order, make the findMelodyPattern() table. Lets
+     *          the streams of a large score be searched on different threads (see
+     *          ScoreCollection::findMelodyPattern()) once the melody search index is built.
+     * @param streamIdx Index of the melody stream (see getMelodyStreams()).
+     * @param melodyPattern Vector of Note objects representing the melodic pattern.
+     * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
+     * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
+     * @param intervalsSimilarityCallback Custom function to calculate interval similarity.
+     * @param rhythmSimilarityCallback Custom function to calculate rhythm similarity.
+     * @param totalIntervalSimilarityCallback Function to aggregate interval similarity.
+     * @param totalRhythmSimilarityCallback Function to aggregate rhythm similarity.
+     * @param totalSimilarityCallback Function to combine total similarities.
+     * @param metric Similarity metric (default: MelodySimilarityMetric::EUCLIDEAN).
+     * @param warpingWindow DTW band, in notes (DTW only).
+     * @return Table with the matches of the stream.
+     */
+    MelodyPatternTable findMelodyPatternInStream(
+        const int streamIdx, const std::vector<Note>& melodyPattern,
+        const float totalIntervalsSimilarityThreshold = 0.5,
+        const float totalRhythmSimilarityThreshold = 0.5,
+        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+            intervalsSimilarityCallback = nullptr,
+        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+            rhythmSimilarityCallback = nullptr,
+        const std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback =
+            nullptr,
+        const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback =
+            nullptr,
+        const std::function<float(float, float)> totalSimilarityCallback = nullptr,
+        const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+        const int warpingWindow = 2) const;
 
     /**
      * @brief Searches for multiple melodic patterns in the score, returning a table for each pattern.
      * @details Allows parallel analysis of several patterns, useful for comparative research.
+     *          Every (pattern, part) pair is a task of a work-stealing scheduler (see ThreadPool), so
+     *          all patterns are searched whatever their number. Results are in the same order of a
+     *          sequential search. A pattern bigger than the score returns an empty table and a
+     *          warning is logged. Other errors (e.g. an exception thrown by a similarity
+     *          callback) stop the search and the first one is rethrown.
      * @param melodyPatterns Vector of melodic patterns.
      * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
      * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
@@ -651,6 +841,9 @@ class Score {
      * @param totalIntervalSimilarityCallback Function to aggregate interval similarity.
      * @param totalRhythmSimilarityCallback Function to aggregate rhythm similarity.
      * @param totalSimilarityCallback Function to combine total similarities.
+     * @param numThreads Number of worker threads (default: 0, the number of hardware threads).
+     * @param metric Similarity metric (default: MelodySimilarityMetric::EUCLIDEAN).
+     * @param warpingWindow DTW band, in notes (DTW only).
      * @return Vector of result tables, one for each pattern.
      */
     std::vector<MelodyPatternTable> findMelodyPattern(
@@ -664,7 +857,10 @@ class Score {
             nullptr,
         const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback =
             nullptr,
-        const std::function<float(float, float)> totalSimilarityCallback = nullptr) const;
+        const std::function<float(float, float)> totalSimilarityCallback = nullptr,
+        const int numThreads = 0,
+        const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+        const int warpingWindow = 2) const;
 
     /**
      * @brief Finds all possible melodic patterns of a given length in the score.
@@ -677,6 +873,7 @@ class Score {
      * @param totalIntervalSimilarityCallback Function to aggregate interval similarity.
      * @param totalRhythmSimilarityCallback Function to aggregate rhythm similarity.
      * @param totalSimilarityCallback Function to combine total similarities.
+     * @param numThreads Number of worker threads (default: 0, the number of hardware threads).
      * @return Vector of result tables for each found pattern.
      */
     std::vector<MelodyPatternTable> findAnyMelodyPattern(const int patternNumNotes = 5,
@@ -690,8 +887,449 @@ class Score {
             nullptr,
         const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback =
             nullptr,
+        const std::function<float(float, float)> totalSimilarityCallback = nullptr,
+        const int numThreads = 0) const;
+
+    /**
+     * @brief Compact result of a melody pattern search: indices and similarities, no strings.
+     * @details Part and key names are interned: use getPart(partIdx).getName() and
+     *          getMelodySearchKeyNames()[keyIdx] to resolve them when needed.
+     */
+    struct MelodyPatternMatch {
+        int partIdx = 0;                       ///< Part index.
+        int streamIdx = 0;                     ///< Melody stream index (see getMelodyStreams()).
+        int measureIdx = 0;                    ///< Measure of the first segment note.
+        int staveIdx = 0;                      ///< Stave of the first segment note.
+        int keyIdx = 0;                        ///< Index of the measure key name.
+        int noteEventIdx = 0;                  ///< Position of the first segment note in the stream.
+        int numNotes = 0;                      ///< Number of segment notes.
+        float totalIntervalSimilarity = 0.0f;  ///< Interval similarity.
+        float totalRhythmSimilarity = 0.0f;    ///< Rhythm similarity.
+        float totalSimilarity = 0.0f;          ///< Mean of the interval and rhythm similarities.
+    };
+
+    /**
+     * @brief Streaming sink of findMelodyPatternMatches(), called once per match in score order.
+     */
+    typedef std::function<void(const MelodyPatternMatch&)> MelodyPatternMatchCallback;
+
+    /**
+     * @brief Returns the interned key names referenced by MelodyPatternMatch::keyIdx.
+     */
+    const std::vector<std::string>& getMelodySearchKeyNames() const;
+
+    /**
+     * @brief Selects the melody streams searched by the melody pattern engines.
+     * @details By default each part is a single stream with the voice 1 notes of all its staves,
+     *          without chord notes. With `splitVoices`, each (part, staff, voice) line becomes a
+     *          stream and chords contribute their highest note, so keyboard and divisi voices are
+     *          searched too. The skyline and bassline streams keep the highest/lowest note attacked
+     *          at each onset of a part, across all its staves and voices. Rest-only voices and parts
+     *          without notes add no stream.
+     *
+     *          The streams are extracted once and cached with the melody search index, which is
+     *          shared by findMelodyPattern(), findMelodyPatternMatches(), countMelodyPattern(),
+     *          findTopMelodyPattern(), findMelodyPatternBatched(), findAnyMelodyPattern(),
+     *          findRepeatedMotifs() and findMelodyRegex(). Changing the selection drops the cache.
+     * @param splitVoices If true, searches each (part, staff, voice) line instead of each part.
+     * @param includeSkyline If true, also searches the skyline of each part.
+     * @param includeBassline If true, also searches the bassline of each part.
+     */
+    void setMelodyStreams(const bool splitVoices, const bool includeSkyline = false,
+                          const bool includeBassline = false);
+
+    /**
+     * @brief Returns the melody streams searched by the melody pattern engines.
+     * @return Streams in search order: part by part, VOICE (or PART) streams first, then the
+     *         skyline and the bassline.
+     */
+    std::vector<MelodyStream> getMelodyStreams() const;
+
+    /**
+     * @brief Returns the MinHash fingerprint of the score, computed on the first call.
+     * @details Used to find near-duplicate encodings of a work (see ScoreFingerprint and
+     *          ScoreCollection::findNearDuplicates()). Like the melody search index, the cache is
+     *          not updated by later changes to the notes; setMelodyStreams() resets it.
+     */
+    const ScoreFingerprint& getFingerprint() const;
+
+    /**
+     * @brief Returns the feature vector of the score, computed on the first call.
+     * @details Used to find similar scores (see ScoreDescriptor and
+     *          ScoreCollection::findSimilarScores()). The cache is not updated by later changes
+     *          to the notes.
+     */
+    const ScoreDescriptor& getDescriptor() const;
+
+    /**
+     * @brief Streams the matches of a melodic pattern to a callback, without building a table.
+     * @details Same search of findMelodyPattern() with the default similarities, but each match
+     *          is delivered as a compact MelodyPatternMatch: no strings nor difference vectors are
+     *          allocated, so memory does not grow with the number of matches.
+     * @param melodyPattern Vector of notes representing the pattern to search for.
+     * @param callback Function called for each match, in part and score order.
+     * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
+     * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
+     * @param metric Similarity metric (default: MelodySimilarityMetric::EUCLIDEAN).
+     * @param warpingWindow DTW band, in notes (DTW only).
+     */
+    void findMelodyPatternMatches(const std::vector<Note>& melodyPattern,
+                                  const MelodyPatternMatchCallback& callback,
+                                  const float totalIntervalsSimilarityThreshold = 0.5f,
+                                  const float totalRhythmSimilarityThreshold = 0.5f,
+                                  const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+                                  const int warpingWindow = 2) const;
+
+    /**
+     * @brief Counts the matches of a melodic pattern (count-only sink).
+     * @param melodyPattern Vector of notes representing the pattern to search for.
+     * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
+     * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
+     * @param metric Similarity metric (default: MelodySimilarityMetric::EUCLIDEAN).
+     * @param warpingWindow DTW band, in notes (DTW only).
+     * @return Number of rows that findMelodyPattern() would return.
+     */
+    size_t countMelodyPattern(const std::vector<Note>& melodyPattern,
+                              const float totalIntervalsSimilarityThreshold = 0.5f,
+                              const float totalRhythmSimilarityThreshold = 0.5f,
+                              const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+                              const int warpingWindow = 2) const;
+
+    /**
+     * @brief Returns the k best matches of a melodic pattern (top-k sink).
+     * @details Keeps a bounded heap of k matches while searching, so only k result rows are ever
+     *          built. Ties are resolved by score order.
+     * @param melodyPattern Vector of notes representing the pattern to search for.
+     * @param k Maximum number of rows.
+     * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
+     * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
+     * @param metric Similarity metric (default: MelodySimilarityMetric::EUCLIDEAN).
+     * @param warpingWindow DTW band, in notes (DTW only).
+     * @return Up to k rows of findMelodyPattern(), sorted by descending total similarity.
+     */
+    MelodyPatternTable findTopMelodyPattern(const std::vector<Note>& melodyPattern, const size_t k,
+                                            const float totalIntervalsSimilarityThreshold = 0.5f,
+                                            const float totalRhythmSimilarityThreshold = 0.5f,
+                                            const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+                                            const int warpingWindow = 2) const;
+
+    /**
+     * @brief Notes of a set of melody windows, stored as row-major numWindows x windowSize arrays.
+     * @details Used by the batched similarity callbacks: a whole part is delivered in a single
+     *          call, ready to be wrapped as 2D NumPy arrays.
+     */
+    struct MelodyWindowBatch {
+        int numWindows = 0;                   ///< Number of windows (rows).
+        int windowSize = 0;                   ///< Number of notes of each window (columns).
+        std::vector<int> midiNumbers;         ///< MIDI number of each note (0 for rests).
+        std::vector<float> quarterDurations;  ///< Quarter duration of each note.
+        std::vector<uint8_t> restMask;        ///< 1 for rests, 0 for notes.
+        std::vector<int> noteEventIdx;        ///< Position of the first note of each window in the stream.
+    };
+
+    /**
+     * @brief Batched similarity: receives the pattern (a single window) and all candidate windows
+     *        of a melody stream, and returns the interval and rhythm similarities of each window.
+     */
+    typedef std::function<std::pair<std::vector<float>, std::vector<float>>(
+        const MelodyWindowBatch&, const MelodyWindowBatch&)>
+        MelodyBatchSimilarityCallback;
+
+    /**
+     * @brief Searches for a melodic pattern using a batched similarity callback.
+     * @details Same windows and result rows of findMelodyPattern(), but the similarities of all
+     *          windows of a part are computed by a single callback call instead of one call per
+     *          window with two std::vector<Note>. From Python this lets custom metrics run at NumPy
+     *          speed. The `semitonesDiff` and `rhythmDiff` columns are the default differences.
+     * @param melodyPattern Vector of notes representing the pattern to search for.
+     * @param batchSimilarityCallback Function returning one interval and one rhythm similarity per
+     *                                window (both vectors with batch.numWindows values).
+     * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
+     * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
+     * @param totalSimilarityCallback Function to combine total similarities.
+     * @return Table of results, same format of findMelodyPattern().
+     */
+    MelodyPatternTable findMelodyPatternBatched(
+        const std::vector<Note>& melodyPattern,
+        const MelodyBatchSimilarityCallback& batchSimilarityCallback,
+        const float totalIntervalsSimilarityThreshold = 0.5f,
+        const float totalRhythmSimilarityThreshold = 0.5f,
         const std::function<float(float, float)> totalSimilarityCallback = nullptr) const;
-    
+
+    /**
+     * @brief Occurrence of a repeated motif found by findRepeatedMotifs().
+     */
+    struct MotifOccurrence {
+        int partIdx = 0;                  ///< Part index.
+        std::string partName;             ///< Part name.
+        int streamIdx = 0;                ///< Melody stream index (see getMelodyStreams()).
+        int measureIdx = 0;               ///< Measure of the first note.
+        int staveIdx = 0;                 ///< Stave of the first note.
+        int noteEventIdx = 0;             ///< Position of the first note in the stream.
+        std::vector<std::string> pitches;  ///< Written pitches of the occurrence.
+    };
+
+    /**
+     * @brief Motif that repeats in the score, with all its occurrences.
+     */
+    struct RepeatedMotif {
+        int numNotes = 0;                     ///< Number of notes of the motif.
+        std::vector<int> intervals;           ///< Semitones between consecutive notes (0 with rests).
+        std::vector<float> quarterDurations;  ///< Note durations of the first occurrence.
+        std::vector<MotifOccurrence> occurrences;  ///< Occurrences, in part and score order.
+    };
+
+    /**
+     * @brief Discovers the melodic motifs that repeat in the score, of any length.
+     * @details The melody of each part is converted to a token stream, one token per pair of
+     *          consecutive notes (interval and duration of the first note), and all parts are
+     *          indexed together in a suffix array. The maximal repeats of that text are the motifs
+     *          that cannot be extended to the left or to the right without losing an occurrence,
+     *          so each recurring idea is reported once, at its longest length, instead of once per
+     *          window size. Runs in O(n log n) on the number of notes.
+     *
+     *          Occurrences are exact and transposition invariant. When `considerRhythm` is true
+     *          the durations must also match, except the one of the last note, which usually
+     *          depends on the phrase ending. Motifs made only of rests are ignored, and
+     *          occurrences may overlap.
+     * @param minNumNotes Minimum number of notes of a motif (at least 2).
+     * @param minNumOccurrences Minimum number of occurrences of a motif (at least 2).
+     * @param considerRhythm If true, the note durations are part of the motif.
+     * @return Motifs sorted by number of notes, then by number of occurrences (both descending),
+     *         then by the position of their first occurrence.
+     */
+    std::vector<RepeatedMotif> findRepeatedMotifs(const int minNumNotes = 4,
+                                                  const int minNumOccurrences = 2,
+                                                  const bool considerRhythm = true) const;
+
+    /**
+     * @brief Match of a melody expression found by findMelodyRegex().
+     */
+    struct MelodyRegexMatch {
+        int partIdx = 0;                   ///< Part index.
+        std::string partName;              ///< Part name.
+        int streamIdx = 0;                 ///< Melody stream index (see getMelodyStreams()).
+        int measureIdx = 0;                ///< Measure of the first note.
+        int staveIdx = 0;                  ///< Stave of the first note.
+        int noteEventIdx = 0;              ///< Position of the first note in the stream.
+        int numNotes = 0;                  ///< Number of notes and rests of the match.
+        std::vector<std::string> pitches;  ///< Written pitches of the match.
+    };
+
+    /**
+     * @brief Searches each melody stream for a structural expression over intervals,
+     *        durations and rests.
+     * @details The expression is a regular expression where each symbol is a note event, e.g.
+     *          `[i=+3] [same]* [i=-2..-1]` (see MelodyRegex for the grammar). Intervals are
+     *          measured from the previous note of the stream, so the query is transposition
+     *          invariant. The streams are the ones of findMelodyPattern() (see setMelodyStreams())
+     *          and are scanned in parallel by a compiled automaton, without any similarity
+     *          threshold.
+     * @param pattern Melody expression.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @return Leftmost-longest, non-overlapping matches, in stream and score order.
+     */
+    std::vector<MelodyRegexMatch> findMelodyRegex(const std::string& pattern,
+                                                  const int numThreads = 0) const;
+
+    /**
+     * @brief Searches each melody stream for a compiled melody expression.
+     * @details Same of findMelodyRegex(const std::string&), for expressions compiled once and
+     *          searched in many scores.
+     * @param regex Compiled melody expression.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @return Leftmost-longest, non-overlapping matches, in stream and score order.
+     */
+    std::vector<MelodyRegexMatch> findMelodyRegex(const MelodyRegex& regex,
+                                                  const int numThreads = 0) const;
+
+    /**
+     * @brief Occurrence of a rhythmic cell found by findRhythmPattern().
+     */
+    struct RhythmPatternMatch {
+        int partIdx = 0;                          ///< Part index.
+        std::string partName;                     ///< Part name.
+        int staveIdx = 0;                         ///< Stave of the voice.
+        int voice = 1;                            ///< Voice number.
+        int measureIdx = 0;                       ///< Measure of the first onset.
+        int onsetIdx = 0;                         ///< Position of the first onset in the voice.
+        float quarterOnset = 0.0f;                ///< First onset, in quarter notes from the score start.
+        std::vector<float> interOnsetIntervals;   ///< IOIs of the occurrence, in quarter notes.
+        float maxDeviation = 0.0f;                ///< Largest relative IOI deviation (0 when exact).
+    };
+
+    /**
+     * @brief Searches for a rhythmic cell in every voice of every part, pitched or not.
+     * @details Pitch is ignored: each voice (part, stave, voice number) is reduced to its onsets on
+     *          the integer tick grid of the score (the LCM of all divisions), and the cell is
+     *          matched against the inter-onset intervals (IOIs). Rests extend the previous IOI,
+     *          tied notes do not start a new onset and chord notes share the onset of the chord,
+     *          so the search sees what is heard. The last duration of the cell is ignored, as it
+     *          does not define an onset.
+     *
+     *          With `tolerance = 0` the IOIs must be identical (rolling-hash search). A positive
+     *          tolerance accepts each IOI within `tolerance * cellIoi`, e.g. 0.35 finds swung
+     *          eighth pairs (2/3 + 1/3) for a straight pair (1/2 + 1/2). See RhythmMatcher.
+     * @param rhythmPattern Notes of the cell: only the durations, rests and ties are used.
+     * @param tolerance Maximum relative deviation of each IOI (default: 0, exact).
+     * @param includeUnpitched If true, the percussion (unpitched) parts are searched too.
+     * @return Occurrences (overlapping included), ordered by part, stave, voice and onset.
+     */
+    std::vector<RhythmPatternMatch> findRhythmPattern(const std::vector<Note>& rhythmPattern,
+                                                      const float tolerance = 0.0f,
+                                                      const bool includeUnpitched = true) const;
+
+    /**
+     * @brief Searches for a rhythmic cell given by its inter-onset intervals.
+     * @details Same of findRhythmPattern(const std::vector<Note>&, ...). The IOIs are rounded to
+     *          the tick grid of the score.
+     * @param interOnsetIntervals IOIs of the cell, in quarter notes (e.g. {0.75, 0.25}).
+     * @param tolerance Maximum relative deviation of each IOI (default: 0, exact).
+     * @param includeUnpitched If true, the percussion (unpitched) parts are searched too.
+     * @return Occurrences (overlapping included), ordered by part, stave, voice and onset.
+     */
+    std::vector<RhythmPatternMatch> findRhythmPattern(const std::vector<float>& interOnsetIntervals,
+                                                      const float tolerance = 0.0f,
+                                                      const bool includeUnpitched = true) const;
+
+   private:
+    /**
+     * @brief Onsets of a single voice, on the integer tick grid of the score.
+     */
+    struct RhythmStream {
+        int partIdx = 0;
+        int staveIdx = 0;
+        int voice = 1;
+        std::vector<int64_t> onsets;   ///< Onset ticks of the sounding notes (no rests, no tie stops).
+        std::vector<int> measureIdx;   ///< Measure of each onset.
+    };
+
+    /**
+     * @brief Splits the score in voices and collects their onsets.
+     * @param includeUnpitched If true, the percussion (unpitched) parts are included.
+     * @param ticksPerQuarter Output: grid resolution (LCM of all divisions per quarter note).
+     * @return One stream per (part, stave, voice), in this order.
+     */
+    std::vector<RhythmStream> collectRhythmStreams(const bool includeUnpitched,
+                                                   int64_t* ticksPerQuarter) const;
+
+    /**
+     * @brief Searches a rhythmic cell, given in ticks of its own grid, in a set of voices.
+     * @param streams Voices returned by collectRhythmStreams().
+     * @param ticksPerQuarter Grid of the voices.
+     * @param cellIntervals IOIs of the cell.
+     * @param cellTicksPerQuarter Grid of the cell.
+     * @param tolerance Maximum relative deviation of each IOI.
+     */
+    std::vector<RhythmPatternMatch> matchRhythmStreams(const std::vector<RhythmStream>& streams,
+                                                       const int64_t ticksPerQuarter,
+                                                       const std::vector<int64_t>& cellIntervals,
+                                                       const int64_t cellTicksPerQuarter,
+                                                       const float tolerance) const;
+
+    /**
+     * @brief Data of a melody pattern search computed once and shared by the per-part searches.
+     */
+    struct MelodyPatternQuery {
+        const std::vector<Note>* melodyPattern = nullptr;
+        float totalIntervalsSimilarityThreshold = 0.0f;
+        float totalRhythmSimilarityThreshold = 0.0f;
+        std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+            intervalsSimilarityCallback;
+        std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+            rhythmSimilarityCallback;
+        std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback;
+        std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback;
+        std::function<float(float, float)> totalSimilarityCallback;
+
+        bool useDefaultIntervals = false;  ///< Default interval similarity: index and integer kernel.
+        bool useDefaultRhythm = false;     ///< Default rhythm similarity: duration kernel.
+        int numPatternIntervals = 0;
+        std::vector<int> patternIntervals;
+        std::vector<float> patternDurations;
+        float patternMaxDuration = 0.0f;
+        const Note* patternFirstNoteOn = nullptr;  ///< First non-rest note of the pattern.
+        bool useIndex = false;  ///< Candidates come from the interval n-gram posting lists.
+        int numBlocks = 0;      ///< Number of pattern interval blocks (allowed mismatches + 1).
+        int blockSize = 0;      ///< Number of intervals of each block.
+
+        MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN;
+        int warpingWindow = 0;  ///< DTW band, in notes.
+        std::vector<int> patternContour;  ///< Semitones from the first pattern note (DTW).
+        double maxDtwDistance = 0.0;  ///< Largest DTW distance above the interval threshold.
+
+        bool needsDifferences = true;  ///< False for the sinks that only use MelodyPatternMatch.
+    };
+
+    /**
+     * @brief Validates a melody pattern and precomputes its search data.
+     * @return MelodyPatternQuery that references `melodyPattern`.
+     */
+    MelodyPatternQuery prepareMelodyPatternQuery(
+        const std::vector<Note>& melodyPattern, const float totalIntervalsSimilarityThreshold,
+        const float totalRhythmSimilarityThreshold,
+        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>&
+            intervalsSimilarityCallback,
+        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>&
+            rhythmSimilarityCallback,
+        const std::function<float(const std::vector<float>&)>& totalIntervalSimilarityCallback,
+        const std::function<float(const std::vector<float>&)>& totalRhythmSimilarityCallback,
+        const std::function<float(float, float)>& totalSimilarityCallback,
+        const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+        const int warpingWindow = 0) const;
+
+    /**
+     * @brief Receives each accepted segment of a search, with its difference vectors.
+     */
+    typedef std::function<void(const MelodyPatternMatch&, std::vector<float>&, std::vector<float>&)>
+        MelodyPatternEmitter;
+
+    /**
+     * @brief Searches a prepared melody pattern in a single melody stream.
+     * @param query Prepared pattern data.
+     * @param streamIdx Melody stream index.
+     * @param emit Called for each match, in the score order.
+     */
+    void findMelodyPatternInStream(const MelodyPatternQuery& query, const int streamIdx,
+                                   const MelodyPatternEmitter& emit) const;
+
+    /**
+     * @brief Searches a prepared melody pattern in a single melody stream with the DTW metric.
+     * @param query Prepared pattern data.
+     * @param streamIdx Melody stream index.
+     * @param emit Called for each match, in the score order.
+     */
+    void findMelodyPatternInStreamDtw(const MelodyPatternQuery& query, const int streamIdx,
+                                      const MelodyPatternEmitter& emit) const;
+
+    /**
+     * @brief Fills the compact match of an accepted segment.
+     * @param query Prepared pattern data.
+     * @param streamIdx Melody stream index.
+     * @param segmentStart Index of the first segment note in the stream.
+     * @param segmentSize Number of segment notes.
+     * @param totalIntervalSimilarity Interval similarity of the segment.
+     * @param totalRhythmSimilarity Rhythm similarity of the segment.
+     * @return Match with the total similarity of the query.
+     */
+    MelodyPatternMatch makeMelodyPatternMatch(const MelodyPatternQuery& query, const int streamIdx,
+                                              const int segmentStart, const int segmentSize,
+                                              const float totalIntervalSimilarity,
+                                              const float totalRhythmSimilarity) const;
+
+    /**
+     * @brief Builds the result row of a match and appends it to a table.
+     * @param query Prepared pattern data.
+     * @param match Compact match.
+     * @param semitonesDiff Interval differences.
+     * @param durationDiff Duration differences.
+     * @param resultTable Output table.
+     */
+    void appendMelodyPatternRow(const MelodyPatternQuery& query, const MelodyPatternMatch& match,
+                                std::vector<float> semitonesDiff, std::vector<float> durationDiff,
+                                MelodyPatternTable* resultTable) const;
+
+   public:
     /**
      * @brief Extracts vertical chord structures from the score with configurable analysis parameters.
      * @param config Optional JSON configuration object controlling chord extraction criteria.
@@ -753,4 +1391,90 @@ class Score {
      *       - For contrapuntal textures (fugues, inventions): use continuosMode=true
      */
     std::vector<std::tuple<int, float, Key, Chord, bool>> getChords(nlohmann::json config = {});
+
+    /**
+     * @brief Sethares dissonance values of the score vertical chords, stored as parallel arrays.
+     */
+    struct SetharesDissonanceTimeline {
+        std::vector<int> measure;                ///< Measure number of each chord.
+        std::vector<float> floatMeasure;         ///< Chord onset, in measures.
+        std::vector<std::string> keyName;        ///< Key of the measure of each chord.
+        std::vector<float> quarterDuration;      ///< Chord duration, in quarter notes.
+        std::vector<int> chordSize;              ///< Number of notes of each chord.
+        std::vector<std::string> chordNotes;     ///< Chord pitches joined by ", ".
+        std::vector<float> dissonance;           ///< Chord Sethares dissonance.
+        std::vector<uint8_t> isHomophonic;       ///< 1 if all voices of the chord share the same rhythm.
+    };
+
+    /**
+     * @brief Computes the Sethares dissonance of every vertical chord of the score.
+     * @param config Optional JSON configuration object, same as getChords().
+     * @param numPartialsPerNote Number of partials per note.
+     * @param useMinModel If true, uses the minimum amplitude model; otherwise, uses the product.
+     * @param amplCallback Optional: function to modify amplitude vector.
+     * @param partialsDecayExpRate Optional Partials decay exponential rate (default: 0.88).
+     * @param dissCallback Optional: function to aggregate dissonance values (e.g., mean, max).
+     * @param context Optional analysis context with the tuning system and A4 reference frequency
+     *                (default: equal temperament, A4 = 440 Hz).
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @return Timeline with the onset, duration and dissonance of each chord.
+     * @details Native replacement for calling Chord::getSetharesDissonance() on each row of
+     *          getChords(). The chords are extracted once and their dissonance values are
+     *          computed in parallel over chunks of chord slices, writing straight into the
+     *          output arrays. Custom callbacks are supported, but they are called from the
+     *          worker threads and must be thread-safe.
+     */
+    SetharesDissonanceTimeline getSetharesDissonanceTimeline(
+        nlohmann::json config = {}, const int numPartialsPerNote = 6,
+        const bool useMinModel = true,
+        const std::function<std::vector<float>(std::vector<float>)> amplCallback = nullptr,
+        const float partialsDecayExpRate = 0.88f,
+        const std::function<float(std::vector<float>)> dissCallback = nullptr,
+        const AnalysisContext& context = AnalysisContext(), const int numThreads = 0);
+
+    /**
+     * @brief Returns the harmonic sequence of the score: one HarmonicSlice per getChords() chord.
+     * @param config Optional JSON configuration object, same as getChords().
+     * @return Reference to the cached sequence, valid until the next call with another config.
+     * @details The root, quality and degree of each chord are computed once, relative to the key
+     *          of the measure (Measure::getKey()), and cached for the given configuration.
+     */
+    const std::vector<HarmonicSlice>& getHarmonicIndex(nlohmann::json config = {});
+
+    /**
+     * @brief Occurrence of a chord progression found by findChordProgression().
+     */
+    struct ChordProgressionMatch {
+        int firstSliceIdx = 0;           ///< First slice of the occurrence in getHarmonicIndex().
+        int numSlices = 0;               ///< Number of slices of the occurrence.
+        int startMeasure = 0;            ///< Measure number of the first chord (1 = first measure).
+        float startFloatMeasure = 0.0f;  ///< Onset of the first chord, in measures.
+        int endMeasure = 0;              ///< Measure number of the last chord.
+        float endFloatMeasure = 0.0f;    ///< Onset of the last chord, in measures.
+        std::string keyName;             ///< Key of the first chord.
+        std::vector<std::string> rootPitches;   ///< Root of each chord of the progression.
+        std::vector<std::string> qualities;     ///< Quality of each chord of the progression.
+        std::vector<std::string> romanDegrees;  ///< Roman degree of each chord of the progression.
+    };
+
+    /**
+     * @brief Finds a chord progression in the harmonic sequence of the score.
+     * @param progression Progression query (see ChordProgressionQuery), e.g. "II:minor V I".
+     * @param config Optional JSON configuration object, same as getChords().
+     * @param mergeRepeatedChords If true, consecutive slices with the same root and quality are
+     *                            taken as a single chord (e.g. a V chord re-attacked or arpeggiated).
+     * @return Occurrences in ascending order of onset, overlapping included.
+     */
+    std::vector<ChordProgressionMatch> findChordProgression(const std::string& progression,
+                                                            nlohmann::json config = {},
+                                                            const bool mergeRepeatedChords = true);
+
+    /**
+     * @brief Finds a compiled chord progression in the harmonic sequence of the score.
+     * @details Same of findChordProgression(const std::string&, ...), without parsing the query
+     *          again. Useful to search the same progression in many scores.
+     */
+    std::vector<ChordProgressionMatch> findChordProgression(const ChordProgressionQuery& query,
+                                                            nlohmann::json config = {},
+                                                            const bool mergeRepeatedChords = true);
 };
@@ -3,25 +3,70 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <map>
+#include <memory>
 
+#include "maiacore/corpus_pack.h"
+#include "maiacore/directory_scanner.h"
+#include "maiacore/melody_corpus_index.h"
+#include "maiacore/reducers.h"
 #include "maiacore/score.h"
+#include "maiacore/score_descriptor.h"
+#include "maiacore/score_fingerprint.h"
+#include "maiacore/thread_pool.h"
 
 /**
  * @brief Represents a collection of musical scores, supporting batch analysis and management.
  *
  * The ScoreCollection class provides methods for loading, managing, and analyzing multiple Score objects.
  * It is designed for large-scale musicological research, corpus studies, and batch processing of MusicXML files.
+ *
+ * The scores are held by shared handles (ScoreHandle): copying, merging or slicing a collection
+ * (see merge(), getSubCollection() and filter()) copies pointers, and the same score can be in
+ * several collections. A score is copied only when it is changed through a collection that
+ * shares it (copy-on-write, see getScore()).
  */
 class ScoreCollection {
+   public:
+    /**
+     * @brief Shared, immutable handle of a score of the collection.
+     */
+    typedef std::shared_ptr<const Score> ScoreHandle;
+
    private:
     std::vector<std::string> _directoriesPaths; ///< List of directories containing score files.
-    std::vector<Score> _scores; ///< Vector of loaded Score objects.
+    std::vector<ScoreHandle> _scores; ///< Loaded scores, possibly shared with other collections.
+    DirectoryScanner _scanner; ///< Recursion and glob filters of the directory scans.
+    std::map<std::string, DirectoryScanner::FileInfo> _manifest; ///< Loaded files of the directories, by path.
+    std::shared_ptr<MelodyCorpusIndex> _melodyIndex; ///< Persistent melody index (null if not built).
+    std::vector<int> _melodyIndexEntries; ///< Melody index entry of each score.
+    bool _fingerprintOnLoad = false; ///< If true, the new scores are fingerprinted when added.
+    bool _descriptorOnLoad = false; ///< If true, the descriptors of the new scores are computed when added.
+    std::shared_ptr<ScoreDescriptorIndex> _descriptorIndex; ///< Descriptor index (null if not built).
 
+   public:
     /**
-     * @brief Loads all MusicXML files from the specified directories into the collection.
-     * @details Scans each directory for .xml, .mxl, and .musicxml files and loads them as Score objects.
+     * @brief Files changed by refresh() or addDirectory().
      */
-    void loadCollectionFiles();
+    struct RefreshSummary {
+        std::vector<std::string> addedFiles;     ///< New files, loaded and appended.
+        std::vector<std::string> removedFiles;   ///< Deleted files, whose scores were removed.
+        std::vector<std::string> reloadedFiles;  ///< Modified files, parsed again in place.
+    };
+
+   private:
+    /**
+     * @brief Updates the collection to a list of scanned files.
+     * @details Files missing from the manifest are loaded; files whose size or write time changed
+     *          are hashed and parsed again only if the content changed. The files are parsed in
+     *          parallel and the collection only changes after all of them are loaded.
+     * @param files Scanned files (see DirectoryScanner::scan()).
+     * @param removeMissing If true, the scores of the manifest files missing from 'files' are
+     *                      removed.
+     * @param numThreads Number of threads used to hash and parse the files.
+     */
+    RefreshSummary applyScan(const std::vector<DirectoryScanner::FileInfo>& files,
+                             const bool removeMissing, const int numThreads);
 
     /**
      * @brief Row type for extended melodic pattern search results (single pattern).
@@ -39,6 +84,89 @@ class ScoreCollection {
                    std::vector<float>, std::vector<float>, float, float, float> ExtendedMultiMelodyPatternRow;
     typedef std::vector<ExtendedMultiMelodyPatternRow> ExtendedMultiMelodyPatternTable;
 
+    /**
+     * @brief Prepends the file name, composer name and title of a score to a result row.
+     */
+    static ExtendedMelodyPatternRow extendMelodyPatternRow(const Score& score,
+                                                           Score::MelodyPatternRow row);
+
+    /**
+     * @brief Prepends the metadata of a melody index entry to a result row.
+     */
+    static ExtendedMelodyPatternRow extendMelodyPatternRow(const MelodyCorpusIndex::ScoreInfo& info,
+                                                           Score::MelodyPatternRow row);
+
+    /**
+     * @brief Searches a melodic pattern in the melody index (default similarities, EUCLIDEAN).
+     * @param melodyPattern Melodic pattern (at least 2 notes).
+     * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
+     * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
+     * @param numThreads Number of threads.
+     * @param skippedFileNames If not null, receives the file names of the entries with fewer notes
+     *                         than the pattern, in result order; if null, such an entry throws.
+     * @return Result rows of each position (see getMelodyIndexOrder()).
+     */
+    std::vector<ExtendedMelodyPatternTable> findMelodyPatternInIndex(
+        const std::vector<Note>& melodyPattern, const float totalIntervalsSimilarityThreshold,
+        const float totalRhythmSimilarityThreshold, const int numThreads,
+        std::vector<std::string>* skippedFileNames) const;
+
+    /**
+     * @brief Adds the scores from 'firstScoreIdx' on to the melody and descriptor indexes, if
+     *        there are any, and fingerprints or describes them if enabled on load.
+     */
+    void indexScores(const size_t firstScoreIdx, const int numThreads = 0);
+
+    /**
+     * @brief Computes the fingerprints of the scores from 'firstScoreIdx' on, in parallel.
+     * @details The fingerprint is a cache of the score (see Score::getFingerprint()): it is filled
+     *          once per distinct score, in the shared scores too.
+     */
+    void fingerprintScores(const size_t firstScoreIdx, const int numThreads) const;
+
+    /**
+     * @brief Returns the LSH index of the fingerprints of all scores (ids are score indices).
+     */
+    NearDuplicateIndex buildNearDuplicateIndex(const int numThreads) const;
+
+    /**
+     * @brief Computes the descriptors of the scores from 'firstScoreIdx' on, in parallel.
+     * @details Like fingerprintScores(), once per distinct score (see Score::getDescriptor()).
+     */
+    void describeScores(const size_t firstScoreIdx, const int numThreads) const;
+
+    /**
+     * @brief Returns the descriptor index, copied first if another collection shares it.
+     */
+    ScoreDescriptorIndex& getMutableDescriptorIndex();
+
+    /**
+     * @brief Returns the nearest scores of a descriptor, in the descriptor index if there is one.
+     */
+    std::vector<std::pair<int, float>> findSimilarScores(const ScoreDescriptor& descriptor,
+                                                         const int k, const int numProbes,
+                                                         const int excludedIdx,
+                                                         const int numThreads) const;
+
+    /**
+     * @brief Returns the melody index, copied first if another collection shares it.
+     */
+    MelodyCorpusIndex& getMutableMelodyIndex();
+
+    /**
+     * @brief Returns the first position of each distinct score (a score can be added twice).
+     * @details Parallel loops that fill score caches run once per distinct score: two threads
+     *          must not fill the caches of the same score.
+     */
+    std::vector<size_t> getDistinctScoreIndices() const;
+
+    /**
+     * @brief Returns the position of each melody index entry in the search results.
+     * @details Entries of the scores come in collection order; entries without a loaded score
+     *          (index-only collection) come after them, in entry order.
+     */
+    std::vector<int> getMelodyIndexOrder() const;
+
    public:
     /**
      * @brief Constructs a ScoreCollection from a single directory path.
@@ -59,23 +187,65 @@ class ScoreCollection {
     std::vector<std::string> getDirectoriesPaths() const;
 
     /**
-     * @brief Sets the list of directory paths and reloads the collection.
+     * @brief Sets the list of directory paths and updates the collection (see refresh()).
+     * @details Files already loaded are kept; the scores of the files that are no longer in any
+     *          directory are removed.
      * @param directoriesPaths Vector of directory path strings.
      */
     void setDirectoriesPaths(const std::vector<std::string>& directoriesPaths);
 
     /**
-     * @brief Adds a directory path to the collection (does not reload files automatically).
+     * @brief Adds a directory path to the collection and loads its new files.
      * @param directoryPath Directory path string.
+     * @return Loaded files.
+     */
+    RefreshSummary addDirectory(const std::string& directoryPath);
+
+    /**
+     * @brief Sets how the directories are scanned. Takes effect on the next refresh().
+     * @param recursive If true, the subdirectories are also scanned.
+     * @param includeGlobs Patterns of the loaded files (see DirectoryScanner for the syntax).
+     * @param excludeGlobs Patterns of the skipped files and subdirectories.
+     */
+    void setScanOptions(const bool recursive,
+                        const std::vector<std::string>& includeGlobs = {"*.xml", "*.mxl", "*.musicxml"},
+                        const std::vector<std::string>& excludeGlobs = {});
+
+    /**
+     * @brief Returns the scanner of the directories (recursion and glob filters).
      */
-    void addDirectory(const std::string& directoryPath);
+    const DirectoryScanner& getDirectoryScanner() const;
 
     /**
-     * @brief Adds a Score object to the collection.
+     * @brief Scans the directories again and applies only the changes.
+     * @details The manifest records the path, size, write time and content hash of each loaded
+     *          file. New files are loaded and appended, the scores of deleted files are removed
+     *          and modified files (different size or write time, and different hash) are parsed
+     *          again in place; the other scores are not touched. Scores added with addScore() are
+     *          not in the manifest and are kept, and files whose scores were removed with
+     *          removeScore() are not loaded again. The melody index, if any, is updated.
+     * @param numThreads Number of threads used to hash and parse the files.
+     * @return Changed files.
+     */
+    RefreshSummary refresh(const int numThreads = 0);
+
+    /**
+     * @brief Returns the manifest of the loaded directory files, sorted by path.
+     */
+    std::vector<DirectoryScanner::FileInfo> getManifest() const;
+
+    /**
+     * @brief Adds a copy of a Score object to the collection.
      * @param score Score object to add.
      */
     void addScore(const Score& score);
 
+    /**
+     * @brief Adds a shared score to the collection, without copying it.
+     * @param score Score handle (e.g. from getScores() of another collection). Must not be null.
+     */
+    void addScore(ScoreHandle score);
+
     /**
      * @brief Loads a Score from a file path and adds it to the collection.
      * @param filePath Path to a MusicXML file.
@@ -88,6 +258,33 @@ class ScoreCollection {
      */
     void addScore(const std::vector<std::string>& filePaths);
 
+    /**
+     * @brief Loads scores of a corpus pack and adds them to the collection.
+     * @details The scores are parsed in parallel from the mapped pack (see CorpusPack): select
+     *          them first by metadata with CorpusPack::selectScores() to parse only those.
+     * @param pack Opened corpus pack.
+     * @param scoreIndices Indices of the scores in the pack (empty: all the scores).
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     */
+    void loadPack(const CorpusPack& pack, const std::vector<int>& scoreIndices = {},
+                  const int numThreads = 0);
+
+    /**
+     * @brief Opens a corpus pack file and loads its scores (see loadPack(const CorpusPack&)).
+     * @param packPath Path of the pack file.
+     * @param scoreIndices Indices of the scores in the pack (empty: all the scores).
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     */
+    void loadPack(const std::string& packPath, const std::vector<int>& scoreIndices = {},
+                  const int numThreads = 0);
+
+    /**
+     * @brief Saves the scores of the collection to a corpus pack file (see CorpusPack::save()).
+     * @param packPath Path of the pack file.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     */
+    void savePack(const std::string& packPath, const int numThreads = 0) const;
+
     /**
      * @brief Removes all scores from the collection.
      */
@@ -106,16 +303,28 @@ class ScoreCollection {
     int getNumScores() const;
 
     /**
-     * @brief Returns a reference to the vector of Score objects (modifiable).
-     * @return Reference to vector of Score.
+     * @brief Returns the shared handles of the scores.
+     * @details The handles keep the scores alive after they leave the collection and can be added
+     *          to other collections without copies (see addScore(ScoreHandle)). Use getScore() to
+     *          change a score.
+     * @return Const reference to the vector of score handles.
+     */
+    const std::vector<ScoreHandle>& getScores() const;
+
+    /**
+     * @brief Returns a score of the collection.
+     * @param scoreIdx Index of the score.
      */
-    std::vector<Score>& getScores();
+    const Score& getScore(const int scoreIdx) const;
 
     /**
-     * @brief Returns a const reference to the vector of Score objects.
-     * @return Const reference to vector of Score.
+     * @brief Returns a score of the collection for changes.
+     * @details Copy-on-write: if the score is shared (with another collection, a copy of this one
+     *          or a handle), it is first copied, so the change is only seen by this collection.
+     *          The reference is valid until the collection changes.
+     * @param scoreIdx Index of the score.
      */
-    const std::vector<Score>& getScores() const;
+    Score& getScore(const int scoreIdx);
 
     /**
      * @brief Returns true if the collection contains no scores.
@@ -125,6 +334,8 @@ class ScoreCollection {
 
     /**
      * @brief Merges another ScoreCollection into this one, combining directories and scores.
+     * @details The scores of 'other' are shared, not copied. Merging a collection with itself
+     *          adds each score a second time.
      * @param other Another ScoreCollection.
      */
     void merge(const ScoreCollection& other);
@@ -135,9 +346,91 @@ class ScoreCollection {
      */
     void removeScore(const int scoreIdx);
 
+    /**
+     * @brief Returns a new collection with some scores of this one, shared without copies.
+     * @details The sub-collection has no directories, manifest nor melody index: refresh() does
+     *          not change its scores and buildMelodyIndex() indexes them.
+     * @param scoreIndices Indices of the scores, in the order of the new collection.
+     */
+    ScoreCollection getSubCollection(const std::vector<int>& scoreIndices) const;
+
+    /**
+     * @brief Returns a new collection with the scores that satisfy a predicate, shared without
+     *        copies (e.g. the scores of a composer or a period).
+     * @details The predicate is called in parallel, like forEachScoreParallel(). The new
+     *          collection is like a getSubCollection() and keeps the collection order.
+     * @param predicate Function that returns true for the kept scores.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     */
+    ScoreCollection filter(const std::function<bool(const Score&)>& predicate,
+                           const int numThreads = 0) const;
+
+    /**
+     * @brief Calls a function for every score, in parallel.
+     * @details Each score is a task of the thread pool (see ThreadPool). The function is called
+     *          from the worker threads: it must only write to per-score locations, or use
+     *          mapReduce() to accumulate results.
+     * @param function Function called with the score index and the score.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     */
+    void forEachScoreParallel(const std::function<void(int, const Score&)>& function,
+                              const int numThreads = 0) const;
+
+    /**
+     * @brief Calls a function for every score, in parallel, with write access to the scores.
+     * @details Same as the const overload, for per-score methods that fill a cache (e.g.
+     *          Score::getChords()). Each call must only change its own score. The shared scores
+     *          are copied first, like getScore(), and a score added twice is copied once per
+     *          position.
+     */
+    void forEachScoreParallel(const std::function<void(int, Score&)>& function,
+                              const int numThreads = 0);
+
+    /**
+     * @brief Computes a statistic of the whole collection in parallel (map/reduce).
+     * @details Calls `map(scoreIdx, score, accumulator)` for every score, with one accumulator per
+     *          worker thread, and merges the accumulators at the end (see ThreadPool::mapReduce()).
+     *          reducers.h provides counters (CounterReducer), histograms (HistogramReducer) and
+     *          ordered concatenations (ConcatenationReducer); any type with a
+     *          `merge(Accumulator&&)` method works.
+     *
+     *          Example: `collection.mapReduce([](int, const Score& score,
+     *          CounterReducer<std::string>& composers) { composers.add(score.getComposerName()); },
+     *          CounterReducer<std::string>())`.
+     * @param map Function called with the score index, the score and the worker accumulator.
+     * @param initial Initial value of every accumulator (must be neutral).
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @return Merged accumulator.
+     */
+    template <typename Accumulator, typename Map>
+    Accumulator mapReduce(const Map& map, const Accumulator& initial,
+                          const int numThreads = 0) const {
+        return ThreadPool::mapReduce(
+            _scores.size(),
+            [&](const size_t scoreIdx, Accumulator& accumulator) {
+                map(static_cast<int>(scoreIdx), *_scores[scoreIdx], accumulator);
+            },
+            initial, numThreads, 1);
+    }
+
     /**
      * @brief Searches for a melodic pattern in all scores, returning extended results.
      * @details Each result row includes file metadata and all fields from Score::MelodyPatternRow.
+     *
+     *          The search runs on a work-stealing thread pool (see ThreadPool). The melody search
+     *          index of each score is built first, one score per task; then each score is a search
+     *          task, and large scores are split in one task per melody stream (see
+     *          Score::findMelodyPatternInStream()), so a few big scores do not keep a single thread
+     *          busy. Each worker appends its rows to its own accumulator and the accumulators are
+     *          merged at the end, without locks (see ThreadPool::mapReduce()). With
+     *          `deterministicOrder` the rows are in collection order, the same of a sequential
+     *          search; otherwise they are in merge order, which skips the ordering of the rows.
+     *
+     *          Custom similarity callbacks are called from the worker threads: they must be
+     *          thread safe (Python callbacks are serialized by the interpreter lock).
+     *
+     *          With a melody index (see buildMelodyIndex()), patterns of at least 2 notes without
+     *          custom callbacks and with the EUCLIDEAN metric are searched in the index.
      * @param melodyPattern Vector of Note objects representing the pattern.
      * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
      * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
@@ -146,6 +439,10 @@ class ScoreCollection {
      * @param totalIntervalSimilarityCallback Function to aggregate interval similarity.
      * @param totalRhythmSimilarityCallback Function to aggregate rhythm similarity.
      * @param totalSimilarityCallback Function to combine total similarities.
+     * @param metric Similarity metric (see Score::findMelodyPattern()).
+     * @param warpingWindow DTW band, in notes (DTW only).
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @param deterministicOrder If true (default), the rows are in collection order.
      * @return ExtendedMelodyPatternTable with results from all scores.
      */
     ExtendedMelodyPatternTable findMelodyPattern(
@@ -155,11 +452,20 @@ class ScoreCollection {
         const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>& rhythmSimilarityCallback = nullptr,
         const std::function<float(const std::vector<float>&)>& totalIntervalSimilarityCallback = nullptr,
         const std::function<float(const std::vector<float>&)>& totalRhythmSimilarityCallback = nullptr,
-        const std::function<float(float, float)>& totalSimilarityCallback = nullptr) const;
+        const std::function<float(float, float)>& totalSimilarityCallback = nullptr,
+        const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+        const int warpingWindow = 2, const int numThreads = 0,
+        const bool deterministicOrder = true) const;
 
     /**
      * @brief Searches for multiple melodic patterns in all scores, returning extended results for each pattern.
      * @details Each result row includes pattern index, file metadata, and all fields from Score::MelodyPatternRow.
+     *          Every (pattern, score) pair, or (pattern, melody stream) pair of a large score, is a
+     *          task of the same thread pool of the single pattern search. A pattern bigger than a
+     *          score adds no rows for that score and a warning is logged. Other errors (e.g. an
+     *          exception thrown by a similarity callback) stop the search and the first one is
+     *          rethrown.
+     *          Uses the melody index like the single pattern search.
      * @param melodyPatterns Vector of melodic patterns (each a vector of Note).
      * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
      * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
@@ -168,7 +474,12 @@ class ScoreCollection {
      * @param totalIntervalSimilarityCallback Function to aggregate interval similarity.
      * @param totalRhythmSimilarityCallback Function to aggregate rhythm similarity.
      * @param totalSimilarityCallback Function to combine total similarities.
-     * @return Vector of ExtendedMultiMelodyPatternTable, one for each pattern.
+     * @param metric Similarity metric (see Score::findMelodyPattern()).
+     * @param warpingWindow DTW band, in notes (DTW only).
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @param deterministicOrder If true (default), the rows of each table are sorted by pattern,
+     *                           then in score order; otherwise they are in completion order.
+     * @return Vector of ExtendedMultiMelodyPatternTable, one for each score.
      */
     std::vector<ExtendedMultiMelodyPatternTable> findMelodyPattern(
         const std::vector<std::vector<Note>>& melodyPatterns, const float totalIntervalsSimilarityThreshold = 0.5f,
@@ -177,10 +488,259 @@ class ScoreCollection {
         const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>& rhythmSimilarityCallback = nullptr,
         const std::function<float(const std::vector<float>&)>& totalIntervalSimilarityCallback = nullptr,
         const std::function<float(const std::vector<float>&)>& totalRhythmSimilarityCallback = nullptr,
-        const std::function<float(float, float)>& totalSimilarityCallback = nullptr) const;
+        const std::function<float(float, float)>& totalSimilarityCallback = nullptr,
+        const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+        const int warpingWindow = 2, const int numThreads = 0,
+        const bool deterministicOrder = true) const;
+
+    /**
+     * @brief Streaming sink of findMelodyPatternMatches(): score index and compact match.
+     */
+    typedef std::function<void(int, const Score::MelodyPatternMatch&)> MelodyPatternMatchCallback;
+
+    /**
+     * @brief Streams the matches of a melodic pattern in all scores to a callback.
+     * @details Uses Score::findMelodyPatternMatches(): no result table is built, so memory does
+     *          not grow with the number of matches. Score metadata can be read from
+     *          getScore(scoreIdx).
+     * @param melodyPattern Vector of Note objects representing the pattern.
+     * @param callback Function called with the score index and each match, in collection order.
+     * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
+     * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
+     * @param metric Similarity metric (see Score::findMelodyPattern()).
+     * @param warpingWindow DTW band, in notes (DTW only).
+     */
+    void findMelodyPatternMatches(const std::vector<Note>& melodyPattern,
+                                  const MelodyPatternMatchCallback& callback,
+                                  const float totalIntervalsSimilarityThreshold = 0.5f,
+                                  const float totalRhythmSimilarityThreshold = 0.5f,
+                                  const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+                                  const int warpingWindow = 2) const;
+
+    /**
+     * @brief Counts the matches of a melodic pattern in all scores (count-only sink).
+     * @return Number of rows that findMelodyPattern() would return.
+     */
+    size_t countMelodyPattern(const std::vector<Note>& melodyPattern,
+                              const float totalIntervalsSimilarityThreshold = 0.5f,
+                              const float totalRhythmSimilarityThreshold = 0.5f,
+                              const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+                              const int warpingWindow = 2) const;
+
+    /**
+     * @brief Returns the k best matches of a melodic pattern in the whole collection.
+     * @details Each score keeps its own top-k heap (Score::findTopMelodyPattern()) and a global
+     *          bounded heap merges them, so at most 2k rows exist at any time. Ties are resolved
+     *          by collection order.
+     * @param melodyPattern Vector of Note objects representing the pattern.
+     * @param k Maximum number of rows.
+     * @param totalIntervalsSimilarityThreshold Minimum interval similarity threshold.
+     * @param totalRhythmSimilarityThreshold Minimum rhythm similarity threshold.
+     * @param metric Similarity metric (see Score::findMelodyPattern()).
+     * @param warpingWindow DTW band, in notes (DTW only).
+     * @return Up to k rows, sorted by descending total similarity.
+     */
+    ExtendedMelodyPatternTable findTopMelodyPattern(
+        const std::vector<Note>& melodyPattern, const size_t k,
+        const float totalIntervalsSimilarityThreshold = 0.5f,
+        const float totalRhythmSimilarityThreshold = 0.5f,
+        const MelodySimilarityMetric metric = MelodySimilarityMetric::EUCLIDEAN,
+        const int warpingWindow = 2) const;
+
+    /**
+     * @brief Searches a melody expression in all scores, in parallel.
+     * @details The expression is compiled once (see MelodyRegex for the grammar) and each score is
+     *          scanned by Score::findMelodyRegex() on a worker thread.
+     * @param pattern Melody expression, e.g. `[i=+3] [same]* [i=-2..-1]`.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @return Matches of each score, indexed by score and in collection order.
+     */
+    std::vector<std::vector<Score::MelodyRegexMatch>> findMelodyRegex(
+        const std::string& pattern, const int numThreads = 0) const;
+
+    /**
+     * @brief Searches a chord progression in all scores, in parallel.
+     * @details The progression is compiled once (see ChordProgressionQuery for the grammar) and
+     *          each score is scanned by Score::findChordProgression() on a worker thread. The
+     *          harmonic index of each score is cached, so later queries with the same config only
+     *          scan the chord sequences. Filling the cache changes the score, so the scores shared
+     *          with other collections are copied first, like getScore().
+     * @param progression Progression query, e.g. `II:minor V:major I` or `@ @+5 @+5`.
+     * @param config Optional JSON configuration object, same as Score::getChords().
+     * @param mergeRepeatedChords If true, consecutive slices with the same root and quality are
+     *                            taken as a single chord.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @return Matches of each score, indexed by score and in collection order.
+     */
+    std::vector<std::vector<Score::ChordProgressionMatch>> findChordProgression(
+        const std::string& progression, const nlohmann::json& config = {},
+        const bool mergeRepeatedChords = true, const int numThreads = 0);
+
+    /**
+     * @brief Builds the persistent melody index of the collection.
+     * @details The index (see MelodyCorpusIndex) stores the melody streams and the interval n-gram
+     *          posting lists of every score. While the collection has an index, findMelodyPattern()
+     *          searches it instead of the scores when there are no custom similarity callbacks and
+     *          the metric is EUCLIDEAN; the rows are the same. addScore(), removeScore(), merge()
+     *          and the directory loading keep the index up to date, indexing only the new scores.
+     *
+     *          Changes made to the scores through getScore(), including setMelodyStreams(), are
+     *          not seen by the index: call buildMelodyIndex() again after them.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     */
+    void buildMelodyIndex(const int numThreads = 0);
+
+    /**
+     * @brief Saves the melody index to a file, compacted. Throws if the collection has no index.
+     * @param filePath Path of the index file.
+     */
+    void saveMelodyIndex(const std::string& filePath) const;
+
+    /**
+     * @brief Opens a melody index saved by saveMelodyIndex(). The file is memory mapped.
+     * @details On an empty collection, the index alone answers findMelodyPattern() (with the
+     *          default similarities), without loading any score. Otherwise the index is updated to
+     *          the collection: each score is matched to an entry with the same file name and
+     *          number of notes, the other entries are removed and the unmatched scores are
+     *          indexed.
+     * @param filePath Path of the index file.
+     * @param numThreads Number of threads used to index the unmatched scores.
+     */
+    void loadMelodyIndex(const std::string& filePath, const int numThreads = 0);
+
+    /**
+     * @brief Returns true if the collection has a melody index.
+     */
+    bool hasMelodyIndex() const;
+
+    /**
+     * @brief Drops the melody index: findMelodyPattern() scans the scores again.
+     */
+    void clearMelodyIndex();
+
+    /**
+     * @brief Returns the melody index (null if the collection has none).
+     */
+    std::shared_ptr<const MelodyCorpusIndex> getMelodyIndex() const;
+
+    /**
+     * @brief Enables the fingerprinting stage of the loading.
+     * @details When enabled, the fingerprint of each loaded or added score (see
+     *          Score::getFingerprint()) is computed in parallel right after it is parsed, and the
+     *          scores already in the collection are fingerprinted now. Otherwise the fingerprints
+     *          are computed by the first near-duplicate query.
+     * @param enable True to fingerprint the scores on load.
+     * @param numThreads Number of threads used to fingerprint the scores already loaded.
+     */
+    void setFingerprintOnLoad(const bool enable, const int numThreads = 0);
+
+    /**
+     * @brief Returns true if the scores are fingerprinted on load.
+     */
+    bool getFingerprintOnLoad() const;
+
+    /**
+     * @brief Groups the near-duplicate scores of the collection (e.g. the same work encoded by
+     *        different editors, or added twice).
+     * @details The fingerprints are looked up in a NearDuplicateIndex, so only the candidate pairs
+     *          of the LSH bands are compared, not every pair of scores.
+     * @param threshold Minimum estimated similarity (see ScoreFingerprint::estimateSimilarity()).
+     * @param numThreads Number of threads used to fingerprint the scores.
+     * @return Groups of 2 or more score indices, each sorted and ordered by their first index.
+     */
+    std::vector<std::vector<int>> findNearDuplicates(const double threshold = 0.8,
+                                                     const int numThreads = 0) const;
+
+    /**
+     * @brief Returns the scores of the collection that are near duplicates of a score.
+     * @param score Query score (it does not need to be in the collection).
+     * @param threshold Minimum estimated similarity.
+     * @param numThreads Number of threads used to fingerprint the scores.
+     * @return (score index, similarity) pairs, by descending similarity.
+     */
+    std::vector<std::pair<int, double>> findNearDuplicatesOf(const Score& score,
+                                                             const double threshold = 0.8,
+                                                             const int numThreads = 0) const;
+
+    /**
+     * @brief Returns a new collection without the near duplicates, to skip them before expensive
+     *        analyses.
+     * @details Keeps the first score of each group of findNearDuplicates() and all the scores
+     *          without near duplicates. Like getSubCollection(), the scores are shared and keep
+     *          the collection order.
+     * @param threshold Minimum estimated similarity.
+     * @param numThreads Number of threads used to fingerprint the scores.
+     */
+    ScoreCollection withoutNearDuplicates(const double threshold = 0.8,
+                                          const int numThreads = 0) const;
+
+    /**
+     * @brief Enables the computation of the score descriptors on load.
+     * @details When enabled, the descriptor of each loaded or added score (see
+     *          Score::getDescriptor()) is computed in parallel right after it is parsed, and the
+     *          scores already in the collection are described now.
+     * @param enable True to compute the descriptors on load.
+     * @param numThreads Number of threads used to describe the scores already loaded.
+     */
+    void setDescriptorOnLoad(const bool enable, const int numThreads = 0);
+
+    /**
+     * @brief Returns true if the score descriptors are computed on load.
+     */
+    bool getDescriptorOnLoad() const;
+
+    /**
+     * @brief Builds the approximate nearest-neighbor index of the score descriptors.
+     * @details While the collection has an index (see ScoreDescriptorIndex), findSimilarScores()
+     *          only scans the lists of the nearest centroids instead of every score. addScore(),
+     *          removeScore(), merge() and the directory loading keep the index up to date; the
+     *          centroids are only trained again by buildDescriptorIndex().
+     * @param numLists Number of lists (default: 0, the square root of the number of scores).
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     */
+    void buildDescriptorIndex(const int numLists = 0, const int numThreads = 0);
+
+    /**
+     * @brief Returns true if the collection has a descriptor index.
+     */
+    bool hasDescriptorIndex() const;
+
+    /**
+     * @brief Drops the descriptor index: findSimilarScores() compares every score again.
+     */
+    void clearDescriptorIndex();
+
+    /**
+     * @brief Returns the scores of the collection most similar to a score, by the Euclidean
+     *        distance of their descriptors (see ScoreDescriptor).
+     * @details Uses the descriptor index if there is one (approximate); otherwise every score is
+     *          compared (exact).
+     * @param score Query score (it does not need to be in the collection).
+     * @param k Maximum number of results (default: 20).
+     * @param numProbes Number of scanned lists of the descriptor index (default: 8).
+     * @param numThreads Number of threads used to describe the scores.
+     * @return (score index, distance) pairs, by ascending distance.
+     */
+    std::vector<std::pair<int, float>> findSimilarScores(const Score& score, const int k = 20,
+                                                         const int numProbes = 8,
+                                                         const int numThreads = 0) const;
+
+    /**
+     * @brief Returns the scores most similar to a score of the collection, without the score
+     *        itself.
+     * @param scoreIdx Index of the query score.
+     * @param k Maximum number of results (default: 20).
+     * @param numProbes Number of scanned lists of the descriptor index (default: 8).
+     * @param numThreads Number of threads used to describe the scores.
+     * @return (score index, distance) pairs, by ascending distance.
+     */
+    std::vector<std::pair<int, float>> findSimilarScores(const int scoreIdx, const int k = 20,
+                                                         const int numProbes = 8,
+                                                         const int numThreads = 0) const;
 
     /**
      * @brief Merges two ScoreCollections using the + operator.
+     * @details The scores are shared with both collections, without copies.
      * @param other Another ScoreCollection.
      * @return New ScoreCollection containing all scores and directories from both.
      */
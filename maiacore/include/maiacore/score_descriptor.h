@@ -0,0 +1,118 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+class Score;
+
+/**
+ * @file score_descriptor.h
+ * @brief Fixed-length feature vectors of whole scores and their nearest-neighbor index.
+ */
+
+/**
+ * @brief Fixed-length feature vector of a whole score, to compare scores by their content.
+ * @details The values are computed in a single pass over the notes of the pitched parts and are
+ *          grouped in blocks (see getFeatureNames()):
+ *
+ *          - Pitch classes (12): sounding duration of each pitch class (0 = C).
+ *          - Intervals (25): melodic intervals between consecutive attacks of each voice, from -12
+ *            to +12 semitones (the first and last bins also count the larger intervals).
+ *          - Rhythm (8): attacks by quarter duration, rounded in log2 from the 64th to the breve.
+ *          - Chord qualities (11): sounding duration of each quality of the vertical pitch-class
+ *            sets (e.g. major, minor, dominant seventh), from every change of the sounding notes.
+ *          - Texture (4): mean number of sounding notes, attacks per quarter, rest ratio and
+ *            pitch range, scaled to [0, 1].
+ *
+ *          Each histogram block sums to 1 (or is all zeros), so scores of any length are
+ *          comparable by the Euclidean distance of their descriptors.
+ */
+struct ScoreDescriptor {
+    static const int NUM_PITCH_CLASS_BINS = 12;    ///< Size of the pitch-class block.
+    static const int NUM_INTERVAL_BINS = 25;       ///< Size of the interval block.
+    static const int NUM_RHYTHM_BINS = 8;          ///< Size of the rhythm block.
+    static const int NUM_CHORD_QUALITY_BINS = 11;  ///< Size of the chord-quality block.
+    static const int NUM_TEXTURE_BINS = 4;         ///< Size of the texture block.
+    static const int SIZE = NUM_PITCH_CLASS_BINS + NUM_INTERVAL_BINS + NUM_RHYTHM_BINS +
+                            NUM_CHORD_QUALITY_BINS + NUM_TEXTURE_BINS;  ///< Number of values.
+
+    std::vector<float> values;  ///< SIZE values, in the order of getFeatureNames().
+
+    /**
+     * @brief Computes the descriptor of a score.
+     * @details Use Score::getDescriptor() to compute it once per score.
+     */
+    static ScoreDescriptor compute(const Score& score);
+
+    /**
+     * @brief Returns the name of each value, e.g. `pitch_class_C`, `interval_+2`,
+     *        `rhythm_eighth`, `chord_major` or `texture_polyphony`.
+     */
+    static std::vector<std::string> getFeatureNames();
+
+    /**
+     * @brief Returns the Euclidean distance to another descriptor.
+     */
+    float distance(const ScoreDescriptor& other) const;
+};
+
+/**
+ * @brief Approximate nearest-neighbor index of score descriptors (inverted file, IVF).
+ * @details The descriptors are clustered by k-means in `numLists` lists; a query only scans the
+ *          lists of its `numProbes` nearest centroids, so it reads about numProbes / numLists of
+ *          the descriptors. The results are exact when numProbes >= numLists. The values of each
+ *          list are stored contiguously.
+ */
+class ScoreDescriptorIndex {
+   public:
+    /**
+     * @brief Builds the index.
+     * @param descriptors Indexed descriptors (ids are their positions).
+     * @param numLists Number of lists (default: 0, the square root of the number of descriptors).
+     * @param numThreads Number of threads used by the k-means.
+     */
+    explicit ScoreDescriptorIndex(const std::vector<ScoreDescriptor>& descriptors,
+                                  const int numLists = 0, const int numThreads = 0);
+
+    /**
+     * @brief Adds a descriptor to the list of its nearest centroid. The centroids do not change.
+     * @return Id of the descriptor (the number of descriptors before the call).
+     */
+    int add(const ScoreDescriptor& descriptor);
+
+    /**
+     * @brief Removes a descriptor. The ids above it are decremented, like positions in a vector.
+     */
+    void remove(const int id);
+
+    /**
+     * @brief Returns the number of descriptors.
+     */
+    int getNumDescriptors() const;
+
+    /**
+     * @brief Returns the number of lists.
+     */
+    int getNumLists() const;
+
+    /**
+     * @brief Returns the nearest descriptors of a query.
+     * @param query Query descriptor.
+     * @param k Maximum number of results.
+     * @param numProbes Number of scanned lists (default: 8).
+     * @param excludedId Id left out of the results (e.g. the query itself), -1 for none.
+     * @return (id, distance) pairs, by ascending distance (ties by id).
+     */
+    std::vector<std::pair<int, float>> findNearest(const ScoreDescriptor& query, const int k,
+                                                   const int numProbes = 8,
+                                                   const int excludedId = -1) const;
+
+   private:
+    std::vector<float> _centroids;              ///< numLists x SIZE values.
+    std::vector<std::vector<int>> _listIds;     ///< Ids of each list.
+    std::vector<std::vector<float>> _listValues;  ///< Values of each list, SIZE per id.
+    std::vector<int> _listOfId;                 ///< List of each id.
+
+    int findNearestCentroid(const float* values) const;
+};
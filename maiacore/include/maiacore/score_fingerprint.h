@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Score;
+
+/**
+ * @file score_fingerprint.h
+ * @brief MinHash fingerprints of scores and their LSH index, to find near-duplicate encodings.
+ */
+
+/**
+ * @brief MinHash signature of the melodic and rhythmic content of a score.
+ * @details The tokens of a score are the interval n-grams (INTERVAL_GRAM_SIZE consecutive
+ *          semitone intervals) and the rhythm n-grams (RHYTHM_GRAM_SIZE consecutive duration
+ *          ratios, in quarter steps of log2) of each melody stream of the melody search index (see
+ *          Score::setMelodyStreams(); one stream per part by default). The tokens of all the
+ *          streams form a single set, so the order and the splitting of the parts change few
+ *          tokens, and the duration ratios do not depend on the notated note values.
+ *
+ *          The fraction of equal MinHash values of two signatures estimates the Jaccard
+ *          similarity of their token sets: encodings of the same work by different editors share
+ *          most of their tokens.
+ */
+struct ScoreFingerprint {
+    static const int NUM_HASHES = 128;          ///< Number of MinHash values.
+    static const int INTERVAL_GRAM_SIZE = 4;    ///< Intervals of each interval token.
+    static const int RHYTHM_GRAM_SIZE = 4;      ///< Duration ratios of each rhythm token.
+
+    std::vector<uint32_t> minHashes;  ///< NUM_HASHES MinHash values (empty if no tokens).
+    int numTokens = 0;                ///< Number of distinct tokens.
+
+    /**
+     * @brief Computes the fingerprint of a score. Builds its melody search index if needed.
+     * @details Use Score::getFingerprint() to compute it once per score.
+     */
+    static ScoreFingerprint compute(const Score& score);
+
+    /**
+     * @brief Estimates the Jaccard similarity of the token sets of two scores.
+     * @return Value in [0, 1]; 0 if a score has no tokens.
+     */
+    double estimateSimilarity(const ScoreFingerprint& other) const;
+};
+
+/**
+ * @brief Locality-sensitive hashing (LSH) index of score fingerprints.
+ * @details The MinHash values are split in `numBands` bands; two fingerprints are candidates when
+ *          all the values of at least one band are equal. Pairs with similarity s are candidates
+ *          with probability 1 - (1 - s^r)^b, for b bands of r values: the default 32 bands of 4
+ *          values find almost every pair above 0.6 and few below 0.3. The candidates are then
+ *          checked with ScoreFingerprint::estimateSimilarity(), so a query does not compare the
+ *          whole corpus.
+ */
+class NearDuplicateIndex {
+   public:
+    /**
+     * @brief Creates an empty index.
+     * @param numBands Number of bands (must divide ScoreFingerprint::NUM_HASHES).
+     */
+    explicit NearDuplicateIndex(const int numBands = 32);
+
+    /**
+     * @brief Adds a fingerprint.
+     * @return Id of the fingerprint (0, 1, 2... in insertion order).
+     */
+    int add(const ScoreFingerprint& fingerprint);
+
+    /**
+     * @brief Returns the number of fingerprints.
+     */
+    int getNumFingerprints() const;
+
+    /**
+     * @brief Returns the ids of the fingerprints that share a band with a fingerprint, ascending.
+     */
+    std::vector<int> findCandidates(const ScoreFingerprint& fingerprint) const;
+
+    /**
+     * @brief Returns the fingerprints similar to a fingerprint.
+     * @param fingerprint Query fingerprint.
+     * @param threshold Minimum estimated similarity.
+     * @return (id, similarity) pairs, by descending similarity (ties by id).
+     */
+    std::vector<std::pair<int, double>> findSimilar(const ScoreFingerprint& fingerprint,
+                                                    const double threshold) const;
+
+    /**
+     * @brief Groups the fingerprints whose similarity is at least the threshold.
+     * @details Groups are the connected components of the similar pairs. Only groups of 2 or more
+     *          fingerprints are returned, each sorted by id and ordered by their first id.
+     */
+    std::vector<std::vector<int>> getGroups(const double threshold) const;
+
+   private:
+    int _numBands;
+    int _rowsPerBand;
+    std::vector<ScoreFingerprint> _fingerprints;
+    std::vector<std::unordered_map<uint64_t, std::vector<int>>> _buckets;  ///< Per band.
+
+    uint64_t getBandKey(const ScoreFingerprint& fingerprint, const int bandIdx) const;
+};
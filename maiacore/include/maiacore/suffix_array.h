@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @file suffix_array.h
+ * @brief Suffix array and LCP array of integer token sequences, used by the motif discovery.
+ */
+
+/**
+ * @brief Suffix array of a sequence of integer tokens, with its longest common prefix (LCP) array.
+ * @details The suffixes are sorted by prefix doubling with radix sort, in O(n log n), and the LCP
+ *          array is computed with the Kasai algorithm, in O(n). The tokens are usually musical
+ *          events (intervals, durations) mapped to dense ids.
+ *
+ *          A token that occurs only once works as a separator: no repeat can cross it. This is
+ *          used to concatenate independent sequences (e.g. the parts of a score) in a single text.
+ */
+class SuffixArray {
+   public:
+    /**
+     * @brief Repeated substring of the text.
+     */
+    struct Repeat {
+        int length = 0;              ///< Number of tokens of the repeat.
+        std::vector<int> positions;  ///< Start position of each occurrence, in ascending order.
+    };
+
+    /**
+     * @brief Builds the suffix array and the LCP array of a token sequence.
+     * @param text Token sequence. Values must be non-negative.
+     */
+    explicit SuffixArray(const std::vector<int>& text);
+
+    /**
+     * @brief Returns the number of tokens of the text.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the indexed token sequence.
+     */
+    const std::vector<int>& getText() const;
+
+    /**
+     * @brief Returns the start positions of the suffixes in lexicographic order.
+     */
+    const std::vector<int>& getSuffixArray() const;
+
+    /**
+     * @brief Returns the LCP array.
+     * @details lcp[i] is the length of the longest common prefix of the suffixes sa[i - 1] and
+     *          sa[i]. lcp[0] is 0.
+     */
+    const std::vector<int>& getLcpArray() const;
+
+    /**
+     * @brief Returns the maximal repeats of the text.
+     * @details A maximal repeat is a substring that occurs at least twice and cannot be extended
+     *          to the left or to the right without losing an occurrence. Every repeated substring
+     *          is contained in a maximal repeat, so this is the compact answer to "which patterns
+     *          repeat?". They are found in a single pass over the LCP intervals, in O(n) plus the
+     *          size of the output.
+     * @param minLength Minimum number of tokens of a repeat.
+     * @param minNumOccurrences Minimum number of occurrences of a repeat (at least 2).
+     * @return Maximal repeats, ordered by the LCP interval traversal (not by length).
+     */
+    std::vector<Repeat> getMaximalRepeats(const int minLength = 1,
+                                          const int minNumOccurrences = 2) const;
+
+   private:
+    std::vector<int> _text;
+    std::vector<int> _suffixArray;
+    std::vector<int> _lcp;
+};
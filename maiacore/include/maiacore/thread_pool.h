@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+/**
+ * @file thread_pool.h
+ * @brief Work-stealing scheduler for the parallel analysis methods of maiacore.
+ */
+
+/**
+ * @brief Runs independent tasks on a set of worker threads with work stealing.
+ * @details The task indices [0, numTasks) are split in one contiguous range per worker. Each
+ *          worker takes chunks from the front of its own range; when it runs out of work it steals
+ *          the back half of the range of another worker. This keeps all threads busy even when
+ *          the tasks have very different costs (e.g. melody patterns of different sizes).
+ *
+ *          The calling thread is one of the workers. Tasks must write their results to disjoint
+ *          locations (e.g. a pre-sized vector indexed by the task index), so no lock is needed and
+ *          the output order does not depend on the scheduling.
+ */
+class ThreadPool {
+   public:
+    /**
+     * @brief Returns the number of worker threads used for a requested thread count.
+     * @param numThreads Requested number of threads. Values <= 0 select the number of hardware
+     *                   threads.
+     * @return Number of threads (at least 1).
+     */
+    static int getNumThreads(const int numThreads = 0);
+
+    /**
+     * @brief Runs `task(taskIdx)` for every task index in [0, numTasks).
+     * @param numTasks Number of tasks.
+     * @param task Function called once for each task index.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @param chunkSize Number of consecutive tasks taken at once by a worker (default: 0, chosen
+     *                  from the number of tasks and threads).
+     * @details If a task throws, the remaining tasks are skipped and the first exception is
+     *          rethrown in the calling thread after all workers finish.
+     */
+    static void parallelFor(const size_t numTasks, const std::function<void(size_t)>& task,
+                            const int numThreads = 0, const size_t chunkSize = 0);
+
+    /**
+     * @brief Runs `task(taskIdx, workerIdx)` for every task index in [0, numTasks).
+     * @details Same scheduling of parallelFor(). `workerIdx` is in [0, getNumThreads(numThreads))
+     *          and no two tasks with the same `workerIdx` run at the same time, so each worker can
+     *          append to its own buffer without locks.
+     * @param numTasks Number of tasks.
+     * @param task Function called once for each task index, with the index of its worker.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @param chunkSize Number of consecutive tasks taken at once by a worker (default: 0, chosen
+     *                  from the number of tasks and threads).
+     */
+    static void parallelForWithWorker(const size_t numTasks,
+                                      const std::function<void(size_t, size_t)>& task,
+                                      const int numThreads = 0, const size_t chunkSize = 0);
+
+    /**
+     * @brief Runs `map(taskIdx, accumulator)` for every task index, with one accumulator per
+     *        worker, and merges the accumulators at the end.
+     * @details Each worker starts from a copy of `initial`, so it must be neutral (e.g. an empty
+     *          counter or a histogram with the chosen bins). The tasks of a worker write to its own
+     *          accumulator without locks; the accumulators are then merged in worker order with
+     *          `Accumulator::merge(Accumulator&&)` (see reducers.h for the built-in ones).
+     * @param numTasks Number of tasks.
+     * @param map Function called once for each task index with the accumulator of its worker.
+     * @param initial Initial value of every accumulator.
+     * @param numThreads Number of threads (default: 0, the number of hardware threads).
+     * @param chunkSize Number of consecutive tasks taken at once by a worker (default: 0, chosen
+     *                  from the number of tasks and threads).
+     * @return Merged accumulator.
+     */
+    template <typename Accumulator, typename Map>
+    static Accumulator mapReduce(const size_t numTasks, const Map& map, const Accumulator& initial,
+                                 const int numThreads = 0, const size_t chunkSize = 0) {
+        std::vector<Accumulator> accumulators(getNumThreads(numThreads), initial);
+        parallelForWithWorker(numTasks, [&](const size_t taskIdx, const size_t workerIdx) {
+            map(taskIdx, accumulators[workerIdx]);
+        }, numThreads, chunkSize);
+
+        Accumulator result = std::move(accumulators[0]);
+        for (size_t workerIdx = 1; workerIdx < accumulators.size(); workerIdx++) {
+            result.merge(std::move(accumulators[workerIdx]));
+        }
+        return result;
+    }
+};
@@ -3,7 +3,11 @@
 #include <algorithm>  // std::rotate, std::count
 #include <iostream>
 #include <map>
+#include <memory>   // std::shared_ptr
+#include <mutex>    // std::mutex
+#include <numeric>  // std::iota
 #include <set>      // std::set
+#include <tuple>    // std::tie
 #include <utility>  // std::pair
 
 #include "maiacore/constants.h"
@@ -2512,44 +2516,139 @@ std::string Chord::getMeanOfExtremesPitch(const std::string& accType) const {
     return Helper::midiNote2pitch(meanMIDI, accType);
 }
 
+namespace {
+
+std::vector<float> computePartialsDecayWeights(const int numPartials,
+                                               const float partialsDecayExpRate) {
+    // Same values as Note::getHarmonicSpectrum()
+    std::vector<float> weights(numPartials);
+    for (int i = 0; i < numPartials; i++) {
+        weights[i] = std::pow(partialsDecayExpRate, i);
+    }
+    return weights;
+}
+
+// Writes 'notes.size() * weights.size()' partials into 'freqs' and 'ampls'
+void fillNotesPartials(const std::vector<Note>& notes, const std::vector<float>& weights,
+                       const AnalysisContext& context, float* freqs, float* ampls) {
+    const int numPartials = weights.size();
+    for (const auto& note : notes) {
+        const float fundamentalFreq = note.getFrequency(context);
+        for (int i = 0; i < numPartials; i++) {
+            freqs[i] = fundamentalFreq * (i + 1);
+            ampls[i] = weights[i];
+        }
+        freqs += numPartials;
+        ampls += numPartials;
+    }
+}
+
+}  // namespace
+
 std::pair<std::vector<float>, std::vector<float>> Chord::getHarmonicSpectrum(
     const int numPartialsPerNote,
     const std::function<std::vector<float>(std::vector<float>)> amplCallback,
-    const float partialsDecayExpRate) const {
+    const float partialsDecayExpRate, const AnalysisContext& context) const {
     if (numPartialsPerNote <= 0) {
         LOG_ERROR("The 'numPartialsPerNote' must be a positive value");
     }
 
-    std::map<float, float> freqAmplMap;
-
-    for (const auto& note : _originalNotes) {
-        const auto freqsAmplsPair = note.getHarmonicSpectrum(numPartialsPerNote, amplCallback, partialsDecayExpRate);
-
-        for (size_t i = 0; i < freqsAmplsPair.first.size(); ++i) {
-            auto freq = freqsAmplsPair.first[i];
-            auto ampl = freqsAmplsPair.second[i];
+    // Partials of all notes, in notes order
+    const size_t numValues = _originalNotes.size() * numPartialsPerNote;
+    std::vector<float> freqs(numValues);
+    std::vector<float> ampls(numValues);
 
-            freqAmplMap[freq] += ampl;
+    if (amplCallback == nullptr) {
+        fillNotesPartials(_originalNotes,
+                          computePartialsDecayWeights(numPartialsPerNote, partialsDecayExpRate),
+                          context, freqs.data(), ampls.data());
+    } else {
+        for (size_t n = 0; n < _originalNotes.size(); n++) {
+            const auto freqsAmplsPair = _originalNotes[n].getHarmonicSpectrum(
+                numPartialsPerNote, amplCallback, partialsDecayExpRate, context);
+
+            std::copy(freqsAmplsPair.first.begin(), freqsAmplsPair.first.end(),
+                      freqs.begin() + n * numPartialsPerNote);
+            std::copy(freqsAmplsPair.second.begin(), freqsAmplsPair.second.end(),
+                      ampls.begin() + n * numPartialsPerNote);
         }
     }
 
+    // Sort by frequency and sum the amplitudes of coincident partials.
+    // The stable sort keeps the notes order, so the sums are the same of a std::map merge
+    std::vector<size_t> order(numValues);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&freqs](const size_t a, const size_t b) { return freqs[a] < freqs[b]; });
+
     std::vector<float> combinedFrequencies;
     std::vector<float> combinedAmplitudes;
+    combinedFrequencies.reserve(numValues);
+    combinedAmplitudes.reserve(numValues);
 
-    // Extract keys and values from the map to the vectors
-    std::transform(freqAmplMap.begin(), freqAmplMap.end(), std::back_inserter(combinedFrequencies),
-                   [](const std::pair<float, float>& pair) { return pair.first; });
-
-    std::transform(freqAmplMap.begin(), freqAmplMap.end(), std::back_inserter(combinedAmplitudes),
-                   [](const std::pair<float, float>& pair) { return pair.second; });
+    for (const size_t idx : order) {
+        if (!combinedFrequencies.empty() && !(combinedFrequencies.back() < freqs[idx])) {
+            combinedAmplitudes.back() += ampls[idx];
+        } else {
+            combinedFrequencies.push_back(freqs[idx]);
+            combinedAmplitudes.push_back(ampls[idx]);
+        }
+    }
 
     return {combinedFrequencies, combinedAmplitudes};
 }
 
+void Chord::getHarmonicSpectrumBatch(
+    const std::vector<Chord>& chords, HarmonicSpectrumBuffer* buffer,
+    const int numPartialsPerNote, const float partialsDecayExpRate,
+    const std::function<std::vector<float>(const std::vector<float>&)> batchAmplCallback,
+    const AnalysisContext& context) {
+    if (buffer == nullptr) {
+        LOG_ERROR("The 'buffer' must not be null");
+    }
+
+    if (numPartialsPerNote <= 0) {
+        LOG_ERROR("The 'numPartialsPerNote' must be a positive value");
+    }
+
+    const std::vector<float> weights =
+        computePartialsDecayWeights(numPartialsPerNote, partialsDecayExpRate);
+
+    buffer->numPartials = numPartialsPerNote;
+    buffer->chordNoteOffsets.resize(chords.size() + 1);
+
+    size_t numNotes = 0;
+    for (size_t c = 0; c < chords.size(); c++) {
+        buffer->chordNoteOffsets[c] = numNotes;
+        numNotes += chords[c]._originalNotes.size();
+    }
+    buffer->chordNoteOffsets[chords.size()] = numNotes;
+
+    buffer->frequencies.resize(numNotes * numPartialsPerNote);
+    buffer->amplitudes.resize(numNotes * numPartialsPerNote);
+
+    for (size_t c = 0; c < chords.size(); c++) {
+        const size_t offset = buffer->chordNoteOffsets[c] * numPartialsPerNote;
+        fillNotesPartials(chords[c]._originalNotes, weights, context,
+                          buffer->frequencies.data() + offset, buffer->amplitudes.data() + offset);
+    }
+
+    if (batchAmplCallback != nullptr) {
+        buffer->amplitudes = batchAmplCallback(buffer->frequencies);
+
+        if (buffer->amplitudes.size() != buffer->frequencies.size()) {
+            LOG_ERROR(
+                "The output vector of 'batchAmplCallback' function must have the size of the "
+                "input frequencies vector: " +
+                std::to_string(buffer->frequencies.size()));
+        }
+    }
+}
+
 SetharesDissonanceTable Chord::getSetharesDyadsDissonanceValue(
     const int numPartialsPerNote, const bool useMinModel,
     const std::function<std::vector<float>(std::vector<float>)> amplCallback,
-    const float partialsDecayExpRate) const {
+    const float partialsDecayExpRate, const AnalysisContext& context) const {
     /*
     Given a list of partials in fvec, with amplitudes in amp, this routine
     calculates the dissonance by summing the roughness of every sine pair
@@ -2560,7 +2659,8 @@ SetharesDissonanceTable Chord::getSetharesDyadsDissonanceValue(
     of the two amplitudes, since this matches the beat frequency amplitude.
     */
 
-    const auto& freqAmplPair = getHarmonicSpectrum(numPartialsPerNote, amplCallback, partialsDecayExpRate);
+    const auto& freqAmplPair =
+        getHarmonicSpectrum(numPartialsPerNote, amplCallback, partialsDecayExpRate, context);
 
     const std::vector<float>& fvec = freqAmplPair.first;
     const std::vector<float>& amp = freqAmplPair.second;
@@ -2633,30 +2733,242 @@ SetharesDissonanceTable Chord::getSetharesDyadsDissonanceValue(
     return table;
 }
 
+namespace {
+
+constexpr int SETHARES_NUM_MIDI_NOTES = 128;
+
+// Maximum number of cached parameter sets (each one uses ~80KB)
+constexpr size_t SETHARES_MAX_CACHED_TABLES = 32;
+
+/*
+ * Roughness between the default harmonic spectra of every pair of MIDI notes.
+ * With the default spectrum (no 'amplCallback') the chord dissonance only depends on the MIDI
+ * numbers of its notes, so it can be computed as a sum over note pairs instead of partial pairs.
+ */
+struct SetharesDyadsTable {
+    std::vector<float> weights;     // Partials amplitudes: partialsDecayExpRate^i
+    std::vector<float> noteFreqs;   // Fundamental frequency of each MIDI note
+    std::vector<float> self;        // Roughness between the partials of a single note
+    std::vector<float> cross;       // Roughness between the partials of two different notes
+    std::vector<uint8_t> coincide;  // True if two notes share at least one partial frequency
+};
+
+struct SetharesDyadsTableKey {
+    int numPartials;
+    float partialsDecayExpRate;
+    TuningSystem tuningSystem;
+    float freqA4;
+    bool useMinModel;
+
+    bool operator<(const SetharesDyadsTableKey& other) const {
+        return std::tie(numPartials, partialsDecayExpRate, tuningSystem, freqA4, useMinModel) <
+               std::tie(other.numPartials, other.partialsDecayExpRate, other.tuningSystem,
+                        other.freqA4, other.useMinModel);
+    }
+};
+
+// Same Plomp-Levelt curve used by Helper::setharesDissonance()
+inline float setharesRoughness(const float freqA, const float amplA, const float freqB,
+                               const float amplB, const bool useMinModel) {
+    const float Fmin = std::min(freqA, freqB);
+    const float S = 0.24f / (0.0207f * Fmin + 18.96f);
+    const float SFdif = S * std::fabs(freqB - freqA);
+    const float a = (useMinModel) ? std::min(amplA, amplB) : amplA * amplB;
+
+    return a * (5.0f * std::exp(-3.51f * SFdif) - 5.0f * std::exp(-5.75f * SFdif));
+}
+
+// Roughness between the spectra of two notes, with their amplitudes scaled by 'scaleA' and 'scaleB'
+float setharesNotesRoughness(const SetharesDyadsTable& table, const int midiA, const int midiB,
+                             const float scaleA, const float scaleB, const bool useMinModel) {
+    const int numPartials = table.weights.size();
+    const float f0A = table.noteFreqs[midiA];
+    const float f0B = table.noteFreqs[midiB];
+
+    float roughness = 0.0f;
+    for (int k = 0; k < numPartials; k++) {
+        for (int l = 0; l < numPartials; l++) {
+            roughness += setharesRoughness(f0A * (k + 1), scaleA * table.weights[k], f0B * (l + 1),
+                                           scaleB * table.weights[l], useMinModel);
+        }
+    }
+
+    return roughness;
+}
+
+std::shared_ptr<const SetharesDyadsTable> buildSetharesDyadsTable(
+    const SetharesDyadsTableKey& key) {
+    auto table = std::make_shared<SetharesDyadsTable>();
+    const int numPartials = key.numPartials;
+
+    table->weights.resize(numPartials);
+    for (int i = 0; i < numPartials; i++) {
+        table->weights[i] = std::pow(key.partialsDecayExpRate, i);
+    }
+
+    const auto& frequencyTable =
+        AnalysisContext(key.tuningSystem, key.freqA4).getFrequencyTable();
+    table->noteFreqs.assign(frequencyTable.begin(), frequencyTable.end());
+
+    table->self.assign(SETHARES_NUM_MIDI_NOTES, 0.0f);
+    table->cross.assign(SETHARES_NUM_MIDI_NOTES * SETHARES_NUM_MIDI_NOTES, 0.0f);
+    table->coincide.assign(SETHARES_NUM_MIDI_NOTES * SETHARES_NUM_MIDI_NOTES, 0);
+
+    for (int a = 0; a < SETHARES_NUM_MIDI_NOTES; a++) {
+        const float f0A = table->noteFreqs[a];
+
+        float selfRoughness = 0.0f;
+        for (int k = 0; k < numPartials; k++) {
+            for (int l = k + 1; l < numPartials; l++) {
+                selfRoughness += setharesRoughness(f0A * (k + 1), table->weights[k], f0A * (l + 1),
+                                                   table->weights[l], key.useMinModel);
+            }
+        }
+        table->self[a] = selfRoughness;
+
+        for (int b = a; b < SETHARES_NUM_MIDI_NOTES; b++) {
+            const float f0B = table->noteFreqs[b];
+
+            // Same rule as the std::map merge in Chord::getHarmonicSpectrum()
+            bool coincide = false;
+            for (int k = 0; k < numPartials && !coincide; k++) {
+                for (int l = 0; l < numPartials; l++) {
+                    if (f0A * (k + 1) == f0B * (l + 1)) {
+                        coincide = true;
+                        break;
+                    }
+                }
+            }
+
+            const float crossRoughness =
+                setharesNotesRoughness(*table, a, b, 1.0f, 1.0f, key.useMinModel);
+
+            table->cross[a * SETHARES_NUM_MIDI_NOTES + b] = crossRoughness;
+            table->cross[b * SETHARES_NUM_MIDI_NOTES + a] = crossRoughness;
+            table->coincide[a * SETHARES_NUM_MIDI_NOTES + b] = coincide;
+            table->coincide[b * SETHARES_NUM_MIDI_NOTES + a] = coincide;
+        }
+    }
+
+    return table;
+}
+
+std::shared_ptr<const SetharesDyadsTable> getSetharesDyadsTable(const SetharesDyadsTableKey& key) {
+    static std::mutex cacheMutex;
+    static std::map<SetharesDyadsTableKey, std::shared_ptr<const SetharesDyadsTable>> cache;
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        const auto it = cache.find(key);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+
+    // Build outside the lock: concurrent builds of the same key produce identical tables
+    auto table = buildSetharesDyadsTable(key);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cache.size() >= SETHARES_MAX_CACHED_TABLES) {
+        cache.clear();
+    }
+
+    return cache.emplace(key, table).first->second;
+}
+
+}  // namespace
+
+bool Chord::computeSetharesDissonanceFromDyadsTable(const int numPartialsPerNote,
+                                                    const bool useMinModel,
+                                                    const float partialsDecayExpRate,
+                                                    const AnalysisContext& context,
+                                                    float* dissonance) const {
+    // Group unison notes: their merged partials have the amplitudes multiplied by the group size
+    std::map<int, int> midiCount;
+    for (const auto& note : _originalNotes) {
+        const int midi = note.getMidiNumber();
+        if (midi < 0 || midi >= SETHARES_NUM_MIDI_NOTES) {
+            return false;
+        }
+        midiCount[midi]++;
+    }
+
+    const std::vector<std::pair<int, int>> groups(midiCount.begin(), midiCount.end());
+    const int numGroups = groups.size();
+
+    const auto table =
+        getSetharesDyadsTable({numPartialsPerNote, partialsDecayExpRate,
+                               context.getTuningSystem(), context.getFreqA4(), useMinModel});
+
+    // The 'min' model is not linear on the amplitudes: partials shared by two different notes
+    // must be merged before computing the roughness, so use the exact path
+    if (useMinModel) {
+        for (int i = 0; i < numGroups; i++) {
+            for (int j = i + 1; j < numGroups; j++) {
+                if (table->coincide[groups[i].first * SETHARES_NUM_MIDI_NOTES + groups[j].first]) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    float total = 0.0f;
+    for (int i = 0; i < numGroups; i++) {
+        const int midiA = groups[i].first;
+        const float countA = groups[i].second;
+
+        total += (useMinModel) ? countA * table->self[midiA] : countA * countA * table->self[midiA];
+
+        for (int j = i + 1; j < numGroups; j++) {
+            const int midiB = groups[j].first;
+            const float countB = groups[j].second;
+            const float cross = table->cross[midiA * SETHARES_NUM_MIDI_NOTES + midiB];
+
+            if (!useMinModel) {
+                total += countA * countB * cross;
+            } else if (countA == countB) {
+                total += countA * cross;
+            } else {
+                total += setharesNotesRoughness(*table, midiA, midiB, countA, countB, true);
+            }
+        }
+    }
+
+    *dissonance = total;
+    return true;
+}
+
 float Chord::getSetharesDissonance(
     const int numPartialsPerNote, const bool useMinModel,
     const std::function<std::vector<float>(std::vector<float>)> amplCallback,
     const float partialsDecayExpRate,
-    const std::function<float(std::vector<float>)> dissCallback) const {
-    const SetharesDissonanceTable table =
-        getSetharesDyadsDissonanceValue(numPartialsPerNote, useMinModel, amplCallback, partialsDecayExpRate);
+    const std::function<float(std::vector<float>)> dissCallback,
+    const AnalysisContext& context) const {
+    if (numPartialsPerNote <= 0) {
+        LOG_ERROR("The 'numPartialsPerNote' must be a positive value");
+    }
 
-    const int tableSize = table.size();
-    const int dissColIdx = 12;
-    if (dissCallback == nullptr) {
-        float totalDissonance = 0.0f;
-        for (int row = 0; row < tableSize; row++) {
-            totalDissonance += std::get<dissColIdx>(table[row]);
+    // Default spectrum: sum the cached note-pair roughness values
+    if (amplCallback == nullptr && dissCallback == nullptr) {
+        float dissonance = 0.0f;
+        if (computeSetharesDissonanceFromDyadsTable(numPartialsPerNote, useMinModel,
+                                                    partialsDecayExpRate, context, &dissonance)) {
+            return dissonance;
         }
-
-        return totalDissonance;
     }
 
-    std::vector<float> dissonanceVec(tableSize, 0.0f);
-    for (int row = 0; row < tableSize; row++) {
-        dissonanceVec[row] = std::get<dissColIdx>(table[row]);
+    // Exact path: skip the SetharesDissonanceTable and the partials pitch naming
+    const auto freqAmplPair =
+        getHarmonicSpectrum(numPartialsPerNote, amplCallback, partialsDecayExpRate, context);
+
+    if (dissCallback == nullptr) {
+        return Helper::setharesDissonance(freqAmplPair.first, freqAmplPair.second, useMinModel);
     }
 
+    std::vector<float> dissonanceVec;
+    Helper::setharesDissonance(freqAmplPair.first, freqAmplPair.second, useMinModel,
+                               &dissonanceVec);
+
     return dissCallback(dissonanceVec);
 }
 
@@ -1,6 +1,174 @@
 #include "maiacore/config.h"
 
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>  // std::pair
+
+#include "maiacore/helper.h"
+#include "maiacore/log.h"
+
 TuningSystem _tuningSystem = TuningSystem::EQUAL_TEMPERAMENT;
 
 TuningSystem getTuningSystem() { return _tuningSystem; }
-void setTuningSystem(TuningSystem tuningSystem) { _tuningSystem = tuningSystem; }
\ No newline at end of file
+void setTuningSystem(TuningSystem tuningSystem) { _tuningSystem = tuningSystem; }
+
+namespace {
+
+// Pitch class frequency ratios relative to C, for the C major based tunings
+typedef std::array<double, 12> PitchClassRatios;
+
+PitchClassRatios computeFifthsCycleRatios(const double fifthRatio) {
+    // Stack fifths from Eb (-3) to G# (+8), folding each one into the [1, 2) octave
+    PitchClassRatios ratios{};
+    for (int fifths = -3; fifths <= 8; fifths++) {
+        double ratio = std::pow(fifthRatio, fifths);
+        while (ratio >= 2.0) {
+            ratio /= 2.0;
+        }
+        while (ratio < 1.0) {
+            ratio *= 2.0;
+        }
+        const int pitchClass = ((fifths * 7) % 12 + 12) % 12;
+        ratios[pitchClass] = ratio;
+    }
+    return ratios;
+}
+
+PitchClassRatios computeCentsRatios(const std::array<double, 12>& cents) {
+    PitchClassRatios ratios{};
+    for (int pitchClass = 0; pitchClass < 12; pitchClass++) {
+        ratios[pitchClass] = std::pow(2.0, cents[pitchClass] / 1200.0);
+    }
+    return ratios;
+}
+
+PitchClassRatios getPitchClassRatios(const TuningSystem tuningSystem) {
+    switch (tuningSystem) {
+        case TuningSystem::JUST_INTONATION:
+            return {1.0,       16.0 / 15.0, 9.0 / 8.0, 6.0 / 5.0, 5.0 / 4.0,  4.0 / 3.0,
+                    45.0 / 32.0, 3.0 / 2.0, 8.0 / 5.0, 5.0 / 3.0, 16.0 / 9.0, 15.0 / 8.0};
+        case TuningSystem::PYTHAGOREAN_TUNING:
+            return computeFifthsCycleRatios(3.0 / 2.0);
+        case TuningSystem::MEANTONE_TEMPERAMENT:
+            return computeFifthsCycleRatios(std::pow(5.0, 0.25));
+        case TuningSystem::WELL_TEMPERAMENT:
+            // Werckmeister III
+            return computeCentsRatios({0.0, 90.225, 192.18, 294.135, 390.225, 498.045, 588.27,
+                                       696.09, 792.18, 888.27, 996.09, 1092.18});
+        case TuningSystem::EQUAL_TEMPERAMENT:
+        default:
+            return computeCentsRatios(
+                {0.0, 100.0, 200.0, 300.0, 400.0, 500.0, 600.0, 700.0, 800.0, 900.0, 1000.0, 1100.0});
+    }
+}
+
+std::shared_ptr<const AnalysisContext::FrequencyTable> buildFrequencyTable(
+    const TuningSystem tuningSystem, const float freqA4) {
+    auto table = std::make_shared<AnalysisContext::FrequencyTable>();
+
+    // Same values as Helper::midiNote2freq()
+    if (tuningSystem == TuningSystem::EQUAL_TEMPERAMENT) {
+        for (int midiNote = 0; midiNote < 128; midiNote++) {
+            (*table)[midiNote] = Helper::midiNote2freq(midiNote, freqA4);
+        }
+        return table;
+    }
+
+    const PitchClassRatios ratios = getPitchClassRatios(tuningSystem);
+    const int pitchClassA = 9;
+    const int octaveA4 = 4;
+
+    for (int midiNote = 0; midiNote < 128; midiNote++) {
+        const int pitchClass = midiNote % 12;
+        const int octave = midiNote / 12 - 1;
+        const double freq = freqA4 * (ratios[pitchClass] / ratios[pitchClassA]) *
+                            std::pow(2.0, octave - octaveA4);
+        (*table)[midiNote] = static_cast<float>(freq);
+    }
+
+    return table;
+}
+
+// Maximum number of cached frequency tables: a sweep over A4 values must not grow the cache forever
+constexpr size_t MAX_CACHED_FREQUENCY_TABLES = 32;
+
+// Only the non-equal tunings use the cache: equal temperament is computed by Helper::midiNote2freq()
+std::shared_ptr<const AnalysisContext::FrequencyTable> getCachedFrequencyTable(
+    const TuningSystem tuningSystem, const float freqA4) {
+    static std::mutex cacheMutex;
+    static std::map<std::pair<TuningSystem, float>,
+                    std::shared_ptr<const AnalysisContext::FrequencyTable>>
+        cache;
+
+    const std::pair<TuningSystem, float> key(tuningSystem, freqA4);
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        const auto it = cache.find(key);
+        if (it != cache.end()) {
+            return it->second;
+        }
+    }
+
+    // Build outside the lock: concurrent builds of the same key produce identical tables
+    auto table = buildFrequencyTable(tuningSystem, freqA4);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    if (cache.size() >= MAX_CACHED_FREQUENCY_TABLES) {
+        cache.clear();
+    }
+
+    return cache.emplace(key, table).first->second;
+}
+
+}  // namespace
+
+AnalysisContext::AnalysisContext(const TuningSystem tuningSystem, const float freqA4)
+    : _tuningSystem(tuningSystem), _freqA4(freqA4) {
+    if (!std::isfinite(freqA4) || freqA4 <= 0.0f) {
+        LOG_ERROR("The A4 reference frequency must be a positive value");
+    }
+
+    // Default context: shared table, no lock needed
+    if (tuningSystem == TuningSystem::EQUAL_TEMPERAMENT) {
+        if (freqA4 == 440.0f) {
+            static const auto defaultTable =
+                buildFrequencyTable(TuningSystem::EQUAL_TEMPERAMENT, 440.0f);
+            _frequencyTable = defaultTable;
+        }
+        return;
+    }
+
+    _frequencyTable = getCachedFrequencyTable(tuningSystem, freqA4);
+}
+
+TuningSystem AnalysisContext::getTuningSystem() const { return _tuningSystem; }
+
+float AnalysisContext::getFreqA4() const { return _freqA4; }
+
+float AnalysisContext::getFrequency(const int midiNote) const {
+    if (midiNote < 0) {
+        return 0.0f;
+    }  // rest
+
+    if (_tuningSystem == TuningSystem::EQUAL_TEMPERAMENT) {
+        return (midiNote < 128 && _frequencyTable != nullptr)
+                   ? (*_frequencyTable)[midiNote]
+                   : Helper::midiNote2freq(midiNote, _freqA4);
+    }
+
+    if (midiNote < 128) {
+        return (*_frequencyTable)[midiNote];
+    }
+
+    // Above the MIDI range: transpose the highest octave of the table
+    const int octavesAbove = (midiNote - 116) / 12;
+    return (*_frequencyTable)[midiNote - 12 * octavesAbove] * std::pow(2.0f, octavesAbove);
+}
+
+AnalysisContext::FrequencyTable AnalysisContext::getFrequencyTable() const {
+    if (_frequencyTable == nullptr) {
+        return *buildFrequencyTable(_tuningSystem, _freqA4);
+    }
+    return *_frequencyTable;
+}
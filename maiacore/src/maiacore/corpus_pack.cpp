@@ -0,0 +1,351 @@
+#include "maiacore/corpus_pack.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <utility>
+
+#include "maiacore/log.h"
+#include "maiacore/mapped_file.h"
+#include "maiacore/thread_pool.h"
+
+namespace {
+
+const char PACK_MAGIC[8] = {'M', 'A', 'I', 'A', 'P', 'C', 'K', '\0'};
+const uint32_t PACK_VERSION = 1;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// Scores loaded per thread before a batch is written
+const size_t SCORES_PER_THREAD_PER_BATCH = 8;
+
+uint64_t alignTo8(const uint64_t pos) { return (pos + 7) & ~uint64_t{7}; }
+
+}  // namespace
+
+// ===== FORMATO DO ARQUIVO ===== //
+// Header, documents, then the index (8-byte aligned sections, native byte order)
+struct CorpusPack::FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint64_t numScores;
+    uint64_t numStrings;
+    uint64_t entriesPos;        // EntryRecord[numScores]
+    uint64_t stringOffsetsPos;  // uint64_t[numStrings + 1]
+    uint64_t stringDataPos;     // char[]
+    uint64_t fileSize;
+};
+
+struct CorpusPack::EntryRecord {
+    uint32_t filePathId;
+    uint32_t fileNameId;
+    uint32_t titleId;
+    uint32_t composerNameId;
+    uint32_t firstPartNameId;  // Part names: numParts consecutive ids in the part name list
+    uint32_t numParts;
+    uint32_t numMeasures;
+    uint32_t numNotes;
+    uint64_t documentPos;
+    uint64_t documentSize;
+};
+
+CorpusPack::CorpusPack(const std::string& filePath)
+    : _filePath(filePath), _file(std::make_shared<MappedFile>(filePath)) {
+    const char* data = _file->data();
+    const size_t size = _file->size();
+    const std::string error = "Invalid corpus pack file '" + filePath + "': ";
+    if (size < sizeof(FileHeader)) {
+        LOG_ERROR(error + "truncated header");
+    }
+
+    _header = reinterpret_cast<const FileHeader*>(data);
+    if (std::memcmp(_header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0) {
+        LOG_ERROR(error + "not a corpus pack");
+    }
+    if (_header->byteOrderMark != BYTE_ORDER_MARK) {
+        LOG_ERROR(error + "saved with a different byte order");
+    }
+    if (_header->version != PACK_VERSION) {
+        LOG_ERROR(error + "unsupported version " + std::to_string(_header->version));
+    }
+    if (_header->fileSize != size) {
+        LOG_ERROR(error + "truncated file");
+    }
+
+    // Every section must lie inside the file
+    const auto section = [&](const uint64_t pos, const uint64_t count, const size_t itemSize) {
+        if (pos % 8 != 0 || pos > size || count > (size - pos) / itemSize) {
+            LOG_ERROR(error + "corrupted section table");
+        }
+        return data + pos;
+    };
+
+    const FileHeader& h = *_header;
+    _entries = reinterpret_cast<const EntryRecord*>(
+        section(h.entriesPos, h.numScores, sizeof(EntryRecord)));
+    _stringOffsets = reinterpret_cast<const uint64_t*>(
+        section(h.stringOffsetsPos, h.numStrings + 1, sizeof(uint64_t)));
+    _stringData = section(h.stringDataPos, _stringOffsets[h.numStrings], 1);
+
+    for (uint64_t scoreIdx = 0; scoreIdx < h.numScores; scoreIdx++) {
+        const EntryRecord& entry = _entries[scoreIdx];
+        const uint64_t maxStringId =
+            std::max({entry.filePathId, entry.fileNameId, entry.titleId, entry.composerNameId});
+        const uint64_t partNamesEnd = uint64_t{entry.firstPartNameId} + entry.numParts;
+        if (maxStringId >= h.numStrings || partNamesEnd > h.numStrings ||
+            entry.documentPos > size ||
+            entry.documentSize > size - entry.documentPos) {
+            LOG_ERROR(error + "corrupted entry " + std::to_string(scoreIdx));
+        }
+    }
+}
+
+CorpusPack::~CorpusPack() = default;
+
+void CorpusPack::save(const std::vector<const Score*>& scores, const std::string& filePath,
+                      const int numThreads) {
+    // Non-owning handles: the caller keeps the scores alive
+    write(filePath, scores.size(), [&scores](const size_t scoreIdx) {
+        return std::shared_ptr<const Score>(std::shared_ptr<const Score>(), scores[scoreIdx]);
+    }, numThreads);
+}
+
+int CorpusPack::build(const std::string& directoryPath, const std::string& packPath,
+                      const DirectoryScanner& scanner, const int numThreads) {
+    const std::vector<DirectoryScanner::FileInfo> files = scanner.scan(directoryPath);
+
+    write(packPath, files.size(), [&files](const size_t fileIdx) {
+        return std::make_shared<const Score>(files[fileIdx].filePath);
+    }, numThreads);
+
+    return files.size();
+}
+
+void CorpusPack::write(const std::string& filePath, const size_t numScores,
+                       const std::function<std::shared_ptr<const Score>(size_t)>& loadScore,
+                       const int numThreads) {
+    // Written to a temporary file first: an opened pack may be the destination
+    const std::string tempPath = filePath + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        LOG_ERROR("Unable to write the corpus pack file: " + filePath);
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = PACK_VERSION;
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.numScores = numScores;
+
+    uint64_t pos = 0;
+    const auto append = [&file, &pos](const void* source, const size_t numBytes) {
+        file.write(reinterpret_cast<const char*>(source), numBytes);
+        pos += numBytes;
+    };
+    const auto pad = [&]() {
+        const char zeros[8] = {};
+        append(zeros, alignTo8(pos) - pos);
+    };
+    append(&header, sizeof(header));  // Rewritten at the end
+    pad();
+
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> stringIds;
+    const auto addString = [&](const std::string& text) -> uint32_t {
+        const auto it = stringIds.emplace(text, strings.size()).first;
+        if (it->second == strings.size()) {
+            strings.push_back(text);
+        }
+        return it->second;
+    };
+
+    // Part names are not deduplicated: the names of a score have consecutive ids
+    std::vector<std::string> partNames;
+    std::vector<EntryRecord> entries(numScores);
+
+    // ===== STEP 1: DOCUMENTOS, EM LOTES PARALELOS ===== //
+    const size_t batchSize =
+        SCORES_PER_THREAD_PER_BATCH * ThreadPool::getNumThreads(numThreads);
+    try {
+        for (size_t firstIdx = 0; firstIdx < numScores; firstIdx += batchSize) {
+            const size_t batchEnd = std::min(numScores, firstIdx + batchSize);
+
+            std::vector<std::shared_ptr<const Score>> scores(batchEnd - firstIdx);
+            std::vector<std::string> documents(batchEnd - firstIdx);
+            ThreadPool::parallelFor(scores.size(), [&](const size_t i) {
+                scores[i] = loadScore(firstIdx + i);
+                documents[i] = scores[i]->saveXMLDocument();
+            }, numThreads, 1);
+
+            for (size_t i = 0; i < scores.size(); i++) {
+                const Score& score = *scores[i];
+                EntryRecord& entry = entries[firstIdx + i];
+                entry.filePathId = addString(score.getFilePath());
+                entry.fileNameId = addString(score.getFileName());
+                entry.titleId = addString(score.getTitle());
+                entry.composerNameId = addString(score.getComposerName());
+                entry.numMeasures = score.getNumMeasures();
+                entry.numNotes = score.getNumNotes();
+
+                const std::vector<std::string> names = score.getPartsNames();
+                entry.firstPartNameId = partNames.size();
+                entry.numParts = names.size();
+                partNames.insert(partNames.end(), names.begin(), names.end());
+
+                entry.documentPos = pos;
+                entry.documentSize = documents[i].size();
+                append(documents[i].data(), documents[i].size());
+                pad();
+            }
+        }
+    } catch (...) {
+        // A file that cannot be parsed leaves no partial pack
+        file.close();
+        std::remove(tempPath.c_str());
+        throw;
+    }
+
+    // ===== STEP 2: ÍNDICE ===== //
+    // Part names after the other strings: their ids are shifted by the number of strings
+    const uint32_t firstPartNameId = strings.size();
+    for (auto& entry : entries) {
+        entry.firstPartNameId += firstPartNameId;
+    }
+    strings.insert(strings.end(), partNames.begin(), partNames.end());
+
+    std::vector<uint64_t> stringOffsets = {0};
+    for (const auto& text : strings) {
+        stringOffsets.push_back(stringOffsets.back() + text.size());
+    }
+
+    header.numStrings = strings.size();
+    header.entriesPos = pos;
+    append(entries.data(), entries.size() * sizeof(EntryRecord));
+    pad();
+    header.stringOffsetsPos = pos;
+    append(stringOffsets.data(), stringOffsets.size() * sizeof(uint64_t));
+    pad();
+    header.stringDataPos = pos;
+    for (const auto& text : strings) {
+        append(text.data(), text.size());
+    }
+    pad();
+    header.fileSize = pos;
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    if (!file) {
+        LOG_ERROR("Unable to write the corpus pack file: " + filePath);
+    }
+
+    std::remove(filePath.c_str());
+    if (std::rename(tempPath.c_str(), filePath.c_str()) != 0) {
+        LOG_ERROR("Unable to write the corpus pack file: " + filePath);
+    }
+}
+
+const std::string& CorpusPack::getFilePath() const { return _filePath; }
+
+int CorpusPack::getNumScores() const { return _header->numScores; }
+
+const CorpusPack::EntryRecord& CorpusPack::getRecord(const int scoreIdx) const {
+    if (scoreIdx < 0 || scoreIdx >= getNumScores()) {
+        LOG_ERROR("Invalid corpus pack score index: " + std::to_string(scoreIdx));
+    }
+    return _entries[scoreIdx];
+}
+
+std::string CorpusPack::getString(const uint32_t stringId) const {
+    return std::string(_stringData + _stringOffsets[stringId],
+                       _stringOffsets[stringId + 1] - _stringOffsets[stringId]);
+}
+
+CorpusPack::Entry CorpusPack::getEntry(const int scoreIdx) const {
+    const EntryRecord& record = getRecord(scoreIdx);
+
+    Entry entry;
+    entry.filePath = getString(record.filePathId);
+    entry.fileName = getString(record.fileNameId);
+    entry.title = getString(record.titleId);
+    entry.composerName = getString(record.composerNameId);
+    for (uint32_t p = 0; p < record.numParts; p++) {
+        entry.partsNames.push_back(getString(record.firstPartNameId + p));
+    }
+    entry.numParts = record.numParts;
+    entry.numMeasures = record.numMeasures;
+    entry.numNotes = record.numNotes;
+    entry.documentSize = record.documentSize;
+    return entry;
+}
+
+std::vector<CorpusPack::Entry> CorpusPack::getEntries() const {
+    std::vector<Entry> entries;
+    entries.reserve(getNumScores());
+    for (int scoreIdx = 0; scoreIdx < getNumScores(); scoreIdx++) {
+        entries.push_back(getEntry(scoreIdx));
+    }
+    return entries;
+}
+
+std::vector<int> CorpusPack::selectScores(
+    const std::function<bool(const Entry&)>& predicate) const {
+    std::vector<int> scoreIndices;
+    for (int scoreIdx = 0; scoreIdx < getNumScores(); scoreIdx++) {
+        if (predicate(getEntry(scoreIdx))) {
+            scoreIndices.push_back(scoreIdx);
+        }
+    }
+    return scoreIndices;
+}
+
+int CorpusPack::findScore(const std::string& fileName) const {
+    for (int scoreIdx = 0; scoreIdx < getNumScores(); scoreIdx++) {
+        const EntryRecord& record = _entries[scoreIdx];
+        const uint64_t size = _stringOffsets[record.fileNameId + 1] -
+                              _stringOffsets[record.fileNameId];
+        if (size == fileName.size() &&
+            std::memcmp(_stringData + _stringOffsets[record.fileNameId], fileName.data(),
+                        size) == 0) {
+            return scoreIdx;
+        }
+    }
+    return -1;
+}
+
+std::string CorpusPack::getDocument(const int scoreIdx) const {
+    const EntryRecord& record = getRecord(scoreIdx);
+    return std::string(_file->data() + record.documentPos, record.documentSize);
+}
+
+std::shared_ptr<Score> CorpusPack::loadScore(const int scoreIdx) const {
+    const EntryRecord& record = getRecord(scoreIdx);
+
+    // Parsed from the mapped pages: only the pages of this document are read
+    return std::shared_ptr<Score>(new Score(_file->data() + record.documentPos,
+                                            record.documentSize, getString(record.filePathId)));
+}
+
+std::vector<std::shared_ptr<Score>> CorpusPack::loadScores(const std::vector<int>& scoreIndices,
+                                                           const int numThreads) const {
+    std::vector<int> indices = scoreIndices;
+    if (indices.empty()) {
+        indices.resize(getNumScores());
+        for (int scoreIdx = 0; scoreIdx < getNumScores(); scoreIdx++) {
+            indices[scoreIdx] = scoreIdx;
+        }
+    }
+
+    for (const int scoreIdx : indices) {
+        getRecord(scoreIdx);  // Checked before the workers start
+    }
+
+    std::vector<std::shared_ptr<Score>> scores(indices.size());
+    ThreadPool::parallelFor(indices.size(), [&](const size_t i) {
+        scores[i] = loadScore(indices[i]);
+    }, numThreads, 1);
+    return scores;
+}
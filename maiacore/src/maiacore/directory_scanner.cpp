@@ -0,0 +1,194 @@
+#include "maiacore/directory_scanner.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include "maiacore/log.h"
+
+namespace {
+
+bool hasSlash(const std::string& pattern) { return pattern.find('/') != std::string::npos; }
+
+// Matches one character against a set '[...]' starting at pattern[p]; sets p after the ']'
+bool matchCharacterSet(const std::string& pattern, size_t* p, const char c) {
+    size_t i = *p + 1;
+    const bool negated = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+    if (negated) {
+        i++;
+    }
+
+    bool matched = false;
+    bool first = true;
+    while (i < pattern.size() && (first || pattern[i] != ']')) {
+        if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+            matched = matched || (pattern[i] <= c && c <= pattern[i + 2]);
+            i += 3;
+        } else {
+            matched = matched || pattern[i] == c;
+            i++;
+        }
+        first = false;
+    }
+
+    *p = i + 1;  // Past the ']' (or past the end of an unterminated set)
+    return matched != negated;
+}
+
+bool matchGlobAt(const std::string& pattern, size_t p, const std::string& text, size_t t) {
+    while (p < pattern.size()) {
+        const char c = pattern[p];
+        if (c == '*') {
+            const bool crossesSlash = p + 1 < pattern.size() && pattern[p + 1] == '*';
+            p += crossesSlash ? 2 : 1;
+
+            // '**/' also matches no directory at all
+            if (crossesSlash && p < pattern.size() && pattern[p] == '/' &&
+                matchGlobAt(pattern, p + 1, text, t)) {
+                return true;
+            }
+
+            for (size_t end = t; end <= text.size(); end++) {
+                if (matchGlobAt(pattern, p, text, end)) {
+                    return true;
+                }
+                if (end < text.size() && text[end] == '/' && !crossesSlash) {
+                    return false;
+                }
+            }
+            return false;
+        }
+
+        if (t >= text.size()) {
+            return false;
+        }
+
+        if (c == '?') {
+            if (text[t] == '/') {
+                return false;
+            }
+            p++;
+        } else if (c == '[') {
+            if (text[t] == '/' || !matchCharacterSet(pattern, &p, text[t])) {
+                return false;
+            }
+        } else {
+            if (c != text[t]) {
+                return false;
+            }
+            p++;
+        }
+        t++;
+    }
+
+    return t == text.size();
+}
+
+}  // namespace
+
+DirectoryScanner::DirectoryScanner()
+    : DirectoryScanner(false, {"*.xml", "*.mxl", "*.musicxml"}) {}
+
+DirectoryScanner::DirectoryScanner(const bool recursive,
+                                   const std::vector<std::string>& includeGlobs,
+                                   const std::vector<std::string>& excludeGlobs)
+    : _recursive(recursive), _includeGlobs(includeGlobs), _excludeGlobs(excludeGlobs) {}
+
+bool DirectoryScanner::isRecursive() const { return _recursive; }
+
+const std::vector<std::string>& DirectoryScanner::getIncludeGlobs() const { return _includeGlobs; }
+
+const std::vector<std::string>& DirectoryScanner::getExcludeGlobs() const { return _excludeGlobs; }
+
+bool DirectoryScanner::matchGlob(const std::string& pattern, const std::string& text) {
+    return matchGlobAt(pattern, 0, text, 0);
+}
+
+bool DirectoryScanner::isIncluded(const std::string& relativePath) const {
+    const size_t slash = relativePath.rfind('/');
+    const std::string fileName =
+        (slash == std::string::npos) ? relativePath : relativePath.substr(slash + 1);
+
+    const auto matches = [&](const std::string& pattern) {
+        return matchGlob(pattern, hasSlash(pattern) ? relativePath : fileName);
+    };
+
+    return std::any_of(_includeGlobs.begin(), _includeGlobs.end(), matches) &&
+           std::none_of(_excludeGlobs.begin(), _excludeGlobs.end(), matches);
+}
+
+bool DirectoryScanner::isExcludedDirectory(const std::string& directoryName) const {
+    return std::any_of(_excludeGlobs.begin(), _excludeGlobs.end(), [&](const std::string& pattern) {
+        return !hasSlash(pattern) && matchGlob(pattern, directoryName);
+    });
+}
+
+std::vector<DirectoryScanner::FileInfo> DirectoryScanner::scan(
+    const std::string& directoryPath) const {
+    namespace fs = std::filesystem;
+
+    std::error_code error;
+    if (!fs::is_directory(directoryPath, error)) {
+        LOG_ERROR("Unable to scan the directory: " + directoryPath);
+    }
+
+    std::vector<FileInfo> files;
+    const fs::path root(directoryPath);
+    const auto addFile = [&](const fs::directory_entry& entry) {
+        if (!entry.is_regular_file(error)) {
+            return;
+        }
+
+        const std::string relativePath = entry.path().lexically_relative(root).generic_string();
+        if (!isIncluded(relativePath)) {
+            return;
+        }
+
+        FileInfo file;
+        file.filePath = entry.path().string();
+        file.size = entry.file_size(error);
+        file.modificationTime = entry.last_write_time(error).time_since_epoch().count();
+        files.push_back(file);
+    };
+
+    if (_recursive) {
+        fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied);
+        for (; it != fs::recursive_directory_iterator(); it.increment(error)) {
+            if (it->is_directory(error)) {
+                if (isExcludedDirectory(it->path().filename().string())) {
+                    it.disable_recursion_pending();
+                }
+                continue;
+            }
+            addFile(*it);
+        }
+    } else {
+        for (const auto& entry : fs::directory_iterator(root)) {
+            addFile(entry);
+        }
+    }
+
+    std::sort(files.begin(), files.end(),
+              [](const FileInfo& a, const FileInfo& b) { return a.filePath < b.filePath; });
+    return files;
+}
+
+uint64_t DirectoryScanner::hashFile(const std::string& filePath) {
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+        LOG_ERROR("Unable to read the file: " + filePath);
+    }
+
+    uint64_t hash = 14695981039346656037ULL;
+    char buffer[1 << 16];
+    while (file) {
+        file.read(buffer, sizeof(buffer));
+        const std::streamsize numBytes = file.gcount();
+        for (std::streamsize i = 0; i < numBytes; i++) {
+            hash ^= static_cast<unsigned char>(buffer[i]);
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    return (hash == 0) ? 1 : hash;
+}
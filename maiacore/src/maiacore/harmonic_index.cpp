@@ -0,0 +1,130 @@
+#include "maiacore/harmonic_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+#include "maiacore/log.h"
+
+namespace {
+
+// Roman numeral (case insensitive) to scale degree. Returns 0 if it is not a numeral
+int romanToDegree(std::string numeral) {
+    std::transform(numeral.begin(), numeral.end(), numeral.begin(),
+                   [](unsigned char c) { return std::toupper(c); });
+
+    static const char* const numerals[] = {"I", "II", "III", "IV", "V", "VI", "VII"};
+    for (int d = 0; d < 7; d++) {
+        if (numeral == numerals[d]) {
+            return d + 1;
+        }
+    }
+    return 0;
+}
+
+}  // namespace
+
+ChordProgressionQuery::ChordProgressionQuery(const std::string& progression)
+    : _progression(progression) {
+    std::istringstream stream(progression);
+    std::string text;
+    while (stream >> text) {
+        Token token;
+        const size_t colonPos = text.find(':');
+        const std::string head = text.substr(0, colonPos);
+        if (colonPos != std::string::npos) {
+            token.quality = text.substr(colonPos + 1);
+            if (token.quality.empty()) {
+                LOG_ERROR("Invalid chord progression token '" + text + "': empty quality");
+            }
+            if (token.quality == "*") {
+                token.quality.clear();
+            }
+        }
+
+        if (head == "*") {
+            // Any chord
+        } else if (!head.empty() && head[0] == '@') {
+            token.requireRoot = true;
+            if (head.size() > 1) {
+                if (_tokens.empty()) {
+                    LOG_ERROR("Invalid chord progression token '" + text +
+                              "': the first chord has no previous root");
+                }
+
+                int semitones = 0;
+                size_t numParsed = 0;
+                try {
+                    semitones = std::stoi(head.substr(1), &numParsed);
+                } catch (const std::exception&) {
+                    numParsed = 0;
+                }
+                if (numParsed != head.size() - 1 || (head[1] != '+' && head[1] != '-')) {
+                    LOG_ERROR("Invalid chord progression token '" + text + "'");
+                }
+
+                token.isRelative = true;
+                token.rootInterval = ((semitones % 12) + 12) % 12;
+            }
+        } else {
+            token.degree = romanToDegree(head);
+            if (token.degree == 0) {
+                LOG_ERROR("Invalid chord progression token '" + text +
+                          "': expected a Roman numeral, '*' or '@'");
+            }
+        }
+
+        _tokens.push_back(token);
+    }
+
+    if (_tokens.empty()) {
+        LOG_ERROR("Empty chord progression");
+    }
+}
+
+const std::string& ChordProgressionQuery::getProgression() const { return _progression; }
+
+int ChordProgressionQuery::size() const { return _tokens.size(); }
+
+bool ChordProgressionQuery::tokenMatches(const Token& token, const HarmonicSlice& slice,
+                                         const HarmonicSlice* previous) const {
+    if (!token.quality.empty() && slice.quality != token.quality) {
+        return false;
+    }
+    if (token.degree != 0 && slice.degree != token.degree) {
+        return false;
+    }
+    if (token.requireRoot && slice.rootPitchClass < 0) {
+        return false;
+    }
+    if (token.isRelative) {
+        if (previous == nullptr || previous->rootPitchClass < 0) {
+            return false;
+        }
+        const int interval = (slice.rootPitchClass - previous->rootPitchClass + 12) % 12;
+        if (interval != token.rootInterval) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<ChordProgressionQuery::Match> ChordProgressionQuery::findAll(
+    const std::vector<HarmonicSlice>& slices) const {
+    std::vector<Match> matches;
+    const int numSlices = slices.size();
+    const int numTokens = _tokens.size();
+
+    for (int start = 0; start + numTokens <= numSlices; start++) {
+        int k = 0;
+        while (k < numTokens &&
+               tokenMatches(_tokens[k], slices[start + k], (k > 0) ? &slices[start + k - 1] : nullptr)) {
+            k++;
+        }
+        if (k == numTokens) {
+            matches.push_back({start, numTokens});
+        }
+    }
+
+    return matches;
+}
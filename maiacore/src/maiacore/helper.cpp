@@ -8,6 +8,7 @@
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <numeric>  // std::iota
 #include <sstream>
 
 #include "cherno/instrumentor.h"
@@ -15,6 +16,10 @@
 #include "maiacore/log.h"
 #include "maiacore/utils.h"
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 std::vector<std::string> Helper::splitString(const std::string& s, char delimiter) {
     std::vector<std::string> tokens;
     std::string token;
@@ -2794,3 +2799,331 @@ float Helper::calculateRhythmicEuclideanSimilarity(const std::vector<float>& dur
 
     return similarity;
 }
+
+// ===== Sethares dissonance kernel ===== //
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define MAIACORE_SIMD_SSE2
+#endif
+
+#if defined(MAIACORE_SIMD_SSE2) && (defined(__GNUC__) || defined(__clang__))
+// GCC/Clang: compile the AVX2 kernel with a target attribute and select it at runtime
+#define MAIACORE_SIMD_AVX2
+#define MAIACORE_SIMD_AVX2_RUNTIME_CHECK
+#define MAIACORE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#elif defined(MAIACORE_SIMD_SSE2) && defined(__AVX2__)
+// MSVC: only when the whole library is built with /arch:AVX2
+#define MAIACORE_SIMD_AVX2
+#define MAIACORE_TARGET_AVX2
+#endif
+
+namespace {
+
+// Plomp-Levelt roughness curve constants (Sethares model)
+constexpr float SETHARES_DSTAR = 0.24f;  // Point of maximum dissonance
+constexpr float SETHARES_S1 = 0.0207f;
+constexpr float SETHARES_S2 = 18.96f;
+constexpr float SETHARES_C1 = 5.0f;
+constexpr float SETHARES_C2 = -5.0f;
+constexpr float SETHARES_A1 = -3.51f;
+constexpr float SETHARES_A2 = -5.75f;
+
+// Beyond this scaled frequency difference both exponentials underflow to zero in float
+constexpr float SETHARES_MAX_SFDIF = 30.0f;
+
+// Computes the dissonance of the partial 'i' against the partials [begin, end)
+typedef float (*SetharesRowKernel)(const float* fr, const float* am, const int begin,
+                                   const int end, const float fi, const float ai, const float S,
+                                   const bool useMinModel, float* out);
+
+float setharesRowScalar(const float* fr, const float* am, const int begin, const int end,
+                        const float fi, const float ai, const float S, const bool useMinModel,
+                        float* out) {
+    float sum = 0.0f;
+    for (int j = begin; j < end; j++) {
+        const float a = (useMinModel) ? std::min(ai, am[j]) : ai * am[j];
+        const float SFdif = S * (fr[j] - fi);
+        const float diss = a * (SETHARES_C1 * std::exp(SETHARES_A1 * SFdif) +
+                                SETHARES_C2 * std::exp(SETHARES_A2 * SFdif));
+        if (out != nullptr) {
+            out[j - begin] = diss;
+        }
+        sum += diss;
+    }
+    return sum;
+}
+
+#ifdef MAIACORE_SIMD_SSE2
+// Cephes-style single precision exp() polynomial approximation (~1 ulp)
+constexpr float EXP_HI = 88.3762626647949f;
+constexpr float EXP_LO = -87.3365447505531f;
+constexpr float EXP_LOG2EF = 1.44269504088896341f;
+constexpr float EXP_C1 = 0.693359375f;
+constexpr float EXP_C2 = -2.12194440e-4f;
+constexpr float EXP_P0 = 1.9875691500E-4f;
+constexpr float EXP_P1 = 1.3981999507E-3f;
+constexpr float EXP_P2 = 8.3334519073E-3f;
+constexpr float EXP_P3 = 4.1665795894E-2f;
+constexpr float EXP_P4 = 1.6666665459E-1f;
+constexpr float EXP_P5 = 5.0000001201E-1f;
+
+inline __m128 exp128(__m128 x) {
+    x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(EXP_LO)), _mm_set1_ps(EXP_HI));
+
+    // n = floor(x / ln(2) + 0.5)
+    __m128 fx = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(EXP_LOG2EF)), _mm_set1_ps(0.5f));
+    const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+    const __m128 mask = _mm_and_ps(_mm_cmpgt_ps(truncated, fx), _mm_set1_ps(1.0f));
+    fx = _mm_sub_ps(truncated, mask);
+
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(EXP_C1)));
+    x = _mm_sub_ps(x, _mm_mul_ps(fx, _mm_set1_ps(EXP_C2)));
+    const __m128 z = _mm_mul_ps(x, x);
+
+    __m128 y = _mm_set1_ps(EXP_P0);
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P1));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P2));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P3));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P4));
+    y = _mm_add_ps(_mm_mul_ps(y, x), _mm_set1_ps(EXP_P5));
+    y = _mm_add_ps(_mm_mul_ps(y, z), x);
+    y = _mm_add_ps(y, _mm_set1_ps(1.0f));
+
+    // 2^n
+    __m128i n = _mm_cvttps_epi32(fx);
+    n = _mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23);
+
+    return _mm_mul_ps(y, _mm_castsi128_ps(n));
+}
+
+float setharesRowSSE2(const float* fr, const float* am, const int begin, const int end,
+                      const float fi, const float ai, const float S, const bool useMinModel,
+                      float* out) {
+    const __m128 vfi = _mm_set1_ps(fi);
+    const __m128 vai = _mm_set1_ps(ai);
+    const __m128 vS = _mm_set1_ps(S);
+    const __m128 vA1 = _mm_set1_ps(SETHARES_A1);
+    const __m128 vA2 = _mm_set1_ps(SETHARES_A2);
+    const __m128 vC1 = _mm_set1_ps(SETHARES_C1);
+    const __m128 vC2 = _mm_set1_ps(SETHARES_C2);
+
+    __m128 vsum = _mm_setzero_ps();
+    int j = begin;
+    for (; j + 4 <= end; j += 4) {
+        const __m128 aj = _mm_loadu_ps(am + j);
+        const __m128 a = (useMinModel) ? _mm_min_ps(vai, aj) : _mm_mul_ps(vai, aj);
+        const __m128 SFdif = _mm_mul_ps(vS, _mm_sub_ps(_mm_loadu_ps(fr + j), vfi));
+        const __m128 curve = _mm_add_ps(_mm_mul_ps(vC1, exp128(_mm_mul_ps(vA1, SFdif))),
+                                        _mm_mul_ps(vC2, exp128(_mm_mul_ps(vA2, SFdif))));
+        const __m128 diss = _mm_mul_ps(a, curve);
+        if (out != nullptr) {
+            _mm_storeu_ps(out + (j - begin), diss);
+        }
+        vsum = _mm_add_ps(vsum, diss);
+    }
+
+    float lanes[4];
+    _mm_storeu_ps(lanes, vsum);
+    const float tailSum = setharesRowScalar(fr, am, j, end, fi, ai, S, useMinModel,
+                                            (out != nullptr) ? out + (j - begin) : nullptr);
+
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + tailSum;
+}
+#endif  // MAIACORE_SIMD_SSE2
+
+#ifdef MAIACORE_SIMD_AVX2
+MAIACORE_TARGET_AVX2 inline __m256 exp256(__m256 x) {
+    x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(EXP_LO)), _mm256_set1_ps(EXP_HI));
+
+    __m256 fx = _mm256_fmadd_ps(x, _mm256_set1_ps(EXP_LOG2EF), _mm256_set1_ps(0.5f));
+    fx = _mm256_floor_ps(fx);
+
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(EXP_C1), x);
+    x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(EXP_C2), x);
+    const __m256 z = _mm256_mul_ps(x, x);
+
+    __m256 y = _mm256_set1_ps(EXP_P0);
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P1));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P2));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P3));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P4));
+    y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(EXP_P5));
+    y = _mm256_fmadd_ps(y, z, x);
+    y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+    __m256i n = _mm256_cvttps_epi32(fx);
+    n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+MAIACORE_TARGET_AVX2 float setharesRowAVX2(const float* fr, const float* am, const int begin,
+                                           const int end, const float fi, const float ai,
+                                           const float S, const bool useMinModel, float* out) {
+    const __m256 vfi = _mm256_set1_ps(fi);
+    const __m256 vai = _mm256_set1_ps(ai);
+    const __m256 vS = _mm256_set1_ps(S);
+    const __m256 vA1 = _mm256_set1_ps(SETHARES_A1);
+    const __m256 vA2 = _mm256_set1_ps(SETHARES_A2);
+    const __m256 vC1 = _mm256_set1_ps(SETHARES_C1);
+    const __m256 vC2 = _mm256_set1_ps(SETHARES_C2);
+
+    __m256 vsum = _mm256_setzero_ps();
+    int j = begin;
+    for (; j + 8 <= end; j += 8) {
+        const __m256 aj = _mm256_loadu_ps(am + j);
+        const __m256 a = (useMinModel) ? _mm256_min_ps(vai, aj) : _mm256_mul_ps(vai, aj);
+        const __m256 SFdif = _mm256_mul_ps(vS, _mm256_sub_ps(_mm256_loadu_ps(fr + j), vfi));
+        const __m256 curve = _mm256_fmadd_ps(vC1, exp256(_mm256_mul_ps(vA1, SFdif)),
+                                             _mm256_mul_ps(vC2, exp256(_mm256_mul_ps(vA2, SFdif))));
+        const __m256 diss = _mm256_mul_ps(a, curve);
+        if (out != nullptr) {
+            _mm256_storeu_ps(out + (j - begin), diss);
+        }
+        vsum = _mm256_add_ps(vsum, diss);
+    }
+
+    const __m128 half = _mm_add_ps(_mm256_castps256_ps128(vsum), _mm256_extractf128_ps(vsum, 1));
+    float lanes[4];
+    _mm_storeu_ps(lanes, half);
+    const float tailSum = setharesRowScalar(fr, am, j, end, fi, ai, S, useMinModel,
+                                            (out != nullptr) ? out + (j - begin) : nullptr);
+
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + tailSum;
+}
+#endif  // MAIACORE_SIMD_AVX2
+
+SetharesRowKernel selectSetharesRowKernel() {
+#ifdef MAIACORE_SIMD_AVX2
+#ifdef MAIACORE_SIMD_AVX2_RUNTIME_CHECK
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return setharesRowAVX2;
+    }
+#else
+    return setharesRowAVX2;
+#endif
+#endif
+
+#ifdef MAIACORE_SIMD_SSE2
+    return setharesRowSSE2;
+#else
+    return setharesRowScalar;
+#endif
+}
+
+}  // namespace
+
+float Helper::setharesDissonance(const std::vector<float>& freqs, const std::vector<float>& ampls,
+                                 const bool useMinModel, std::vector<float>* dyadsDissonance) {
+    if (freqs.size() != ampls.size()) {
+        LOG_ERROR("The 'frequency' and 'amplitude' vectors must have the same size.");
+    }
+
+    static const SetharesRowKernel rowKernel = selectSetharesRowKernel();
+
+    // Sort the partials by frequency only if needed
+    const bool isSorted = std::is_sorted(freqs.begin(), freqs.end());
+    std::vector<float> frSorted;
+    std::vector<float> amSorted;
+    if (!isSorted) {
+        std::vector<size_t> sortIdx(freqs.size());
+        std::iota(sortIdx.begin(), sortIdx.end(), 0);
+        std::sort(sortIdx.begin(), sortIdx.end(),
+                  [&freqs](size_t i, size_t j) { return freqs[i] < freqs[j]; });
+
+        frSorted.resize(freqs.size());
+        amSorted.resize(ampls.size());
+        for (size_t i = 0; i < sortIdx.size(); i++) {
+            frSorted[i] = freqs[sortIdx[i]];
+            amSorted[i] = ampls[sortIdx[i]];
+        }
+    }
+
+    const float* fr = (isSorted) ? freqs.data() : frSorted.data();
+    const float* am = (isSorted) ? ampls.data() : amSorted.data();
+    const int numPartials = static_cast<int>(freqs.size());
+
+    float* out = nullptr;
+    if (dyadsDissonance != nullptr) {
+        const size_t numDyads = (numPartials < 2) ? 0 : (numPartials * (numPartials - 1)) / 2;
+        dyadsDissonance->assign(numDyads, 0.0f);
+        out = dyadsDissonance->data();
+    }
+
+    float totalDissonance = 0.0f;
+    for (int i = 0; i < numPartials - 1; i++) {
+        const float fi = fr[i];
+        const float S = SETHARES_DSTAR / (SETHARES_S1 * fi + SETHARES_S2);
+        const int rowSize = numPartials - i - 1;
+
+        // Partials above this frequency add exactly zero roughness to the total
+        int end = numPartials;
+        if (out == nullptr) {
+            const float maxFreq = fi + SETHARES_MAX_SFDIF / S;
+            end = static_cast<int>(std::upper_bound(fr + i + 1, fr + numPartials, maxFreq) - fr);
+        }
+
+        totalDissonance += rowKernel(fr, am, i + 1, end, fi, am[i], S, useMinModel, out);
+
+        if (out != nullptr) {
+            out += rowSize;
+        }
+    }
+
+    return totalDissonance;
+}
+
+uint32_t Helper::intervalsGramKey(const int* intervals, const int gramSize) {
+    uint32_t key = 0;
+    for (int i = 0; i < gramSize; i++) {
+        key = (key << 9) | (static_cast<uint32_t>(intervals[i] + 256) & 0x1FF);
+    }
+    return key;
+}
+
+float Helper::intervalsEuclideanSimilarity(const int* patternIntervals,
+                                           const int* segmentIntervals, const int numIntervals) {
+    float sumSquares = 0.0f;
+    for (int i = 0; i < numIntervals; i++) {
+        const float semitone = (float)patternIntervals[i] - (float)segmentIntervals[i];
+        const float semitonePow2 = std::pow(semitone, 2);
+        sumSquares += semitonePow2;
+    }
+
+    return 1.0f / (1.0f + std::sqrt(sumSquares));
+}
+
+bool Helper::durationsEuclideanSimilarity(const float* patternDurations,
+                                          const float patternMaxDuration,
+                                          const float* segmentDurations, const int numNotes,
+                                          const float threshold, float* durationDifferences,
+                                          float* similarity) {
+    float segmentMaxDuration = 0.0f;
+    for (int i = 0; i < numNotes; i++) {
+        segmentMaxDuration = std::max(segmentMaxDuration, segmentDurations[i]);
+    }
+
+    const int blockSize = 8;
+    float sumSquares = 0.0f;
+    for (int blockStart = 0; blockStart < numNotes; blockStart += blockSize) {
+        const int blockEnd = std::min(blockStart + blockSize, numNotes);
+
+        for (int i = blockStart; i < blockEnd; i++) {
+            durationDifferences[i] = patternDurations[i] / patternMaxDuration -
+                                     segmentDurations[i] / segmentMaxDuration;
+        }
+
+        for (int i = blockStart; i < blockEnd; i++) {
+            const float diffPow2 = std::pow(durationDifferences[i], 2);
+            sumSquares += diffPow2;
+        }
+
+        if (1.0f / (1.0f + std::sqrt(sumSquares)) < threshold) {
+            return false;
+        }
+    }
+
+    *similarity = 1.0f / (1.0f + std::sqrt(sumSquares));
+    return true;
+}
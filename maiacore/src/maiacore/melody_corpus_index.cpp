@@ -0,0 +1,791 @@
+#include "maiacore/melody_corpus_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+#include "maiacore/helper.h"
+#include "maiacore/interval.h"
+#include "maiacore/log.h"
+#include "maiacore/mapped_file.h"
+#include "maiacore/thread_pool.h"
+
+namespace {
+
+const char INDEX_MAGIC[8] = {'M', 'A', 'I', 'A', 'M', 'C', 'I', '\0'};
+const uint32_t INDEX_VERSION = 1;
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const uint32_t NO_PITCH = UINT32_MAX;  // Sounding pitch id of the rests
+
+// ===== FORMATO DO ARQUIVO ===== //
+// Header followed by 8-byte aligned sections, in native byte order (checked by the mark)
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrderMark;
+    uint32_t gramSize;
+    uint32_t reserved;
+    uint64_t numStrings;
+    uint64_t numScores;
+    uint64_t numStreams;
+    uint64_t numEvents;
+    uint64_t numKeys;
+    uint64_t numPostings;
+    uint64_t stringOffsetsPos;  // uint64_t[numStrings + 1]
+    uint64_t stringDataPos;     // char[]
+    uint64_t scoresPos;         // ScoreRecord[numScores]
+    uint64_t streamsPos;        // StreamRecord[numStreams]
+    uint64_t intervalsPos;      // int32_t[numEvents], 0 after the last event of a stream
+    uint64_t durationsPos;      // float[numEvents]
+    uint64_t eventsPos;         // EventRecord[numEvents]
+    uint64_t keysPos;           // uint32_t[numKeys], ascending n-gram keys
+    uint64_t keyOffsetsPos;     // uint64_t[numKeys + 1], posting range of each key
+    uint64_t postingsPos;       // PostingRecord[numPostings]
+    uint64_t fileSize;
+};
+
+struct ScoreRecord {
+    uint32_t fileNameId;
+    uint32_t titleId;
+    uint32_t composerNameId;
+    uint32_t numNotes;
+    uint32_t firstStream;
+    uint32_t numStreams;
+};
+
+struct StreamRecord {
+    uint32_t scoreIdx;
+    uint32_t partIdx;
+    uint32_t partNameId;
+    uint32_t numEvents;
+    uint64_t firstEvent;
+};
+
+struct EventRecord {
+    uint32_t writtenPitchId;
+    uint32_t soundingPitchId;
+    uint32_t keyId;
+    uint32_t measureIdx;
+    uint32_t staveIdx;
+};
+
+struct PostingRecord {
+    uint32_t streamIdx;
+    uint32_t offset;
+};
+
+uint64_t alignTo8(const uint64_t pos) { return (pos + 7) & ~uint64_t{7}; }
+
+// Same semitones of the melody search index of Score: 0 if any note is a rest
+int melodicInterval(const Note& firstNote, const Note& secondNote) {
+    if (firstNote.isNoteOff() || secondNote.isNoteOff()) {
+        return 0;
+    }
+
+    return secondNote.getMidiNumber() - firstNote.getMidiNumber();
+}
+
+}  // namespace
+
+// Melody streams of a score, decoded (used to build and to compact segments)
+struct MelodyCorpusIndex::ScoreData {
+    struct Stream {
+        int partIdx = 0;
+        std::string partName;
+        std::vector<int> intervals;
+        std::vector<float> quarterDurations;
+        std::vector<std::string> writtenPitches;
+        std::vector<std::string> soundingPitches;  // Empty for rests
+        std::vector<std::string> keyNames;
+        std::vector<int> measureIdx;
+        std::vector<int> staveIdx;
+    };
+
+    ScoreInfo info;
+    std::vector<Stream> streams;
+};
+
+// Immutable view of an index file, memory mapped or built in memory
+class MelodyCorpusIndex::Segment {
+   public:
+    static std::shared_ptr<const Segment> fromFile(const std::string& filePath) {
+        auto segment = std::make_shared<Segment>();
+        segment->_file = std::make_shared<MappedFile>(filePath);
+        segment->parse(segment->_file->data(), segment->_file->size(), filePath);
+        return segment;
+    }
+
+    static std::shared_ptr<const Segment> fromScores(const std::vector<const ScoreData*>& scores) {
+        auto segment = std::make_shared<Segment>();
+        segment->_buffer = serialize(scores);
+        segment->parse(reinterpret_cast<const char*>(segment->_buffer.data()),
+                       segment->_buffer.size() * sizeof(uint64_t), "memory");
+        return segment;
+    }
+
+    // Index file bytes, in 8-byte words so that the records are aligned in memory
+    static std::vector<uint64_t> serialize(const std::vector<const ScoreData*>& scores);
+
+    int getNumScores() const { return _header->numScores; }
+    const ScoreRecord& getScore(const int scoreIdx) const { return _scores[scoreIdx]; }
+    const StreamRecord& getStream(const int streamIdx) const { return _streams[streamIdx]; }
+    int getNumStreams() const { return _header->numStreams; }
+    const int32_t* getIntervals(const StreamRecord& stream) const {
+        return _intervals + stream.firstEvent;
+    }
+    const float* getDurations(const StreamRecord& stream) const {
+        return _durations + stream.firstEvent;
+    }
+    const EventRecord* getEvents(const StreamRecord& stream) const {
+        return _events + stream.firstEvent;
+    }
+
+    std::string getString(const uint32_t stringId) const {
+        if (stringId >= _header->numStrings) {
+            LOG_ERROR("Corrupted melody index: invalid string id " + std::to_string(stringId));
+        }
+        return std::string(_stringData + _stringOffsets[stringId],
+                           _stringOffsets[stringId + 1] - _stringOffsets[stringId]);
+    }
+
+    // Postings of an n-gram key: [first, last)
+    std::pair<const PostingRecord*, const PostingRecord*> findPostings(const uint32_t key) const {
+        const uint32_t* keysEnd = _keys + _header->numKeys;
+        const uint32_t* it = std::lower_bound(_keys, keysEnd, key);
+        if (it == keysEnd || *it != key) {
+            return {nullptr, nullptr};
+        }
+        const size_t keyIdx = it - _keys;
+        return {_postings + _keyOffsets[keyIdx], _postings + _keyOffsets[keyIdx + 1]};
+    }
+
+    ScoreInfo getScoreInfo(const int scoreIdx) const {
+        const ScoreRecord& record = _scores[scoreIdx];
+        ScoreInfo info;
+        info.fileName = getString(record.fileNameId);
+        info.title = getString(record.titleId);
+        info.composerName = getString(record.composerNameId);
+        info.numNotes = record.numNotes;
+        info.numStreams = record.numStreams;
+        return info;
+    }
+
+    ScoreData getScoreData(const int scoreIdx) const {
+        const ScoreRecord& record = _scores[scoreIdx];
+        ScoreData data;
+        data.info = getScoreInfo(scoreIdx);
+        data.streams.resize(record.numStreams);
+        for (uint32_t s = 0; s < record.numStreams; s++) {
+            const StreamRecord& stream = _streams[record.firstStream + s];
+            auto& decoded = data.streams[s];
+            decoded.partIdx = stream.partIdx;
+            decoded.partName = getString(stream.partNameId);
+
+            const int32_t* intervals = getIntervals(stream);
+            const float* durations = getDurations(stream);
+            const EventRecord* events = getEvents(stream);
+            for (uint32_t e = 0; e < stream.numEvents; e++) {
+                decoded.intervals.push_back(intervals[e]);
+                decoded.quarterDurations.push_back(durations[e]);
+                decoded.writtenPitches.push_back(getString(events[e].writtenPitchId));
+                decoded.soundingPitches.push_back(
+                    (events[e].soundingPitchId == NO_PITCH) ? std::string()
+                                                            : getString(events[e].soundingPitchId));
+                decoded.keyNames.push_back(getString(events[e].keyId));
+                decoded.measureIdx.push_back(events[e].measureIdx);
+                decoded.staveIdx.push_back(events[e].staveIdx);
+            }
+        }
+        return data;
+    }
+
+   private:
+    std::shared_ptr<const MappedFile> _file;
+    std::vector<uint64_t> _buffer;
+
+    const FileHeader* _header = nullptr;
+    const uint64_t* _stringOffsets = nullptr;
+    const char* _stringData = nullptr;
+    const ScoreRecord* _scores = nullptr;
+    const StreamRecord* _streams = nullptr;
+    const int32_t* _intervals = nullptr;
+    const float* _durations = nullptr;
+    const EventRecord* _events = nullptr;
+    const uint32_t* _keys = nullptr;
+    const uint64_t* _keyOffsets = nullptr;
+    const PostingRecord* _postings = nullptr;
+
+    void parse(const char* data, const size_t size, const std::string& name);
+};
+
+void MelodyCorpusIndex::Segment::parse(const char* data, const size_t size,
+                                       const std::string& name) {
+    const std::string error = "Invalid melody index file '" + name + "': ";
+    if (size < sizeof(FileHeader)) {
+        LOG_ERROR(error + "truncated header");
+    }
+
+    _header = reinterpret_cast<const FileHeader*>(data);
+    if (std::memcmp(_header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0) {
+        LOG_ERROR(error + "not a melody index");
+    }
+    if (_header->byteOrderMark != BYTE_ORDER_MARK) {
+        LOG_ERROR(error + "saved with a different byte order");
+    }
+    if (_header->version != INDEX_VERSION || _header->gramSize != GRAM_SIZE) {
+        LOG_ERROR(error + "unsupported version " + std::to_string(_header->version));
+    }
+    if (_header->fileSize != size) {
+        LOG_ERROR(error + "truncated file");
+    }
+
+    // Every section must lie inside the file
+    const auto section = [&](const uint64_t pos, const uint64_t count, const size_t itemSize) {
+        if (pos % 8 != 0 || pos > size || count > (size - pos) / itemSize) {
+            LOG_ERROR(error + "corrupted section table");
+        }
+        return data + pos;
+    };
+
+    const FileHeader& h = *_header;
+    _stringOffsets = reinterpret_cast<const uint64_t*>(
+        section(h.stringOffsetsPos, h.numStrings + 1, sizeof(uint64_t)));
+    _stringData = section(h.stringDataPos, _stringOffsets[h.numStrings], 1);
+    _scores = reinterpret_cast<const ScoreRecord*>(
+        section(h.scoresPos, h.numScores, sizeof(ScoreRecord)));
+    _streams = reinterpret_cast<const StreamRecord*>(
+        section(h.streamsPos, h.numStreams, sizeof(StreamRecord)));
+    _intervals = reinterpret_cast<const int32_t*>(
+        section(h.intervalsPos, h.numEvents, sizeof(int32_t)));
+    _durations = reinterpret_cast<const float*>(section(h.durationsPos, h.numEvents, sizeof(float)));
+    _events = reinterpret_cast<const EventRecord*>(
+        section(h.eventsPos, h.numEvents, sizeof(EventRecord)));
+    _keys = reinterpret_cast<const uint32_t*>(section(h.keysPos, h.numKeys, sizeof(uint32_t)));
+    _keyOffsets = reinterpret_cast<const uint64_t*>(
+        section(h.keyOffsetsPos, h.numKeys + 1, sizeof(uint64_t)));
+    _postings = reinterpret_cast<const PostingRecord*>(
+        section(h.postingsPos, h.numPostings, sizeof(PostingRecord)));
+
+    for (uint64_t i = 0; i < h.numStrings; i++) {
+        if (_stringOffsets[i] > _stringOffsets[i + 1]) {
+            LOG_ERROR(error + "corrupted string table");
+        }
+    }
+    for (uint64_t i = 0; i < h.numScores; i++) {
+        if (static_cast<uint64_t>(_scores[i].firstStream) + _scores[i].numStreams > h.numStreams) {
+            LOG_ERROR(error + "corrupted score table");
+        }
+    }
+    for (uint64_t i = 0; i < h.numStreams; i++) {
+        if (_streams[i].scoreIdx >= h.numScores ||
+            _streams[i].firstEvent + _streams[i].numEvents > h.numEvents) {
+            LOG_ERROR(error + "corrupted stream table");
+        }
+    }
+    if (_keyOffsets[h.numKeys] != h.numPostings) {
+        LOG_ERROR(error + "corrupted posting lists");
+    }
+}
+
+std::vector<uint64_t> MelodyCorpusIndex::Segment::serialize(
+    const std::vector<const ScoreData*>& scores) {
+    // ===== STEP 1: TABELAS ===== //
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> stringIds;
+    const auto intern = [&](const std::string& text) {
+        const auto it = stringIds.emplace(text, static_cast<uint32_t>(strings.size()));
+        if (it.second) {
+            strings.push_back(text);
+        }
+        return it.first->second;
+    };
+
+    std::vector<ScoreRecord> scoreRecords;
+    std::vector<StreamRecord> streamRecords;
+    std::vector<int32_t> intervals;
+    std::vector<float> durations;
+    std::vector<EventRecord> events;
+    std::vector<std::pair<uint32_t, PostingRecord>> postings;
+
+    for (const ScoreData* score : scores) {
+        ScoreRecord scoreRecord;
+        scoreRecord.fileNameId = intern(score->info.fileName);
+        scoreRecord.titleId = intern(score->info.title);
+        scoreRecord.composerNameId = intern(score->info.composerName);
+        scoreRecord.numNotes = score->info.numNotes;
+        scoreRecord.firstStream = streamRecords.size();
+        scoreRecord.numStreams = score->streams.size();
+
+        for (const auto& stream : score->streams) {
+            const uint32_t streamIdx = streamRecords.size();
+            StreamRecord streamRecord;
+            streamRecord.scoreIdx = scoreRecords.size();
+            streamRecord.partIdx = stream.partIdx;
+            streamRecord.partNameId = intern(stream.partName);
+            streamRecord.numEvents = stream.quarterDurations.size();
+            streamRecord.firstEvent = durations.size();
+            streamRecords.push_back(streamRecord);
+
+            const int numEvents = stream.quarterDurations.size();
+            for (int e = 0; e < numEvents; e++) {
+                intervals.push_back(stream.intervals[e]);
+                durations.push_back(stream.quarterDurations[e]);
+                events.push_back({intern(stream.writtenPitches[e]),
+                                  stream.soundingPitches[e].empty()
+                                      ? NO_PITCH
+                                      : intern(stream.soundingPitches[e]),
+                                  intern(stream.keyNames[e]),
+                                  static_cast<uint32_t>(stream.measureIdx[e]),
+                                  static_cast<uint32_t>(stream.staveIdx[e])});
+            }
+
+            // Same n-grams of the melody search index of Score
+            for (int e = 0; e + GRAM_SIZE < numEvents; e++) {
+                postings.push_back({Helper::intervalsGramKey(&stream.intervals[e], GRAM_SIZE),
+                                    {streamIdx, static_cast<uint32_t>(e)}});
+            }
+        }
+
+        scoreRecords.push_back(scoreRecord);
+    }
+
+    // ===== STEP 2: LISTAS DE POSTINGS ===== //
+    std::sort(postings.begin(), postings.end(), [](const auto& a, const auto& b) {
+        return std::tie(a.first, a.second.streamIdx, a.second.offset) <
+               std::tie(b.first, b.second.streamIdx, b.second.offset);
+    });
+
+    std::vector<uint32_t> keys;
+    std::vector<uint64_t> keyOffsets;
+    for (size_t i = 0; i < postings.size(); i++) {
+        if (i == 0 || postings[i].first != postings[i - 1].first) {
+            keys.push_back(postings[i].first);
+            keyOffsets.push_back(i);
+        }
+    }
+    keyOffsets.push_back(postings.size());
+
+    std::vector<uint64_t> stringOffsets = {0};
+    for (const auto& text : strings) {
+        stringOffsets.push_back(stringOffsets.back() + text.size());
+    }
+
+    // ===== STEP 3: LAYOUT E CÓPIA ===== //
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.version = INDEX_VERSION;
+    header.byteOrderMark = BYTE_ORDER_MARK;
+    header.gramSize = GRAM_SIZE;
+    header.numStrings = strings.size();
+    header.numScores = scoreRecords.size();
+    header.numStreams = streamRecords.size();
+    header.numEvents = durations.size();
+    header.numKeys = keys.size();
+    header.numPostings = postings.size();
+
+    uint64_t pos = alignTo8(sizeof(FileHeader));
+    const auto place = [&pos](uint64_t* sectionPos, const uint64_t numBytes) {
+        *sectionPos = pos;
+        pos = alignTo8(pos + numBytes);
+    };
+    place(&header.stringOffsetsPos, stringOffsets.size() * sizeof(uint64_t));
+    place(&header.stringDataPos, stringOffsets.back());
+    place(&header.scoresPos, scoreRecords.size() * sizeof(ScoreRecord));
+    place(&header.streamsPos, streamRecords.size() * sizeof(StreamRecord));
+    place(&header.intervalsPos, intervals.size() * sizeof(int32_t));
+    place(&header.durationsPos, durations.size() * sizeof(float));
+    place(&header.eventsPos, events.size() * sizeof(EventRecord));
+    place(&header.keysPos, keys.size() * sizeof(uint32_t));
+    place(&header.keyOffsetsPos, keyOffsets.size() * sizeof(uint64_t));
+    place(&header.postingsPos, postings.size() * sizeof(PostingRecord));
+    header.fileSize = pos;
+
+    std::vector<uint64_t> buffer(pos / sizeof(uint64_t), 0);
+    char* bytes = reinterpret_cast<char*>(buffer.data());
+    const auto copy = [bytes](const uint64_t sectionPos, const void* source, const size_t numBytes) {
+        if (numBytes > 0) {
+            std::memcpy(bytes + sectionPos, source, numBytes);
+        }
+    };
+
+    copy(0, &header, sizeof(header));
+    copy(header.stringOffsetsPos, stringOffsets.data(), stringOffsets.size() * sizeof(uint64_t));
+    for (size_t i = 0; i < strings.size(); i++) {
+        copy(header.stringDataPos + stringOffsets[i], strings[i].data(), strings[i].size());
+    }
+    copy(header.scoresPos, scoreRecords.data(), scoreRecords.size() * sizeof(ScoreRecord));
+    copy(header.streamsPos, streamRecords.data(), streamRecords.size() * sizeof(StreamRecord));
+    copy(header.intervalsPos, intervals.data(), intervals.size() * sizeof(int32_t));
+    copy(header.durationsPos, durations.data(), durations.size() * sizeof(float));
+    copy(header.eventsPos, events.data(), events.size() * sizeof(EventRecord));
+    copy(header.keysPos, keys.data(), keys.size() * sizeof(uint32_t));
+    copy(header.keyOffsetsPos, keyOffsets.data(), keyOffsets.size() * sizeof(uint64_t));
+    for (size_t i = 0; i < postings.size(); i++) {
+        copy(header.postingsPos + i * sizeof(PostingRecord), &postings[i].second,
+             sizeof(PostingRecord));
+    }
+
+    return buffer;
+}
+
+MelodyCorpusIndex::MelodyCorpusIndex() = default;
+
+MelodyCorpusIndex::MelodyCorpusIndex(const std::string& filePath) {
+    appendSegment(Segment::fromFile(filePath));
+}
+
+void MelodyCorpusIndex::extractScoreData(const Score& score, ScoreData* data) {
+    const Score::MelodySearchIndex& index = score.getMelodySearchIndex();
+
+    data->info.fileName = score.getFileName();
+    data->info.title = score.getTitle();
+    data->info.composerName = score.getComposerName();
+    data->info.numNotes = score.getNumNotes();
+    data->info.numStreams = index.streams.size();
+
+    data->streams.resize(index.streams.size());
+    for (size_t streamIdx = 0; streamIdx < index.streams.size(); streamIdx++) {
+        const auto& noteEvents = index.noteEvents[streamIdx];
+        auto& stream = data->streams[streamIdx];
+        stream.partIdx = index.streams[streamIdx].partIdx;
+        stream.partName = score._part[stream.partIdx].getName();
+        stream.intervals = index.intervals[streamIdx];
+        stream.intervals.resize(noteEvents.size(), 0);
+        stream.quarterDurations = index.quarterDurations[streamIdx];
+
+        for (size_t e = 0; e < noteEvents.size(); e++) {
+            const Note& note = *noteEvents[e].notePtr;
+            stream.writtenPitches.push_back(note.getWrittenPitch());
+            stream.soundingPitches.push_back(note.isNoteOff() ? std::string()
+                                                              : note.getSoundingPitch());
+            stream.keyNames.push_back(noteEvents[e].keyName);
+            stream.measureIdx.push_back(noteEvents[e].measureIdx);
+            stream.staveIdx.push_back(noteEvents[e].staveIdx);
+        }
+    }
+}
+
+int MelodyCorpusIndex::addScore(const Score& score) { return addScores({&score}, 1)[0]; }
+
+std::vector<int> MelodyCorpusIndex::addScores(const std::vector<const Score*>& scores,
+                                              const int numThreads) {
+    std::vector<int> entryIds;
+    if (scores.empty()) {
+        return entryIds;
+    }
+
+    // A score listed twice (shared by two positions of a collection) is extracted once: the
+    // extraction fills its melody search index, which is not safe from two threads
+    std::unordered_map<const Score*, size_t> firstIdx;
+    std::vector<size_t> uniqueIdx;
+    for (size_t scoreIdx = 0; scoreIdx < scores.size(); scoreIdx++) {
+        if (firstIdx.emplace(scores[scoreIdx], scoreIdx).second) {
+            uniqueIdx.push_back(scoreIdx);
+        }
+    }
+
+    std::vector<ScoreData> data(scores.size());
+    ThreadPool::parallelFor(uniqueIdx.size(), [&](const size_t i) {
+        extractScoreData(*scores[uniqueIdx[i]], &data[uniqueIdx[i]]);
+    }, numThreads);
+    for (size_t scoreIdx = 0; scoreIdx < scores.size(); scoreIdx++) {
+        const size_t sourceIdx = firstIdx[scores[scoreIdx]];
+        if (sourceIdx != scoreIdx) {
+            data[scoreIdx] = data[sourceIdx];
+        }
+    }
+
+    std::vector<const ScoreData*> dataPtrs;
+    for (const auto& scoreData : data) {
+        dataPtrs.push_back(&scoreData);
+    }
+
+    const int firstEntryId = _removed.size();
+    appendSegment(Segment::fromScores(dataPtrs));
+    for (size_t i = 0; i < scores.size(); i++) {
+        entryIds.push_back(firstEntryId + i);
+    }
+    return entryIds;
+}
+
+void MelodyCorpusIndex::appendSegment(std::shared_ptr<const Segment> segment) {
+    _firstEntryIds.push_back(_removed.size());
+    _removed.resize(_removed.size() + segment->getNumScores(), false);
+    _numLiveEntries += segment->getNumScores();
+    _segments.push_back(std::move(segment));
+}
+
+std::pair<int, int> MelodyCorpusIndex::locateEntry(const int entryId) const {
+    if (!hasEntry(entryId)) {
+        LOG_ERROR("Invalid melody index entry: " + std::to_string(entryId));
+    }
+
+    const int segmentIdx =
+        std::upper_bound(_firstEntryIds.begin(), _firstEntryIds.end(), entryId) -
+        _firstEntryIds.begin() - 1;
+    return {segmentIdx, entryId - _firstEntryIds[segmentIdx]};
+}
+
+void MelodyCorpusIndex::removeScore(const int entryId) {
+    locateEntry(entryId);
+    _removed[entryId] = true;
+    _numLiveEntries--;
+}
+
+bool MelodyCorpusIndex::hasEntry(const int entryId) const {
+    return entryId >= 0 && entryId < static_cast<int>(_removed.size()) && !_removed[entryId];
+}
+
+int MelodyCorpusIndex::getNumScores() const { return _numLiveEntries; }
+
+std::vector<int> MelodyCorpusIndex::getEntryIds() const {
+    std::vector<int> entryIds;
+    entryIds.reserve(_numLiveEntries);
+    for (int entryId = 0; entryId < static_cast<int>(_removed.size()); entryId++) {
+        if (!_removed[entryId]) {
+            entryIds.push_back(entryId);
+        }
+    }
+    return entryIds;
+}
+
+MelodyCorpusIndex::ScoreInfo MelodyCorpusIndex::getScoreInfo(const int entryId) const {
+    const auto location = locateEntry(entryId);
+    return _segments[location.first]->getScoreInfo(location.second);
+}
+
+int MelodyCorpusIndex::getNumSegments() const { return _segments.size(); }
+
+void MelodyCorpusIndex::save(const std::string& filePath) const {
+    // Compaction: the live entries of all segments in a single file
+    std::vector<ScoreData> data;
+    data.reserve(_numLiveEntries);
+    for (const int entryId : getEntryIds()) {
+        const auto location = locateEntry(entryId);
+        data.push_back(_segments[location.first]->getScoreData(location.second));
+    }
+
+    std::vector<const ScoreData*> dataPtrs;
+    for (const auto& scoreData : data) {
+        dataPtrs.push_back(&scoreData);
+    }
+    const std::vector<uint64_t> buffer = Segment::serialize(dataPtrs);
+
+    // Written to a temporary file first: a mapped index may be the destination
+    const std::string tempPath = filePath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            LOG_ERROR("Unable to write the melody index file: " + filePath);
+        }
+        file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(uint64_t));
+        if (!file) {
+            LOG_ERROR("Unable to write the melody index file: " + filePath);
+        }
+    }
+
+    std::remove(filePath.c_str());
+    if (std::rename(tempPath.c_str(), filePath.c_str()) != 0) {
+        LOG_ERROR("Unable to write the melody index file: " + filePath);
+    }
+}
+
+std::vector<MelodyCorpusIndex::Row> MelodyCorpusIndex::findMelodyPattern(
+    const std::vector<Note>& melodyPattern, const float totalIntervalsSimilarityThreshold,
+    const float totalRhythmSimilarityThreshold, const int numThreads,
+    std::vector<int>* skippedEntryIds) const {
+    std::vector<Row> rows;
+    const int melodyPatternSize = melodyPattern.size();
+    if (melodyPatternSize == 0) {
+        return rows;
+    }
+    if (melodyPatternSize < 2) {
+        LOG_ERROR("The melody corpus index needs patterns of at least 2 notes");
+    }
+
+    // ===== STEP 1: VETORES DO PADRÃO ===== //
+    const int numPatternIntervals = melodyPatternSize - 1;
+    std::vector<int> patternIntervals(numPatternIntervals);
+    for (int i = 0; i < numPatternIntervals; i++) {
+        patternIntervals[i] = melodicInterval(melodyPattern[i], melodyPattern[i + 1]);
+    }
+
+    std::vector<float> patternDurations(melodyPatternSize);
+    float patternMaxDuration = 0.0f;
+    for (int i = 0; i < melodyPatternSize; i++) {
+        patternDurations[i] = melodyPattern[i].getDuration().getQuarterDuration();
+        patternMaxDuration = std::max(patternMaxDuration, patternDurations[i]);
+    }
+
+    const Note* patternFirstNoteOn = nullptr;
+    for (const Note& note : melodyPattern) {
+        if (!note.isNoteOff()) {
+            patternFirstNoteOn = &note;
+            break;
+        }
+    }
+
+    // Same candidate rule of Score::findMelodyPattern(): a window above the interval threshold
+    // matches at least one of the (allowed mismatches + 1) blocks of the pattern intervals
+    int maxIntervalMismatches = -1;
+    while (maxIntervalMismatches < numPatternIntervals &&
+           1.0f / (1.0f + std::sqrt(static_cast<float>(maxIntervalMismatches + 1))) >=
+               totalIntervalsSimilarityThreshold) {
+        maxIntervalMismatches++;
+    }
+    const int numBlocks = maxIntervalMismatches + 1;
+    const int blockSize = (numBlocks > 0) ? numPatternIntervals / numBlocks : 0;
+    const bool useIndex = numBlocks > 0 && blockSize >= GRAM_SIZE;
+
+    // ===== STEP 2: TAREFAS (ENTRADA, STREAM) ===== //
+    struct StreamTask {
+        int entryId;
+        int segmentIdx;
+        int streamIdx;
+        std::vector<int> candidates;  // Empty: every window
+    };
+    std::vector<StreamTask> tasks;
+
+    for (size_t segmentIdx = 0; segmentIdx < _segments.size(); segmentIdx++) {
+        const Segment& segment = *_segments[segmentIdx];
+        const int numScores = segment.getNumScores();
+        std::vector<bool> searchScore(numScores, false);
+        for (int scoreIdx = 0; scoreIdx < numScores; scoreIdx++) {
+            const int entryId = _firstEntryIds[segmentIdx] + scoreIdx;
+            if (_removed[entryId]) {
+                continue;
+            }
+
+            if (static_cast<int>(segment.getScore(scoreIdx).numNotes) < melodyPatternSize) {
+                if (skippedEntryIds == nullptr) {
+                    LOG_ERROR("The melody pattern is bigger than the score");
+                }
+                skippedEntryIds->push_back(entryId);
+                continue;
+            }
+            searchScore[scoreIdx] = true;
+        }
+
+        if (!useIndex) {
+            for (int streamIdx = 0; streamIdx < segment.getNumStreams(); streamIdx++) {
+                const int scoreIdx = segment.getStream(streamIdx).scoreIdx;
+                if (searchScore[scoreIdx]) {
+                    tasks.push_back(
+                        {_firstEntryIds[segmentIdx] + scoreIdx, (int)segmentIdx, streamIdx, {}});
+                }
+            }
+            continue;
+        }
+
+        std::vector<std::pair<int, int>> candidates;  // (stream, window)
+        for (int block = 0; block < numBlocks; block++) {
+            const int blockStart = block * blockSize;
+            const auto range = segment.findPostings(
+                Helper::intervalsGramKey(&patternIntervals[blockStart], GRAM_SIZE));
+            for (const PostingRecord* posting = range.first; posting != range.second; posting++) {
+                if (posting->streamIdx >= static_cast<uint32_t>(segment.getNumStreams())) {
+                    LOG_ERROR("Corrupted melody index: invalid posting");
+                }
+                const StreamRecord& stream = segment.getStream(posting->streamIdx);
+                const int windowIdx = static_cast<int>(posting->offset) - blockStart;
+                const int numWindows = static_cast<int>(stream.numEvents) - melodyPatternSize;
+                if (searchScore[stream.scoreIdx] && windowIdx >= 0 && windowIdx < numWindows) {
+                    candidates.emplace_back(posting->streamIdx, windowIdx);
+                }
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        for (const auto& candidate : candidates) {
+            if (tasks.empty() || tasks.back().segmentIdx != (int)segmentIdx ||
+                tasks.back().streamIdx != candidate.first) {
+                const int scoreIdx = segment.getStream(candidate.first).scoreIdx;
+                tasks.push_back(
+                    {_firstEntryIds[segmentIdx] + scoreIdx, (int)segmentIdx, candidate.first, {}});
+            }
+            tasks.back().candidates.push_back(candidate.second);
+        }
+    }
+
+    // ===== STEP 3: VERIFICAÇÃO DE CADA STREAM ===== //
+    std::vector<std::vector<Row>> taskRows(tasks.size());
+    ThreadPool::parallelFor(tasks.size(), [&](const size_t taskIdx) {
+        const StreamTask& task = tasks[taskIdx];
+        const Segment& segment = *_segments[task.segmentIdx];
+        const StreamRecord& stream = segment.getStream(task.streamIdx);
+        const int32_t* intervals = segment.getIntervals(stream);
+        const float* durations = segment.getDurations(stream);
+        const EventRecord* events = segment.getEvents(stream);
+        const std::string partName = segment.getString(stream.partNameId);
+
+        std::vector<int> windows = task.candidates;
+        if (!useIndex) {
+            for (int i = 0; i + melodyPatternSize < static_cast<int>(stream.numEvents); i++) {
+                windows.push_back(i);
+            }
+        }
+
+        std::vector<float> durationDiff(melodyPatternSize);
+        for (const int i : windows) {
+            const float totalIntervalSimilarity = Helper::intervalsEuclideanSimilarity(
+                patternIntervals.data(), &intervals[i], numPatternIntervals);
+            if (totalIntervalSimilarity < totalIntervalsSimilarityThreshold) {
+                continue;
+            }
+
+            float totalRhythmSimilarity = 0.0f;
+            if (!Helper::durationsEuclideanSimilarity(patternDurations.data(), patternMaxDuration,
+                                                      &durations[i], melodyPatternSize,
+                                                      totalRhythmSimilarityThreshold,
+                                                      durationDiff.data(),
+                                                      &totalRhythmSimilarity)) {
+                continue;
+            }
+
+            std::string intervalName;
+            for (int k = 0; k < melodyPatternSize && patternFirstNoteOn != nullptr; k++) {
+                if (events[i + k].soundingPitchId != NO_PITCH) {
+                    const Interval transposeInterval(
+                        patternFirstNoteOn->getSoundingPitch(),
+                        segment.getString(events[i + k].soundingPitchId));
+                    intervalName =
+                        transposeInterval.getName() + " " + transposeInterval.getDirection();
+                    break;
+                }
+            }
+
+            std::vector<std::string> segmentPitchList(melodyPatternSize);
+            for (int k = 0; k < melodyPatternSize; k++) {
+                segmentPitchList[k] = segment.getString(events[i + k].writtenPitchId);
+            }
+
+            std::vector<float> semitonesDiff(numPatternIntervals);
+            for (int k = 0; k < numPatternIntervals; k++) {
+                semitonesDiff[k] = (float)patternIntervals[k] - (float)intervals[i + k];
+            }
+
+            Row row;
+            row.entryId = task.entryId;
+            row.row = Score::MelodyPatternRow(
+                partName, events[i].measureIdx, events[i].staveIdx,
+                segment.getString(events[i].keyId), intervalName, std::move(segmentPitchList),
+                std::move(semitonesDiff), durationDiff, totalIntervalSimilarity,
+                totalRhythmSimilarity, (totalIntervalSimilarity + totalRhythmSimilarity) / 2.0f);
+            taskRows[taskIdx].push_back(std::move(row));
+        }
+    }, numThreads);
+
+    for (auto& table : taskRows) {
+        rows.insert(rows.end(), std::make_move_iterator(table.begin()),
+                    std::make_move_iterator(table.end()));
+    }
+
+    return rows;
+}
@@ -0,0 +1,645 @@
+#include "maiacore/melody_regex.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "maiacore/log.h"
+
+namespace {
+
+const int MAX_NUM_ATOMS = 64;           // Atom masks are 64-bit
+const int MAX_REPEAT_COUNT = 256;       // Largest {n,m} bound
+const size_t MAX_NUM_NFA_STATES = 200000;
+const float DURATION_TOLERANCE = 1e-3f;  // Tuplets have non-exact quarter durations
+
+// Parses a whole string as a number. Returns false if there are trailing characters
+bool parseNumber(const std::string& text, double* value) {
+    if (text.empty()) {
+        return false;
+    }
+
+    size_t numParsed = 0;
+    try {
+        *value = std::stod(text, &numParsed);
+    } catch (const std::exception&) {
+        return false;
+    }
+    return numParsed == text.size();
+}
+
+}  // namespace
+
+// ============================================================================
+// Expression tree and parser
+// ============================================================================
+
+struct MelodyRegex::Node {
+    enum class Type { ATOM, CONCAT, ALTERNATION, REPEAT };
+
+    Type type = Type::ATOM;
+    int atomIdx = -1;    ///< ATOM only.
+    int minCount = 0;    ///< REPEAT only.
+    int maxCount = -1;   ///< REPEAT only (-1: unbounded).
+    std::vector<std::unique_ptr<Node>> children;
+};
+
+class MelodyRegex::Parser {
+   public:
+    Parser(const std::string& pattern, std::vector<Atom>* atoms)
+        : _pattern(pattern), _atoms(atoms) {}
+
+    std::unique_ptr<Node> parse() {
+        auto root = parseAlternation();
+        skipSpaces();
+        if (_pos < _pattern.size()) {
+            error("unexpected '" + std::string(1, _pattern[_pos]) + "'");
+        }
+        return root;
+    }
+
+   private:
+    const std::string& _pattern;
+    std::vector<Atom>* _atoms;
+    size_t _pos = 0;
+
+    [[noreturn]] void error(const std::string& message) const {
+        LOG_ERROR("Invalid melody expression '" + _pattern + "' at position " +
+                  std::to_string(_pos) + ": " + message);
+    }
+
+    void skipSpaces() {
+        while (_pos < _pattern.size() && std::isspace(static_cast<unsigned char>(_pattern[_pos]))) {
+            _pos++;
+        }
+    }
+
+    bool peek(const char c) {
+        skipSpaces();
+        return _pos < _pattern.size() && _pattern[_pos] == c;
+    }
+
+    std::unique_ptr<Node> parseAlternation() {
+        auto first = parseConcatenation();
+        if (!peek('|')) {
+            return first;
+        }
+
+        auto node = std::make_unique<Node>();
+        node->type = Node::Type::ALTERNATION;
+        node->children.push_back(std::move(first));
+        while (peek('|')) {
+            _pos++;
+            node->children.push_back(parseConcatenation());
+        }
+        return node;
+    }
+
+    std::unique_ptr<Node> parseConcatenation() {
+        auto node = std::make_unique<Node>();
+        node->type = Node::Type::CONCAT;
+        skipSpaces();
+        while (_pos < _pattern.size() && _pattern[_pos] != '|' && _pattern[_pos] != ')') {
+            node->children.push_back(parseRepeat());
+            skipSpaces();
+        }
+
+        if (node->children.empty()) {
+            error("empty expression");
+        }
+        if (node->children.size() == 1) {
+            return std::move(node->children.front());
+        }
+        return node;
+    }
+
+    std::unique_ptr<Node> parseRepeat() {
+        auto node = parsePrimary();
+        while (true) {
+            skipSpaces();
+            if (_pos >= _pattern.size()) {
+                return node;
+            }
+
+            int minCount = 0;
+            int maxCount = -1;
+            const char c = _pattern[_pos];
+            if (c == '*') {
+                _pos++;
+            } else if (c == '+') {
+                minCount = 1;
+                _pos++;
+            } else if (c == '?') {
+                maxCount = 1;
+                _pos++;
+            } else if (c == '{') {
+                parseBounds(&minCount, &maxCount);
+            } else {
+                return node;
+            }
+
+            auto repeat = std::make_unique<Node>();
+            repeat->type = Node::Type::REPEAT;
+            repeat->minCount = minCount;
+            repeat->maxCount = maxCount;
+            repeat->children.push_back(std::move(node));
+            node = std::move(repeat);
+        }
+    }
+
+    // {n}, {n,} or {n,m}
+    void parseBounds(int* minCount, int* maxCount) {
+        const size_t closePos = _pattern.find('}', _pos);
+        if (closePos == std::string::npos) {
+            error("missing '}'");
+        }
+
+        const std::string bounds = _pattern.substr(_pos + 1, closePos - _pos - 1);
+        const size_t commaPos = bounds.find(',');
+        const std::string minText = bounds.substr(0, commaPos);
+        const std::string maxText =
+            (commaPos == std::string::npos) ? minText : bounds.substr(commaPos + 1);
+
+        double minValue = 0.0;
+        double maxValue = -1.0;
+        if (!parseNumber(minText, &minValue) ||
+            (!maxText.empty() && !parseNumber(maxText, &maxValue))) {
+            error("invalid repeat bounds '{" + bounds + "}'");
+        }
+
+        *minCount = static_cast<int>(minValue);
+        *maxCount = static_cast<int>(maxValue);
+        if (*minCount < 0 || *minCount > MAX_REPEAT_COUNT || *maxCount > MAX_REPEAT_COUNT ||
+            (*maxCount >= 0 && *maxCount < *minCount)) {
+            error("invalid repeat bounds '{" + bounds + "}'");
+        }
+        _pos = closePos + 1;
+    }
+
+    std::unique_ptr<Node> parsePrimary() {
+        const char c = _pattern[_pos];
+        if (c == '(') {
+            _pos++;
+            auto node = parseAlternation();
+            if (!peek(')')) {
+                error("missing ')'");
+            }
+            _pos++;
+            return node;
+        }
+
+        Atom atom;
+        if (c == '.') {
+            _pos++;
+        } else if (c == 'N') {
+            atom.requireNote = true;
+            _pos++;
+        } else if (c == 'R') {
+            atom.requireRest = true;
+            _pos++;
+        } else if (c == '[') {
+            _pos++;
+            atom = parseConditions();
+        } else {
+            error("unexpected '" + std::string(1, c) + "'");
+        }
+
+        if (static_cast<int>(_atoms->size()) >= MAX_NUM_ATOMS) {
+            error("more than " + std::to_string(MAX_NUM_ATOMS) + " event conditions");
+        }
+
+        auto node = std::make_unique<Node>();
+        node->type = Node::Type::ATOM;
+        node->atomIdx = _atoms->size();
+        _atoms->push_back(atom);
+        return node;
+    }
+
+    // Conditions of a '[...]' atom, up to the closing ']'
+    Atom parseConditions() {
+        Atom atom;
+        int minInterval = INT_MIN;
+        int maxInterval = INT_MAX;
+        float minDuration = 0.0f;
+        float maxDuration = static_cast<float>(INT_MAX);
+
+        while (true) {
+            skipSpaces();
+            if (_pos >= _pattern.size()) {
+                error("missing ']'");
+            }
+            if (_pattern[_pos] == ']') {
+                _pos++;
+                break;
+            }
+
+            const size_t tokenStart = _pos;
+            while (_pos < _pattern.size() && _pattern[_pos] != ']' &&
+                   !std::isspace(static_cast<unsigned char>(_pattern[_pos]))) {
+                _pos++;
+            }
+            const std::string token = _pattern.substr(tokenStart, _pos - tokenStart);
+
+            if (token == "note") {
+                atom.requireNote = true;
+            } else if (token == "rest") {
+                atom.requireRest = true;
+            } else if (token == "dotted") {
+                atom.requireDotted = true;
+            } else if (token == "up") {
+                atom.hasIntervalRange = true;
+                minInterval = std::max(minInterval, 1);
+            } else if (token == "down") {
+                atom.hasIntervalRange = true;
+                maxInterval = std::min(maxInterval, -1);
+            } else if (token == "same") {
+                atom.hasIntervalRange = true;
+                minInterval = std::max(minInterval, 0);
+                maxInterval = std::min(maxInterval, 0);
+            } else if (token.size() > 1 && (token[0] == 'i' || token[0] == 'd')) {
+                double low = 0.0;
+                double high = 0.0;
+                parseComparison(token, &low, &high);
+                if (token[0] == 'i') {
+                    atom.hasIntervalRange = true;
+                    minInterval = std::max(minInterval, static_cast<int>(low));
+                    maxInterval = std::min(maxInterval, static_cast<int>(high));
+                } else {
+                    atom.hasDurationRange = true;
+                    minDuration = std::max(minDuration, static_cast<float>(low) - DURATION_TOLERANCE);
+                    maxDuration = std::min(maxDuration, static_cast<float>(high) + DURATION_TOLERANCE);
+                }
+            } else {
+                error("unknown condition '" + token + "'");
+            }
+        }
+
+        if (atom.requireNote && atom.requireRest) {
+            error("an event cannot be both a note and a rest");
+        }
+
+        atom.minInterval = minInterval;
+        atom.maxInterval = maxInterval;
+        atom.minDuration = minDuration;
+        atom.maxDuration = maxDuration;
+        return atom;
+    }
+
+    // 'i=+3', 'i=-2..-1', 'i>0', 'd<=1', ... as an inclusive range [low, high]
+    void parseComparison(const std::string& token, double* low, double* high) const {
+        const bool isInterval = token[0] == 'i';
+        size_t valueStart = 1;
+        std::string op;
+        while (valueStart < token.size() && valueStart < 3 &&
+               (token[valueStart] == '=' || token[valueStart] == '<' || token[valueStart] == '>')) {
+            op += token[valueStart++];
+        }
+
+        // Intervals are whole semitones
+        const auto parseValue = [isInterval](const std::string& text, double* value) {
+            return parseNumber(text, value) && (!isInterval || std::floor(*value) == *value);
+        };
+
+        const std::string valueText = token.substr(valueStart);
+        double value = 0.0;
+        if (op == "=") {
+            const size_t rangePos = valueText.find("..");
+            double rangeEnd = 0.0;
+            if (rangePos == std::string::npos) {
+                if (!parseValue(valueText, &value)) {
+                    error("invalid value in '" + token + "'");
+                }
+                *low = value;
+                *high = value;
+            } else if (!parseValue(valueText.substr(0, rangePos), &value) ||
+                       !parseValue(valueText.substr(rangePos + 2), &rangeEnd) || rangeEnd < value) {
+                error("invalid range in '" + token + "'");
+            } else {
+                *low = value;
+                *high = rangeEnd;
+            }
+            return;
+        }
+
+        if (!parseValue(valueText, &value)) {
+            error("invalid condition '" + token + "'");
+        }
+
+        // Strict comparisons: one semitone for intervals, the tolerance for durations
+        const double step = isInterval ? 1.0 : 2.0 * DURATION_TOLERANCE;
+        if (op == "<") {
+            *low = -1e9;
+            *high = value - step;
+        } else if (op == "<=") {
+            *low = -1e9;
+            *high = value;
+        } else if (op == ">") {
+            *low = value + step;
+            *high = 1e9;
+        } else if (op == ">=") {
+            *low = value;
+            *high = 1e9;
+        } else {
+            error("invalid operator in '" + token + "'");
+        }
+    }
+};
+
+// ============================================================================
+// Lazy DFA: subset construction on demand
+// ============================================================================
+
+class MelodyRegex::LazyDfa {
+   public:
+    /**
+     * @param unanchored If true, a new match may start before every event (search DFA).
+     */
+    LazyDfa(const Nfa& nfa, const bool unanchored) : _nfa(nfa), _unanchored(unanchored) {
+        _mark.assign(nfa.states.size(), 0);
+
+        // State 0 is the dead state
+        addState({});
+        _startSet = closure({nfa.start});
+        addState(_startSet);
+    }
+
+    int start() const { return 1; }
+
+    bool isAccepting(const int state) const { return _accepting[state] != 0; }
+
+    int next(const int state, const uint64_t mask) {
+        auto& transitions = _transitions[state];
+        const auto it = transitions.find(mask);
+        if (it != transitions.end()) {
+            return it->second;
+        }
+
+        std::vector<int> targets;
+        for (const int nfaState : _sets[state]) {
+            const NfaState& s = _nfa.states[nfaState];
+            if (s.atomIdx >= 0 && ((mask >> s.atomIdx) & 1)) {
+                targets.push_back(s.next);
+            }
+        }
+
+        std::vector<int> nextSet = closure(targets);
+        if (_unanchored) {
+            nextSet.insert(nextSet.end(), _startSet.begin(), _startSet.end());
+            std::sort(nextSet.begin(), nextSet.end());
+            nextSet.erase(std::unique(nextSet.begin(), nextSet.end()), nextSet.end());
+        }
+
+        const int nextState = addState(nextSet);
+        _transitions[state].emplace(mask, nextState);
+        return nextState;
+    }
+
+   private:
+    const Nfa& _nfa;
+    const bool _unanchored;
+    std::vector<int> _startSet;
+    std::vector<std::vector<int>> _sets;
+    std::vector<char> _accepting;
+    std::map<std::vector<int>, int> _ids;
+    std::vector<std::unordered_map<uint64_t, int>> _transitions;
+    std::vector<int> _mark;
+    int _markGeneration = 0;
+
+    // Sorted set of the atom states and the final state reachable by epsilon transitions
+    std::vector<int> closure(const std::vector<int>& states) {
+        _markGeneration++;
+        std::vector<int> stack(states.begin(), states.end());
+        std::vector<int> result;
+        while (!stack.empty()) {
+            const int s = stack.back();
+            stack.pop_back();
+            if (_mark[s] == _markGeneration) {
+                continue;
+            }
+            _mark[s] = _markGeneration;
+
+            const NfaState& state = _nfa.states[s];
+            if (state.atomIdx >= 0 || s == _nfa.final) {
+                result.push_back(s);
+            }
+            stack.insert(stack.end(), state.epsilons.begin(), state.epsilons.end());
+        }
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    int addState(const std::vector<int>& set) {
+        const auto it = _ids.find(set);
+        if (it != _ids.end()) {
+            return it->second;
+        }
+
+        const int id = _sets.size();
+        _ids.emplace(set, id);
+        _sets.push_back(set);
+        _accepting.push_back(std::binary_search(set.begin(), set.end(), _nfa.final) ? 1 : 0);
+        _transitions.emplace_back();
+        return id;
+    }
+};
+
+// ============================================================================
+// MelodyRegex
+// ============================================================================
+
+bool MelodyRegex::Atom::matches(const Event& event) const {
+    if ((requireNote && event.isRest) || (requireRest && !event.isRest) ||
+        (requireDotted && event.numDots == 0)) {
+        return false;
+    }
+
+    if (hasIntervalRange &&
+        (!event.hasInterval || event.interval < minInterval || event.interval > maxInterval)) {
+        return false;
+    }
+
+    if (hasDurationRange &&
+        (event.quarterDuration < minDuration || event.quarterDuration > maxDuration)) {
+        return false;
+    }
+
+    return true;
+}
+
+MelodyRegex::MelodyRegex(const std::string& pattern) : _pattern(pattern) {
+    Parser parser(_pattern, &_atoms);
+    const auto root = parser.parse();
+
+    _forward = compile(*root, false);
+    _reverse = compile(*root, true);
+
+    // A match must consume at least one event
+    LazyDfa dfa(_forward, false);
+    if (dfa.isAccepting(dfa.start())) {
+        LOG_ERROR("The melody expression '" + _pattern + "' matches an empty melody");
+    }
+}
+
+const std::string& MelodyRegex::getPattern() const { return _pattern; }
+
+std::pair<int, int> MelodyRegex::compileNode(const Node& node, const bool reverse, Nfa* nfa) {
+    auto& states = nfa->states;
+    if (states.size() > MAX_NUM_NFA_STATES) {
+        LOG_ERROR("The melody expression is too large");
+    }
+
+    const auto newState = [&states]() {
+        states.emplace_back();
+        return static_cast<int>(states.size()) - 1;
+    };
+
+    switch (node.type) {
+        case Node::Type::ATOM: {
+            const int atomState = newState();
+            const int end = newState();
+            states[atomState].atomIdx = node.atomIdx;
+            states[atomState].next = end;
+            return {atomState, end};
+        }
+
+        case Node::Type::CONCAT: {
+            const int numChildren = node.children.size();
+            std::pair<int, int> fragment = {-1, -1};
+            for (int c = 0; c < numChildren; c++) {
+                const Node& child = *node.children[reverse ? numChildren - 1 - c : c];
+                const auto childFragment = compileNode(child, reverse, nfa);
+                if (fragment.first < 0) {
+                    fragment = childFragment;
+                } else {
+                    states[fragment.second].epsilons.push_back(childFragment.first);
+                    fragment.second = childFragment.second;
+                }
+            }
+            return fragment;
+        }
+
+        case Node::Type::ALTERNATION: {
+            const int start = newState();
+            const int end = newState();
+            for (const auto& child : node.children) {
+                const auto childFragment = compileNode(*child, reverse, nfa);
+                states[start].epsilons.push_back(childFragment.first);
+                states[childFragment.second].epsilons.push_back(end);
+            }
+            return {start, end};
+        }
+
+        case Node::Type::REPEAT: {
+            const Node& child = *node.children.front();
+            const int start = newState();
+            int current = start;
+
+            // Mandatory copies
+            for (int i = 0; i < node.minCount; i++) {
+                const auto childFragment = compileNode(child, reverse, nfa);
+                states[current].epsilons.push_back(childFragment.first);
+                current = childFragment.second;
+            }
+
+            const int end = newState();
+            if (node.maxCount < 0) {
+                // Kleene star: loop through 'current'
+                const auto childFragment = compileNode(child, reverse, nfa);
+                states[current].epsilons.push_back(childFragment.first);
+                states[childFragment.second].epsilons.push_back(current);
+            } else {
+                // Optional copies: each one may jump to the end
+                for (int i = node.minCount; i < node.maxCount; i++) {
+                    const auto childFragment = compileNode(child, reverse, nfa);
+                    states[current].epsilons.push_back(childFragment.first);
+                    states[current].epsilons.push_back(end);
+                    current = childFragment.second;
+                }
+            }
+            states[current].epsilons.push_back(end);
+            return {start, end};
+        }
+    }
+
+    return {-1, -1};
+}
+
+MelodyRegex::Nfa MelodyRegex::compile(const Node& root, const bool reverse) {
+    Nfa nfa;
+    const auto fragment = compileNode(root, reverse, &nfa);
+    nfa.start = fragment.first;
+    nfa.final = fragment.second;
+    return nfa;
+}
+
+uint64_t MelodyRegex::atomMask(const Event& event) const {
+    uint64_t mask = 0;
+    for (size_t a = 0; a < _atoms.size(); a++) {
+        if (_atoms[a].matches(event)) {
+            mask |= uint64_t{1} << a;
+        }
+    }
+    return mask;
+}
+
+bool MelodyRegex::matchesEvent(const Event& event) const {
+    const auto matches = findAll({event});
+    return matches.size() == 1 && matches.front().length == 1;
+}
+
+std::vector<MelodyRegex::Match> MelodyRegex::findAll(const std::vector<Event>& events) const {
+    std::vector<Match> matches;
+    const int numEvents = events.size();
+
+    std::vector<uint64_t> masks(numEvents);
+    for (int i = 0; i < numEvents; i++) {
+        masks[i] = atomMask(events[i]);
+    }
+
+    // ===== STEP 1: INÍCIOS DAS OCORRÊNCIAS (DFA REVERSO) ===== //
+    // After reading events [i, numEvents) backwards, the reverse DFA accepts if a match starts at i
+    LazyDfa reverseDfa(_reverse, true);
+    std::vector<char> isMatchStart(numEvents, 0);
+    int state = reverseDfa.start();
+    for (int i = numEvents - 1; i >= 0; i--) {
+        state = reverseDfa.next(state, masks[i]);
+        isMatchStart[i] = reverseDfa.isAccepting(state) ? 1 : 0;
+    }
+
+    // ===== STEP 2: OCORRÊNCIA MAIS LONGA DE CADA INÍCIO (DFA DIRETO) ===== //
+    LazyDfa forwardDfa(_forward, false);
+    int pos = 0;
+    while (pos < numEvents) {
+        if (!isMatchStart[pos]) {
+            pos++;
+            continue;
+        }
+
+        int lastEnd = -1;
+        state = forwardDfa.start();
+        for (int i = pos; i < numEvents; i++) {
+            state = forwardDfa.next(state, masks[i]);
+            if (state == 0) {
+                break;
+            }
+            if (forwardDfa.isAccepting(state)) {
+                lastEnd = i;
+            }
+        }
+
+        if (lastEnd < pos) {
+            pos++;
+            continue;
+        }
+
+        matches.push_back({pos, lastEnd - pos + 1});
+        pos = lastEnd + 1;
+    }
+
+    return matches;
+}
@@ -1583,21 +1583,41 @@ int Note::getScaleDegree(const Key& key) const {
 }
 
 float Note::getFrequency(const float freqA4) const {
+    // Default A4 reference: read the precomputed equal temperament table
+    static const AnalysisContext defaultContext;
+    if (freqA4 == defaultContext.getFreqA4()) {
+        return defaultContext.getFrequency(_midiNumber);
+    }
+
     return Helper::midiNote2freq(_midiNumber, freqA4);
 }
 
+float Note::getFrequency(const AnalysisContext& context) const {
+    return context.getFrequency(_midiNumber);
+}
+
 std::pair<std::vector<float>, std::vector<float>> Note::getHarmonicSpectrum(
     const int numPartials,
     const std::function<std::vector<float>(std::vector<float>)> amplCallback,
     const float partialsDecayExpRate,
     const float freqA4) const {
+    return getHarmonicSpectrum(numPartials, amplCallback, partialsDecayExpRate,
+                               AnalysisContext(TuningSystem::EQUAL_TEMPERAMENT, freqA4));
+}
+
+std::pair<std::vector<float>, std::vector<float>> Note::getHarmonicSpectrum(
+    const int numPartials,
+    const std::function<std::vector<float>(std::vector<float>)> amplCallback,
+    const float partialsDecayExpRate, const AnalysisContext& context) const {
     if (numPartials <= 0) {
         LOG_ERROR("The 'numPartials' must be a positive value");
     }
 
+    const float fundamentalFreq = getFrequency(context);
+
     std::vector<float> freqs(numPartials, 0);
     for (int i = 0; i < numPartials; i++) {
-        freqs[i] = getFrequency(freqA4) * (i + 1);
+        freqs[i] = fundamentalFreq * (i + 1);
     }
 
     std::vector<float> ampls(numPartials, 0);
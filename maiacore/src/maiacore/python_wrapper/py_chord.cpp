@@ -345,22 +345,39 @@ void ChordClass(const py::module& m) {
     cls.def("getHarmonicSpectrum", &Chord::getHarmonicSpectrum, 
         py::arg("numPartialsPerNote") = 6,
         py::arg("amplCallback") = nullptr,
-        py::arg("partialsDecayExpRate") = 0.88f);
+        py::arg("partialsDecayExpRate") = 0.88f,
+        py::arg("context") = AnalysisContext());
+
+    cls.def_static(
+        "getHarmonicSpectrumBatch",
+        [](const std::vector<Chord>& chords, const int numPartialsPerNote,
+           const float partialsDecayExpRate,
+           const std::function<std::vector<float>(const std::vector<float>&)> batchAmplCallback,
+           const AnalysisContext& context) {
+            HarmonicSpectrumBuffer buffer;
+            Chord::getHarmonicSpectrumBatch(chords, &buffer, numPartialsPerNote,
+                                            partialsDecayExpRate, batchAmplCallback, context);
+            return buffer;
+        },
+        py::arg("chords"), py::arg("numPartialsPerNote") = 6,
+        py::arg("partialsDecayExpRate") = 0.88f, py::arg("batchAmplCallback") = nullptr,
+        py::arg("context") = AnalysisContext());
 
     cls.def("getSetharesDissonance", &Chord::getSetharesDissonance,
             py::arg("numPartialsPerNote") = 6, 
             py::arg("useMinModel") = true,
             py::arg("amplCallback") = nullptr,
             py::arg("partialsDecayExpRate") = 0.88f,
-            py::arg("dissCallback") = nullptr);
+            py::arg("dissCallback") = nullptr,
+            py::arg("context") = AnalysisContext());
 
     cls.def(
         "getSetharesDyadsDataFrame",
         [](const Chord& chord, const int numPartialsPerNote, const bool useMinModel,
            const std::function<std::vector<float>(std::vector<float>)> amplCallback,
-            const float partialsDecayExpRate) {
+            const float partialsDecayExpRate, const AnalysisContext& context) {
             const SetharesDissonanceTable table = chord.getSetharesDyadsDissonanceValue(
-                numPartialsPerNote, useMinModel, amplCallback, partialsDecayExpRate);
+                numPartialsPerNote, useMinModel, amplCallback, partialsDecayExpRate, context);
 
             // Import Pandas module
             py::object Pandas = py::module_::import("pandas");
@@ -413,6 +430,7 @@ void ChordClass(const py::module& m) {
         py::arg("useMinModel") = true,
         py::arg("amplCallback") = nullptr,
         py::arg("partialsDecayExpRate") = 0.88f,
+        py::arg("context") = AnalysisContext(),
         py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
 
     cls.def(py::self == py::self);
@@ -456,6 +474,13 @@ void ChordClass(const py::module& m) {
 
     cls.def("__sizeof__", [](const Chord& chord) { return sizeof(chord); });
 
+    // bindings to HarmonicSpectrumBuffer struct
+    py::class_<HarmonicSpectrumBuffer> clsSpectrumBuffer(m, "HarmonicSpectrumBuffer");
+    clsSpectrumBuffer.def_readonly("numPartials", &HarmonicSpectrumBuffer::numPartials);
+    clsSpectrumBuffer.def_readonly("frequencies", &HarmonicSpectrumBuffer::frequencies);
+    clsSpectrumBuffer.def_readonly("amplitudes", &HarmonicSpectrumBuffer::amplitudes);
+    clsSpectrumBuffer.def_readonly("chordNoteOffsets", &HarmonicSpectrumBuffer::chordNoteOffsets);
+
     // bindings to NoteDataHeap Data typedef
     py::class_<NoteData> clsNoteData(m, "NoteData");
     clsNoteData.def(py::init<>());
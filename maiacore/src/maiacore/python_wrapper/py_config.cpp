@@ -0,0 +1,26 @@
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "maiacore/config.h"
+
+namespace py = pybind11;
+
+void Config(py::module& m) {
+    m.def("getTuningSystem", &getTuningSystem);
+    m.def("setTuningSystem", &setTuningSystem, py::arg("tuningSystem"));
+
+    // bindings to AnalysisContext class
+    py::class_<AnalysisContext> cls(m, "AnalysisContext");
+    cls.def(py::init<const TuningSystem, const float>(),
+            py::arg("tuningSystem") = TuningSystem::EQUAL_TEMPERAMENT,
+            py::arg("freqA4") = 440.0f);
+
+    cls.def("getTuningSystem", &AnalysisContext::getTuningSystem);
+    cls.def("getFreqA4", &AnalysisContext::getFreqA4);
+    cls.def("getFrequency", &AnalysisContext::getFrequency, py::arg("midiNote"));
+    cls.def("getFrequencyTable", &AnalysisContext::getFrequencyTable);
+
+    cls.def("__repr__", [](const AnalysisContext& context) {
+        return "<AnalysisContext A4=" + std::to_string(context.getFreqA4()) + "Hz>";
+    });
+}
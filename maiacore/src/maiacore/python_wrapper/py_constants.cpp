@@ -23,10 +23,20 @@ void Constants(const py::module &m) {
         .value("N512TH", RhythmFigure::N512TH)
         .value("N1024TH", RhythmFigure::N1024TH);
 
-    // py::enum_<TuningSystem>(m, "TuningSystem")
-    //     .value("EQUAL_TEMPERAMENT", TuningSystem::EQUAL_TEMPERAMENT)
-    //     .value("JUST_INTONATION", TuningSystem::JUST_INTONATION)
-    //     .value("PYTHAGOREAN_TUNING", TuningSystem::PYTHAGOREAN_TUNING)
-    //     .value("MEANTONE_TEMPERAMENT", TuningSystem::MEANTONE_TEMPERAMENT)
-    //     .value("WELL_TEMPERAMENT", TuningSystem::WELL_TEMPERAMENT);
+    py::enum_<TuningSystem>(m, "TuningSystem")
+        .value("EQUAL_TEMPERAMENT", TuningSystem::EQUAL_TEMPERAMENT)
+        .value("JUST_INTONATION", TuningSystem::JUST_INTONATION)
+        .value("PYTHAGOREAN_TUNING", TuningSystem::PYTHAGOREAN_TUNING)
+        .value("MEANTONE_TEMPERAMENT", TuningSystem::MEANTONE_TEMPERAMENT)
+        .value("WELL_TEMPERAMENT", TuningSystem::WELL_TEMPERAMENT);
+
+    py::enum_<MelodySimilarityMetric>(m, "MelodySimilarityMetric")
+        .value("EUCLIDEAN", MelodySimilarityMetric::EUCLIDEAN)
+        .value("DTW", MelodySimilarityMetric::DTW);
+
+    py::enum_<MelodyStreamType>(m, "MelodyStreamType")
+        .value("PART", MelodyStreamType::PART)
+        .value("VOICE", MelodyStreamType::VOICE)
+        .value("SKYLINE", MelodyStreamType::SKYLINE)
+        .value("BASSLINE", MelodyStreamType::BASSLINE);
 }
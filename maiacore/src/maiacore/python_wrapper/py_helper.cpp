@@ -85,6 +85,14 @@ void HelperClass(const py::module& m) {
     cls.def_static("pitchRatio", &Helper::pitchRatio, py::arg("pitch_A"), py::arg("pitch_B"),
                    py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
     //--------------------- //
+    cls.def_static(
+        "setharesDissonance",
+        [](const std::vector<float>& freqs, const std::vector<float>& ampls,
+           const bool useMinModel) {
+            return Helper::setharesDissonance(freqs, ampls, useMinModel);
+        },
+        py::arg("freqs"), py::arg("ampls"), py::arg("useMinModel") = true);
+    //--------------------- //
     cls.def_static(
         "noteSimilarity",
         [](std::string& pitchClass_A, int octave_A, const float duration_A,
@@ -26,6 +26,7 @@ PYBIND11_MODULE(maiacore, m) {
     m.doc() = "This is a Python binding of C++ Maia Library";
 
     Constants(m);
+    Config(m);
     NoteClass(m);
     ChordClass(m);
     ScoreClass(m);
@@ -149,12 +149,28 @@ void NoteClass(const py::module& m) {
     cls.def("toEnharmonicPitch", &Note::toEnharmonicPitch,
             py::arg("alternativeEnhamonicPitch") = false);
     cls.def("getScaleDegree", &Note::getScaleDegree, py::arg("key"));
-    cls.def("getFrequency", &Note::getFrequency, py::arg("freqA4") = 440.0f);
-    cls.def("getHarmonicSpectrum", &Note::getHarmonicSpectrum, 
+    cls.def("getFrequency", py::overload_cast<const float>(&Note::getFrequency, py::const_),
+            py::arg("freqA4") = 440.0f);
+    cls.def("getFrequency",
+            py::overload_cast<const AnalysisContext&>(&Note::getFrequency, py::const_),
+            py::arg("context"));
+    cls.def("getHarmonicSpectrum",
+            py::overload_cast<const int,
+                              const std::function<std::vector<float>(std::vector<float>)>,
+                              const float, const float>(&Note::getHarmonicSpectrum, py::const_),
             py::arg("numPartials") = 6,
             py::arg("amplCallback") = nullptr,
             py::arg("partialsDecayExpRate") = 0.88f,
             py::arg("freqA4") = 440.0f);
+    cls.def("getHarmonicSpectrum",
+            py::overload_cast<const int,
+                              const std::function<std::vector<float>(std::vector<float>)>,
+                              const float, const AnalysisContext&>(&Note::getHarmonicSpectrum,
+                                                                   py::const_),
+            py::arg("numPartials"),
+            py::arg("amplCallback"),
+            py::arg("partialsDecayExpRate"),
+            py::arg("context"));
 
     cls.def("transpose", &Note::transpose, py::arg("semitones"),
             py::arg("accType") = MUSIC_XML::ACCIDENT::NONE);
@@ -1,5 +1,6 @@
 #include <pybind11/functional.h>
 #include <pybind11/iostream.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -11,11 +12,41 @@
 namespace py = pybind11;
 using namespace pybind11::literals;
 
+// Moves a std::vector into a NumPy array without copying its data
+template <typename T>
+py::array_t<T> toNumpyArray(std::vector<T>&& vec) {
+    auto* heapVec = new std::vector<T>(std::move(vec));
+    py::capsule owner(heapVec, [](void* ptr) { delete static_cast<std::vector<T>*>(ptr); });
+    return py::array_t<T>(heapVec->size(), heapVec->data(), owner);
+}
+
+// Wraps a MelodyWindowBatch as a dict of 2D (numWindows x windowSize) NumPy arrays
+py::dict melodyWindowBatchToDict(const Score::MelodyWindowBatch& batch) {
+    const std::vector<py::ssize_t> shape = {batch.numWindows, batch.windowSize};
+
+    py::dict out;
+    out["midiNumber"] = py::array_t<int>(shape, batch.midiNumbers.data());
+    out["quarterDuration"] = py::array_t<float>(shape, batch.quarterDurations.data());
+    out["isRest"] = py::array_t<bool>(shape, reinterpret_cast<const bool*>(batch.restMask.data()));
+    out["noteEventIdx"] = py::array_t<int>(batch.noteEventIdx.size(), batch.noteEventIdx.data());
+    return out;
+}
+
+// Copies a 1D array-like Python object to a std::vector<float>
+std::vector<float> toFloatVector(const py::handle& obj) {
+    const auto array = py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(obj);
+    if (!array || array.ndim() != 1) {
+        throw std::runtime_error("The batch similarity callback must return 1D arrays");
+    }
+    return std::vector<float>(array.data(), array.data() + array.size());
+}
+
 void ScoreClass(const py::module& m) {
     m.doc() = "Score class binding";
 
     // bindings to Score class
-    py::class_<Score> cls(m, "Score");
+    // Shared holder: collections hand their scores to Python without copies
+    py::class_<Score, std::shared_ptr<Score>> cls(m, "Score");
 
     cls.def(py::init<const std::vector<std::string>&, const int>(), py::arg("partsName"),
             py::arg("numMeasures") = 20,
@@ -105,7 +136,9 @@ void ScoreClass(const py::module& m) {
                rhythmSimilarityCallback,
            const std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback,
            const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback,
-           const std::function<float(float, float)> totalSimilarityCallback) {
+           const std::function<float(float, float)> totalSimilarityCallback,
+           const MelodySimilarityMetric metric, const int warpingWindow,
+           const py::object& batchSimilarityCallback) {
             // Import Pandas module
             py::object Pandas = py::module_::import("pandas");
 
@@ -125,12 +158,49 @@ void ScoreClass(const py::module& m) {
                                                 "totalRhythmSimilarity",
                                                 "totalSimilarity"};
 
+            // Batched callback: one Python call per part, with NumPy arrays of all windows
+            if (!batchSimilarityCallback.is_none()) {
+                // The batch callback returns the per-window similarities itself
+                if (intervalsSimilarityCallback || rhythmSimilarityCallback ||
+                    totalIntervalSimilarityCallback || totalRhythmSimilarityCallback) {
+                    throw std::runtime_error(
+                        "The batch similarity callback can not be combined with the interval "
+                        "and rhythm similarity callbacks");
+                }
+                if (metric != MelodySimilarityMetric::EUCLIDEAN) {
+                    throw std::runtime_error(
+                        "The batch similarity callback is only supported by the EUCLIDEAN "
+                        "metric");
+                }
+
+                const Score::MelodyBatchSimilarityCallback batchCallback =
+                    [&batchSimilarityCallback](const Score::MelodyWindowBatch& pattern,
+                                               const Score::MelodyWindowBatch& windows) {
+                        py::gil_scoped_acquire acquire;
+                        py::tuple result = batchSimilarityCallback(
+                            melodyWindowBatchToDict(pattern), melodyWindowBatchToDict(windows));
+                        return std::make_pair(toFloatVector(result[0]), toFloatVector(result[1]));
+                    };
+
+                Score::MelodyPatternTable table;
+                {
+                    // The GIL is only held while the batch callback runs
+                    py::gil_scoped_release release;
+                    table = score.findMelodyPatternBatched(
+                        melodyPattern, batchCallback, totalIntervalsSimilarityThreshold,
+                        totalRhythmSimilarityThreshold, totalSimilarityCallback);
+                }
+
+                return FromRecords(table, "columns"_a = columns);
+            }
+
             // Fill DataFrame with records and columns
             py::object df = FromRecords(
                 score.findMelodyPattern(melodyPattern, totalIntervalsSimilarityThreshold,
                                         totalRhythmSimilarityThreshold, intervalsSimilarityCallback,
                                         rhythmSimilarityCallback, totalIntervalSimilarityCallback,
-                                        totalRhythmSimilarityCallback, totalSimilarityCallback),
+                                        totalRhythmSimilarityCallback, totalSimilarityCallback,
+                                        metric, warpingWindow),
                 "columns"_a = columns);
 
             return df;
@@ -142,6 +212,8 @@ void ScoreClass(const py::module& m) {
         py::arg("totalIntervalSimilarityCallback") = nullptr,
         py::arg("totalRhythmSimilarityCallback") = nullptr,
         py::arg("totalSimilarityCallback") = nullptr,
+        py::arg("metric") = MelodySimilarityMetric::EUCLIDEAN, py::arg("warpingWindow") = 2,
+        py::arg("batchSimilarityCallback") = py::none(),
         py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
 
     // Overload para multiplos padrões em paralelo
@@ -155,15 +227,21 @@ void ScoreClass(const py::module& m) {
                                                   const std::vector<Note>&)> rhythmSimilarityCallback,
            const std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback,
            const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback,
-           const std::function<float(float, float)> totalSimilarityCallback) {
-
-            const auto& results = score.findMelodyPattern(melodyPatterns, totalIntervalsSimilarityThreshold,
-                                        totalRhythmSimilarityThreshold, intervalsSimilarityCallback,
-                                        rhythmSimilarityCallback, totalIntervalSimilarityCallback,
-                                        totalRhythmSimilarityCallback, totalSimilarityCallback);
+           const std::function<float(float, float)> totalSimilarityCallback,
+           const int numThreads, const MelodySimilarityMetric metric, const int warpingWindow) {
+
+            std::vector<Score::MelodyPatternTable> results;
+            {
+                // Python callbacks re-acquire the GIL inside the worker threads
+                py::gil_scoped_release release;
+                results = score.findMelodyPattern(melodyPatterns, totalIntervalsSimilarityThreshold,
+                                                  totalRhythmSimilarityThreshold, intervalsSimilarityCallback,
+                                                  rhythmSimilarityCallback, totalIntervalSimilarityCallback,
+                                                  totalRhythmSimilarityCallback, totalSimilarityCallback,
+                                                  numThreads, metric, warpingWindow);
+            }
 
             // Converte os resultados para DataFrames no contexto principal (com o GIL adquirido)
-            py::gil_scoped_acquire acquire;
             py::object Pandas = py::module_::import("pandas");
             py::object FromRecords = Pandas.attr("DataFrame").attr("from_records");
             std::vector<py::object> dataframes;
@@ -205,7 +283,10 @@ void ScoreClass(const py::module& m) {
         py::arg("rhythmSimilarityCallback") = nullptr,
         py::arg("totalIntervalSimilarityCallback") = nullptr,
         py::arg("totalRhythmSimilarityCallback") = nullptr,
-        py::arg("totalSimilarityCallback") = nullptr
+        py::arg("totalSimilarityCallback") = nullptr,
+        py::arg("numThreads") = 0,
+        py::arg("metric") = MelodySimilarityMetric::EUCLIDEAN,
+        py::arg("warpingWindow") = 2
     );
 
     // cls.def(
@@ -310,6 +391,46 @@ void ScoreClass(const py::module& m) {
     //     py::arg("totalSimilarityCallback") = nullptr
     // );
 
+    cls.def("getMelodySearchKeyNames", &Score::getMelodySearchKeyNames);
+    cls.def("setMelodyStreams", &Score::setMelodyStreams, py::arg("splitVoices"),
+            py::arg("includeSkyline") = false, py::arg("includeBassline") = false);
+    cls.def("getMelodyStreams", &Score::getMelodyStreams);
+    cls.def("getFingerprint", &Score::getFingerprint, py::return_value_policy::reference_internal);
+    cls.def("getDescriptor", &Score::getDescriptor, py::return_value_policy::reference_internal);
+    cls.def("findMelodyPatternMatches", &Score::findMelodyPatternMatches,
+            py::arg("melodyPattern"), py::arg("callback"),
+            py::arg("totalIntervalsSimilarityThreshold") = 0.5f,
+            py::arg("totalRhythmSimilarityThreshold") = 0.5f,
+            py::arg("metric") = MelodySimilarityMetric::EUCLIDEAN, py::arg("warpingWindow") = 2);
+    cls.def("countMelodyPattern", &Score::countMelodyPattern, py::arg("melodyPattern"),
+            py::arg("totalIntervalsSimilarityThreshold") = 0.5f,
+            py::arg("totalRhythmSimilarityThreshold") = 0.5f,
+            py::arg("metric") = MelodySimilarityMetric::EUCLIDEAN, py::arg("warpingWindow") = 2,
+            py::call_guard<py::gil_scoped_release>());
+    cls.def("findTopMelodyPattern", &Score::findTopMelodyPattern, py::arg("melodyPattern"),
+            py::arg("k"), py::arg("totalIntervalsSimilarityThreshold") = 0.5f,
+            py::arg("totalRhythmSimilarityThreshold") = 0.5f,
+            py::arg("metric") = MelodySimilarityMetric::EUCLIDEAN, py::arg("warpingWindow") = 2,
+            py::call_guard<py::gil_scoped_release>());
+
+    cls.def("findRepeatedMotifs", &Score::findRepeatedMotifs, py::arg("minNumNotes") = 4,
+            py::arg("minNumOccurrences") = 2, py::arg("considerRhythm") = true,
+            py::call_guard<py::gil_scoped_release>());
+    cls.def("findMelodyRegex",
+            py::overload_cast<const std::string&, const int>(&Score::findMelodyRegex, py::const_),
+            py::arg("pattern"), py::arg("numThreads") = 0,
+            py::call_guard<py::gil_scoped_release>());
+    cls.def("findRhythmPattern",
+            py::overload_cast<const std::vector<Note>&, const float, const bool>(
+                &Score::findRhythmPattern, py::const_),
+            py::arg("rhythmPattern"), py::arg("tolerance") = 0.0f,
+            py::arg("includeUnpitched") = true, py::call_guard<py::gil_scoped_release>());
+    cls.def("findRhythmPattern",
+            py::overload_cast<const std::vector<float>&, const float, const bool>(
+                &Score::findRhythmPattern, py::const_),
+            py::arg("interOnsetIntervals"), py::arg("tolerance") = 0.0f,
+            py::arg("includeUnpitched") = true, py::call_guard<py::gil_scoped_release>());
+
     cls.def("getChords", &Score::getChords, py::arg("config") = nlohmann::json(),
             py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
     cls.def(
@@ -333,6 +454,53 @@ void ScoreClass(const py::module& m) {
         py::arg("config") = nlohmann::json(),
         py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
 
+    cls.def(
+        "getSetharesDissonanceTimeline",
+        [](Score& score, nlohmann::json config, const int numPartialsPerNote,
+           const bool useMinModel,
+           const std::function<std::vector<float>(std::vector<float>)> amplCallback,
+           const float partialsDecayExpRate,
+           const std::function<float(std::vector<float>)> dissCallback,
+           const AnalysisContext& context, const int numThreads) {
+            Score::SetharesDissonanceTimeline timeline;
+            {
+                // Python callbacks re-acquire the GIL inside the worker threads
+                py::gil_scoped_release release;
+                timeline = score.getSetharesDissonanceTimeline(config, numPartialsPerNote,
+                                                               useMinModel, amplCallback,
+                                                               partialsDecayExpRate, dissCallback,
+                                                               context, numThreads);
+            }
+
+            py::dict out;
+            out["measure"] = toNumpyArray(std::move(timeline.measure));
+            out["floatMeasure"] = toNumpyArray(std::move(timeline.floatMeasure));
+            out["key"] = timeline.keyName;
+            out["quarterDuration"] = toNumpyArray(std::move(timeline.quarterDuration));
+            out["chordSize"] = toNumpyArray(std::move(timeline.chordSize));
+            out["chordNotes"] = timeline.chordNotes;
+            out["dissonance"] = toNumpyArray(std::move(timeline.dissonance));
+            out["isHomophonic"] = py::array_t<bool>(
+                timeline.isHomophonic.size(),
+                reinterpret_cast<const bool*>(timeline.isHomophonic.data()));
+
+            return out;
+        },
+        py::arg("config") = nlohmann::json(), py::arg("numPartialsPerNote") = 6,
+        py::arg("useMinModel") = true, py::arg("amplCallback") = nullptr,
+        py::arg("partialsDecayExpRate") = 0.88f, py::arg("dissCallback") = nullptr,
+        py::arg("context") = AnalysisContext(), py::arg("numThreads") = 0);
+
+    cls.def("getHarmonicIndex", &Score::getHarmonicIndex, py::arg("config") = nlohmann::json(),
+            py::return_value_policy::copy,
+            py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
+    cls.def("findChordProgression",
+            py::overload_cast<const std::string&, nlohmann::json, const bool>(
+                &Score::findChordProgression),
+            py::arg("progression"), py::arg("config") = nlohmann::json(),
+            py::arg("mergeRepeatedChords") = true,
+            py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
+
     cls.def("forEachNote", &Score::forEachNote, py::arg("callback"), py::arg("measureStart") = 0,
             py::arg("measureEnd") = -1, py::arg("partNames") = std::vector<std::string>(),
             py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
@@ -394,4 +562,111 @@ void ScoreClass(const py::module& m) {
     cls.def("__hash__", [](const Score& score) { return std::hash<std::string>{}(score.toXML()); });
 
     cls.def("__sizeof__", [](const Score& score) { return sizeof(score); });
+
+    // bindings to the compact melody search result
+    py::class_<Score::MelodyPatternMatch> clsMatch(m, "MelodyPatternMatch");
+    clsMatch.def_readonly("partIdx", &Score::MelodyPatternMatch::partIdx);
+    clsMatch.def_readonly("streamIdx", &Score::MelodyPatternMatch::streamIdx);
+    clsMatch.def_readonly("measureIdx", &Score::MelodyPatternMatch::measureIdx);
+    clsMatch.def_readonly("staveIdx", &Score::MelodyPatternMatch::staveIdx);
+    clsMatch.def_readonly("keyIdx", &Score::MelodyPatternMatch::keyIdx);
+    clsMatch.def_readonly("noteEventIdx", &Score::MelodyPatternMatch::noteEventIdx);
+    clsMatch.def_readonly("numNotes", &Score::MelodyPatternMatch::numNotes);
+    clsMatch.def_readonly("totalIntervalSimilarity",
+                          &Score::MelodyPatternMatch::totalIntervalSimilarity);
+    clsMatch.def_readonly("totalRhythmSimilarity", &Score::MelodyPatternMatch::totalRhythmSimilarity);
+    clsMatch.def_readonly("totalSimilarity", &Score::MelodyPatternMatch::totalSimilarity);
+
+    // bindings to the findRepeatedMotifs() result structs
+    py::class_<Score::MotifOccurrence> clsMotifOccurrence(m, "MotifOccurrence");
+    clsMotifOccurrence.def_readonly("partIdx", &Score::MotifOccurrence::partIdx);
+    clsMotifOccurrence.def_readonly("partName", &Score::MotifOccurrence::partName);
+    clsMotifOccurrence.def_readonly("streamIdx", &Score::MotifOccurrence::streamIdx);
+    clsMotifOccurrence.def_readonly("measureIdx", &Score::MotifOccurrence::measureIdx);
+    clsMotifOccurrence.def_readonly("staveIdx", &Score::MotifOccurrence::staveIdx);
+    clsMotifOccurrence.def_readonly("noteEventIdx", &Score::MotifOccurrence::noteEventIdx);
+    clsMotifOccurrence.def_readonly("pitches", &Score::MotifOccurrence::pitches);
+
+    py::class_<Score::RepeatedMotif> clsRepeatedMotif(m, "RepeatedMotif");
+    clsRepeatedMotif.def_readonly("numNotes", &Score::RepeatedMotif::numNotes);
+    clsRepeatedMotif.def_readonly("intervals", &Score::RepeatedMotif::intervals);
+    clsRepeatedMotif.def_readonly("quarterDurations", &Score::RepeatedMotif::quarterDurations);
+    clsRepeatedMotif.def_readonly("occurrences", &Score::RepeatedMotif::occurrences);
+
+    // bindings to the getMelodyStreams() result struct
+    py::class_<Score::MelodyStream> clsMelodyStream(m, "MelodyStream");
+    clsMelodyStream.def_readonly("type", &Score::MelodyStream::type);
+    clsMelodyStream.def_readonly("partIdx", &Score::MelodyStream::partIdx);
+    clsMelodyStream.def_readonly("partName", &Score::MelodyStream::partName);
+    clsMelodyStream.def_readonly("staveIdx", &Score::MelodyStream::staveIdx);
+    clsMelodyStream.def_readonly("voice", &Score::MelodyStream::voice);
+    clsMelodyStream.def_readonly("numNoteEvents", &Score::MelodyStream::numNoteEvents);
+
+    // bindings to the getFingerprint() result struct
+    py::class_<ScoreFingerprint> clsFingerprint(m, "ScoreFingerprint");
+    clsFingerprint.def_readonly("minHashes", &ScoreFingerprint::minHashes);
+    clsFingerprint.def_readonly("numTokens", &ScoreFingerprint::numTokens);
+    clsFingerprint.def("estimateSimilarity", &ScoreFingerprint::estimateSimilarity,
+                       py::arg("other"));
+
+    // bindings to the getDescriptor() result struct
+    py::class_<ScoreDescriptor> clsDescriptor(m, "ScoreDescriptor");
+    clsDescriptor.def(py::init<>());
+    clsDescriptor.def_readwrite("values", &ScoreDescriptor::values);
+    clsDescriptor.def_static("getFeatureNames", &ScoreDescriptor::getFeatureNames);
+    clsDescriptor.def("distance", &ScoreDescriptor::distance, py::arg("other"));
+
+    // bindings to the findMelodyRegex() result struct
+    py::class_<Score::MelodyRegexMatch> clsMelodyRegexMatch(m, "MelodyRegexMatch");
+    clsMelodyRegexMatch.def_readonly("partIdx", &Score::MelodyRegexMatch::partIdx);
+    clsMelodyRegexMatch.def_readonly("partName", &Score::MelodyRegexMatch::partName);
+    clsMelodyRegexMatch.def_readonly("streamIdx", &Score::MelodyRegexMatch::streamIdx);
+    clsMelodyRegexMatch.def_readonly("measureIdx", &Score::MelodyRegexMatch::measureIdx);
+    clsMelodyRegexMatch.def_readonly("staveIdx", &Score::MelodyRegexMatch::staveIdx);
+    clsMelodyRegexMatch.def_readonly("noteEventIdx", &Score::MelodyRegexMatch::noteEventIdx);
+    clsMelodyRegexMatch.def_readonly("numNotes", &Score::MelodyRegexMatch::numNotes);
+    clsMelodyRegexMatch.def_readonly("pitches", &Score::MelodyRegexMatch::pitches);
+
+    // bindings to the findRhythmPattern() result struct
+    py::class_<Score::RhythmPatternMatch> clsRhythmPatternMatch(m, "RhythmPatternMatch");
+    clsRhythmPatternMatch.def_readonly("partIdx", &Score::RhythmPatternMatch::partIdx);
+    clsRhythmPatternMatch.def_readonly("partName", &Score::RhythmPatternMatch::partName);
+    clsRhythmPatternMatch.def_readonly("staveIdx", &Score::RhythmPatternMatch::staveIdx);
+    clsRhythmPatternMatch.def_readonly("voice", &Score::RhythmPatternMatch::voice);
+    clsRhythmPatternMatch.def_readonly("measureIdx", &Score::RhythmPatternMatch::measureIdx);
+    clsRhythmPatternMatch.def_readonly("onsetIdx", &Score::RhythmPatternMatch::onsetIdx);
+    clsRhythmPatternMatch.def_readonly("quarterOnset", &Score::RhythmPatternMatch::quarterOnset);
+    clsRhythmPatternMatch.def_readonly("interOnsetIntervals",
+                                       &Score::RhythmPatternMatch::interOnsetIntervals);
+    clsRhythmPatternMatch.def_readonly("maxDeviation", &Score::RhythmPatternMatch::maxDeviation);
+
+    // bindings to the getHarmonicIndex() and findChordProgression() result structs
+    py::class_<HarmonicSlice> clsHarmonicSlice(m, "HarmonicSlice");
+    clsHarmonicSlice.def_readonly("measure", &HarmonicSlice::measure);
+    clsHarmonicSlice.def_readonly("floatMeasure", &HarmonicSlice::floatMeasure);
+    clsHarmonicSlice.def_readonly("keyName", &HarmonicSlice::keyName);
+    clsHarmonicSlice.def_readonly("rootPitchClass", &HarmonicSlice::rootPitchClass);
+    clsHarmonicSlice.def_readonly("rootPitch", &HarmonicSlice::rootPitch);
+    clsHarmonicSlice.def_readonly("quality", &HarmonicSlice::quality);
+    clsHarmonicSlice.def_readonly("degree", &HarmonicSlice::degree);
+    clsHarmonicSlice.def_readonly("romanDegree", &HarmonicSlice::romanDegree);
+    clsHarmonicSlice.def_readonly("isInRootPosition", &HarmonicSlice::isInRootPosition);
+
+    py::class_<Score::ChordProgressionMatch> clsChordProgressionMatch(m, "ChordProgressionMatch");
+    clsChordProgressionMatch.def_readonly("firstSliceIdx",
+                                          &Score::ChordProgressionMatch::firstSliceIdx);
+    clsChordProgressionMatch.def_readonly("numSlices", &Score::ChordProgressionMatch::numSlices);
+    clsChordProgressionMatch.def_readonly("startMeasure",
+                                          &Score::ChordProgressionMatch::startMeasure);
+    clsChordProgressionMatch.def_readonly("startFloatMeasure",
+                                          &Score::ChordProgressionMatch::startFloatMeasure);
+    clsChordProgressionMatch.def_readonly("endMeasure", &Score::ChordProgressionMatch::endMeasure);
+    clsChordProgressionMatch.def_readonly("endFloatMeasure",
+                                          &Score::ChordProgressionMatch::endFloatMeasure);
+    clsChordProgressionMatch.def_readonly("keyName", &Score::ChordProgressionMatch::keyName);
+    clsChordProgressionMatch.def_readonly("rootPitches",
+                                          &Score::ChordProgressionMatch::rootPitches);
+    clsChordProgressionMatch.def_readonly("qualities", &Score::ChordProgressionMatch::qualities);
+    clsChordProgressionMatch.def_readonly("romanDegrees",
+                                          &Score::ChordProgressionMatch::romanDegrees);
 }
@@ -5,6 +5,8 @@
 #include <pybind11/functional.h>
 
 #include "maiacore/score_collection.h"
+#include "nlohmann/json.hpp"
+#include "pybind11_json/pybind11_json.hpp"
 
 namespace py = pybind11;
 using namespace pybind11::literals;
@@ -12,6 +14,85 @@ using namespace pybind11::literals;
 void ScoreCollectionClass(const py::module& m) {
     m.doc() = "ScoreCollection class binding";
 
+    // Manifest entries and refresh() results
+    py::class_<DirectoryScanner::FileInfo>(m, "ScannedFile")
+        .def_readonly("filePath", &DirectoryScanner::FileInfo::filePath)
+        .def_readonly("size", &DirectoryScanner::FileInfo::size)
+        .def_readonly("modificationTime", &DirectoryScanner::FileInfo::modificationTime)
+        .def_readonly("hash", &DirectoryScanner::FileInfo::hash)
+        .def("__repr__", [](const DirectoryScanner::FileInfo& file) {
+            return "<ScannedFile " + file.filePath + ">";
+        });
+
+    py::class_<ScoreCollection::RefreshSummary>(m, "RefreshSummary")
+        .def_readonly("addedFiles", &ScoreCollection::RefreshSummary::addedFiles)
+        .def_readonly("removedFiles", &ScoreCollection::RefreshSummary::removedFiles)
+        .def_readonly("reloadedFiles", &ScoreCollection::RefreshSummary::reloadedFiles);
+
+    // Corpus packs: metadata index and random access to the scores
+    py::class_<NearDuplicateIndex>(m, "NearDuplicateIndex")
+        .def(py::init<const int>(), py::arg("numBands") = 32)
+        .def("add", &NearDuplicateIndex::add, py::arg("fingerprint"))
+        .def("getNumFingerprints", &NearDuplicateIndex::getNumFingerprints)
+        .def("findCandidates", &NearDuplicateIndex::findCandidates, py::arg("fingerprint"))
+        .def("findSimilar", &NearDuplicateIndex::findSimilar, py::arg("fingerprint"),
+             py::arg("threshold"))
+        .def("getGroups", &NearDuplicateIndex::getGroups, py::arg("threshold"));
+
+    py::class_<ScoreDescriptorIndex>(m, "ScoreDescriptorIndex")
+        .def(py::init<const std::vector<ScoreDescriptor>&, const int, const int>(),
+             py::arg("descriptors"), py::arg("numLists") = 0, py::arg("numThreads") = 0,
+             py::call_guard<py::gil_scoped_release>())
+        .def("add", &ScoreDescriptorIndex::add, py::arg("descriptor"))
+        .def("remove", &ScoreDescriptorIndex::remove, py::arg("id"))
+        .def("getNumDescriptors", &ScoreDescriptorIndex::getNumDescriptors)
+        .def("getNumLists", &ScoreDescriptorIndex::getNumLists)
+        .def("findNearest", &ScoreDescriptorIndex::findNearest, py::arg("query"), py::arg("k"),
+             py::arg("numProbes") = 8, py::arg("excludedId") = -1);
+
+    py::class_<CorpusPack::Entry>(m, "CorpusPackEntry")
+        .def_readonly("filePath", &CorpusPack::Entry::filePath)
+        .def_readonly("fileName", &CorpusPack::Entry::fileName)
+        .def_readonly("title", &CorpusPack::Entry::title)
+        .def_readonly("composerName", &CorpusPack::Entry::composerName)
+        .def_readonly("partsNames", &CorpusPack::Entry::partsNames)
+        .def_readonly("numParts", &CorpusPack::Entry::numParts)
+        .def_readonly("numMeasures", &CorpusPack::Entry::numMeasures)
+        .def_readonly("numNotes", &CorpusPack::Entry::numNotes)
+        .def_readonly("documentSize", &CorpusPack::Entry::documentSize)
+        .def("__repr__", [](const CorpusPack::Entry& entry) {
+            return "<CorpusPackEntry " + entry.fileName + ">";
+        });
+
+    py::class_<CorpusPack> clsPack(m, "CorpusPack");
+    clsPack.def(py::init<const std::string&>(), py::arg("filePath"));
+    clsPack.def_static("build",
+                       [](const std::string& directoryPath, const std::string& packPath,
+                          const bool recursive, const std::vector<std::string>& includeGlobs,
+                          const std::vector<std::string>& excludeGlobs, const int numThreads) {
+                           return CorpusPack::build(
+                               directoryPath, packPath,
+                               DirectoryScanner(recursive, includeGlobs, excludeGlobs), numThreads);
+                       },
+                       py::arg("directoryPath"), py::arg("packPath"), py::arg("recursive") = false,
+                       py::arg("includeGlobs") = std::vector<std::string>{"*.xml", "*.mxl", "*.musicxml"},
+                       py::arg("excludeGlobs") = std::vector<std::string>(),
+                       py::arg("numThreads") = 0,
+                       py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
+    clsPack.def("getFilePath", &CorpusPack::getFilePath);
+    clsPack.def("getNumScores", &CorpusPack::getNumScores);
+    clsPack.def("getEntry", &CorpusPack::getEntry, py::arg("scoreIdx"));
+    clsPack.def("getEntries", &CorpusPack::getEntries);
+    clsPack.def("selectScores", &CorpusPack::selectScores, py::arg("predicate"));
+    clsPack.def("findScore", &CorpusPack::findScore, py::arg("fileName"));
+    clsPack.def("getDocument", &CorpusPack::getDocument, py::arg("scoreIdx"));
+    clsPack.def("loadScore", &CorpusPack::loadScore, py::arg("scoreIdx"),
+                py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
+    clsPack.def("loadScores", &CorpusPack::loadScores,
+                py::arg("scoreIndices") = std::vector<int>(), py::arg("numThreads") = 0,
+                py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
+    clsPack.def("__len__", &CorpusPack::getNumScores);
+
     // bindings to ScoreCollection class
     py::class_<ScoreCollection> cls(m, "ScoreCollection");
     cls.def(py::init<const std::string&>(), py::arg("directoryPath") = std::string());
@@ -24,29 +105,113 @@ void ScoreCollectionClass(const py::module& m) {
             py::arg("directoriesPaths"),
             py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
 
-    cls.def("addDirectory", &ScoreCollection::addDirectory, py::arg("directoryPath"));
+    cls.def("addDirectory", &ScoreCollection::addDirectory, py::arg("directoryPath"),
+            py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
+    cls.def("setScanOptions", &ScoreCollection::setScanOptions, py::arg("recursive"),
+            py::arg("includeGlobs") = std::vector<std::string>{"*.xml", "*.mxl", "*.musicxml"},
+            py::arg("excludeGlobs") = std::vector<std::string>());
+    cls.def("refresh", &ScoreCollection::refresh, py::arg("numThreads") = 0,
+            py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
+    cls.def("getManifest", &ScoreCollection::getManifest);
 
     cls.def("addScore", py::overload_cast<const Score&>(&ScoreCollection::addScore),
             py::arg("score"));
+    // Shares a score of another collection: no copy
+    cls.def("addScoreFrom",
+            [](ScoreCollection& collection, const ScoreCollection& other, const int scoreIdx) {
+                other.getScore(scoreIdx);  // Index check
+                collection.addScore(other.getScores()[scoreIdx]);
+            },
+            py::arg("other"), py::arg("scoreIdx"));
     cls.def("addScore", py::overload_cast<const std::string&>(&ScoreCollection::addScore),
             py::arg("filePath"));
     cls.def("addScore",
             py::overload_cast<const std::vector<std::string>&>(&ScoreCollection::addScore),
             py::arg("filePaths"));
 
+    cls.def("loadPack",
+            py::overload_cast<const CorpusPack&, const std::vector<int>&, const int>(
+                &ScoreCollection::loadPack),
+            py::arg("pack"), py::arg("scoreIndices") = std::vector<int>(),
+            py::arg("numThreads") = 0,
+            py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
+    cls.def("loadPack",
+            py::overload_cast<const std::string&, const std::vector<int>&, const int>(
+                &ScoreCollection::loadPack),
+            py::arg("packPath"), py::arg("scoreIndices") = std::vector<int>(),
+            py::arg("numThreads") = 0,
+            py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
+    cls.def("savePack", &ScoreCollection::savePack, py::arg("packPath"),
+            py::arg("numThreads") = 0);
+
     cls.def("clear", &ScoreCollection::clear);
     cls.def("getNumDirectories", &ScoreCollection::getNumDirectories);
     cls.def("getNumScores", &ScoreCollection::getNumScores);
 
-    cls.def("getScores", py::overload_cast<>(&ScoreCollection::getScores),
-            py::return_value_policy::reference_internal);
-    cls.def("getScores", py::overload_cast<>(&ScoreCollection::getScores, py::const_),
-            py::return_value_policy::reference_internal);
+    // Read access: the Python objects share the scores with the collection (a pointer copy) and
+    // keep them alive. Changes must go through getMutableScore()
+    cls.def("getScores", [](const ScoreCollection& collection) {
+        std::vector<std::shared_ptr<Score>> scores;
+        scores.reserve(collection.getNumScores());
+        for (const auto& score : collection.getScores()) {
+            scores.push_back(std::const_pointer_cast<Score>(score));
+        }
+        return scores;
+    });
+    cls.def("getScore",
+            [](const ScoreCollection& collection, const int scoreIdx) {
+                collection.getScore(scoreIdx);  // Index check
+                return std::const_pointer_cast<Score>(collection.getScores()[scoreIdx]);
+            },
+            py::arg("scoreIdx"));
+    // Copy-on-write: a score shared with another collection is copied first, so the changes are
+    // only seen by this collection
+    cls.def("getMutableScore",
+            [](ScoreCollection& collection, const int scoreIdx) {
+                collection.getScore(scoreIdx);
+                return std::const_pointer_cast<Score>(collection.getScores()[scoreIdx]);
+            },
+            py::arg("scoreIdx"));
 
     cls.def("isEmpty", &ScoreCollection::isEmpty);
     cls.def("merge", &ScoreCollection::merge, py::arg("other"));
     cls.def("removeScore", &ScoreCollection::removeScore, py::arg("scoreIdx"),
             py::call_guard<py::scoped_ostream_redirect, py::scoped_estream_redirect>());
+    cls.def("getSubCollection", &ScoreCollection::getSubCollection, py::arg("scoreIndices"));
+    // filter() is not bound: a Python predicate would run on one thread at a time anyway. Select
+    // the indices in Python and use getSubCollection()
+
+    cls.def("setFingerprintOnLoad", &ScoreCollection::setFingerprintOnLoad, py::arg("enable"),
+            py::arg("numThreads") = 0, py::call_guard<py::gil_scoped_release>());
+    cls.def("getFingerprintOnLoad", &ScoreCollection::getFingerprintOnLoad);
+    cls.def("findNearDuplicates", &ScoreCollection::findNearDuplicates,
+            py::arg("threshold") = 0.8, py::arg("numThreads") = 0,
+            py::call_guard<py::gil_scoped_release>());
+    cls.def("findNearDuplicatesOf", &ScoreCollection::findNearDuplicatesOf, py::arg("score"),
+            py::arg("threshold") = 0.8, py::arg("numThreads") = 0,
+            py::call_guard<py::gil_scoped_release>());
+    cls.def("withoutNearDuplicates", &ScoreCollection::withoutNearDuplicates,
+            py::arg("threshold") = 0.8, py::arg("numThreads") = 0,
+            py::call_guard<py::gil_scoped_release>());
+
+    cls.def("setDescriptorOnLoad", &ScoreCollection::setDescriptorOnLoad, py::arg("enable"),
+            py::arg("numThreads") = 0, py::call_guard<py::gil_scoped_release>());
+    cls.def("getDescriptorOnLoad", &ScoreCollection::getDescriptorOnLoad);
+    cls.def("buildDescriptorIndex", &ScoreCollection::buildDescriptorIndex,
+            py::arg("numLists") = 0, py::arg("numThreads") = 0,
+            py::call_guard<py::gil_scoped_release>());
+    cls.def("hasDescriptorIndex", &ScoreCollection::hasDescriptorIndex);
+    cls.def("clearDescriptorIndex", &ScoreCollection::clearDescriptorIndex);
+    cls.def("findSimilarScores",
+            py::overload_cast<const Score&, const int, const int, const int>(
+                &ScoreCollection::findSimilarScores, py::const_),
+            py::arg("score"), py::arg("k") = 20, py::arg("numProbes") = 8,
+            py::arg("numThreads") = 0, py::call_guard<py::gil_scoped_release>());
+    cls.def("findSimilarScores",
+            py::overload_cast<const int, const int, const int, const int>(
+                &ScoreCollection::findSimilarScores, py::const_),
+            py::arg("scoreIdx"), py::arg("k") = 20, py::arg("numProbes") = 8,
+            py::arg("numThreads") = 0, py::call_guard<py::gil_scoped_release>());
 
     cls.def("findMelodyPatternDataFrame",
             [](const ScoreCollection& collection, const std::vector<Note>& melodyPattern,
@@ -55,13 +220,20 @@ void ScoreCollectionClass(const py::module& m) {
                const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>& rhythmSimilarityCallback,
                const std::function<float(const std::vector<float>&)>& totalIntervalSimilarityCallback,
                const std::function<float(const std::vector<float>&)>& totalRhythmSimilarityCallback,
-               const std::function<float(float, float)>& totalSimilarityCallback) {
-                
-                auto results = collection.findMelodyPattern(melodyPattern, totalIntervalsSimilarityThreshold,
-                                                            totalRhythmSimilarityThreshold,
-                                                            intervalsSimilarityCallback, rhythmSimilarityCallback,
-                                                            totalIntervalSimilarityCallback, totalRhythmSimilarityCallback,
-                                                            totalSimilarityCallback);
+               const std::function<float(float, float)>& totalSimilarityCallback,
+               const MelodySimilarityMetric metric, const int warpingWindow, const int numThreads,
+               const bool deterministicOrder) {
+
+                // The workers take the interpreter lock only to run Python callbacks
+                auto results = [&]() {
+                    py::gil_scoped_release release;
+                    return collection.findMelodyPattern(melodyPattern, totalIntervalsSimilarityThreshold,
+                                                        totalRhythmSimilarityThreshold,
+                                                        intervalsSimilarityCallback, rhythmSimilarityCallback,
+                                                        totalIntervalSimilarityCallback, totalRhythmSimilarityCallback,
+                                                        totalSimilarityCallback, metric, warpingWindow,
+                                                        numThreads, deterministicOrder);
+                }();
 
                 // Converte para uma lista de dicionários para compatibilidade com Pandas
                 std::vector<py::dict> records;
@@ -98,7 +270,10 @@ void ScoreCollectionClass(const py::module& m) {
             py::arg("rhythmSimilarityCallback") = nullptr,
             py::arg("totalIntervalSimilarityCallback") = nullptr,
             py::arg("totalRhythmSimilarityCallback") = nullptr,
-            py::arg("totalSimilarityCallback") = nullptr);
+            py::arg("totalSimilarityCallback") = nullptr,
+            py::arg("metric") = MelodySimilarityMetric::EUCLIDEAN,
+            py::arg("warpingWindow") = 2, py::arg("numThreads") = 0,
+            py::arg("deterministicOrder") = true);
 
     // Wrapper para a segunda versão de findMelodyPatternDataFrame, que aceita múltiplos padrões
     cls.def("findMelodyPatternDataFrame",
@@ -108,13 +283,20 @@ void ScoreCollectionClass(const py::module& m) {
                const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>& rhythmSimilarityCallback,
                const std::function<float(const std::vector<float>&)>& totalIntervalSimilarityCallback,
                const std::function<float(const std::vector<float>&)>& totalRhythmSimilarityCallback,
-               const std::function<float(float, float)>& totalSimilarityCallback) {
+               const std::function<float(float, float)>& totalSimilarityCallback,
+               const MelodySimilarityMetric metric, const int warpingWindow, const int numThreads,
+               const bool deterministicOrder) {
 
-                auto allResults = collection.findMelodyPattern(melodyPatterns, totalIntervalsSimilarityThreshold,
-                                                               totalRhythmSimilarityThreshold,
-                                                               intervalsSimilarityCallback, rhythmSimilarityCallback,
-                                                               totalIntervalSimilarityCallback, totalRhythmSimilarityCallback,
-                                                               totalSimilarityCallback);
+                // The workers take the interpreter lock only to run Python callbacks
+                auto allResults = [&]() {
+                    py::gil_scoped_release release;
+                    return collection.findMelodyPattern(melodyPatterns, totalIntervalsSimilarityThreshold,
+                                                        totalRhythmSimilarityThreshold,
+                                                        intervalsSimilarityCallback, rhythmSimilarityCallback,
+                                                        totalIntervalSimilarityCallback, totalRhythmSimilarityCallback,
+                                                        totalSimilarityCallback, metric, warpingWindow,
+                                                        numThreads, deterministicOrder);
+                }();
 
                 // Converte para uma lista de dicionários para compatibilidade com Pandas
                 py::object pandas = py::module_::import("pandas");
@@ -158,7 +340,42 @@ void ScoreCollectionClass(const py::module& m) {
             py::arg("rhythmSimilarityCallback") = nullptr,
             py::arg("totalIntervalSimilarityCallback") = nullptr,
             py::arg("totalRhythmSimilarityCallback") = nullptr,
-            py::arg("totalSimilarityCallback") = nullptr);
+            py::arg("totalSimilarityCallback") = nullptr,
+            py::arg("metric") = MelodySimilarityMetric::EUCLIDEAN,
+            py::arg("warpingWindow") = 2, py::arg("numThreads") = 0,
+            py::arg("deterministicOrder") = true);
+
+    cls.def("findMelodyPatternMatches", &ScoreCollection::findMelodyPatternMatches,
+            py::arg("melodyPattern"), py::arg("callback"),
+            py::arg("totalIntervalsSimilarityThreshold") = 0.5f,
+            py::arg("totalRhythmSimilarityThreshold") = 0.5f,
+            py::arg("metric") = MelodySimilarityMetric::EUCLIDEAN, py::arg("warpingWindow") = 2);
+    cls.def("countMelodyPattern", &ScoreCollection::countMelodyPattern, py::arg("melodyPattern"),
+            py::arg("totalIntervalsSimilarityThreshold") = 0.5f,
+            py::arg("totalRhythmSimilarityThreshold") = 0.5f,
+            py::arg("metric") = MelodySimilarityMetric::EUCLIDEAN, py::arg("warpingWindow") = 2,
+            py::call_guard<py::gil_scoped_release>());
+    cls.def("findTopMelodyPattern", &ScoreCollection::findTopMelodyPattern,
+            py::arg("melodyPattern"), py::arg("k"),
+            py::arg("totalIntervalsSimilarityThreshold") = 0.5f,
+            py::arg("totalRhythmSimilarityThreshold") = 0.5f,
+            py::arg("metric") = MelodySimilarityMetric::EUCLIDEAN, py::arg("warpingWindow") = 2,
+            py::call_guard<py::gil_scoped_release>());
+    cls.def("findMelodyRegex", &ScoreCollection::findMelodyRegex, py::arg("pattern"),
+            py::arg("numThreads") = 0, py::call_guard<py::gil_scoped_release>());
+    cls.def("findChordProgression", &ScoreCollection::findChordProgression,
+            py::arg("progression"), py::arg("config") = nlohmann::json(),
+            py::arg("mergeRepeatedChords") = true, py::arg("numThreads") = 0,
+            py::call_guard<py::gil_scoped_release>());
+
+    cls.def("buildMelodyIndex", &ScoreCollection::buildMelodyIndex, py::arg("numThreads") = 0,
+            py::call_guard<py::gil_scoped_release>());
+    cls.def("saveMelodyIndex", &ScoreCollection::saveMelodyIndex, py::arg("filePath"),
+            py::call_guard<py::gil_scoped_release>());
+    cls.def("loadMelodyIndex", &ScoreCollection::loadMelodyIndex, py::arg("filePath"),
+            py::arg("numThreads") = 0, py::call_guard<py::gil_scoped_release>());
+    cls.def("hasMelodyIndex", &ScoreCollection::hasMelodyIndex);
+    cls.def("clearMelodyIndex", &ScoreCollection::clearMelodyIndex);
 
     // Default Python 'print' function:
     cls.def("__repr__", [](const ScoreCollection& scoreCollection) {
@@ -0,0 +1,81 @@
+#include "maiacore/reducers.h"
+
+#include <algorithm>
+
+#include "maiacore/log.h"
+
+HistogramReducer::HistogramReducer(const double minValue, const double maxValue,
+                                   const int numBins)
+    : _minValue(minValue), _maxValue(maxValue) {
+    if (numBins < 1 || !(maxValue > minValue)) {
+        LOG_ERROR("Invalid histogram: the range must be increasing and have at least 1 bin");
+    }
+
+    _bins.assign(numBins, 0.0);
+}
+
+void HistogramReducer::add(const double value, const double weight) {
+    if (value < _minValue) {
+        _underflow += weight;
+        return;
+    }
+    if (value >= _maxValue) {
+        _overflow += weight;
+        return;
+    }
+
+    const int numBins = _bins.size();
+    const int binIdx = static_cast<int>((value - _minValue) / (_maxValue - _minValue) * numBins);
+    _bins[std::min(binIdx, numBins - 1)] += weight;  // Rounding at the upper edge
+}
+
+void HistogramReducer::merge(HistogramReducer&& other) {
+    if (other._minValue != _minValue || other._maxValue != _maxValue ||
+        other._bins.size() != _bins.size()) {
+        LOG_ERROR("Unable to merge histograms with different bins");
+    }
+
+    for (size_t i = 0; i < _bins.size(); i++) {
+        _bins[i] += other._bins[i];
+    }
+    _underflow += other._underflow;
+    _overflow += other._overflow;
+}
+
+const std::vector<double>& HistogramReducer::getBins() const { return _bins; }
+
+std::vector<double> HistogramReducer::getBinEdges() const {
+    const int numBins = _bins.size();
+    std::vector<double> edges(numBins + 1);
+    for (int i = 0; i <= numBins; i++) {
+        edges[i] = _minValue + (_maxValue - _minValue) * i / numBins;
+    }
+    return edges;
+}
+
+std::vector<double> HistogramReducer::getNormalizedBins() const {
+    double total = 0.0;
+    for (const double bin : _bins) {
+        total += bin;
+    }
+
+    std::vector<double> normalized(_bins.size(), 0.0);
+    if (total > 0.0) {
+        for (size_t i = 0; i < _bins.size(); i++) {
+            normalized[i] = _bins[i] / total;
+        }
+    }
+    return normalized;
+}
+
+double HistogramReducer::getUnderflow() const { return _underflow; }
+
+double HistogramReducer::getOverflow() const { return _overflow; }
+
+double HistogramReducer::getTotal() const {
+    double total = _underflow + _overflow;
+    for (const double bin : _bins) {
+        total += bin;
+    }
+    return total;
+}
@@ -0,0 +1,132 @@
+#include "maiacore/rhythm_matcher.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "maiacore/log.h"
+
+namespace {
+
+const uint64_t HASH_BASE = 1000003ULL;  // Arithmetic modulo 2^64
+
+uint64_t intervalHashValue(const int64_t interval) {
+    // Mixes the interval so that small tick values spread over the whole word
+    uint64_t x = static_cast<uint64_t>(interval) + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    return x ^ (x >> 27);
+}
+
+}  // namespace
+
+RhythmMatcher::RhythmMatcher(const std::vector<int64_t>& cellIntervals, const float tolerance)
+    : _cell(cellIntervals), _tolerance(tolerance) {
+    if (_cell.empty()) {
+        LOG_ERROR("A rhythmic cell must have at least 2 onsets");
+    }
+    if (_tolerance < 0.0f) {
+        LOG_ERROR("The rhythm tolerance must be non-negative");
+    }
+
+    for (const int64_t interval : _cell) {
+        if (interval <= 0) {
+            LOG_ERROR("The inter-onset intervals of a rhythmic cell must be positive");
+        }
+        _cellHash = _cellHash * HASH_BASE + intervalHashValue(interval);
+    }
+
+    for (size_t i = 1; i < _cell.size(); i++) {
+        _highestPower *= HASH_BASE;
+    }
+}
+
+int RhythmMatcher::getNumIntervals() const { return _cell.size(); }
+
+float RhythmMatcher::deviation(const int64_t interval, const int cellIdx) const {
+    return static_cast<float>(std::abs(static_cast<double>(interval - _cell[cellIdx])) /
+                              static_cast<double>(_cell[cellIdx]));
+}
+
+std::vector<RhythmMatcher::Match> RhythmMatcher::findAll(
+    const std::vector<int64_t>& intervals) const {
+    return (_tolerance == 0.0f) ? findExact(intervals) : findApproximate(intervals);
+}
+
+std::vector<RhythmMatcher::Match> RhythmMatcher::findExact(
+    const std::vector<int64_t>& intervals) const {
+    std::vector<Match> matches;
+    const int numIntervals = intervals.size();
+    const int cellSize = _cell.size();
+    if (numIntervals < cellSize) {
+        return matches;
+    }
+
+    uint64_t windowHash = 0;
+    for (int i = 0; i < cellSize; i++) {
+        windowHash = windowHash * HASH_BASE + intervalHashValue(intervals[i]);
+    }
+
+    for (int start = 0;; start++) {
+        if (windowHash == _cellHash &&
+            std::equal(_cell.begin(), _cell.end(), intervals.begin() + start)) {
+            matches.push_back({start, 0.0f});
+        }
+
+        if (start + cellSize >= numIntervals) {
+            break;
+        }
+
+        // Rolls the window one interval to the right
+        windowHash -= intervalHashValue(intervals[start]) * _highestPower;
+        windowHash = windowHash * HASH_BASE + intervalHashValue(intervals[start + cellSize]);
+    }
+
+    return matches;
+}
+
+std::vector<RhythmMatcher::Match> RhythmMatcher::findApproximate(
+    const std::vector<int64_t>& intervals) const {
+    std::vector<Match> matches;
+    const int numIntervals = intervals.size();
+    const int cellSize = _cell.size();
+
+    const auto appendMatch = [&](const int start) {
+        float maxDeviation = 0.0f;
+        for (int k = 0; k < cellSize; k++) {
+            maxDeviation = std::max(maxDeviation, deviation(intervals[start + k], k));
+        }
+        matches.push_back({start, maxDeviation});
+    };
+
+    if (cellSize > 64) {
+        for (int start = 0; start + cellSize <= numIntervals; start++) {
+            int k = 0;
+            while (k < cellSize && deviation(intervals[start + k], k) <= _tolerance) {
+                k++;
+            }
+            if (k == cellSize) {
+                appendMatch(start);
+            }
+        }
+        return matches;
+    }
+
+    // Shift-And: bit k of 'state' is set if the last k + 1 intervals match the first k + 1
+    // intervals of the cell
+    const uint64_t finalBit = uint64_t{1} << (cellSize - 1);
+    uint64_t state = 0;
+    for (int i = 0; i < numIntervals; i++) {
+        uint64_t intervalMask = 0;
+        for (int k = 0; k < cellSize; k++) {
+            if (deviation(intervals[i], k) <= _tolerance) {
+                intervalMask |= uint64_t{1} << k;
+            }
+        }
+
+        state = ((state << 1) | 1) & intervalMask;
+        if (state & finalBit) {
+            appendMatch(i - cellSize + 1);
+        }
+    }
+
+    return matches;
+}
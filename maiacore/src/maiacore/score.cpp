@@ -1,10 +1,18 @@
 #include "maiacore/score.h"
 
+#include <atomic>
+#include <cmath>  // std::llround
+#include <cstring>  // std::memcpy
+#include <deque>
+#include <exception>  // std::exception_ptr
 #include <filesystem>  // Para std::filesystem::absolute
 #include <iostream>
 #include <limits>  // std::numeric_limits
+#include <numeric>  // std::iota
 #include <set>
+#include <sstream>
 #include <tuple>
+#include <unordered_set>
 #include <thread>
 #include <future>
 #include <vector>
@@ -15,6 +23,8 @@
 #include "maiacore/clef.h"
 #include "maiacore/helper.h"
 #include "maiacore/log.h"
+#include "maiacore/suffix_array.h"
+#include "maiacore/thread_pool.h"
 #include "maiacore/utils.h"
 #include "miniz-cpp/zip_file.hpp"
 #include "nlohmann/json.hpp"
@@ -86,6 +96,7 @@ void Score::clear() {
     _isValidXML = false;
     _haveTypeTag = false;
     _isLoadedXML = false;
+    _isChangedAfterLoad = false;
     _lcmDivisionsPerQuarterNote = 0;
 }
 
@@ -121,6 +132,44 @@ std::string Score::getFilePath() const { return _filePath; }
 
 std::string Score::getFileName() const { return _fileName; }
 
+Score::Score(const char* xmlData, const size_t xmlSize, const std::string& filePath)
+    : _numParts(0),
+      _numMeasures(0),
+      _numNotes(0),
+      _isValidXML(false),
+      _haveTypeTag(false),
+      _isLoadedXML(false),
+      _lcmDivisionsPerQuarterNote(0),
+      _haveAnacrusisMeasure(false) {
+    loadXMLBuffer(xmlData, xmlSize, filePath);
+}
+
+void Score::loadXMLBuffer(const char* xmlData, const size_t xmlSize,
+                          const std::string& filePath) {
+    clear();
+
+    _filePath = filePath;
+    const size_t slash = filePath.find_last_of("/\\");
+    _fileName = (slash == std::string::npos) ? filePath : filePath.substr(slash + 1);
+
+    if (!_doc.load_buffer(xmlData, xmlSize)) {
+        LOG_ERROR("Unable to load the MusicXML document of: " + filePath);
+        return;
+    }
+
+    loadXMLDocument();
+}
+
+std::string Score::saveXMLDocument() const {
+    if (!_isLoadedXML || _isChangedAfterLoad || !_doc.document_element()) {
+        return toXML();
+    }
+
+    std::ostringstream stream;
+    _doc.save(stream, "", pugi::format_raw);
+    return stream.str();
+}
+
 void Score::loadXMLFile(const std::string& filePath) {
     clear();
 
@@ -180,6 +229,10 @@ void Score::loadXMLFile(const std::string& filePath) {
         return;
     }
 
+    loadXMLDocument();
+}
+
+void Score::loadXMLDocument() {
     // Try to get the main MusicXML nodes:
     const std::string xPathParts = "/score-partwise/part";
     const std::string xPathMeasures = "/score-partwise/part[1]/measure";
@@ -748,10 +801,14 @@ void Score::loadXMLFile(const std::string& filePath) {
             }
         }
     }
+
+    // The parts and metadata above were filled from the document
+    _isChangedAfterLoad = false;
 }
 
 void Score::addPart(const std::string& partName, const int numStaves) {
     // PROFILE_FUNCTION();
+    _isChangedAfterLoad = true;
 
     _part.emplace_back(partName, numStaves);
     _part.back().addMeasure(_numMeasures);
@@ -762,6 +819,7 @@ void Score::addPart(const std::string& partName, const int numStaves) {
 
 void Score::removePart(const int partId) {
     // PROFILE_FUNCTION();
+    _isChangedAfterLoad = true;
 
     if (partId >= static_cast<int>(_part.size())) {
         LOG_ERROR("Invalid part index");
@@ -773,6 +831,7 @@ void Score::removePart(const int partId) {
 
 void Score::addMeasure(const int numMeasures) {
     // PROFILE_FUNCTION();
+    _isChangedAfterLoad = true;
     const int partSize = _part.size();
 
     for (int i = 0; i < partSize; i++) {
@@ -789,6 +848,7 @@ void Score::removeMeasure(const int measureStart, const int measureEnd) {
         return;
     }
 
+    _isChangedAfterLoad = true;
     const int partSize = _part.size();
 
     for (int i = 0; i < partSize; i++) {
@@ -807,6 +867,8 @@ Part& Score::getPart(const int partId) {
         LOG_ERROR("Invalid partId: " + std::to_string(partId));
     }
 
+    // The part can be changed through the reference
+    _isChangedAfterLoad = true;
     return _part.at(partId);
 }
 
@@ -864,14 +926,21 @@ const std::vector<std::string> Score::getPartsNames() const {
 
 std::string Score::getTitle() const { return _title; }
 
-void Score::setTitle(const std::string& scoreTitle) { _title = scoreTitle; }
+void Score::setTitle(const std::string& scoreTitle) {
+    _title = scoreTitle;
+    _isChangedAfterLoad = true;
+}
 
 std::string Score::getComposerName() const { return _composerName; }
 
-void Score::setComposerName(const std::string& composerName) { _composerName = composerName; }
+void Score::setComposerName(const std::string& composerName) {
+    _composerName = composerName;
+    _isChangedAfterLoad = true;
+}
 
 void Score::setKeySignature(const int fifthCicle, const bool isMajorMode, const int measureId) {
     // PROFILE_FUNCTION();
+    _isChangedAfterLoad = true;
     const int partSize = _part.size();
 
     for (int i = 0; i < partSize; i++) {
@@ -899,6 +968,7 @@ void Score::setKeySignature(const std::string& key, const int measureId) {
 
 void Score::setTimeSignature(const int timeUpper, const int timeLower, const int measureId) {
     // PROFILE_FUNCTION();
+    _isChangedAfterLoad = true;
     if (measureId < 0) {  // For all measures
         for (auto& part : _part) {
             for (int m = 0; m < _numMeasures; m++) {
@@ -931,6 +1001,7 @@ void Score::setMetronomeMark(int bpm, const RhythmFigure duration, int measureSt
     measureStart = (measureStart < 0) ? 0 : measureStart;
 
     // ===== PROCESSING ===== //
+    _isChangedAfterLoad = true;
     const int partSize = _part.size();
 
     for (int i = 0; i < partSize; i++) {
@@ -1751,12 +1822,18 @@ std::vector<std::vector<Score::NoteEvent>> Score::collectNoteEventsPerPart() con
         return _cachedNoteEventsPerPart;
     }
 
-    _cachedNoteEventsPerPart.clear(); // Garante que esteja vazio antes de preencher
-    _cachedNoteEventsPerPart.reserve(getNumParts());
+    _cachedNoteEventsPerPart = buildNoteEventsPerPart();
+    _isNoteEventsPerPartCached = true; // Marca o cache como preenchido
+    return _cachedNoteEventsPerPart;
+}
+
+std::vector<std::vector<Score::NoteEvent>> Score::buildNoteEventsPerPart() const {
+    std::vector<std::vector<NoteEvent>> noteEventsPerPart;
+    noteEventsPerPart.reserve(getNumParts());
     const int NUM_NOTES_PER_MEASURE = 16;
     for (int partIdx = 0; partIdx < getNumParts(); partIdx++) {
-        std::vector<NoteEvent> cachedNoteEvents;
-        cachedNoteEvents.reserve(_part[partIdx].getNumMeasures() * NUM_NOTES_PER_MEASURE);
+        std::vector<NoteEvent> noteEvents;
+        noteEvents.reserve(_part[partIdx].getNumMeasures() * NUM_NOTES_PER_MEASURE);
 
         const Part& currentPart = _part[partIdx];
         const std::string& currentPartName = currentPart.getName();
@@ -1774,378 +1851,1706 @@ std::vector<std::vector<Score::NoteEvent>> Score::collectNoteEventsPerPart() con
                         continue;
                     }
                     const std::string& currentKeyName = currentMeasure.getKey().getName();
-                    cachedNoteEvents.push_back({currentPartName, measureIdx, staveIdx, noteIdx, currentKeyName, &currentNote});
+                    noteEvents.push_back({currentPartName, measureIdx, staveIdx, noteIdx, currentKeyName, &currentNote});
                 }
             }
         }
-        _cachedNoteEventsPerPart.push_back(cachedNoteEvents);
+        noteEventsPerPart.push_back(std::move(noteEvents));
     }
 
-    _isNoteEventsPerPartCached = true; // Marca o cache como preenchido
-    return _cachedNoteEventsPerPart;
+    return noteEventsPerPart;
 }
 
-Score::MelodyPatternTable Score::findMelodyPattern(
-    const std::vector<Note>& melodyPattern, const float totalIntervalsSimilarityThreshold,
-    const float totalRhythmSimilarityThreshold,
-    const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
-        intervalsSimilarityCallback,
-    const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
-        rhythmSimilarityCallback,
-    const std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback,
-    const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback,
-    const std::function<float(float, float)> totalSimilarityCallback) const {
-    const int totalNumNotes = getNumNotes();
-    const int melodyPatternSize = melodyPattern.size();
-
-    if (melodyPatternSize > totalNumNotes) {
-        LOG_ERROR("The melody pattern is bigger than the score");
-    }
+namespace {
 
-    MelodyPatternTable resultTable;
+// Second and following notes of a tie do not start a new onset
+bool isTieContinuation(const Note& note) {
+    const auto ties = note.getTie();
+    return std::find(ties.begin(), ties.end(), "stop") != ties.end();
+}
 
-    // Error checking: empty pattern
-    if (melodyPatternSize == 0) {
-        return resultTable;
+// Least common multiple of all 'divisions' of the parts: every onset is an integer number of ticks
+int64_t divisionsTicksGrid(const std::vector<Part>& parts) {
+    int64_t grid = 1;
+    for (const Part& part : parts) {
+        for (int measureIdx = 0; measureIdx < part.getNumMeasures(); measureIdx++) {
+            const Measure& measure = part.getMeasure(measureIdx);
+            grid = std::lcm(grid, static_cast<int64_t>(std::max(1, measure.getDivisionsPerQuarterNote())));
+            for (int staveIdx = 0; staveIdx < measure.getNumStaves(); staveIdx++) {
+                for (int noteIdx = 0; noteIdx < measure.getNumNotes(staveIdx); noteIdx++) {
+                    const int divisions = measure.getNote(noteIdx, staveIdx).getDivisionsPerQuarterNote();
+                    grid = std::lcm(grid, static_cast<int64_t>(std::max(1, divisions)));
+                }
+            }
+        }
     }
+    return grid;
+}
 
-    const auto& noteEvents = collectNoteEvents(); // Obtém o cache de eventos de nota
-    resultTable.reserve(noteEvents.size() - melodyPattern.size());
+}  // namespace
+
+void Score::collectMelodyStreams(std::vector<MelodyStream>* streams,
+                                 std::vector<std::vector<NoteEvent>>* noteEvents) const {
+    streams->clear();
+    noteEvents->clear();
+
+    const bool needsOnsets = _melodyStreamsPerVoice || _melodySkylineStreams || _melodyBasslineStreams;
+    const int64_t grid = needsOnsets ? divisionsTicksGrid(_part) : 1;
+    const std::vector<std::vector<NoteEvent>> noteEventsPerPart =
+        _melodyStreamsPerVoice ? std::vector<std::vector<NoteEvent>>() : buildNoteEventsPerPart();
+
+    // Note attacked at a given tick, for the skyline and the bassline
+    struct Attack {
+        int64_t onset;
+        int measureIdx;
+        int staveIdx;
+        int noteIdx;
+        const Note* notePtr;
+    };
 
-    // ===== STEP 1: COLETAR TODAS AS NOTAS DA PARTITURA ===== //
     for (int partIdx = 0; partIdx < getNumParts(); partIdx++) {
-        std::vector<NoteEvent> noteEvents;
-        const int NUM_NOTES_PER_MEASURE = 16;
-        noteEvents.reserve(_part[partIdx].getNumMeasures() * NUM_NOTES_PER_MEASURE);
+        const Part& part = _part[partIdx];
+        const std::string& partName = part.getName();
+
+        MelodyStream partStream;
+        partStream.partIdx = partIdx;
+        partStream.partName = partName;
+
+        // ===== STEP 1: MELODIA DA PARTE (PADRÃO) ===== //
+        if (!_melodyStreamsPerVoice) {
+            partStream.type = MelodyStreamType::PART;
+            partStream.numNoteEvents = noteEventsPerPart[partIdx].size();
+            streams->push_back(partStream);
+            noteEvents->push_back(noteEventsPerPart[partIdx]);
+        }
 
-        const Part& currentPart = _part[partIdx];
-        const std::string& currentPartName = currentPart.getName();
-        for (int measureIdx = 0; measureIdx < currentPart.getNumMeasures(); measureIdx++) {
-            const Measure& currentMeasure = currentPart.getMeasure(measureIdx);
-            const int numStaves = currentMeasure.getNumStaves();
-            for (int staveIdx = 0; staveIdx < numStaves; staveIdx++) {
-                const int numNotes = currentMeasure.getNumNotes(staveIdx);
-                for (int noteIdx = 0; noteIdx < numNotes; noteIdx++) {
-                    const Note& currentNote = currentMeasure.getNote(noteIdx, staveIdx);
+        if (!needsOnsets) {
+            continue;
+        }
 
-                    // Skip all chords and multiple voices! To fix in the future
-                    // Get only the top melody of each instrument/stave
-                    if (currentNote.inChord() || currentNote.getVoice() != 1) {
-                        continue;
+        // ===== STEP 2: LINHAS (PAUTA, VOZ) E ATAQUES DA PARTE ===== //
+        std::map<std::pair<int, int>, std::vector<NoteEvent>> voiceEvents;  // (stave, voice)
+        std::vector<Attack> attacks;
+        int64_t measureStart = 0;
+        for (int measureIdx = 0; measureIdx < part.getNumMeasures(); measureIdx++) {
+            const Measure& measure = part.getMeasure(measureIdx);
+            const std::string& keyName = measure.getKey().getName();
+            const int64_t measureScale = grid / std::max(1, measure.getDivisionsPerQuarterNote());
+            const int64_t measureEnd = measureStart + measure.getDurationTicks() * measureScale;
+
+            // Each voice restarts at the beginning of the measure
+            int64_t lastNoteEnd = measureStart;
+            for (int staveIdx = 0; staveIdx < measure.getNumStaves(); staveIdx++) {
+                std::map<int, int64_t> voiceCursor;
+                std::map<int, int64_t> voiceLastOnset;
+                for (int noteIdx = 0; noteIdx < measure.getNumNotes(staveIdx); noteIdx++) {
+                    const Note& note = measure.getNote(noteIdx, staveIdx);
+                    const int voice = note.getVoice();
+                    int64_t& cursor = voiceCursor.emplace(voice, measureStart).first->second;
+                    std::vector<NoteEvent>& events = voiceEvents[{staveIdx, voice}];
+
+                    // Chord notes start with the previous note of the voice: the line keeps the
+                    // highest one
+                    int64_t onset = cursor;
+                    if (note.inChord()) {
+                        onset = voiceLastOnset.emplace(voice, cursor).first->second;
+                        if (!events.empty() && note.isNoteOn() && events.back().notePtr->isNoteOn() &&
+                            note.getMidiNumber() > events.back().notePtr->getMidiNumber()) {
+                            events.back().noteIdx = noteIdx;
+                            events.back().notePtr = &note;
+                        }
+                    } else {
+                        events.push_back({partName, measureIdx, staveIdx, noteIdx, keyName, &note});
+                        voiceLastOnset[voice] = cursor;
+                        cursor += note.getDurationTicks() * (grid / std::max(1, note.getDivisionsPerQuarterNote()));
+                        lastNoteEnd = std::max(lastNoteEnd, cursor);
                     }
-                    const std::string& currentKeyName = currentMeasure.getKey().getName();
-                    // Armazena o evento da nota em memória
-                    noteEvents.push_back(
-                        {currentPartName, measureIdx, staveIdx, noteIdx, currentKeyName, &currentNote});
-                }
-            }
-        }
 
-        const int patternMaxIterations = noteEvents.size() - melodyPatternSize;
-        for (int i = 0; i < patternMaxIterations; i++) {
-            // Extrai o segmento para comparação com o padrão
-            std::vector<Note> segment;
-            segment.reserve(melodyPatternSize);
-            for (int offset = 0; offset < melodyPatternSize; offset++) {
-                const Note& note = *noteEvents[i + offset].notePtr;
-                segment.push_back(note);
+                    if (note.isNoteOn() && note.isPitched() && !note.isGraceNote() &&
+                        !isTieContinuation(note)) {
+                        attacks.push_back({onset, measureIdx, staveIdx, noteIdx, &note});
+                    }
+                }
             }
 
+            // The anacrusis measure lasts only its notes
+            measureStart = (measureIdx == 0 && _haveAnacrusisMeasure) ? lastNoteEnd : measureEnd;
+        }
 
-            // ==== COMPUTE THE TRANSPOSE SEMITONES ===== //
-            const Note* patternFirstNoteOn = nullptr;
-            bool melodyContainANoteOn = false;
-            for (int i = 0; i < melodyPatternSize; i++) {
-                if (melodyPattern[i].isNoteOff()) {
+        if (_melodyStreamsPerVoice) {
+            for (auto& entry : voiceEvents) {
+                // Voices made only of rests have no melody
+                const bool hasNotes = std::any_of(
+                    entry.second.begin(), entry.second.end(),
+                    [](const NoteEvent& event) { return event.notePtr->isNoteOn(); });
+                if (!hasNotes) {
                     continue;
                 }
 
-                melodyContainANoteOn = true;
-                patternFirstNoteOn = &melodyPattern[i];
-                break;
+                MelodyStream voiceStream = partStream;
+                voiceStream.type = MelodyStreamType::VOICE;
+                voiceStream.staveIdx = entry.first.first;
+                voiceStream.voice = entry.first.second;
+                voiceStream.numNoteEvents = entry.second.size();
+                streams->push_back(voiceStream);
+                noteEvents->push_back(std::move(entry.second));
             }
+        }
 
-            const Note* segmentFirstNoteOn = nullptr;
-            bool segmentContainANoteOn = false;
-            for (int i = 0; i < melodyPatternSize; i++) {
-                if (segment[i].isNoteOff()) {
-                    continue;
+        // ===== STEP 3: SKYLINE E BASSLINE ===== //
+        if (attacks.empty()) {
+            continue;
+        }
+
+        std::stable_sort(attacks.begin(), attacks.end(), [](const Attack& a, const Attack& b) {
+            return a.onset < b.onset;
+        });
+
+        const auto appendOuterLine = [&](const MelodyStreamType type, const bool keepHighest) {
+            std::vector<NoteEvent> events;
+            size_t first = 0;
+            while (first < attacks.size()) {
+                size_t last = first;
+                size_t selected = first;
+                while (last < attacks.size() && attacks[last].onset == attacks[first].onset) {
+                    const int midi = attacks[last].notePtr->getMidiNumber();
+                    const int selectedMidi = attacks[selected].notePtr->getMidiNumber();
+                    if (keepHighest ? (midi > selectedMidi) : (midi < selectedMidi)) {
+                        selected = last;
+                    }
+                    last++;
                 }
 
-                segmentContainANoteOn = true;
-                segmentFirstNoteOn = &segment[i];
-                break;
+                const Attack& attack = attacks[selected];
+                events.push_back({partName, attack.measureIdx, attack.staveIdx, attack.noteIdx,
+                                  part.getMeasure(attack.measureIdx).getKey().getName(),
+                                  attack.notePtr});
+                first = last;
             }
 
-            // const int patternFirstNoteMidi = patternFirstNoteOn->getMidiNumber();
-            // const int segmentFirstNoteMidi = segmentFirstNoteOn->getMidiNumber();
-            // const int transposeSemitones = segmentFirstNoteMidi - patternFirstNoteMidi;
+            MelodyStream outerStream = partStream;
+            outerStream.type = type;
+            outerStream.numNoteEvents = events.size();
+            streams->push_back(outerStream);
+            noteEvents->push_back(std::move(events));
+        };
 
-            std::string intervalName;
-            if (melodyContainANoteOn && segmentContainANoteOn) {
-                const std::string& patternFirstSoundingPitch = patternFirstNoteOn->getSoundingPitch();
-                const std::string& segmentFirstSoundingPitch = segmentFirstNoteOn->getSoundingPitch();
+        if (_melodySkylineStreams) {
+            appendOuterLine(MelodyStreamType::SKYLINE, true);
+        }
+        if (_melodyBasslineStreams) {
+            appendOuterLine(MelodyStreamType::BASSLINE, false);
+        }
+    }
+}
 
-                const Interval transposeInterval(patternFirstSoundingPitch, segmentFirstSoundingPitch);
-                intervalName = transposeInterval.getName() + " " + transposeInterval.getDirection();
-            }
+void Score::setMelodyStreams(const bool splitVoices, const bool includeSkyline,
+                             const bool includeBassline) {
+    _melodyStreamsPerVoice = splitVoices;
+    _melodySkylineStreams = includeSkyline;
+    _melodyBasslineStreams = includeBassline;
+    _melodySearchIndex.reset();
+    _fingerprint.reset();
+}
 
-            const std::vector<float> semitonesDiff =
-                (intervalsSimilarityCallback == nullptr)
-                    ? Helper::getSemitonesDifferenceBetweenMelodies(melodyPattern, segment)
-                    : intervalsSimilarityCallback(melodyPattern, segment);
+std::vector<Score::MelodyStream> Score::getMelodyStreams() const {
+    return getMelodySearchIndex().streams;
+}
 
-            const std::vector<float> durationDiff =
-                (rhythmSimilarityCallback == nullptr)
-                    ? Helper::getDurationDifferenceBetweenRhythms(melodyPattern, segment)
-                    : rhythmSimilarityCallback(melodyPattern, segment);
+namespace {
 
-            // Calcula as similaridades
-            float totalIntervalSimilarity = -1.0f;
-            float totalRhythmSimilarity = -1.0f;
-            if (intervalsSimilarityCallback == nullptr) {
-                totalIntervalSimilarity = Helper::calculateMelodyEuclideanSimilarity(semitonesDiff);
-            } else {
-                totalIntervalSimilarity = totalIntervalSimilarityCallback(semitonesDiff);
-            }
+// Lazy cache shared by the threads (and collections) that read the same score: the first stored
+// value wins, so every caller gets the same object
+template <typename T>
+const T& storeCache(std::shared_ptr<const T>* cache, std::shared_ptr<const T> value) {
+    std::shared_ptr<const T> expected;
+    if (!std::atomic_compare_exchange_strong(cache, &expected, value)) {
+        return *expected;
+    }
+    return *value;
+}
 
-            if (rhythmSimilarityCallback == nullptr) {
-                totalRhythmSimilarity = Helper::calculateRhythmicEuclideanSimilarity(durationDiff);
-            } else {
-                totalRhythmSimilarity = totalRhythmSimilarityCallback(durationDiff);
-            }
+}  // namespace
 
-            // Verifica se as similaridades estão acima dos limites
-            if (totalIntervalSimilarity < totalIntervalsSimilarityThreshold ||
-                totalRhythmSimilarity < totalRhythmSimilarityThreshold) {
-                continue;
-            }
-            // Calcula a similaridade total usando o callback personalizado
-            float totalSimilarity = -1.0f;
-            if (totalSimilarityCallback == nullptr) {
-                totalSimilarity = (totalIntervalSimilarity + totalRhythmSimilarity) / 2.0f;
-            } else {
-                totalSimilarity =
-                    totalSimilarityCallback(totalIntervalSimilarity, totalRhythmSimilarity);
-            }
+const ScoreFingerprint& Score::getFingerprint() const {
+    const auto cached = std::atomic_load(&_fingerprint);
+    if (cached != nullptr) {
+        return *cached;
+    }
+    return storeCache<ScoreFingerprint>(
+        &_fingerprint, std::make_shared<ScoreFingerprint>(ScoreFingerprint::compute(*this)));
+}
 
-            std::vector<std::string> segmentPitchList(segment.size());
-            for (int p = 0; p < (int)segment.size(); p++) {
-                segmentPitchList[p] = segment[p].getWrittenPitch();
-            }
+const ScoreDescriptor& Score::getDescriptor() const {
+    const auto cached = std::atomic_load(&_descriptor);
+    if (cached != nullptr) {
+        return *cached;
+    }
+    return storeCache<ScoreDescriptor>(
+        &_descriptor, std::make_shared<ScoreDescriptor>(ScoreDescriptor::compute(*this)));
+}
 
-            // Armazena o resultado
-            MelodyPatternRow row(currentPartName,
-                                 noteEvents[i].measureIdx,  // Número do compasso
-                                 noteEvents[i].staveIdx,    // ID da clave
-                                 noteEvents[i].keyName,         // Tonalidade do compasso
-                                 intervalName, // Intervalo de transposição
-                                 segmentPitchList, // Lista de pitchs do segmento
-                                 semitonesDiff,  // Lista de diferenças intervalares em semitons
-                                 durationDiff,   // Lista de similaridade rítmica
-                                 totalIntervalSimilarity,  // Similaridade intervalar total
-                                 totalRhythmSimilarity,    // Similaridade rítmica total
-                                 totalSimilarity           // Similaridade total
-            );
+namespace {
 
-            resultTable.push_back(row);
-        }
+// Same semitones of Helper::getSemitonesDifferenceBetweenMelodies(): 0 if any note is a rest
+int melodicInterval(const Note& firstNote, const Note& secondNote) {
+    if (firstNote.isNoteOff() || secondNote.isNoteOff()) {
+        return 0;
     }
 
-    return resultTable;
+    return secondNote.getMidiNumber() - firstNote.getMidiNumber();
 }
 
-std::vector<Score::MelodyPatternTable> Score::findMelodyPattern(
-        const std::vector<std::vector<Note>>& melodyPatterns, const float totalIntervalsSimilarityThreshold,
-        const float totalRhythmSimilarityThreshold,
-        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
-            intervalsSimilarityCallback,
-        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
-            rhythmSimilarityCallback,
-        const std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback,
-        const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback,
-        const std::function<float(float, float)> totalSimilarityCallback) const {
-    const auto& noteEvents = collectNoteEvents(); // Obtém o cache de eventos de nota uma única vez
-    std::vector<Score::MelodyPatternTable> results(melodyPatterns.size());
-
-    // Mutex para proteger o acesso ao vetor `results`
-    std::mutex results_mutex;
-
-    // Função para processar cada padrão de melodia
-    auto process_pattern = [&](size_t idx) {
-        std::cout << "Processando padrão de melodia: " << idx << std::endl;
-
-        // Realiza a operação intensiva em C++ e armazena o resultado
-        auto result = findMelodyPattern(
-            melodyPatterns[idx],
-            totalIntervalsSimilarityThreshold,
-            totalRhythmSimilarityThreshold,
-            intervalsSimilarityCallback,
-            rhythmSimilarityCallback,
-            totalIntervalSimilarityCallback,
-            totalRhythmSimilarityCallback,
-            totalSimilarityCallback
-        );
-
-        // Protege o acesso a `results` antes de armazenar o resultado
-        std::lock_guard<std::mutex> lock(results_mutex);
-        results[idx] = std::move(result);
-    };
+// Transposition-invariant shape of a melodic pattern: consecutive MIDI and duration differences
+struct PatternShapeKey {
+    std::vector<int> midiDifferences;
+    std::vector<float> durationDifferences;
+
+    explicit PatternShapeKey(const std::vector<Note>& pattern) {
+        const size_t numDifferences = pattern.empty() ? 0 : pattern.size() - 1;
+        midiDifferences.reserve(numDifferences);
+        durationDifferences.reserve(numDifferences);
+        for (size_t i = 1; i < pattern.size(); i++) {
+            midiDifferences.push_back(pattern[i].getMidiNumber() - pattern[i - 1].getMidiNumber());
+            durationDifferences.push_back(pattern[i].getQuarterDuration() -
+                                          pattern[i - 1].getQuarterDuration());
+        }
+    }
 
-    // Limita o número de threads de acordo com o número de núcleos da CPU
-    size_t num_threads = std::min(melodyPatterns.size(), static_cast<size_t>(std::thread::hardware_concurrency()));
-    std::vector<std::thread> threads;
+    bool operator==(const PatternShapeKey& other) const {
+        return midiDifferences == other.midiDifferences &&
+               durationDifferences == other.durationDifferences;
+    }
+};
 
-    // Executa cada padrão de melodia em um thread separado até o limite definido
-    for (size_t idx = 0; idx < num_threads; ++idx) {
-        threads.emplace_back([&, idx]() {
-            try {
-                process_pattern(idx);
-            } catch (const std::exception& e) {
-                std::cerr << "Erro ao processar padrão: " << e.what() << std::endl;
-            }
-        });
+struct PatternShapeKeyHash {
+    size_t operator()(const PatternShapeKey& key) const {
+        size_t seed = key.midiDifferences.size();
+        auto combine = [&seed](const size_t value) {
+            seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        };
+
+        for (const int midiDifference : key.midiDifferences) {
+            combine(std::hash<int>()(midiDifference));
+        }
+
+        for (const float durationDifference : key.durationDifferences) {
+            // -0.0f == 0.0f, so both must land in the same bucket
+            combine(std::hash<float>()(durationDifference == 0.0f ? 0.0f : durationDifference));
+        }
+
+        return seed;
     }
+};
+
+// Token key of a pair of consecutive notes for findRepeatedMotifs(): interval, rest flags of both
+// notes and (optionally) the bits of both note durations. Consecutive tokens share a note, so a
+// run of tokens compares every note of the motif, including the last one
+struct MotifTokenKey {
+    uint64_t shape = 0;
+    uint64_t durations = 0;
 
-    // Espera por todos os threads
-    for (auto& thread : threads) {
-        if (thread.joinable()) thread.join();
+    bool operator==(const MotifTokenKey& other) const {
+        return shape == other.shape && durations == other.durations;
     }
+};
 
-    return results;
+struct MotifTokenKeyHash {
+    size_t operator()(const MotifTokenKey& key) const {
+        size_t seed = std::hash<uint64_t>()(key.shape);
+        seed ^= std::hash<uint64_t>()(key.durations) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+};
+
+uint32_t motifDurationBits(const float quarterDuration) {
+    // -0.0f == 0.0f, so both must have the same bits
+    const float duration = (quarterDuration == 0.0f) ? 0.0f : quarterDuration;
+    uint32_t durationBits = 0;
+    std::memcpy(&durationBits, &duration, sizeof(durationBits));
+    return durationBits;
 }
 
-void Score::removeDuplicatePatterns(std::vector<std::vector<Note>>* patterns) const {
-    auto& patternsRef = *patterns;
-    std::set<size_t> uniqueIndices;  // Armazena os índices de padrões únicos
+MotifTokenKey motifTokenKey(const int interval, const bool isFirstRest, const bool isSecondRest,
+                            const float firstQuarterDuration, const float secondQuarterDuration,
+                            const bool considerRhythm) {
+    MotifTokenKey key;
+    key.shape = (static_cast<uint64_t>(static_cast<uint32_t>(interval + 1024) & 0x7FF) << 2) |
+                (static_cast<uint64_t>(isFirstRest ? 1 : 0) << 1) |
+                static_cast<uint64_t>(isSecondRest ? 1 : 0);
+    if (considerRhythm) {
+        key.durations = (static_cast<uint64_t>(motifDurationBits(firstQuarterDuration)) << 32) |
+                        motifDurationBits(secondQuarterDuration);
+    }
 
-    // Função auxiliar para calcular as diferenças de MIDI entre notas
-    auto calculateMidiDifferences = [](const std::vector<Note>& pattern) {
-        std::vector<int> midiDiffs;
-        for (size_t i = 1; i < pattern.size(); ++i) {
-            midiDiffs.push_back(pattern[i].getMidiNumber() - pattern[i - 1].getMidiNumber());
-        }
-        return midiDiffs;
-    };
+    return key;
+}
 
-    // Função auxiliar para calcular as diferenças de durações normalizadas entre notas
-    auto calculateDurationDifferences = [](const std::vector<Note>& pattern) {
-        std::vector<float> durationDiffs;
-        for (size_t i = 1; i < pattern.size(); ++i) {
-            float diff = pattern[i].getQuarterDuration() - pattern[i - 1].getQuarterDuration();
-            durationDiffs.push_back(diff);
-        }
-        return durationDiffs;
-    };
+}  // namespace
 
-    for (size_t i = 0; i < patternsRef.size(); ++i) {
-        if (uniqueIndices.find(i) != uniqueIndices.end()) {
-            continue;  // Padrão já marcado como único
-        }
+const Score::MelodySearchIndex& Score::getMelodySearchIndex() const {
+    const auto cached = std::atomic_load(&_melodySearchIndex);
+    if (cached != nullptr) {
+        return *cached;
+    }
+
+    auto index = std::make_shared<MelodySearchIndex>();
+    collectMelodyStreams(&index->streams, &index->noteEvents);
 
-        // Calcula as diferenças de MIDI e duração para o padrão atual
-        auto midiDiffs1 = calculateMidiDifferences(patternsRef[i]);
-        auto durationDiffs1 = calculateDurationDifferences(patternsRef[i]);
+    const int numStreams = index->noteEvents.size();
+    const int gramSize = MelodySearchIndex::GRAM_SIZE;
+    index->intervals.resize(numStreams);
+    index->quarterDurations.resize(numStreams);
+    index->firstNoteOn.resize(numStreams);
+    index->postings.resize(numStreams);
 
-        bool isUnique = true;
+    for (int streamIdx = 0; streamIdx < numStreams; streamIdx++) {
+        const auto& noteEvents = index->noteEvents[streamIdx];
+        auto& intervals = index->intervals[streamIdx];
+        auto& postings = index->postings[streamIdx];
 
-        for (size_t j = i + 1; j < patternsRef.size(); ++j) {
-            // Calcula as diferenças de MIDI e duração para o padrão a ser comparado
-            auto midiDiffs2 = calculateMidiDifferences(patternsRef[j]);
-            auto durationDiffs2 = calculateDurationDifferences(patternsRef[j]);
+        const int numEvents = noteEvents.size();
+        for (int i = 0; i + 1 < numEvents; i++) {
+            intervals.push_back(melodicInterval(*noteEvents[i].notePtr, *noteEvents[i + 1].notePtr));
+        }
 
-            // Verifica se ambos os critérios de igualdade são atendidos
-            if (midiDiffs1 == midiDiffs2 && durationDiffs1 == durationDiffs2) {
-                isUnique = false;
-                uniqueIndices.insert(j);  // Marca o padrão `j` como duplicado
+        auto& quarterDurations = index->quarterDurations[streamIdx];
+        auto& firstNoteOn = index->firstNoteOn[streamIdx];
+        quarterDurations.resize(numEvents);
+        firstNoteOn.resize(numEvents);
+
+        int nextNoteOn = numEvents;
+        for (int i = numEvents - 1; i >= 0; i--) {
+            const Note& note = *noteEvents[i].notePtr;
+            quarterDurations[i] = note.getDuration().getQuarterDuration();
+            if (!note.isNoteOff()) {
+                nextNoteOn = i;
             }
+            firstNoteOn[i] = nextNoteOn;
         }
 
-        if (isUnique) {
-            uniqueIndices.insert(i);  // Marca o padrão `i` como único
+        const int numGrams = static_cast<int>(intervals.size()) - gramSize + 1;
+        for (int i = 0; i < numGrams; i++) {
+            postings[Helper::intervalsGramKey(&intervals[i], gramSize)].push_back(i);
         }
     }
 
-    // Filtra o vetor original para manter apenas os padrões únicos
-    std::vector<std::vector<Note>> filteredPatterns;
-    for (size_t i : uniqueIndices) {
-        filteredPatterns.push_back(std::move(patternsRef[i]));
+    // Key names are interned: MelodyPatternMatch only stores their index
+    std::unordered_map<std::string, int> keyIdxMap;
+    index->keyIds.resize(numStreams);
+    for (int streamIdx = 0; streamIdx < numStreams; streamIdx++) {
+        for (const NoteEvent& event : index->noteEvents[streamIdx]) {
+            const auto it = keyIdxMap.emplace(event.keyName, index->keyNames.size());
+            if (it.second) {
+                index->keyNames.push_back(event.keyName);
+            }
+            index->keyIds[streamIdx].push_back(it.first->second);
+        }
     }
 
-    // Substitui o vetor original pelos padrões únicos
-    patternsRef = std::move(filteredPatterns);
+    return storeCache<MelodySearchIndex>(&_melodySearchIndex, index);
 }
 
-std::vector<Score::MelodyPatternTable> Score::findAnyMelodyPattern(
-        const int patternNumNotes,
-        const float totalIntervalsSimilarityThreshold,
-        const float totalRhythmSimilarityThreshold,
-        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
-            intervalsSimilarityCallback,
-        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
-            rhythmSimilarityCallback,
-        const std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback,
-        const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback,
-        const std::function<float(float, float)> totalSimilarityCallback) const {
-    
-    const auto& noteEventsPerPart = collectNoteEventsPerPart();
-    std::vector<std::vector<Note>> patterns;
-    const int maxNumPatterns = getNumNotes() / patternNumNotes;
-    // std::cout << "Max melody blocks to find: " << maxNumPatterns << std::endl;
-    patterns.reserve(maxNumPatterns); // Impreciso
-    
-    // std::cout << "Creating melody patterns vector..." << std::endl;
-    for (const auto& noteEventList : noteEventsPerPart) {
-        int patternMaxIterationIdx = noteEventList.size() - patternNumNotes;
-        for (int eventIdx = 0; eventIdx < patternMaxIterationIdx; eventIdx++) {
-            std::vector<Note> localPattern;
-            localPattern.reserve(patternNumNotes);
-            const int maxEventIdx = eventIdx + patternNumNotes;
-            for (int idx = eventIdx; idx < maxEventIdx; idx++) {
-                localPattern.push_back(*noteEventList[idx].notePtr);
-            }
-            patterns.push_back(localPattern);
+Score::MelodyPatternQuery Score::prepareMelodyPatternQuery(
+    const std::vector<Note>& melodyPattern, const float totalIntervalsSimilarityThreshold,
+    const float totalRhythmSimilarityThreshold,
+    const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>&
+        intervalsSimilarityCallback,
+    const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>&
+        rhythmSimilarityCallback,
+    const std::function<float(const std::vector<float>&)>& totalIntervalSimilarityCallback,
+    const std::function<float(const std::vector<float>&)>& totalRhythmSimilarityCallback,
+    const std::function<float(float, float)>& totalSimilarityCallback,
+    const MelodySimilarityMetric metric, const int warpingWindow) const {
+    const int totalNumNotes = getNumNotes();
+    const int melodyPatternSize = melodyPattern.size();
+
+    if (melodyPatternSize > totalNumNotes) {
+        LOG_ERROR("The melody pattern is bigger than the score");
+    }
+
+    if (metric == MelodySimilarityMetric::DTW) {
+        if (warpingWindow < 0) {
+            LOG_ERROR("The DTW warping window must be non-negative");
+        }
+
+        if (intervalsSimilarityCallback != nullptr || rhythmSimilarityCallback != nullptr) {
+            LOG_ERROR("Custom similarity callbacks are only supported by the EUCLIDEAN metric");
         }
     }
 
-    removeDuplicatePatterns(&patterns);
+    MelodyPatternQuery query;
+    query.melodyPattern = &melodyPattern;
+    query.totalIntervalsSimilarityThreshold = totalIntervalsSimilarityThreshold;
+    query.totalRhythmSimilarityThreshold = totalRhythmSimilarityThreshold;
+    query.intervalsSimilarityCallback = intervalsSimilarityCallback;
+    query.rhythmSimilarityCallback = rhythmSimilarityCallback;
+    query.totalIntervalSimilarityCallback = totalIntervalSimilarityCallback;
+    query.totalRhythmSimilarityCallback = totalRhythmSimilarityCallback;
+    query.totalSimilarityCallback = totalSimilarityCallback;
+
+    // ===== VETORES DO PADRÃO (calculados uma única vez) ===== //
+    // The index is only valid for the default interval similarity
+    query.useDefaultIntervals = intervalsSimilarityCallback == nullptr && melodyPatternSize >= 2;
+    query.useDefaultRhythm = rhythmSimilarityCallback == nullptr && melodyPatternSize >= 2;
+    query.numPatternIntervals = std::max(0, melodyPatternSize - 1);
+
+    for (int i = 0; i < query.numPatternIntervals; i++) {
+        query.patternIntervals.push_back(melodicInterval(melodyPattern[i], melodyPattern[i + 1]));
+    }
 
-    // std::cout << "Searching patterns..." << std::endl;
-    return findMelodyPattern(patterns, totalIntervalsSimilarityThreshold, 
-    totalRhythmSimilarityThreshold, intervalsSimilarityCallback, rhythmSimilarityCallback, 
-    totalIntervalSimilarityCallback, totalRhythmSimilarityCallback, totalSimilarityCallback);
-}
+    query.patternDurations.resize(melodyPatternSize);
+    query.patternMaxDuration = 0.0f;
+    for (int i = 0; i < melodyPatternSize; i++) {
+        query.patternDurations[i] = melodyPattern[i].getDuration().getQuarterDuration();
+        query.patternMaxDuration = std::max(query.patternMaxDuration, query.patternDurations[i]);
+    }
 
-bool Score::haveAnacrusisMeasure() const { return _haveAnacrusisMeasure; }
+    // ==== COMPUTE THE TRANSPOSE SEMITONES ===== //
+    query.patternFirstNoteOn = nullptr;
+    for (int i = 0; i < melodyPatternSize; i++) {
+        if (!melodyPattern[i].isNoteOff()) {
+            query.patternFirstNoteOn = &melodyPattern[i];
+            break;
+        }
+    }
 
-int Score::xPathCountNodes(const std::string& xPath) const {
-    // Select all nodes from the given XPath:
-    const pugi::xpath_node_set nodes = _doc.select_nodes(xPath.c_str());
+    // ===== JANELAS CANDIDATAS ===== //
+    // Each different interval adds at least 1 to the squared distance: find the maximum
+    // number of different intervals that can still reach the interval similarity threshold
+    int maxIntervalMismatches = query.numPatternIntervals;
+    if (query.useDefaultIntervals) {
+        maxIntervalMismatches = -1;
+        while (maxIntervalMismatches < query.numPatternIntervals &&
+               1.0f / (1.0f + std::sqrt(static_cast<float>(maxIntervalMismatches + 1))) >=
+                   totalIntervalsSimilarityThreshold) {
+            maxIntervalMismatches++;
+        }
+    }
 
-    // Compute the number of nodes:
-    return nodes.size();
+    // Pigeonhole: split the pattern intervals in (maxIntervalMismatches + 1) blocks.
+    // A window above the threshold matches at least one whole block, so it starts at the
+    // posting of the first n-gram of that block
+    query.numBlocks = maxIntervalMismatches + 1;
+    query.blockSize = (query.numBlocks > 0) ? query.numPatternIntervals / query.numBlocks : 0;
+    query.useIndex = query.useDefaultIntervals && query.numBlocks > 0 &&
+                     query.blockSize >= MelodySearchIndex::GRAM_SIZE;
+
+    // ===== DTW ===== //
+    query.metric = metric;
+    query.warpingWindow = warpingWindow;
+    if (metric == MelodySimilarityMetric::DTW) {
+        query.patternContour.assign(melodyPatternSize, 0);
+        for (int i = 0; i < query.numPatternIntervals; i++) {
+            query.patternContour[i + 1] = query.patternContour[i] + query.patternIntervals[i];
+        }
+
+        // 1 / (1 + sqrt(D)) >= threshold  <=>  D <= (1 / threshold - 1)^2
+        query.maxDtwDistance = std::numeric_limits<double>::infinity();
+        if (totalIntervalsSimilarityThreshold > 0.0f) {
+            const double maxDistance = 1.0 / totalIntervalsSimilarityThreshold - 1.0;
+            query.maxDtwDistance = maxDistance * maxDistance;
+        }
+    }
+
+    return query;
 }
 
-void Score::setRepeat(int measureStart, int measureEnd) {
-    // INPUT ARGUMENTS VALIDATION
-    measureStart = (measureStart < 0) ? 0 : measureStart;
-    measureEnd =
-        (measureEnd < 0 || measureEnd > (_numMeasures - 1)) ? _numMeasures - 1 : measureEnd;
+void Score::findMelodyPatternInStream(const MelodyPatternQuery& query, const int streamIdx,
+                                      const MelodyPatternEmitter& emit) const {
+    const MelodySearchIndex& index = getMelodySearchIndex();
+    const int melodyPatternSize = query.melodyPattern->size();
 
-    // Error checking
-    if (measureEnd == 0) {
-        LOG_ERROR("'measureEnd' MUST BE greater than 0");
+    // Error checking: empty pattern
+    if (melodyPatternSize == 0) {
+        return;
     }
 
-    // For each part: set repeat barlines
-    for (auto& part : _part) {
-        part.getMeasure(measureStart).setRepeatStart();
-        part.getMeasure(measureEnd).setRepeatEnd();
+    if (query.metric == MelodySimilarityMetric::DTW) {
+        findMelodyPatternInStreamDtw(query, streamIdx, emit);
+        return;
     }
-}
 
-void Score::forEachNote(
-    std::function<void(Part* part, Measure* measure, int staveId, Note* note)> callback,
+    const std::vector<NoteEvent>& noteEvents = index.noteEvents[streamIdx];
+    const std::vector<int>& intervals = index.intervals[streamIdx];
+    const std::vector<float>& durations = index.quarterDurations[streamIdx];
+    const int gramSize = MelodySearchIndex::GRAM_SIZE;
+
+    const int patternMaxIterations = noteEvents.size() - melodyPatternSize;
+    if (patternMaxIterations <= 0) {
+        return;
+    }
+
+    std::vector<float> windowDurationDiff(melodyPatternSize);
+
+    std::vector<int> candidates;
+    if (query.useIndex) {
+        const auto& postings = index.postings[streamIdx];
+        for (int block = 0; block < query.numBlocks; block++) {
+            const int blockStart = block * query.blockSize;
+            const auto it =
+                postings.find(Helper::intervalsGramKey(&query.patternIntervals[blockStart], gramSize));
+            if (it == postings.end()) {
+                continue;
+            }
+
+            for (const int eventIdx : it->second) {
+                const int windowIdx = eventIdx - blockStart;
+                if (windowIdx >= 0 && windowIdx < patternMaxIterations) {
+                    candidates.push_back(windowIdx);
+                }
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    } else {
+        candidates.resize(patternMaxIterations);
+        std::iota(candidates.begin(), candidates.end(), 0);
+    }
+
+    // ===== STEP 4: VERIFICAÇÃO DE CADA JANELA ===== //
+    for (const int i : candidates) {
+        float totalIntervalSimilarity = -1.0f;
+        float totalRhythmSimilarity = -1.0f;
+        std::vector<float> semitonesDiff;
+        std::vector<float> durationDiff;
+
+        // Skip the windows that cannot reach the interval threshold before copying the notes
+        if (query.useDefaultIntervals) {
+            totalIntervalSimilarity = Helper::intervalsEuclideanSimilarity(
+                query.patternIntervals.data(), &intervals[i], query.numPatternIntervals);
+
+            if (totalIntervalSimilarity < query.totalIntervalsSimilarityThreshold) {
+                continue;
+            }
+        }
+
+        if (query.useDefaultIntervals && query.useDefaultRhythm) {
+            // Default similarities: work on the precomputed arrays, without Note copies
+            if (!Helper::durationsEuclideanSimilarity(query.patternDurations.data(),
+                                                      query.patternMaxDuration, &durations[i],
+                                                      melodyPatternSize,
+                                                      query.totalRhythmSimilarityThreshold,
+                                                      windowDurationDiff.data(),
+                                                      &totalRhythmSimilarity)) {
+                continue;
+            }
+
+            if (query.needsDifferences) {
+                semitonesDiff.resize(query.numPatternIntervals);
+                for (int k = 0; k < query.numPatternIntervals; k++) {
+                    semitonesDiff[k] = (float)query.patternIntervals[k] - (float)intervals[i + k];
+                }
+                durationDiff = windowDurationDiff;
+            }
+        } else {
+            // Extrai o segmento para comparação com o padrão
+            std::vector<Note> segment;
+            segment.reserve(melodyPatternSize);
+            for (int offset = 0; offset < melodyPatternSize; offset++) {
+                const Note& note = *noteEvents[i + offset].notePtr;
+                segment.push_back(note);
+            }
+
+            semitonesDiff =
+                (query.intervalsSimilarityCallback == nullptr)
+                    ? Helper::getSemitonesDifferenceBetweenMelodies(*query.melodyPattern, segment)
+                    : query.intervalsSimilarityCallback(*query.melodyPattern, segment);
+
+            durationDiff =
+                (query.rhythmSimilarityCallback == nullptr)
+                    ? Helper::getDurationDifferenceBetweenRhythms(*query.melodyPattern, segment)
+                    : query.rhythmSimilarityCallback(*query.melodyPattern, segment);
+
+            // Calcula as similaridades
+            if (query.intervalsSimilarityCallback == nullptr) {
+                totalIntervalSimilarity = Helper::calculateMelodyEuclideanSimilarity(semitonesDiff);
+            } else {
+                totalIntervalSimilarity = query.totalIntervalSimilarityCallback(semitonesDiff);
+            }
+
+            if (query.rhythmSimilarityCallback == nullptr) {
+                totalRhythmSimilarity = Helper::calculateRhythmicEuclideanSimilarity(durationDiff);
+            } else {
+                totalRhythmSimilarity = query.totalRhythmSimilarityCallback(durationDiff);
+            }
+
+            // Verifica se as similaridades estão acima dos limites
+            if (totalIntervalSimilarity < query.totalIntervalsSimilarityThreshold ||
+                totalRhythmSimilarity < query.totalRhythmSimilarityThreshold) {
+                continue;
+            }
+        }
+
+        emit(makeMelodyPatternMatch(query, streamIdx, i, melodyPatternSize,
+                                    totalIntervalSimilarity, totalRhythmSimilarity),
+             semitonesDiff, durationDiff);
+    }
+}
+
+void Score::findMelodyPatternInStreamDtw(const MelodyPatternQuery& query, const int streamIdx,
+                                         const MelodyPatternEmitter& emit) const {
+    const MelodySearchIndex& index = getMelodySearchIndex();
+    const std::vector<int>& intervals = index.intervals[streamIdx];
+    const std::vector<float>& durations = index.quarterDurations[streamIdx];
+    const std::vector<int>& patternContour = query.patternContour;
+
+    const int numEvents = durations.size();
+    const int melodyPatternSize = patternContour.size();
+    const int warpingWindow = query.warpingWindow;
+    const int bandWidth = 2 * warpingWindow + 1;
+
+    // The segment ends 'warpingWindow' notes before or after the pattern length
+    const int minSegmentEnd = std::max(0, melodyPatternSize - 1 - warpingWindow);
+    if (numEvents <= minSegmentEnd) {
+        return;
+    }
+
+    // ===== CONTORNO DA PARTE E ENVELOPE (LB_Keogh) ===== //
+    // Segment contour at offset b = contour[i + b] - contour[i]
+    std::vector<int> contour(numEvents, 0);
+    for (int j = 1; j < numEvents; j++) {
+        contour[j] = contour[j - 1] + intervals[j - 1];
+    }
+
+    // Minimum and maximum of contour[j - warpingWindow .. j + warpingWindow] (monotonic deques)
+    std::vector<int> upperEnvelope(numEvents);
+    std::vector<int> lowerEnvelope(numEvents);
+    std::deque<int> maxDeque;
+    std::deque<int> minDeque;
+    for (int k = 0; k < numEvents + warpingWindow; k++) {
+        if (k < numEvents) {
+            while (!maxDeque.empty() && contour[maxDeque.back()] <= contour[k]) {
+                maxDeque.pop_back();
+            }
+            maxDeque.push_back(k);
+            while (!minDeque.empty() && contour[minDeque.back()] >= contour[k]) {
+                minDeque.pop_back();
+            }
+            minDeque.push_back(k);
+        }
+
+        const int center = k - warpingWindow;
+        if (center < 0) {
+            continue;
+        }
+
+        while (maxDeque.front() < center - warpingWindow) {
+            maxDeque.pop_front();
+        }
+        while (minDeque.front() < center - warpingWindow) {
+            minDeque.pop_front();
+        }
+        upperEnvelope[center] = contour[maxDeque.front()];
+        lowerEnvelope[center] = contour[minDeque.front()];
+    }
+
+    // Small slack: pruning must never reject a segment accepted by the float similarity test
+    const double pruneDistance = query.maxDtwDistance * (1.0 + 1e-6) + 1e-6;
+    const int64_t infinity = std::numeric_limits<int64_t>::max() / 4;
+
+    // DTW matrix restricted to the band: cell (a, b) is stored at a * bandWidth + (b - a + w)
+    std::vector<int64_t> dtw(melodyPatternSize * bandWidth);
+    const auto cell = [&](const int a, const int b, const int maxSegmentEnd) -> int64_t {
+        if (a < 0 || b < 0 || b > maxSegmentEnd || std::abs(a - b) > warpingWindow) {
+            return infinity;
+        }
+        return dtw[a * bandWidth + (b - a + warpingWindow)];
+    };
+
+    std::vector<std::pair<int, int>> path;
+    for (int i = 0; i + minSegmentEnd < numEvents; i++) {
+        const int base = contour[i];
+        const int maxSegmentEnd = std::min(melodyPatternSize - 1 + warpingWindow, numEvents - 1 - i);
+
+        // ===== LOWER BOUND: LB_Keogh ===== //
+        // Each pattern note is aligned to a segment note inside its band, so its cost is at
+        // least the squared distance to the band envelope
+        double lowerBound = 0.0;
+        for (int a = 0; a < melodyPatternSize && lowerBound <= pruneDistance; a++) {
+            const int j = std::min(i + a, numEvents - 1);
+            const int value = patternContour[a] + base;
+            int distance = 0;
+            if (value > upperEnvelope[j]) {
+                distance = value - upperEnvelope[j];
+            } else if (value < lowerEnvelope[j]) {
+                distance = lowerEnvelope[j] - value;
+            }
+            lowerBound += static_cast<double>(distance) * distance;
+        }
+
+        if (lowerBound > pruneDistance) {
+            continue;
+        }
+
+        // ===== BANDED DTW WITH EARLY ABANDONING ===== //
+        bool isAbandoned = false;
+        for (int a = 0; a < melodyPatternSize && !isAbandoned; a++) {
+            const int firstB = std::max(0, a - warpingWindow);
+            const int lastB = std::min(a + warpingWindow, maxSegmentEnd);
+            int64_t rowMinimum = infinity;
+
+            for (int b = firstB; b <= lastB; b++) {
+                const int64_t diff = patternContour[a] - (contour[i + b] - base);
+                int64_t previous = 0;
+                if (a > 0 || b > 0) {
+                    previous = std::min({cell(a - 1, b, maxSegmentEnd),
+                                         cell(a, b - 1, maxSegmentEnd),
+                                         cell(a - 1, b - 1, maxSegmentEnd)});
+                }
+
+                const int64_t value = (previous >= infinity) ? infinity : previous + diff * diff;
+                dtw[a * bandWidth + (b - a + warpingWindow)] = value;
+                rowMinimum = std::min(rowMinimum, value);
+            }
+
+            // Costs are non-negative: a path through this row cannot get cheaper
+            isAbandoned = firstB > lastB || static_cast<double>(rowMinimum) > pruneDistance;
+        }
+
+        if (isAbandoned) {
+            continue;
+        }
+
+        // Best segment end
+        const int lastA = melodyPatternSize - 1;
+        int segmentEnd = -1;
+        int64_t distance = infinity;
+        for (int b = minSegmentEnd; b <= maxSegmentEnd; b++) {
+            const int64_t value = cell(lastA, b, maxSegmentEnd);
+            if (value < distance) {
+                distance = value;
+                segmentEnd = b;
+            }
+        }
+
+        if (segmentEnd < 0 || static_cast<double>(distance) > pruneDistance) {
+            continue;
+        }
+
+        const float totalIntervalSimilarity =
+            1.0f / (1.0f + std::sqrt(static_cast<float>(distance)));
+        if (totalIntervalSimilarity < query.totalIntervalsSimilarityThreshold) {
+            continue;
+        }
+
+        // ===== CAMINHO DE ALINHAMENTO ===== //
+        path.clear();
+        int a = lastA;
+        int b = segmentEnd;
+        path.emplace_back(a, b);
+        while (a > 0 || b > 0) {
+            const int64_t diagonal = cell(a - 1, b - 1, maxSegmentEnd);
+            const int64_t up = cell(a - 1, b, maxSegmentEnd);
+            const int64_t left = cell(a, b - 1, maxSegmentEnd);
+            if (diagonal <= up && diagonal <= left) {
+                a--;
+                b--;
+            } else if (up <= left) {
+                a--;
+            } else {
+                b--;
+            }
+            path.emplace_back(a, b);
+        }
+        std::reverse(path.begin(), path.end());
+
+        // Rhythm similarity along the warping path
+        float segmentMaxDuration = 0.0f;
+        for (int k = 0; k <= segmentEnd; k++) {
+            segmentMaxDuration = std::max(segmentMaxDuration, durations[i + k]);
+        }
+
+        std::vector<float> semitonesDiff(path.size());
+        std::vector<float> durationDiff(path.size());
+        float sumSquares = 0.0f;
+        for (size_t k = 0; k < path.size(); k++) {
+            const int patternIdx = path[k].first;
+            const int segmentIdx = path[k].second;
+            semitonesDiff[k] =
+                (float)patternContour[patternIdx] - (float)(contour[i + segmentIdx] - base);
+            durationDiff[k] = query.patternDurations[patternIdx] / query.patternMaxDuration -
+                              durations[i + segmentIdx] / segmentMaxDuration;
+            sumSquares += durationDiff[k] * durationDiff[k];
+        }
+
+        const float totalRhythmSimilarity = 1.0f / (1.0f + std::sqrt(sumSquares));
+        if (totalRhythmSimilarity < query.totalRhythmSimilarityThreshold) {
+            continue;
+        }
+
+        emit(makeMelodyPatternMatch(query, streamIdx, i, segmentEnd + 1,
+                                    totalIntervalSimilarity, totalRhythmSimilarity),
+             semitonesDiff, durationDiff);
+    }
+}
+
+Score::MelodyPatternMatch Score::makeMelodyPatternMatch(const MelodyPatternQuery& query,
+                                                        const int streamIdx, const int segmentStart,
+                                                        const int segmentSize,
+                                                        const float totalIntervalSimilarity,
+                                                        const float totalRhythmSimilarity) const {
+    const MelodySearchIndex& index = getMelodySearchIndex();
+    const NoteEvent& firstEvent = index.noteEvents[streamIdx][segmentStart];
+
+    MelodyPatternMatch match;
+    match.partIdx = index.streams[streamIdx].partIdx;
+    match.streamIdx = streamIdx;
+    match.measureIdx = firstEvent.measureIdx;
+    match.staveIdx = firstEvent.staveIdx;
+    match.keyIdx = index.keyIds[streamIdx][segmentStart];
+    match.noteEventIdx = segmentStart;
+    match.numNotes = segmentSize;
+    match.totalIntervalSimilarity = totalIntervalSimilarity;
+    match.totalRhythmSimilarity = totalRhythmSimilarity;
+
+    // Calcula a similaridade total usando o callback personalizado
+    if (query.totalSimilarityCallback == nullptr) {
+        match.totalSimilarity = (totalIntervalSimilarity + totalRhythmSimilarity) / 2.0f;
+    } else {
+        match.totalSimilarity =
+            query.totalSimilarityCallback(totalIntervalSimilarity, totalRhythmSimilarity);
+    }
+
+    return match;
+}
+
+void Score::appendMelodyPatternRow(const MelodyPatternQuery& query, const MelodyPatternMatch& match,
+                                   std::vector<float> semitonesDiff,
+                                   std::vector<float> durationDiff,
+                                   MelodyPatternTable* resultTable) const {
+    const MelodySearchIndex& index = getMelodySearchIndex();
+    const int streamIdx = match.streamIdx;
+    const int segmentStart = match.noteEventIdx;
+    const int segmentSize = match.numNotes;
+    const std::vector<NoteEvent>& noteEvents = index.noteEvents[streamIdx];
+    const std::string& currentPartName = _part[match.partIdx].getName();
+
+    // Strings are only built for the accepted windows
+    const int segmentFirstNoteOnIdx = index.firstNoteOn[streamIdx][segmentStart];
+
+    std::string intervalName;
+    if (query.patternFirstNoteOn != nullptr && segmentFirstNoteOnIdx < segmentStart + segmentSize) {
+        const std::string& patternFirstSoundingPitch = query.patternFirstNoteOn->getSoundingPitch();
+        const std::string& segmentFirstSoundingPitch =
+            noteEvents[segmentFirstNoteOnIdx].notePtr->getSoundingPitch();
+
+        const Interval transposeInterval(patternFirstSoundingPitch, segmentFirstSoundingPitch);
+        intervalName = transposeInterval.getName() + " " + transposeInterval.getDirection();
+    }
+
+    std::vector<std::string> segmentPitchList(segmentSize);
+    for (int p = 0; p < segmentSize; p++) {
+        segmentPitchList[p] = noteEvents[segmentStart + p].notePtr->getWrittenPitch();
+    }
+
+    // Armazena o resultado
+    MelodyPatternRow row(currentPartName,
+                         noteEvents[segmentStart].measureIdx,  // Número do compasso
+                         noteEvents[segmentStart].staveIdx,    // ID da clave
+                         noteEvents[segmentStart].keyName,         // Tonalidade do compasso
+                         intervalName, // Intervalo de transposição
+                         std::move(segmentPitchList), // Lista de pitchs do segmento
+                         std::move(semitonesDiff),  // Lista de diferenças intervalares em semitons
+                         std::move(durationDiff),   // Lista de similaridade rítmica
+                         match.totalIntervalSimilarity,  // Similaridade intervalar total
+                         match.totalRhythmSimilarity,    // Similaridade rítmica total
+                         match.totalSimilarity           // Similaridade total
+    );
+
+    resultTable->push_back(std::move(row));
+}
+
+Score::MelodyPatternTable Score::findMelodyPattern(
+    const std::vector<Note>& melodyPattern, const float totalIntervalsSimilarityThreshold,
+    const float totalRhythmSimilarityThreshold,
+    const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+        intervalsSimilarityCallback,
+    const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+        rhythmSimilarityCallback,
+    const std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback,
+    const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback,
+    const std::function<float(float, float)> totalSimilarityCallback,
+    const MelodySimilarityMetric metric, const int warpingWindow) const {
+    const MelodyPatternQuery query = prepareMelodyPatternQuery(
+        melodyPattern, totalIntervalsSimilarityThreshold, totalRhythmSimilarityThreshold,
+        intervalsSimilarityCallback, rhythmSimilarityCallback, totalIntervalSimilarityCallback,
+        totalRhythmSimilarityCallback, totalSimilarityCallback, metric, warpingWindow);
+
+    MelodyPatternTable resultTable;
+    const MelodyPatternEmitter appendRow = [&](const MelodyPatternMatch& match,
+                                               std::vector<float>& semitonesDiff,
+                                               std::vector<float>& durationDiff) {
+        appendMelodyPatternRow(query, match, std::move(semitonesDiff), std::move(durationDiff),
+                               &resultTable);
+    };
+
+    const int numStreams = getMelodySearchIndex().noteEvents.size();
+    for (int streamIdx = 0; streamIdx < numStreams; streamIdx++) {
+        findMelodyPatternInStream(query, streamIdx, appendRow);
+    }
+
+    return resultTable;
+}
+
+Score::MelodyPatternTable Score::findMelodyPatternInStream(
+    const int streamIdx, const std::vector<Note>& melodyPattern,
+    const float totalIntervalsSimilarityThreshold, const float totalRhythmSimilarityThreshold,
+    const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+        intervalsSimilarityCallback,
+    const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+        rhythmSimilarityCallback,
+    const std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback,
+    const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback,
+    const std::function<float(float, float)> totalSimilarityCallback,
+    const MelodySimilarityMetric metric, const int warpingWindow) const {
+    const int numStreams = getMelodySearchIndex().noteEvents.size();
+    if (streamIdx < 0 || streamIdx >= numStreams) {
+        LOG_ERROR("Invalid melody stream index: " + std::to_string(streamIdx));
+    }
+
+    const MelodyPatternQuery query = prepareMelodyPatternQuery(
+        melodyPattern, totalIntervalsSimilarityThreshold, totalRhythmSimilarityThreshold,
+        intervalsSimilarityCallback, rhythmSimilarityCallback, totalIntervalSimilarityCallback,
+        totalRhythmSimilarityCallback, totalSimilarityCallback, metric, warpingWindow);
+
+    MelodyPatternTable resultTable;
+    findMelodyPatternInStream(query, streamIdx,
+                              [&](const MelodyPatternMatch& match,
+                                  std::vector<float>& semitonesDiff,
+                                  std::vector<float>& durationDiff) {
+                                  appendMelodyPatternRow(query, match, std::move(semitonesDiff),
+                                                         std::move(durationDiff), &resultTable);
+                              });
+
+    return resultTable;
+}
+
+Score::MelodyPatternTable Score::findMelodyPatternBatched(
+    const std::vector<Note>& melodyPattern,
+    const MelodyBatchSimilarityCallback& batchSimilarityCallback,
+    const float totalIntervalsSimilarityThreshold, const float totalRhythmSimilarityThreshold,
+    const std::function<float(float, float)> totalSimilarityCallback) const {
+    if (batchSimilarityCallback == nullptr) {
+        LOG_ERROR("The batch similarity callback is empty");
+    }
+
+    const MelodyPatternQuery query = prepareMelodyPatternQuery(
+        melodyPattern, totalIntervalsSimilarityThreshold, totalRhythmSimilarityThreshold, nullptr,
+        nullptr, nullptr, nullptr, totalSimilarityCallback);
+
+    MelodyPatternTable resultTable;
+    const int melodyPatternSize = melodyPattern.size();
+    if (melodyPatternSize == 0) {
+        return resultTable;
+    }
+
+    // Pattern: a batch with a single window
+    MelodyWindowBatch patternBatch;
+    patternBatch.numWindows = 1;
+    patternBatch.windowSize = melodyPatternSize;
+    patternBatch.noteEventIdx.push_back(0);
+    for (const Note& note : melodyPattern) {
+        const bool isRest = note.isNoteOff();
+        patternBatch.midiNumbers.push_back(isRest ? 0 : note.getMidiNumber());
+        patternBatch.quarterDurations.push_back(note.getDuration().getQuarterDuration());
+        patternBatch.restMask.push_back(isRest ? 1 : 0);
+    }
+
+    const MelodySearchIndex& index = getMelodySearchIndex();
+    const int numStreams = index.noteEvents.size();
+    for (int streamIdx = 0; streamIdx < numStreams; streamIdx++) {
+        const std::vector<NoteEvent>& noteEvents = index.noteEvents[streamIdx];
+        const std::vector<int>& intervals = index.intervals[streamIdx];
+        const std::vector<float>& durations = index.quarterDurations[streamIdx];
+
+        // Same windows of findMelodyPattern()
+        const int numWindows = static_cast<int>(noteEvents.size()) - melodyPatternSize;
+        if (numWindows <= 0) {
+            continue;
+        }
+
+        // ===== JANELAS DO STREAM ===== //
+        std::vector<int> partMidiNumbers(noteEvents.size());
+        std::vector<uint8_t> partRestMask(noteEvents.size());
+        for (size_t i = 0; i < noteEvents.size(); i++) {
+            const Note& note = *noteEvents[i].notePtr;
+            partRestMask[i] = note.isNoteOff() ? 1 : 0;
+            partMidiNumbers[i] = note.isNoteOff() ? 0 : note.getMidiNumber();
+        }
+
+        MelodyWindowBatch windows;
+        windows.numWindows = numWindows;
+        windows.windowSize = melodyPatternSize;
+        const size_t numValues = static_cast<size_t>(numWindows) * melodyPatternSize;
+        windows.midiNumbers.reserve(numValues);
+        windows.quarterDurations.reserve(numValues);
+        windows.restMask.reserve(numValues);
+        windows.noteEventIdx.resize(numWindows);
+        for (int i = 0; i < numWindows; i++) {
+            windows.noteEventIdx[i] = i;
+            windows.midiNumbers.insert(windows.midiNumbers.end(), partMidiNumbers.begin() + i,
+                                       partMidiNumbers.begin() + i + melodyPatternSize);
+            windows.quarterDurations.insert(windows.quarterDurations.end(), durations.begin() + i,
+                                            durations.begin() + i + melodyPatternSize);
+            windows.restMask.insert(windows.restMask.end(), partRestMask.begin() + i,
+                                    partRestMask.begin() + i + melodyPatternSize);
+        }
+
+        const auto similarities = batchSimilarityCallback(patternBatch, windows);
+        const std::vector<float>& intervalSimilarities = similarities.first;
+        const std::vector<float>& rhythmSimilarities = similarities.second;
+        if (static_cast<int>(intervalSimilarities.size()) != numWindows ||
+            static_cast<int>(rhythmSimilarities.size()) != numWindows) {
+            LOG_ERROR("The batch similarity callback must return one value per window");
+        }
+
+        // ===== LINHAS DAS JANELAS ACEITAS ===== //
+        for (int i = 0; i < numWindows; i++) {
+            if (intervalSimilarities[i] < totalIntervalsSimilarityThreshold ||
+                rhythmSimilarities[i] < totalRhythmSimilarityThreshold) {
+                continue;
+            }
+
+            std::vector<float> semitonesDiff(query.numPatternIntervals);
+            for (int k = 0; k < query.numPatternIntervals; k++) {
+                semitonesDiff[k] = (float)query.patternIntervals[k] - (float)intervals[i + k];
+            }
+
+            float windowMaxDuration = 0.0f;
+            for (int k = 0; k < melodyPatternSize; k++) {
+                windowMaxDuration = std::max(windowMaxDuration, durations[i + k]);
+            }
+
+            std::vector<float> durationDiff(melodyPatternSize);
+            for (int k = 0; k < melodyPatternSize; k++) {
+                durationDiff[k] = query.patternDurations[k] / query.patternMaxDuration -
+                                  durations[i + k] / windowMaxDuration;
+            }
+
+            appendMelodyPatternRow(
+                query,
+                makeMelodyPatternMatch(query, streamIdx, i, melodyPatternSize,
+                                       intervalSimilarities[i], rhythmSimilarities[i]),
+                std::move(semitonesDiff), std::move(durationDiff), &resultTable);
+        }
+    }
+
+    return resultTable;
+}
+
+const std::vector<std::string>& Score::getMelodySearchKeyNames() const {
+    return getMelodySearchIndex().keyNames;
+}
+
+void Score::findMelodyPatternMatches(const std::vector<Note>& melodyPattern,
+                                     const MelodyPatternMatchCallback& callback,
+                                     const float totalIntervalsSimilarityThreshold,
+                                     const float totalRhythmSimilarityThreshold,
+                                     const MelodySimilarityMetric metric,
+                                     const int warpingWindow) const {
+    MelodyPatternQuery query = prepareMelodyPatternQuery(
+        melodyPattern, totalIntervalsSimilarityThreshold, totalRhythmSimilarityThreshold, nullptr,
+        nullptr, nullptr, nullptr, nullptr, metric, warpingWindow);
+    query.needsDifferences = false;
+
+    const MelodyPatternEmitter forward = [&callback](const MelodyPatternMatch& match,
+                                                     std::vector<float>&, std::vector<float>&) {
+        callback(match);
+    };
+
+    const int numStreams = getMelodySearchIndex().noteEvents.size();
+    for (int streamIdx = 0; streamIdx < numStreams; streamIdx++) {
+        findMelodyPatternInStream(query, streamIdx, forward);
+    }
+}
+
+size_t Score::countMelodyPattern(const std::vector<Note>& melodyPattern,
+                                 const float totalIntervalsSimilarityThreshold,
+                                 const float totalRhythmSimilarityThreshold,
+                                 const MelodySimilarityMetric metric,
+                                 const int warpingWindow) const {
+    size_t count = 0;
+    findMelodyPatternMatches(
+        melodyPattern, [&count](const MelodyPatternMatch&) { count++; },
+        totalIntervalsSimilarityThreshold, totalRhythmSimilarityThreshold, metric, warpingWindow);
+
+    return count;
+}
+
+Score::MelodyPatternTable Score::findTopMelodyPattern(const std::vector<Note>& melodyPattern,
+                                                      const size_t k,
+                                                      const float totalIntervalsSimilarityThreshold,
+                                                      const float totalRhythmSimilarityThreshold,
+                                                      const MelodySimilarityMetric metric,
+                                                      const int warpingWindow) const {
+    MelodyPatternTable resultTable;
+    if (k == 0) {
+        return resultTable;
+    }
+
+    const MelodyPatternQuery query = prepareMelodyPatternQuery(
+        melodyPattern, totalIntervalsSimilarityThreshold, totalRhythmSimilarityThreshold, nullptr,
+        nullptr, nullptr, nullptr, nullptr, metric, warpingWindow);
+
+    struct Candidate {
+        MelodyPatternMatch match;
+        size_t order;  // Score order, for the ties
+        std::vector<float> semitonesDiff;
+        std::vector<float> durationDiff;
+    };
+
+    // 'a' ranks before 'b'
+    const auto isBetter = [](const Candidate& a, const Candidate& b) {
+        if (a.match.totalSimilarity != b.match.totalSimilarity) {
+            return a.match.totalSimilarity > b.match.totalSimilarity;
+        }
+        return a.order < b.order;
+    };
+
+    // Bounded heap: the front is the worst kept candidate
+    std::vector<Candidate> heap;
+    heap.reserve(k);
+    size_t numMatches = 0;
+    const MelodyPatternEmitter keepBest = [&](const MelodyPatternMatch& match,
+                                              std::vector<float>& semitonesDiff,
+                                              std::vector<float>& durationDiff) {
+        const size_t order = numMatches++;
+        if (heap.size() == k) {
+            const Candidate& worst = heap.front();
+            if (!(match.totalSimilarity > worst.match.totalSimilarity)) {
+                return;  // Ties keep the earlier match
+            }
+            std::pop_heap(heap.begin(), heap.end(), isBetter);
+            heap.pop_back();
+        }
+
+        heap.push_back({match, order, std::move(semitonesDiff), std::move(durationDiff)});
+        std::push_heap(heap.begin(), heap.end(), isBetter);
+    };
+
+    const int numStreams = getMelodySearchIndex().noteEvents.size();
+    for (int streamIdx = 0; streamIdx < numStreams; streamIdx++) {
+        findMelodyPatternInStream(query, streamIdx, keepBest);
+    }
+
+    std::sort(heap.begin(), heap.end(), isBetter);
+    resultTable.reserve(heap.size());
+    for (Candidate& candidate : heap) {
+        appendMelodyPatternRow(query, candidate.match, std::move(candidate.semitonesDiff),
+                               std::move(candidate.durationDiff), &resultTable);
+    }
+
+    return resultTable;
+}
+
+std::vector<Score::MelodyPatternTable> Score::findMelodyPattern(
+        const std::vector<std::vector<Note>>& melodyPatterns, const float totalIntervalsSimilarityThreshold,
+        const float totalRhythmSimilarityThreshold,
+        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+            intervalsSimilarityCallback,
+        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+            rhythmSimilarityCallback,
+        const std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback,
+        const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback,
+        const std::function<float(float, float)> totalSimilarityCallback,
+        const int numThreads,
+        const MelodySimilarityMetric metric,
+        const int warpingWindow) const {
+    // Constrói o índice antes de iniciar os threads
+    const size_t numStreams = getMelodySearchIndex().noteEvents.size();
+
+    const size_t numPatterns = melodyPatterns.size();
+    std::vector<Score::MelodyPatternTable> results(numPatterns);
+
+    // ===== STEP 1: VETORES DE CADA PADRÃO ===== //
+    // A pattern bigger than the score keeps an empty result table; the other errors (invalid
+    // arguments, exceptions of the callbacks) are rethrown by the thread pool
+    const size_t totalNumNotes = getNumNotes();
+    std::vector<MelodyPatternQuery> queries(numPatterns);
+    std::vector<char> isSkipped(numPatterns, 0);
+    ThreadPool::parallelFor(numPatterns, [&](const size_t patternIdx) {
+        if (melodyPatterns[patternIdx].size() > totalNumNotes) {
+            isSkipped[patternIdx] = 1;
+            return;
+        }
+
+        queries[patternIdx] = prepareMelodyPatternQuery(
+            melodyPatterns[patternIdx], totalIntervalsSimilarityThreshold,
+            totalRhythmSimilarityThreshold, intervalsSimilarityCallback, rhythmSimilarityCallback,
+            totalIntervalSimilarityCallback, totalRhythmSimilarityCallback, totalSimilarityCallback,
+            metric, warpingWindow);
+    }, numThreads);
+
+    // ===== STEP 2: UMA TAREFA POR (PADRÃO, STREAM) ===== //
+    // Each task only writes its own table: 'isSkipped' is read-only here
+    std::vector<Score::MelodyPatternTable> streamResults(numPatterns * numStreams);
+    ThreadPool::parallelFor(numPatterns * numStreams, [&](const size_t taskIdx) {
+        const size_t patternIdx = taskIdx / numStreams;
+        if (isSkipped[patternIdx]) {
+            return;
+        }
+
+        const MelodyPatternQuery& query = queries[patternIdx];
+        auto& streamTable = streamResults[taskIdx];
+        findMelodyPatternInStream(query, taskIdx % numStreams,
+                                  [&](const MelodyPatternMatch& match,
+                                      std::vector<float>& semitonesDiff,
+                                      std::vector<float>& durationDiff) {
+                                      appendMelodyPatternRow(query, match, std::move(semitonesDiff),
+                                                             std::move(durationDiff), &streamTable);
+                                  });
+    }, numThreads);
+
+    // ===== STEP 3: RESULTADOS NA ORDEM DOS STREAMS ===== //
+    for (size_t patternIdx = 0; patternIdx < numPatterns; patternIdx++) {
+        if (isSkipped[patternIdx]) {
+            LOG_WARN("Melody pattern " << patternIdx << " skipped: it is bigger than the score");
+            continue;
+        }
+
+        for (size_t streamIdx = 0; streamIdx < numStreams; streamIdx++) {
+            auto& table = streamResults[patternIdx * numStreams + streamIdx];
+            results[patternIdx].insert(results[patternIdx].end(),
+                                       std::make_move_iterator(table.begin()),
+                                       std::make_move_iterator(table.end()));
+        }
+    }
+
+    return results;
+}
+
+void Score::removeDuplicatePatterns(std::vector<std::vector<Note>>* patterns) const {
+    auto& patternsRef = *patterns;
+
+    // Cada forma (diferenças de MIDI e de duração) é mantida apenas na primeira ocorrência
+    std::unordered_set<PatternShapeKey, PatternShapeKeyHash> seenShapes;
+    seenShapes.reserve(patternsRef.size());
+
+    size_t numUniquePatterns = 0;
+    for (size_t i = 0; i < patternsRef.size(); ++i) {
+        if (!seenShapes.emplace(patternsRef[i]).second) {
+            continue;  // Padrão duplicado
+        }
+
+        if (numUniquePatterns != i) {
+            patternsRef[numUniquePatterns] = std::move(patternsRef[i]);
+        }
+        numUniquePatterns++;
+    }
+
+    patternsRef.resize(numUniquePatterns);
+}
+
+std::vector<Score::MelodyPatternTable> Score::findAnyMelodyPattern(
+        const int patternNumNotes,
+        const float totalIntervalsSimilarityThreshold,
+        const float totalRhythmSimilarityThreshold,
+        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+            intervalsSimilarityCallback,
+        const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>
+            rhythmSimilarityCallback,
+        const std::function<float(const std::vector<float>&)> totalIntervalSimilarityCallback,
+        const std::function<float(const std::vector<float>&)> totalRhythmSimilarityCallback,
+        const std::function<float(float, float)> totalSimilarityCallback,
+        const int numThreads) const {
+    
+    const auto& noteEventsPerPart = getMelodySearchIndex().noteEvents;
+    std::vector<std::vector<Note>> patterns;
+    const int maxNumPatterns = getNumNotes() / patternNumNotes;
+    // std::cout << "Max melody blocks to find: " << maxNumPatterns << std::endl;
+    patterns.reserve(maxNumPatterns); // Impreciso
+    
+    // std::cout << "Creating melody patterns vector..." << std::endl;
+    for (const auto& noteEventList : noteEventsPerPart) {
+        int patternMaxIterationIdx = noteEventList.size() - patternNumNotes;
+        for (int eventIdx = 0; eventIdx < patternMaxIterationIdx; eventIdx++) {
+            std::vector<Note> localPattern;
+            localPattern.reserve(patternNumNotes);
+            const int maxEventIdx = eventIdx + patternNumNotes;
+            for (int idx = eventIdx; idx < maxEventIdx; idx++) {
+                localPattern.push_back(*noteEventList[idx].notePtr);
+            }
+            patterns.push_back(localPattern);
+        }
+    }
+
+    removeDuplicatePatterns(&patterns);
+
+    // std::cout << "Searching patterns..." << std::endl;
+    return findMelodyPattern(patterns, totalIntervalsSimilarityThreshold, 
+    totalRhythmSimilarityThreshold, intervalsSimilarityCallback, rhythmSimilarityCallback, 
+    totalIntervalSimilarityCallback, totalRhythmSimilarityCallback, totalSimilarityCallback,
+    numThreads);
+}
+
+std::vector<Score::RepeatedMotif> Score::findRepeatedMotifs(const int minNumNotes,
+                                                            const int minNumOccurrences,
+                                                            const bool considerRhythm) const {
+    if (minNumNotes < 2) {
+        LOG_ERROR("The minimum number of notes of a motif must be at least 2");
+    }
+
+    const MelodySearchIndex& index = getMelodySearchIndex();
+    const int numStreams = index.noteEvents.size();
+
+    // ===== STEP 1: TEXTO DE TOKENS DE TODOS OS STREAMS ===== //
+    // One token per pair of consecutive notes; each stream ends with a unique separator token
+    std::unordered_map<MotifTokenKey, int, MotifTokenKeyHash> tokenIds;
+    std::vector<int> text;
+    std::vector<int> streamOffsets(numStreams);
+    for (int streamIdx = 0; streamIdx < numStreams; streamIdx++) {
+        streamOffsets[streamIdx] = text.size();
+
+        const auto& noteEvents = index.noteEvents[streamIdx];
+        const auto& intervals = index.intervals[streamIdx];
+        const auto& quarterDurations = index.quarterDurations[streamIdx];
+        for (size_t i = 0; i < intervals.size(); i++) {
+            const MotifTokenKey key = motifTokenKey(
+                intervals[i], noteEvents[i].notePtr->isNoteOff(),
+                noteEvents[i + 1].notePtr->isNoteOff(), quarterDurations[i],
+                quarterDurations[i + 1], considerRhythm);
+            const int newId = tokenIds.size();
+            text.push_back(tokenIds.emplace(key, newId).first->second);
+        }
+        text.push_back(-1 - streamIdx);
+    }
+
+    const int numTokens = tokenIds.size();
+    for (int& token : text) {
+        if (token < 0) {
+            token = numTokens + (-1 - token);
+        }
+    }
+
+    // ===== STEP 2: REPETIÇÕES MAXIMAIS ===== //
+    const SuffixArray suffixArray(text);
+    const auto repeats = suffixArray.getMaximalRepeats(minNumNotes - 1, minNumOccurrences);
+
+    // ===== STEP 3: MOTIVOS E OCORRÊNCIAS ===== //
+    std::vector<RepeatedMotif> motifs;
+    std::vector<int> motifsFirstPosition;
+    for (const auto& repeat : repeats) {
+        const int numNotes = repeat.length + 1;
+        const int firstPosition = repeat.positions.front();
+        const int firstStreamIdx =
+            std::upper_bound(streamOffsets.begin(), streamOffsets.end(), firstPosition) -
+            streamOffsets.begin() - 1;
+        const int firstEventIdx = firstPosition - streamOffsets[firstStreamIdx];
+
+        // Only rests
+        if (index.firstNoteOn[firstStreamIdx][firstEventIdx] >= firstEventIdx + numNotes) {
+            continue;
+        }
+
+        RepeatedMotif motif;
+        motif.numNotes = numNotes;
+        const auto& firstIntervals = index.intervals[firstStreamIdx];
+        const auto& firstDurations = index.quarterDurations[firstStreamIdx];
+        motif.intervals.assign(firstIntervals.begin() + firstEventIdx,
+                               firstIntervals.begin() + firstEventIdx + repeat.length);
+        motif.quarterDurations.assign(firstDurations.begin() + firstEventIdx,
+                                      firstDurations.begin() + firstEventIdx + numNotes);
+
+        motif.occurrences.reserve(repeat.positions.size());
+        for (const int position : repeat.positions) {
+            const int streamIdx =
+                std::upper_bound(streamOffsets.begin(), streamOffsets.end(), position) -
+                streamOffsets.begin() - 1;
+            const int eventIdx = position - streamOffsets[streamIdx];
+            const auto& noteEvents = index.noteEvents[streamIdx];
+
+            MotifOccurrence occurrence;
+            occurrence.partIdx = index.streams[streamIdx].partIdx;
+            occurrence.partName = noteEvents[eventIdx].partName;
+            occurrence.streamIdx = streamIdx;
+            occurrence.measureIdx = noteEvents[eventIdx].measureIdx;
+            occurrence.staveIdx = noteEvents[eventIdx].staveIdx;
+            occurrence.noteEventIdx = eventIdx;
+            occurrence.pitches.reserve(numNotes);
+            for (int n = eventIdx; n < eventIdx + numNotes; n++) {
+                occurrence.pitches.push_back(noteEvents[n].notePtr->getWrittenPitch());
+            }
+            motif.occurrences.push_back(std::move(occurrence));
+        }
+
+        motifs.push_back(std::move(motif));
+        motifsFirstPosition.push_back(firstPosition);
+    }
+
+    // Ordena: mais notas, mais ocorrências, primeira ocorrência
+    std::vector<size_t> order(motifs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b) {
+        if (motifs[a].numNotes != motifs[b].numNotes) {
+            return motifs[a].numNotes > motifs[b].numNotes;
+        }
+        if (motifs[a].occurrences.size() != motifs[b].occurrences.size()) {
+            return motifs[a].occurrences.size() > motifs[b].occurrences.size();
+        }
+        return motifsFirstPosition[a] < motifsFirstPosition[b];
+    });
+
+    std::vector<RepeatedMotif> sortedMotifs;
+    sortedMotifs.reserve(motifs.size());
+    for (const size_t idx : order) {
+        sortedMotifs.push_back(std::move(motifs[idx]));
+    }
+
+    return sortedMotifs;
+}
+
+std::vector<Score::MelodyRegexMatch> Score::findMelodyRegex(const std::string& pattern,
+                                                            const int numThreads) const {
+    return findMelodyRegex(MelodyRegex(pattern), numThreads);
+}
+
+std::vector<Score::MelodyRegexMatch> Score::findMelodyRegex(const MelodyRegex& regex,
+                                                            const int numThreads) const {
+    const MelodySearchIndex& index = getMelodySearchIndex();
+    const int numStreams = index.noteEvents.size();
+
+    // Each stream writes only its own result vector
+    std::vector<std::vector<MelodyRegexMatch>> streamResults(numStreams);
+    ThreadPool::parallelFor(numStreams, [&](const size_t streamIdx) {
+        const auto& noteEvents = index.noteEvents[streamIdx];
+        const int numEvents = noteEvents.size();
+
+        // ===== STEP 1: SEQUÊNCIA DE EVENTOS DO STREAM ===== //
+        // Intervals skip the rests: they are measured from the previous note
+        std::vector<MelodyRegex::Event> events(numEvents);
+        const Note* previousNoteOn = nullptr;
+        for (int i = 0; i < numEvents; i++) {
+            const Note& note = *noteEvents[i].notePtr;
+            MelodyRegex::Event& event = events[i];
+            event.isRest = note.isNoteOff();
+            event.quarterDuration = index.quarterDurations[streamIdx][i];
+            event.numDots = note.getNumDots();
+            if (!event.isRest) {
+                if (previousNoteOn != nullptr) {
+                    event.hasInterval = true;
+                    event.interval = note.getMidiNumber() - previousNoteOn->getMidiNumber();
+                }
+                previousNoteOn = &note;
+            }
+        }
+
+        // ===== STEP 2: OCORRÊNCIAS ===== //
+        for (const MelodyRegex::Match& regexMatch : regex.findAll(events)) {
+            const NoteEvent& firstEvent = noteEvents[regexMatch.start];
+
+            MelodyRegexMatch match;
+            match.partIdx = index.streams[streamIdx].partIdx;
+            match.partName = firstEvent.partName;
+            match.streamIdx = streamIdx;
+            match.measureIdx = firstEvent.measureIdx;
+            match.staveIdx = firstEvent.staveIdx;
+            match.noteEventIdx = regexMatch.start;
+            match.numNotes = regexMatch.length;
+            match.pitches.reserve(regexMatch.length);
+            for (int n = regexMatch.start; n < regexMatch.start + regexMatch.length; n++) {
+                match.pitches.push_back(noteEvents[n].notePtr->getWrittenPitch());
+            }
+            streamResults[streamIdx].push_back(std::move(match));
+        }
+    }, numThreads);
+
+    std::vector<MelodyRegexMatch> result;
+    for (auto& matches : streamResults) {
+        result.insert(result.end(), std::make_move_iterator(matches.begin()),
+                      std::make_move_iterator(matches.end()));
+    }
+
+    return result;
+}
+
+std::vector<Score::RhythmStream> Score::collectRhythmStreams(const bool includeUnpitched,
+                                                             int64_t* ticksPerQuarter) const {
+    // ===== STEP 1: GRADE DE TICKS (MMC DAS DIVISÕES) ===== //
+    const int64_t grid = divisionsTicksGrid(_part);
+    *ticksPerQuarter = grid;
+
+    // ===== STEP 2: ATAQUES DE CADA VOZ ===== //
+    std::vector<RhythmStream> streams;
+    for (int partIdx = 0; partIdx < getNumParts(); partIdx++) {
+        const Part& part = _part[partIdx];
+        if (!includeUnpitched && !part.isPitched()) {
+            continue;
+        }
+
+        std::map<std::pair<int, int>, RhythmStream> partStreams;  // (stave, voice)
+        int64_t measureStart = 0;
+        for (int measureIdx = 0; measureIdx < part.getNumMeasures(); measureIdx++) {
+            const Measure& measure = part.getMeasure(measureIdx);
+            const int64_t measureScale = grid / std::max(1, measure.getDivisionsPerQuarterNote());
+            const int64_t measureEnd = measureStart + measure.getDurationTicks() * measureScale;
+
+            // Each voice restarts at the beginning of the measure
+            int64_t lastNoteEnd = measureStart;
+            for (int staveIdx = 0; staveIdx < measure.getNumStaves(); staveIdx++) {
+                std::map<int, int64_t> voiceCursor;
+                for (int noteIdx = 0; noteIdx < measure.getNumNotes(staveIdx); noteIdx++) {
+                    const Note& note = measure.getNote(noteIdx, staveIdx);
+                    if (note.isGraceNote() || note.inChord()) {
+                        continue;
+                    }
+
+                    const int voice = note.getVoice();
+                    int64_t& cursor = voiceCursor.emplace(voice, measureStart).first->second;
+                    if (note.isNoteOn() && !isTieContinuation(note)) {
+                        RhythmStream& stream = partStreams[{staveIdx, voice}];
+                        stream.partIdx = partIdx;
+                        stream.staveIdx = staveIdx;
+                        stream.voice = voice;
+                        stream.onsets.push_back(cursor);
+                        stream.measureIdx.push_back(measureIdx);
+                    }
+
+                    cursor += note.getDurationTicks() * (grid / std::max(1, note.getDivisionsPerQuarterNote()));
+                    lastNoteEnd = std::max(lastNoteEnd, cursor);
+                }
+            }
+
+            // The anacrusis measure lasts only its notes
+            measureStart = (measureIdx == 0 && _haveAnacrusisMeasure) ? lastNoteEnd : measureEnd;
+        }
+
+        for (auto& entry : partStreams) {
+            streams.push_back(std::move(entry.second));
+        }
+    }
+
+    return streams;
+}
+
+std::vector<Score::RhythmPatternMatch> Score::matchRhythmStreams(
+    const std::vector<RhythmStream>& streams, const int64_t ticksPerQuarter,
+    const std::vector<int64_t>& cellIntervals, const int64_t cellTicksPerQuarter,
+    const float tolerance) const {
+    // Common grid of the score and of the cell: both are exact
+    const int64_t grid = std::lcm(ticksPerQuarter, cellTicksPerQuarter);
+    const int64_t streamScale = grid / ticksPerQuarter;
+
+    std::vector<int64_t> cell(cellIntervals);
+    for (int64_t& interval : cell) {
+        interval *= grid / cellTicksPerQuarter;
+    }
+    const RhythmMatcher matcher(cell, tolerance);
+    const int numIntervals = matcher.getNumIntervals();
+
+    std::vector<RhythmPatternMatch> result;
+    std::vector<int64_t> intervals;
+    for (const RhythmStream& stream : streams) {
+        intervals.clear();
+        for (size_t i = 1; i < stream.onsets.size(); i++) {
+            intervals.push_back((stream.onsets[i] - stream.onsets[i - 1]) * streamScale);
+        }
+
+        for (const RhythmMatcher::Match& rhythmMatch : matcher.findAll(intervals)) {
+            RhythmPatternMatch match;
+            match.partIdx = stream.partIdx;
+            match.partName = _part[stream.partIdx].getName();
+            match.staveIdx = stream.staveIdx;
+            match.voice = stream.voice;
+            match.measureIdx = stream.measureIdx[rhythmMatch.start];
+            match.onsetIdx = rhythmMatch.start;
+            match.quarterOnset = static_cast<float>(stream.onsets[rhythmMatch.start]) /
+                                 static_cast<float>(ticksPerQuarter);
+            match.interOnsetIntervals.reserve(numIntervals);
+            for (int k = rhythmMatch.start; k < rhythmMatch.start + numIntervals; k++) {
+                match.interOnsetIntervals.push_back(static_cast<float>(intervals[k]) /
+                                                    static_cast<float>(grid));
+            }
+            match.maxDeviation = rhythmMatch.maxDeviation;
+            result.push_back(std::move(match));
+        }
+    }
+
+    return result;
+}
+
+std::vector<Score::RhythmPatternMatch> Score::findRhythmPattern(
+    const std::vector<Note>& rhythmPattern, const float tolerance,
+    const bool includeUnpitched) const {
+    // ===== STEP 1: IOIs DO PADRÃO, NA GRADE DO PRÓPRIO PADRÃO ===== //
+    int64_t cellTicksPerQuarter = 1;
+    for (const Note& note : rhythmPattern) {
+        cellTicksPerQuarter = std::lcm(cellTicksPerQuarter,
+                                       static_cast<int64_t>(std::max(1, note.getDivisionsPerQuarterNote())));
+    }
+
+    std::vector<int64_t> onsets;
+    int64_t cursor = 0;
+    for (const Note& note : rhythmPattern) {
+        if (note.isGraceNote() || note.inChord()) {
+            continue;
+        }
+        if (note.isNoteOn() && !isTieContinuation(note)) {
+            onsets.push_back(cursor);
+        }
+        cursor += note.getDurationTicks() *
+                  (cellTicksPerQuarter / std::max(1, note.getDivisionsPerQuarterNote()));
+    }
+
+    std::vector<int64_t> cellIntervals;
+    for (size_t i = 1; i < onsets.size(); i++) {
+        cellIntervals.push_back(onsets[i] - onsets[i - 1]);
+    }
+
+    // ===== STEP 2: BUSCA EM TODAS AS VOZES ===== //
+    int64_t ticksPerQuarter = 1;
+    const auto streams = collectRhythmStreams(includeUnpitched, &ticksPerQuarter);
+    return matchRhythmStreams(streams, ticksPerQuarter, cellIntervals, cellTicksPerQuarter,
+                              tolerance);
+}
+
+std::vector<Score::RhythmPatternMatch> Score::findRhythmPattern(
+    const std::vector<float>& interOnsetIntervals, const float tolerance,
+    const bool includeUnpitched) const {
+    int64_t ticksPerQuarter = 1;
+    const auto streams = collectRhythmStreams(includeUnpitched, &ticksPerQuarter);
+
+    std::vector<int64_t> cellIntervals;
+    cellIntervals.reserve(interOnsetIntervals.size());
+    for (const float quarters : interOnsetIntervals) {
+        cellIntervals.push_back(std::llround(static_cast<double>(quarters) * ticksPerQuarter));
+    }
+
+    return matchRhythmStreams(streams, ticksPerQuarter, cellIntervals, ticksPerQuarter, tolerance);
+}
+
+bool Score::haveAnacrusisMeasure() const { return _haveAnacrusisMeasure; }
+
+int Score::xPathCountNodes(const std::string& xPath) const {
+    // Select all nodes from the given XPath:
+    const pugi::xpath_node_set nodes = _doc.select_nodes(xPath.c_str());
+
+    // Compute the number of nodes:
+    return nodes.size();
+}
+
+void Score::setRepeat(int measureStart, int measureEnd) {
+    // INPUT ARGUMENTS VALIDATION
+    measureStart = (measureStart < 0) ? 0 : measureStart;
+    measureEnd =
+        (measureEnd < 0 || measureEnd > (_numMeasures - 1)) ? _numMeasures - 1 : measureEnd;
+
+    // Error checking
+    if (measureEnd == 0) {
+        LOG_ERROR("'measureEnd' MUST BE greater than 0");
+    }
+
+    // For each part: set repeat barlines
+    _isChangedAfterLoad = true;
+    for (auto& part : _part) {
+        part.getMeasure(measureStart).setRepeatStart();
+        part.getMeasure(measureEnd).setRepeatEnd();
+    }
+}
+
+void Score::forEachNote(
+    std::function<void(Part* part, Measure* measure, int staveId, Note* note)> callback,
     int measureStart, int measureEnd, std::vector<std::string> partNames) {
     // PROFILE_FUNCTION();
 
@@ -2823,7 +4228,12 @@ std::vector<std::tuple<int, float, Key, Chord, bool>> Score::getChords(nlohmann:
     std::string sqlInsertValues;
     const int partNamesSize = partNames.size();
     for (int partIdx = 0; partIdx < partNamesSize; partIdx++) {
-        Part& currentPart = getPart(partNames[partIdx]);
+        // Read only: getPart() would count as a change of the score
+        int partIndex = 0;
+        if (!getPartIndex(partNames[partIdx], &partIndex)) {
+            LOG_ERROR("There is no '" + partNames[partIdx] + "' in this score");
+        }
+        Part& currentPart = _part[partIndex];
 
         // Skip unpitched parts
         if (!includeUnpitched && !currentPart.isPitched()) {
@@ -3074,3 +4484,155 @@ std::vector<std::tuple<int, float, Key, Chord, bool>> Score::getChordsPerEachNot
 
     return stackedChords;
 }
+
+Score::SetharesDissonanceTimeline Score::getSetharesDissonanceTimeline(
+    nlohmann::json config, const int numPartialsPerNote, const bool useMinModel,
+    const std::function<std::vector<float>(std::vector<float>)> amplCallback,
+    const float partialsDecayExpRate,
+    const std::function<float(std::vector<float>)> dissCallback,
+    const AnalysisContext& context, const int numThreads) {
+    if (numPartialsPerNote <= 0) {
+        LOG_ERROR("The 'numPartialsPerNote' must be a positive value");
+    }
+
+    const auto chords = getChords(config);
+    const size_t numChords = chords.size();
+
+    SetharesDissonanceTimeline timeline;
+    timeline.measure.resize(numChords);
+    timeline.floatMeasure.resize(numChords);
+    timeline.keyName.resize(numChords);
+    timeline.quarterDuration.resize(numChords);
+    timeline.chordSize.resize(numChords);
+    timeline.chordNotes.resize(numChords);
+    timeline.dissonance.resize(numChords);
+    timeline.isHomophonic.resize(numChords);
+
+    // Each chord writes only its own slot: no lock is needed for the output arrays
+    auto processChord = [&](const size_t idx) {
+        const Chord& chord = std::get<3>(chords[idx]);
+
+        std::string chordNotes;
+        const size_t chordSize = chord.size();
+        for (size_t n = 0; n < chordSize; n++) {
+            chordNotes += (n == 0) ? chord.getNote(n).getPitch() : ", " + chord.getNote(n).getPitch();
+        }
+
+        timeline.measure[idx] = std::get<0>(chords[idx]);
+        timeline.floatMeasure[idx] = std::get<1>(chords[idx]);
+        timeline.keyName[idx] = std::get<2>(chords[idx]).getName();
+        timeline.quarterDuration[idx] = chord.getQuarterDuration();
+        timeline.chordSize[idx] = chordSize;
+        timeline.chordNotes[idx] = std::move(chordNotes);
+        timeline.dissonance[idx] = chord.getSetharesDissonance(
+            numPartialsPerNote, useMinModel, amplCallback, partialsDecayExpRate, dissCallback,
+            context);
+        timeline.isHomophonic[idx] = std::get<4>(chords[idx]) ? 1 : 0;
+    };
+
+    // Chunks of consecutive chords; the first error is rethrown after the workers finish
+    ThreadPool::parallelFor(numChords, processChord, numThreads, 32);
+
+    return timeline;
+}
+
+const std::vector<HarmonicSlice>& Score::getHarmonicIndex(nlohmann::json config) {
+    const std::string configKey = config.dump();
+    if (_harmonicIndex && _harmonicIndexConfig == configKey) {
+        return *_harmonicIndex;
+    }
+
+    auto chords = getChords(config);
+
+    auto slices = std::make_shared<std::vector<HarmonicSlice>>();
+    slices->reserve(chords.size());
+    for (auto& chordTuple : chords) {
+        Chord& chord = std::get<3>(chordTuple);
+
+        // The measure number comes from the chord onset: measures created in code are not numbered
+        HarmonicSlice slice;
+        slice.floatMeasure = std::get<1>(chordTuple);
+        slice.measure = static_cast<int>(std::floor(slice.floatMeasure + 1e-4f));
+        const int measureIdx = std::min(std::max(slice.measure - 1, 0), getNumMeasures() - 1);
+        const Key& key = _part.at(0).getMeasure(measureIdx).getKey();
+        slice.keyName = key.getName();
+
+        if (chord.size() > 0) {
+            const Note& root = chord.getRoot();
+            if (root.isNoteOn() && root.isPitched()) {
+                slice.rootPitch = root.getPitch();
+                slice.rootPitchClass = root.getMidiNumber() % 12;
+                slice.degree = chord.getDegree(key);
+                slice.romanDegree = chord.getRomanDegree(key);
+            }
+            slice.quality = chord.getQuality();
+            slice.isInRootPosition = chord.isInRootPosition();
+        }
+
+        slices->push_back(std::move(slice));
+    }
+
+    _harmonicIndex = std::move(slices);
+    _harmonicIndexConfig = configKey;
+
+    return *_harmonicIndex;
+}
+
+std::vector<Score::ChordProgressionMatch> Score::findChordProgression(
+    const std::string& progression, nlohmann::json config, const bool mergeRepeatedChords) {
+    return findChordProgression(ChordProgressionQuery(progression), config, mergeRepeatedChords);
+}
+
+std::vector<Score::ChordProgressionMatch> Score::findChordProgression(
+    const ChordProgressionQuery& query, nlohmann::json config, const bool mergeRepeatedChords) {
+    const std::vector<HarmonicSlice>& slices = getHarmonicIndex(config);
+    const int numSlices = slices.size();
+
+    // ===== STEP 1: MERGE REPEATED CHORDS ===== //
+    // 'runStarts[k]' is the first slice of the k-th chord of the sequence
+    std::vector<int> runStarts;
+    runStarts.reserve(numSlices + 1);
+    for (int s = 0; s < numSlices; s++) {
+        const bool isRepeated = mergeRepeatedChords && s > 0 && slices[s].rootPitchClass >= 0 &&
+                                slices[s].rootPitchClass == slices[s - 1].rootPitchClass &&
+                                slices[s].quality == slices[s - 1].quality;
+        if (!isRepeated) {
+            runStarts.push_back(s);
+        }
+    }
+
+    std::vector<HarmonicSlice> mergedSlices;
+    const std::vector<HarmonicSlice>* sequence = &slices;
+    if (static_cast<int>(runStarts.size()) != numSlices) {
+        mergedSlices.reserve(runStarts.size());
+        for (const int s : runStarts) {
+            mergedSlices.push_back(slices[s]);
+        }
+        sequence = &mergedSlices;
+    }
+    runStarts.push_back(numSlices);
+
+    // ===== STEP 2: MATCH THE PROGRESSION ===== //
+    std::vector<ChordProgressionMatch> matches;
+    for (const auto& hit : query.findAll(*sequence)) {
+        const HarmonicSlice& first = (*sequence)[hit.start];
+        const HarmonicSlice& last = (*sequence)[hit.start + hit.length - 1];
+
+        ChordProgressionMatch match;
+        match.firstSliceIdx = runStarts[hit.start];
+        match.numSlices = runStarts[hit.start + hit.length] - runStarts[hit.start];
+        match.startMeasure = first.measure;
+        match.startFloatMeasure = first.floatMeasure;
+        match.endMeasure = last.measure;
+        match.endFloatMeasure = last.floatMeasure;
+        match.keyName = first.keyName;
+        for (int k = hit.start; k < hit.start + hit.length; k++) {
+            match.rootPitches.push_back((*sequence)[k].rootPitch);
+            match.qualities.push_back((*sequence)[k].quality);
+            match.romanDegrees.push_back((*sequence)[k].romanDegree);
+        }
+        matches.push_back(std::move(match));
+    }
+
+    return matches;
+}
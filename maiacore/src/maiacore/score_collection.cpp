@@ -1,11 +1,17 @@
 #include "maiacore/score_collection.h"
 
+#include <algorithm>
 #include <filesystem>
+#include <iostream>
+#include <map>
+#include <set>
 #include <vector>
 #include <string>
 #include <tuple>
+#include <utility>
 
 #include "maiacore/log.h"
+#include "maiacore/thread_pool.h"
 
 ScoreCollection::ScoreCollection(const std::string& directoryPath) {
     setDirectoriesPaths({directoryPath});
@@ -20,16 +26,159 @@ std::vector<std::string> ScoreCollection::getDirectoriesPaths() const { return _
 void ScoreCollection::setDirectoriesPaths(const std::vector<std::string>& directoriesPaths) {
     _directoriesPaths = directoriesPaths;
 
-    loadCollectionFiles();
+    refresh();
 }
 
-void ScoreCollection::addDirectory(const std::string& directoryPath) {
+ScoreCollection::RefreshSummary ScoreCollection::addDirectory(const std::string& directoryPath) {
     _directoriesPaths.push_back(directoryPath);
+
+    return applyScan(_scanner.scan(directoryPath), false, 0);
+}
+
+void ScoreCollection::setScanOptions(const bool recursive,
+                                     const std::vector<std::string>& includeGlobs,
+                                     const std::vector<std::string>& excludeGlobs) {
+    _scanner = DirectoryScanner(recursive, includeGlobs, excludeGlobs);
+}
+
+const DirectoryScanner& ScoreCollection::getDirectoryScanner() const { return _scanner; }
+
+ScoreCollection::RefreshSummary ScoreCollection::refresh(const int numThreads) {
+    std::vector<DirectoryScanner::FileInfo> files;
+    for (const auto& dir : _directoriesPaths) {
+        const std::vector<DirectoryScanner::FileInfo> dirFiles = _scanner.scan(dir);
+        files.insert(files.end(), dirFiles.begin(), dirFiles.end());
+    }
+
+    return applyScan(files, true, numThreads);
+}
+
+std::vector<DirectoryScanner::FileInfo> ScoreCollection::getManifest() const {
+    std::vector<DirectoryScanner::FileInfo> manifest;
+    manifest.reserve(_manifest.size());
+    for (const auto& item : _manifest) {
+        manifest.push_back(item.second);
+    }
+    return manifest;
+}
+
+ScoreCollection::RefreshSummary ScoreCollection::applyScan(
+    const std::vector<DirectoryScanner::FileInfo>& files, const bool removeMissing,
+    const int numThreads) {
+    RefreshSummary summary;
+
+    // ===== STEP 1: ARQUIVOS NOVOS OU COM METADADOS ALTERADOS ===== //
+    std::set<std::string> scannedPaths;
+    std::vector<DirectoryScanner::FileInfo> candidates;
+    for (const auto& file : files) {
+        if (!scannedPaths.insert(file.filePath).second) {
+            continue;  // Same file listed by two directories
+        }
+
+        const auto it = _manifest.find(file.filePath);
+        if (it == _manifest.end() || it->second.size != file.size ||
+            it->second.modificationTime != file.modificationTime) {
+            candidates.push_back(file);
+        }
+    }
+
+    // ===== STEP 2: HASH E LEITURA EM PARALELO ===== //
+    // The collection only changes after every file is parsed
+    for (const auto& file : candidates) {
+        if (_manifest.count(file.filePath) == 0) {
+            LOG_INFO("Loading: " << std::filesystem::path(file.filePath).filename().string());
+        }
+    }
+
+    std::vector<std::shared_ptr<Score>> parsedScores(candidates.size());
+    ThreadPool::parallelFor(candidates.size(), [&](const size_t fileIdx) {
+        DirectoryScanner::FileInfo& file = candidates[fileIdx];
+        file.hash = DirectoryScanner::hashFile(file.filePath);
+
+        const auto it = _manifest.find(file.filePath);
+        if (it == _manifest.end() || it->second.hash != file.hash) {
+            parsedScores[fileIdx] = std::make_shared<Score>(file.filePath);
+        }
+    }, numThreads, 1);
+
+    // ===== STEP 3: ARQUIVOS APAGADOS ===== //
+    if (removeMissing) {
+        std::set<std::string> removedPaths;
+        for (auto it = _manifest.begin(); it != _manifest.end();) {
+            if (scannedPaths.count(it->first) == 0) {
+                removedPaths.insert(it->first);
+                summary.removedFiles.push_back(it->first);
+                it = _manifest.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        for (int scoreIdx = static_cast<int>(_scores.size()) - 1; scoreIdx >= 0; scoreIdx--) {
+            if (removedPaths.count(_scores[scoreIdx]->getFilePath()) > 0) {
+                removeScore(scoreIdx);
+            }
+        }
+    }
+
+    // ===== STEP 4: ARQUIVOS MODIFICADOS (EM SEU LUGAR) E NOVOS (NO FINAL) ===== //
+    std::map<std::string, std::vector<size_t>> scoresByPath;
+    for (size_t scoreIdx = 0; scoreIdx < _scores.size(); scoreIdx++) {
+        scoresByPath[_scores[scoreIdx]->getFilePath()].push_back(scoreIdx);
+    }
+
+    const size_t firstNewScoreIdx = _scores.size();
+    for (size_t fileIdx = 0; fileIdx < candidates.size(); fileIdx++) {
+        const DirectoryScanner::FileInfo& file = candidates[fileIdx];
+        const bool isNew = _manifest.count(file.filePath) == 0;
+        _manifest[file.filePath] = file;
+
+        if (!parsedScores[fileIdx]) {
+            continue;  // Same content: only the write time changed
+        }
+
+        if (isNew) {
+            _scores.push_back(std::move(parsedScores[fileIdx]));
+            summary.addedFiles.push_back(file.filePath);
+            continue;
+        }
+
+        for (const size_t scoreIdx : scoresByPath[file.filePath]) {
+            // Other collections that share the old score keep it
+            _scores[scoreIdx] = parsedScores[fileIdx];
+            if (_melodyIndex) {
+                MelodyCorpusIndex& index = getMutableMelodyIndex();
+                index.removeScore(_melodyIndexEntries[scoreIdx]);
+                _melodyIndexEntries[scoreIdx] = index.addScore(*_scores[scoreIdx]);
+            }
+        }
+        summary.reloadedFiles.push_back(file.filePath);
+    }
+
+    indexScores(firstNewScoreIdx, numThreads);
+
+    // Reloaded scores change in place: their descriptors are indexed again
+    if (_descriptorIndex && !summary.reloadedFiles.empty()) {
+        buildDescriptorIndex(_descriptorIndex->getNumLists(), numThreads);
+    }
+
+    return summary;
 }
 
-void ScoreCollection::addScore(const Score& score) { _scores.push_back(score); }
+void ScoreCollection::addScore(const Score& score) { addScore(std::make_shared<Score>(score)); }
+
+void ScoreCollection::addScore(ScoreHandle score) {
+    if (!score) {
+        LOG_ERROR("Unable to add a null score");
+    }
+
+    _scores.push_back(std::move(score));
+    indexScores(_scores.size() - 1, 1);
+}
 
-void ScoreCollection::addScore(const std::string& filePath) { addScore(Score(filePath)); }
+void ScoreCollection::addScore(const std::string& filePath) {
+    addScore(std::make_shared<Score>(filePath));
+}
 
 void ScoreCollection::addScore(const std::vector<std::string>& filePaths) {
     for (const auto& fp : filePaths) {
@@ -37,7 +186,36 @@ void ScoreCollection::addScore(const std::vector<std::string>& filePaths) {
     }
 }
 
-void ScoreCollection::clear() { _scores.clear(); }
+void ScoreCollection::loadPack(const CorpusPack& pack, const std::vector<int>& scoreIndices,
+                               const int numThreads) {
+    const std::vector<std::shared_ptr<Score>> scores = pack.loadScores(scoreIndices, numThreads);
+
+    const size_t firstScoreIdx = _scores.size();
+    _scores.insert(_scores.end(), scores.begin(), scores.end());
+    indexScores(firstScoreIdx, numThreads);
+}
+
+void ScoreCollection::loadPack(const std::string& packPath, const std::vector<int>& scoreIndices,
+                               const int numThreads) {
+    loadPack(CorpusPack(packPath), scoreIndices, numThreads);
+}
+
+void ScoreCollection::savePack(const std::string& packPath, const int numThreads) const {
+    std::vector<const Score*> scores;
+    scores.reserve(_scores.size());
+    for (const auto& score : _scores) {
+        scores.push_back(score.get());
+    }
+
+    CorpusPack::save(scores, packPath, numThreads);
+}
+
+void ScoreCollection::clear() {
+    _scores.clear();
+    _manifest.clear();
+    clearMelodyIndex();
+    clearDescriptorIndex();
+}
 
 int ScoreCollection::getNumDirectories() const {
     return static_cast<int>(_directoriesPaths.size());
@@ -45,48 +223,57 @@ int ScoreCollection::getNumDirectories() const {
 
 int ScoreCollection::getNumScores() const { return _scores.size(); }
 
-std::vector<Score>& ScoreCollection::getScores() { return _scores; }
+const std::vector<ScoreCollection::ScoreHandle>& ScoreCollection::getScores() const {
+    return _scores;
+}
 
-const std::vector<Score>& ScoreCollection::getScores() const { return _scores; }
+const Score& ScoreCollection::getScore(const int scoreIdx) const {
+    if (scoreIdx < 0 || scoreIdx >= static_cast<int>(_scores.size())) {
+        LOG_ERROR("Invalid score index: " + std::to_string(scoreIdx));
+    }
 
-bool ScoreCollection::isEmpty() const { return _scores.empty(); }
+    return *_scores[scoreIdx];
+}
 
-void ScoreCollection::loadCollectionFiles() {
-    if (_directoriesPaths.empty()) {
-        return;
+Score& ScoreCollection::getScore(const int scoreIdx) {
+    if (scoreIdx < 0 || scoreIdx >= static_cast<int>(_scores.size())) {
+        LOG_ERROR("Invalid score index: " + std::to_string(scoreIdx));
     }
 
-    for (const auto& dir : _directoriesPaths) {
-        for (const auto& fp : std::filesystem::directory_iterator(dir)) {
-            const std::filesystem::path& ext = fp.path().extension();
-            if (ext == ".xml" || ext == ".mxl" || ext == ".musicxml") {
-                const std::string& fileName = fp.path().filename().string();
-                LOG_INFO("Loading: " << fileName);
-
-                const std::string& filePath = fp.path().string();
-                _scores.emplace_back(filePath);
-            }
-        }
+    // Copy-on-write: the other holders of a shared score keep the original
+    if (_scores[scoreIdx].use_count() > 1) {
+        _scores[scoreIdx] = std::make_shared<Score>(*_scores[scoreIdx]);
     }
+
+    // The collection is the only holder, and every handle points to a non-const Score
+    return const_cast<Score&>(*_scores[scoreIdx]);
 }
 
+bool ScoreCollection::isEmpty() const { return _scores.empty(); }
+
 void ScoreCollection::merge(const ScoreCollection& other) {
-    // Detect self-merge to avoid iterator invalidation (undefined behavior)
-    if (this == &other) {
-        ScoreCollection copy = other;  // Make a copy
-        merge(copy);  // Merge with the copy
-        return;
-    }
+    // Sizes taken first: on a self-merge, 'other' grows while it is appended
+    const size_t numOtherDirectories = other._directoriesPaths.size();
+    const size_t numOtherScores = other._scores.size();
 
     // Merge directories paths
-    for (const auto& dir : other.getDirectoriesPaths()) {
-        _directoriesPaths.push_back(dir);
+    for (size_t dirIdx = 0; dirIdx < numOtherDirectories; dirIdx++) {
+        _directoriesPaths.push_back(other._directoriesPaths[dirIdx]);
     }
 
-    // Merge Score objects
-    for (const auto& sc : other.getScores()) {
-        _scores.push_back(sc);
+    // Merge the manifests: refresh() also follows the merged files
+    if (this != &other) {
+        _manifest.insert(other._manifest.begin(), other._manifest.end());
     }
+
+    // Merge the score handles: the scores are shared, not copied
+    const size_t firstScoreIdx = _scores.size();
+    _scores.reserve(firstScoreIdx + numOtherScores);
+    for (size_t scoreIdx = 0; scoreIdx < numOtherScores; scoreIdx++) {
+        _scores.push_back(other._scores[scoreIdx]);
+    }
+
+    indexScores(firstScoreIdx);
 }
 
 void ScoreCollection::removeScore(const int scoreIdx) {
@@ -96,6 +283,446 @@ void ScoreCollection::removeScore(const int scoreIdx) {
     }
 
     _scores.erase(_scores.begin() + scoreIdx);
+
+    if (_melodyIndex) {
+        getMutableMelodyIndex().removeScore(_melodyIndexEntries[scoreIdx]);
+        _melodyIndexEntries.erase(_melodyIndexEntries.begin() + scoreIdx);
+    }
+
+    if (_descriptorIndex) {
+        getMutableDescriptorIndex().remove(scoreIdx);
+    }
+}
+
+void ScoreCollection::indexScores(const size_t firstScoreIdx, const int numThreads) {
+    if (_fingerprintOnLoad) {
+        fingerprintScores(firstScoreIdx, numThreads);
+    }
+
+    if (_descriptorOnLoad || _descriptorIndex) {
+        describeScores(firstScoreIdx, numThreads);
+    }
+
+    if (_descriptorIndex) {
+        ScoreDescriptorIndex& descriptorIndex = getMutableDescriptorIndex();
+        for (size_t scoreIdx = firstScoreIdx; scoreIdx < _scores.size(); scoreIdx++) {
+            descriptorIndex.add(_scores[scoreIdx]->getDescriptor());
+        }
+    }
+
+    if (!_melodyIndex || firstScoreIdx >= _scores.size()) {
+        return;
+    }
+
+    std::vector<const Score*> scores;
+    for (size_t scoreIdx = firstScoreIdx; scoreIdx < _scores.size(); scoreIdx++) {
+        scores.push_back(_scores[scoreIdx].get());
+    }
+
+    const std::vector<int> entryIds = getMutableMelodyIndex().addScores(scores, numThreads);
+    _melodyIndexEntries.insert(_melodyIndexEntries.end(), entryIds.begin(), entryIds.end());
+}
+
+MelodyCorpusIndex& ScoreCollection::getMutableMelodyIndex() {
+    // Copies of the collection share the index until one of them changes it
+    if (_melodyIndex.use_count() > 1) {
+        _melodyIndex = std::make_shared<MelodyCorpusIndex>(*_melodyIndex);
+    }
+    return *_melodyIndex;
+}
+
+void ScoreCollection::fingerprintScores(const size_t firstScoreIdx, const int numThreads) const {
+    std::vector<size_t> scoreIndices;
+    for (const size_t scoreIdx : getDistinctScoreIndices()) {
+        if (scoreIdx >= firstScoreIdx) {
+            scoreIndices.push_back(scoreIdx);
+        }
+    }
+
+    ThreadPool::parallelFor(scoreIndices.size(), [&](const size_t i) {
+        _scores[scoreIndices[i]]->getFingerprint();
+    }, numThreads, 1);
+}
+
+NearDuplicateIndex ScoreCollection::buildNearDuplicateIndex(const int numThreads) const {
+    fingerprintScores(0, numThreads);
+
+    NearDuplicateIndex index;
+    for (const auto& score : _scores) {
+        index.add(score->getFingerprint());
+    }
+    return index;
+}
+
+void ScoreCollection::describeScores(const size_t firstScoreIdx, const int numThreads) const {
+    std::vector<size_t> scoreIndices;
+    for (const size_t scoreIdx : getDistinctScoreIndices()) {
+        if (scoreIdx >= firstScoreIdx) {
+            scoreIndices.push_back(scoreIdx);
+        }
+    }
+
+    ThreadPool::parallelFor(scoreIndices.size(), [&](const size_t i) {
+        _scores[scoreIndices[i]]->getDescriptor();
+    }, numThreads, 1);
+}
+
+ScoreDescriptorIndex& ScoreCollection::getMutableDescriptorIndex() {
+    // Copies of the collection share the index until one of them changes it
+    if (_descriptorIndex.use_count() > 1) {
+        _descriptorIndex = std::make_shared<ScoreDescriptorIndex>(*_descriptorIndex);
+    }
+    return *_descriptorIndex;
+}
+
+std::vector<size_t> ScoreCollection::getDistinctScoreIndices() const {
+    std::set<const Score*> seen;
+    std::vector<size_t> indices;
+    indices.reserve(_scores.size());
+    for (size_t scoreIdx = 0; scoreIdx < _scores.size(); scoreIdx++) {
+        if (seen.insert(_scores[scoreIdx].get()).second) {
+            indices.push_back(scoreIdx);
+        }
+    }
+    return indices;
+}
+
+ScoreCollection ScoreCollection::getSubCollection(const std::vector<int>& scoreIndices) const {
+    ScoreCollection subCollection(std::vector<std::string>{});
+    subCollection._scanner = _scanner;
+    subCollection._fingerprintOnLoad = _fingerprintOnLoad;
+    subCollection._descriptorOnLoad = _descriptorOnLoad;
+    subCollection._scores.reserve(scoreIndices.size());
+    for (const int scoreIdx : scoreIndices) {
+        if (scoreIdx < 0 || scoreIdx >= static_cast<int>(_scores.size())) {
+            LOG_ERROR("Invalid score index: " + std::to_string(scoreIdx));
+        }
+        subCollection._scores.push_back(_scores[scoreIdx]);
+    }
+    return subCollection;
+}
+
+ScoreCollection ScoreCollection::filter(const std::function<bool(const Score&)>& predicate,
+                                        const int numThreads) const {
+    std::vector<char> keep(_scores.size(), 0);
+    forEachScoreParallel([&](const int scoreIdx, const Score& score) {
+        keep[scoreIdx] = predicate(score) ? 1 : 0;
+    }, numThreads);
+
+    std::vector<int> scoreIndices;
+    for (size_t scoreIdx = 0; scoreIdx < keep.size(); scoreIdx++) {
+        if (keep[scoreIdx]) {
+            scoreIndices.push_back(scoreIdx);
+        }
+    }
+    return getSubCollection(scoreIndices);
+}
+
+void ScoreCollection::setFingerprintOnLoad(const bool enable, const int numThreads) {
+    _fingerprintOnLoad = enable;
+    if (enable) {
+        fingerprintScores(0, numThreads);
+    }
+}
+
+bool ScoreCollection::getFingerprintOnLoad() const { return _fingerprintOnLoad; }
+
+std::vector<std::vector<int>> ScoreCollection::findNearDuplicates(const double threshold,
+                                                                  const int numThreads) const {
+    return buildNearDuplicateIndex(numThreads).getGroups(threshold);
+}
+
+std::vector<std::pair<int, double>> ScoreCollection::findNearDuplicatesOf(
+    const Score& score, const double threshold, const int numThreads) const {
+    return buildNearDuplicateIndex(numThreads).findSimilar(score.getFingerprint(), threshold);
+}
+
+ScoreCollection ScoreCollection::withoutNearDuplicates(const double threshold,
+                                                       const int numThreads) const {
+    std::vector<char> keep(_scores.size(), 1);
+    for (const auto& group : findNearDuplicates(threshold, numThreads)) {
+        for (size_t i = 1; i < group.size(); i++) {
+            keep[group[i]] = 0;
+        }
+    }
+
+    std::vector<int> scoreIndices;
+    for (size_t scoreIdx = 0; scoreIdx < keep.size(); scoreIdx++) {
+        if (keep[scoreIdx]) {
+            scoreIndices.push_back(scoreIdx);
+        }
+    }
+    return getSubCollection(scoreIndices);
+}
+
+void ScoreCollection::setDescriptorOnLoad(const bool enable, const int numThreads) {
+    _descriptorOnLoad = enable;
+    if (enable) {
+        describeScores(0, numThreads);
+    }
+}
+
+bool ScoreCollection::getDescriptorOnLoad() const { return _descriptorOnLoad; }
+
+void ScoreCollection::buildDescriptorIndex(const int numLists, const int numThreads) {
+    describeScores(0, numThreads);
+
+    std::vector<ScoreDescriptor> descriptors;
+    descriptors.reserve(_scores.size());
+    for (const auto& score : _scores) {
+        descriptors.push_back(score->getDescriptor());
+    }
+
+    _descriptorIndex = std::make_shared<ScoreDescriptorIndex>(descriptors, numLists, numThreads);
+}
+
+bool ScoreCollection::hasDescriptorIndex() const { return _descriptorIndex != nullptr; }
+
+void ScoreCollection::clearDescriptorIndex() { _descriptorIndex.reset(); }
+
+std::vector<std::pair<int, float>> ScoreCollection::findSimilarScores(
+    const ScoreDescriptor& descriptor, const int k, const int numProbes, const int excludedIdx,
+    const int numThreads) const {
+    if (_descriptorIndex) {
+        return _descriptorIndex->findNearest(descriptor, k, numProbes, excludedIdx);
+    }
+
+    // No index: a single list, scanned whole
+    describeScores(0, numThreads);
+    std::vector<ScoreDescriptor> descriptors;
+    descriptors.reserve(_scores.size());
+    for (const auto& score : _scores) {
+        descriptors.push_back(score->getDescriptor());
+    }
+    return ScoreDescriptorIndex(descriptors, 1).findNearest(descriptor, k, 1, excludedIdx);
+}
+
+std::vector<std::pair<int, float>> ScoreCollection::findSimilarScores(const Score& score,
+                                                                      const int k,
+                                                                      const int numProbes,
+                                                                      const int numThreads) const {
+    return findSimilarScores(score.getDescriptor(), k, numProbes, -1, numThreads);
+}
+
+std::vector<std::pair<int, float>> ScoreCollection::findSimilarScores(const int scoreIdx,
+                                                                      const int k,
+                                                                      const int numProbes,
+                                                                      const int numThreads) const {
+    const Score& score = getScore(scoreIdx);
+    return findSimilarScores(score.getDescriptor(), k, numProbes, scoreIdx, numThreads);
+}
+
+std::vector<int> ScoreCollection::getMelodyIndexOrder() const {
+    const std::vector<int> entryIds = _melodyIndex->getEntryIds();
+    const int maxEntryId = entryIds.empty() ? 0 : entryIds.back() + 1;
+
+    std::vector<int> order(maxEntryId, -1);
+    std::vector<bool> hasScore(maxEntryId, false);
+    for (size_t scoreIdx = 0; scoreIdx < _melodyIndexEntries.size(); scoreIdx++) {
+        order[_melodyIndexEntries[scoreIdx]] = scoreIdx;
+        hasScore[_melodyIndexEntries[scoreIdx]] = true;
+    }
+
+    int position = _melodyIndexEntries.size();
+    for (const int entryId : entryIds) {
+        if (!hasScore[entryId]) {
+            order[entryId] = position++;
+        }
+    }
+    return order;
+}
+
+void ScoreCollection::buildMelodyIndex(const int numThreads) {
+    _melodyIndex = std::make_shared<MelodyCorpusIndex>();
+    _melodyIndexEntries.clear();
+    indexScores(0, numThreads);
+}
+
+void ScoreCollection::saveMelodyIndex(const std::string& filePath) const {
+    if (!_melodyIndex) {
+        LOG_ERROR("The collection has no melody index: call buildMelodyIndex() first");
+    }
+
+    _melodyIndex->save(filePath);
+}
+
+void ScoreCollection::loadMelodyIndex(const std::string& filePath, const int numThreads) {
+    auto index = std::make_shared<MelodyCorpusIndex>(filePath);
+
+    // ===== STEP 1: ENTRADAS DE CADA PARTITURA ===== //
+    // (file name, number of notes) -> unmatched entries, in entry order
+    std::map<std::pair<std::string, int>, std::vector<int>> freeEntries;
+    for (const int entryId : index->getEntryIds()) {
+        const MelodyCorpusIndex::ScoreInfo info = index->getScoreInfo(entryId);
+        if (!info.fileName.empty()) {
+            freeEntries[{info.fileName, info.numNotes}].push_back(entryId);
+        }
+    }
+
+    std::vector<int> entries(_scores.size(), -1);
+    std::vector<const Score*> unmatchedScores;
+    std::vector<size_t> unmatchedScoreIdx;
+    for (size_t scoreIdx = 0; scoreIdx < _scores.size(); scoreIdx++) {
+        const Score& score = *_scores[scoreIdx];
+        const std::string fileName = score.getFileName();
+        auto it = freeEntries.find({fileName, score.getNumNotes()});
+        if (!fileName.empty() && it != freeEntries.end() && !it->second.empty()) {
+            entries[scoreIdx] = it->second.front();
+            it->second.erase(it->second.begin());
+        } else {
+            unmatchedScores.push_back(&score);
+            unmatchedScoreIdx.push_back(scoreIdx);
+        }
+    }
+
+    // ===== STEP 2: SINCRONIZAÇÃO ===== //
+    // An empty collection keeps every entry (index-only collection)
+    if (!_scores.empty()) {
+        for (const auto& freeEntry : freeEntries) {
+            for (const int entryId : freeEntry.second) {
+                index->removeScore(entryId);
+            }
+        }
+    }
+
+    const std::vector<int> newEntryIds = index->addScores(unmatchedScores, numThreads);
+    for (size_t i = 0; i < newEntryIds.size(); i++) {
+        entries[unmatchedScoreIdx[i]] = newEntryIds[i];
+    }
+
+    _melodyIndex = index;
+    _melodyIndexEntries = entries;
+}
+
+bool ScoreCollection::hasMelodyIndex() const { return _melodyIndex != nullptr; }
+
+void ScoreCollection::clearMelodyIndex() {
+    _melodyIndex.reset();
+    _melodyIndexEntries.clear();
+}
+
+std::shared_ptr<const MelodyCorpusIndex> ScoreCollection::getMelodyIndex() const {
+    return _melodyIndex;
+}
+
+namespace {
+
+// Scores with more note events than this are searched in one task per melody stream
+const int LARGE_SCORE_NUM_NOTE_EVENTS = 2048;
+
+// Melody search task: a whole score (streamIdx = -1) or one melody stream of a large score
+struct MelodySearchTask {
+    size_t scoreIdx;
+    int streamIdx;
+};
+
+std::vector<MelodySearchTask> prepareMelodySearchTasks(
+    const std::vector<ScoreCollection::ScoreHandle>& scores,
+    const std::vector<size_t>& distinctScoreIndices, const int numThreads) {
+    // The melody search indices are built before the stream tasks of a score share them, once
+    // per distinct score
+    std::vector<std::vector<Score::MelodyStream>> streams(scores.size());
+    ThreadPool::parallelFor(distinctScoreIndices.size(), [&](const size_t i) {
+        const size_t scoreIdx = distinctScoreIndices[i];
+        streams[scoreIdx] = scores[scoreIdx]->getMelodyStreams();
+    }, numThreads);
+    for (size_t scoreIdx = 0; scoreIdx < scores.size(); scoreIdx++) {
+        if (streams[scoreIdx].empty()) {
+            streams[scoreIdx] = scores[scoreIdx]->getMelodyStreams();  // Already built
+        }
+    }
+
+    std::vector<MelodySearchTask> tasks;
+    tasks.reserve(scores.size());
+    for (size_t scoreIdx = 0; scoreIdx < scores.size(); scoreIdx++) {
+        int numNoteEvents = 0;
+        for (const auto& stream : streams[scoreIdx]) {
+            numNoteEvents += stream.numNoteEvents;
+        }
+
+        const int numStreams = streams[scoreIdx].size();
+        if (numStreams < 2 || numNoteEvents <= LARGE_SCORE_NUM_NOTE_EVENTS) {
+            tasks.push_back({scoreIdx, -1});
+            continue;
+        }
+
+        for (int streamIdx = 0; streamIdx < numStreams; streamIdx++) {
+            tasks.push_back({scoreIdx, streamIdx});
+        }
+    }
+
+    return tasks;
+}
+
+// Copies the results of each distinct score to the other positions of the same score
+template <typename T>
+void copyDistinctResults(const std::vector<ScoreCollection::ScoreHandle>& scores,
+                         std::vector<T>* results) {
+    std::map<const Score*, size_t> firstIdx;
+    for (size_t scoreIdx = 0; scoreIdx < scores.size(); scoreIdx++) {
+        const auto it = firstIdx.emplace(scores[scoreIdx].get(), scoreIdx).first;
+        if (it->second != scoreIdx) {
+            (*results)[scoreIdx] = (*results)[it->second];
+        }
+    }
+}
+
+}  // namespace
+
+ScoreCollection::ExtendedMelodyPatternRow ScoreCollection::extendMelodyPatternRow(
+    const Score& score, Score::MelodyPatternRow row) {
+    MelodyCorpusIndex::ScoreInfo info;
+    info.fileName = score.getFileName();
+    info.composerName = score.getComposerName();
+    info.title = score.getTitle();
+    return extendMelodyPatternRow(info, std::move(row));
+}
+
+ScoreCollection::ExtendedMelodyPatternRow ScoreCollection::extendMelodyPatternRow(
+    const MelodyCorpusIndex::ScoreInfo& info, Score::MelodyPatternRow row) {
+    return ExtendedMelodyPatternRow(info.fileName, info.composerName, info.title,
+                                    std::move(std::get<0>(row)), std::get<1>(row), std::get<2>(row),
+                                    std::move(std::get<3>(row)), std::move(std::get<4>(row)),
+                                    std::move(std::get<5>(row)), std::move(std::get<6>(row)),
+                                    std::move(std::get<7>(row)), std::get<8>(row),
+                                    std::get<9>(row), std::get<10>(row));
+}
+
+std::vector<ScoreCollection::ExtendedMelodyPatternTable> ScoreCollection::findMelodyPatternInIndex(
+    const std::vector<Note>& melodyPattern, const float totalIntervalsSimilarityThreshold,
+    const float totalRhythmSimilarityThreshold, const int numThreads,
+    std::vector<std::string>* skippedFileNames) const {
+    const std::vector<int> order = getMelodyIndexOrder();
+    std::vector<int> skippedEntryIds;
+    std::vector<MelodyCorpusIndex::Row> indexRows = _melodyIndex->findMelodyPattern(
+        melodyPattern, totalIntervalsSimilarityThreshold, totalRhythmSimilarityThreshold,
+        numThreads, (skippedFileNames != nullptr) ? &skippedEntryIds : nullptr);
+
+    std::sort(skippedEntryIds.begin(), skippedEntryIds.end(),
+              [&order](const int a, const int b) { return order[a] < order[b]; });
+    for (const int entryId : skippedEntryIds) {
+        skippedFileNames->push_back(_melodyIndex->getScoreInfo(entryId).fileName);
+    }
+
+    // Loaded scores give the metadata of their rows, like the scan of the scores
+    std::vector<ExtendedMelodyPatternTable> tables(_melodyIndex->getNumScores());
+    std::vector<MelodyCorpusIndex::ScoreInfo> entryInfo(order.size());
+    for (auto& indexRow : indexRows) {
+        const int position = order[indexRow.entryId];
+        if (position < static_cast<int>(_scores.size())) {
+            tables[position].push_back(
+                extendMelodyPatternRow(*_scores[position], std::move(indexRow.row)));
+            continue;
+        }
+
+        MelodyCorpusIndex::ScoreInfo& info = entryInfo[indexRow.entryId];
+        if (info.numStreams == 0) {
+            info = _melodyIndex->getScoreInfo(indexRow.entryId);
+        }
+        tables[position].push_back(extendMelodyPatternRow(info, std::move(indexRow.row)));
+    }
+
+    return tables;
 }
 
 ScoreCollection::ExtendedMelodyPatternTable ScoreCollection::findMelodyPattern(
@@ -105,24 +732,62 @@ ScoreCollection::ExtendedMelodyPatternTable ScoreCollection::findMelodyPattern(
     const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>& rhythmSimilarityCallback,
     const std::function<float(const std::vector<float>&)>& totalIntervalSimilarityCallback,
     const std::function<float(const std::vector<float>&)>& totalRhythmSimilarityCallback,
-    const std::function<float(float, float)>& totalSimilarityCallback) const {
-    
-    ScoreCollection::ExtendedMelodyPatternTable results;
-    for (const auto& score : _scores) {
-        auto scoreResults = score.findMelodyPattern(melodyPattern, totalIntervalsSimilarityThreshold,
-                                                    totalRhythmSimilarityThreshold,
-                                                    intervalsSimilarityCallback, rhythmSimilarityCallback,
-                                                    totalIntervalSimilarityCallback, totalRhythmSimilarityCallback,
-                                                    totalSimilarityCallback);
-        
-        for (const auto& row : scoreResults) {
-            // Constrói diretamente um MelodyPatternRow com o título da partitura
-            results.emplace_back(score.getFileName(), score.getComposerName(), score.getTitle(), std::get<0>(row), std::get<1>(row), std::get<2>(row),
-                                 std::get<3>(row), std::get<4>(row), std::get<5>(row), std::get<6>(row),
-                                 std::get<7>(row), std::get<8>(row), std::get<9>(row), std::get<10>(row));
+    const std::function<float(float, float)>& totalSimilarityCallback,
+    const MelodySimilarityMetric metric, const int warpingWindow, const int numThreads,
+    const bool deterministicOrder) const {
+    const bool defaultSimilarities =
+        !intervalsSimilarityCallback && !rhythmSimilarityCallback &&
+        !totalIntervalSimilarityCallback && !totalRhythmSimilarityCallback && !totalSimilarityCallback;
+    if (_melodyIndex && defaultSimilarities && metric == MelodySimilarityMetric::EUCLIDEAN &&
+        melodyPattern.size() >= 2) {
+        ExtendedMelodyPatternTable results;
+        for (auto& table : findMelodyPatternInIndex(melodyPattern, totalIntervalsSimilarityThreshold,
+                                                    totalRhythmSimilarityThreshold, numThreads,
+                                                    nullptr)) {
+            results.insert(results.end(), std::make_move_iterator(table.begin()),
+                           std::make_move_iterator(table.end()));
         }
+        return results;
     }
-    return results;
+
+    if (_scores.empty() && _melodyIndex && _melodyIndex->getNumScores() > 0) {
+        LOG_ERROR("A collection without scores only searches its melody index: patterns of at "
+                  "least 2 notes, without custom callbacks and with the EUCLIDEAN metric");
+    }
+
+    const std::vector<MelodySearchTask> tasks =
+        prepareMelodySearchTasks(_scores, getDistinctScoreIndices(), numThreads);
+
+    // ===== STEP 1: LINHAS DE CADA TAREFA, UM ACUMULADOR POR WORKER ===== //
+    typedef ConcatenationReducer<ExtendedMelodyPatternRow, size_t> RowsReducer;
+    RowsReducer rows = ThreadPool::mapReduce(tasks.size(), [&](const size_t taskIdx,
+                                                               RowsReducer& accumulator) {
+        const MelodySearchTask& task = tasks[taskIdx];
+        const Score& score = *_scores[task.scoreIdx];
+        Score::MelodyPatternTable scoreRows =
+            (task.streamIdx < 0)
+                ? score.findMelodyPattern(melodyPattern, totalIntervalsSimilarityThreshold,
+                                          totalRhythmSimilarityThreshold,
+                                          intervalsSimilarityCallback, rhythmSimilarityCallback,
+                                          totalIntervalSimilarityCallback,
+                                          totalRhythmSimilarityCallback, totalSimilarityCallback,
+                                          metric, warpingWindow)
+                : score.findMelodyPatternInStream(task.streamIdx, melodyPattern,
+                                                  totalIntervalsSimilarityThreshold,
+                                                  totalRhythmSimilarityThreshold,
+                                                  intervalsSimilarityCallback,
+                                                  rhythmSimilarityCallback,
+                                                  totalIntervalSimilarityCallback,
+                                                  totalRhythmSimilarityCallback,
+                                                  totalSimilarityCallback, metric, warpingWindow);
+
+        for (auto& row : scoreRows) {
+            accumulator.add(taskIdx, extendMelodyPatternRow(score, std::move(row)));
+        }
+    }, RowsReducer(), numThreads);
+
+    // ===== STEP 2: JUNÇÃO, EM ORDEM DE TAREFA SE DETERMINÍSTICA ===== //
+    return rows.takeValues(deterministicOrder);
 }
 
 std::vector<ScoreCollection::ExtendedMultiMelodyPatternTable> ScoreCollection::findMelodyPattern(
@@ -132,7 +797,9 @@ std::vector<ScoreCollection::ExtendedMultiMelodyPatternTable> ScoreCollection::f
     const std::function<std::vector<float>(const std::vector<Note>&, const std::vector<Note>&)>& rhythmSimilarityCallback,
     const std::function<float(const std::vector<float>&)>& totalIntervalSimilarityCallback,
     const std::function<float(const std::vector<float>&)>& totalRhythmSimilarityCallback,
-    const std::function<float(float, float)>& totalSimilarityCallback) const {
+    const std::function<float(float, float)>& totalSimilarityCallback,
+    const MelodySimilarityMetric metric, const int warpingWindow, const int numThreads,
+    const bool deterministicOrder) const {
     
     std::vector<ExtendedMultiMelodyPatternTable> allResults;
 
@@ -141,40 +808,270 @@ std::vector<ScoreCollection::ExtendedMultiMelodyPatternTable> ScoreCollection::f
         return allResults;
     }
 
-    for (const auto& score : _scores) {
-        auto scoreResults = score.findMelodyPattern(melodyPatterns, totalIntervalsSimilarityThreshold,
-                                                    totalRhythmSimilarityThreshold,
-                                                    intervalsSimilarityCallback, rhythmSimilarityCallback,
-                                                    totalIntervalSimilarityCallback, totalRhythmSimilarityCallback,
-                                                    totalSimilarityCallback);
-        
-        ScoreCollection::ExtendedMultiMelodyPatternTable extendedTable;
-        for (size_t patternIdx = 0; patternIdx < scoreResults.size(); ++patternIdx) {
-        // for (const auto& table : scoreResults) {       // Itera sobre cada tabela
-            const auto& table = scoreResults[patternIdx]; // Acessa a tabela atual
-            for (const Score::MelodyPatternRow& row : table) { // Itera sobre cada linha da tabela
-                // Adiciona uma nova linha ao extendedTable, incluindo o título da partitura no início
-                extendedTable.emplace_back(
-                    patternIdx,
-                    score.getFileName(),                  // Nome do arquivo
-                    score.getComposerName(),              // Nome do compositor
-                    score.getTitle(),                       // Título da partitura
-                    std::get<0>(row),                       // partName
-                    std::get<1>(row),                       // measureId
-                    std::get<2>(row),                       // staveId
-                    std::get<3>(row),                       // writtenClefKey
-                    std::get<4>(row),                       // transposeInterval
-                    std::get<5>(row),                       // segmentWrittenPitch
-                    std::get<6>(row),                       // semitonesDiff
-                    std::get<7>(row),                       // rhythmDiff
-                    std::get<8>(row),                       // totalIntervalSimilarity
-                    std::get<9>(row),                       // totalRhythmSimilarity
-                    std::get<10>(row)                       // totalSimilarity
-                );
+    const bool defaultSimilarities =
+        !intervalsSimilarityCallback && !rhythmSimilarityCallback &&
+        !totalIntervalSimilarityCallback && !totalRhythmSimilarityCallback && !totalSimilarityCallback;
+    const bool patternsFitIndex =
+        std::all_of(melodyPatterns.begin(), melodyPatterns.end(),
+                    [](const std::vector<Note>& pattern) { return pattern.size() >= 2; });
+    if (_melodyIndex && defaultSimilarities && metric == MelodySimilarityMetric::EUCLIDEAN &&
+        patternsFitIndex) {
+        allResults.resize(_melodyIndex->getNumScores());
+        for (size_t patternIdx = 0; patternIdx < melodyPatterns.size(); patternIdx++) {
+            std::vector<std::string> skippedFileNames;
+            std::vector<ExtendedMelodyPatternTable> tables = findMelodyPatternInIndex(
+                melodyPatterns[patternIdx], totalIntervalsSimilarityThreshold,
+                totalRhythmSimilarityThreshold, numThreads, &skippedFileNames);
+
+            for (const std::string& fileName : skippedFileNames) {
+                LOG_WARN("Melody pattern " << patternIdx << " skipped in " << fileName
+                                           << ": it is bigger than the score");
+            }
+
+            for (size_t position = 0; position < tables.size(); position++) {
+                for (auto& row : tables[position]) {
+                    allResults[position].push_back(std::tuple_cat(
+                        std::make_tuple(static_cast<int>(patternIdx)), std::move(row)));
+                }
             }
         }
-        allResults.push_back(extendedTable);
+        return allResults;
     }
+
+    if (_scores.empty() && _melodyIndex && _melodyIndex->getNumScores() > 0) {
+        LOG_ERROR("A collection without scores only searches its melody index: patterns of at "
+                  "least 2 notes, without custom callbacks and with the EUCLIDEAN metric");
+    }
+
+    const std::vector<MelodySearchTask> tasks =
+        prepareMelodySearchTasks(_scores, getDistinctScoreIndices(), numThreads);
+    const size_t numPatterns = melodyPatterns.size();
+
+    // ===== STEP 1: UMA TAREFA POR (PADRÃO, PARTITURA OU STREAM) ===== //
+    // A pattern bigger than a score is skipped in that score; the other errors (invalid
+    // arguments, exceptions of the callbacks) are rethrown by the thread pool
+    struct TaskRows {
+        size_t taskIdx;
+        size_t patternIdx;
+        bool isSkipped;
+        ExtendedMultiMelodyPatternTable rows;
+    };
+
+    // Ordered by score, then pattern, then stream
+    typedef std::tuple<size_t, size_t, size_t> TaskKey;
+    typedef ConcatenationReducer<TaskRows, TaskKey> TaskRowsReducer;
+
+    const size_t numTasks = tasks.size() * numPatterns;
+    TaskRowsReducer results = ThreadPool::mapReduce(numTasks, [&](const size_t idx,
+                                                                  TaskRowsReducer& accumulator) {
+        const size_t taskIdx = idx / numPatterns;
+        const size_t patternIdx = idx % numPatterns;
+        const MelodySearchTask& task = tasks[taskIdx];
+        const Score& score = *_scores[task.scoreIdx];
+        const std::vector<Note>& melodyPattern = melodyPatterns[patternIdx];
+
+        TaskRows taskRows{taskIdx, patternIdx, false, {}};
+        if (melodyPattern.size() > static_cast<size_t>(score.getNumNotes())) {
+            taskRows.isSkipped = true;
+        } else {
+            Score::MelodyPatternTable scoreRows =
+                (task.streamIdx < 0)
+                    ? score.findMelodyPattern(melodyPattern, totalIntervalsSimilarityThreshold,
+                                              totalRhythmSimilarityThreshold,
+                                              intervalsSimilarityCallback, rhythmSimilarityCallback,
+                                              totalIntervalSimilarityCallback,
+                                              totalRhythmSimilarityCallback,
+                                              totalSimilarityCallback, metric, warpingWindow)
+                    : score.findMelodyPatternInStream(task.streamIdx, melodyPattern,
+                                                      totalIntervalsSimilarityThreshold,
+                                                      totalRhythmSimilarityThreshold,
+                                                      intervalsSimilarityCallback,
+                                                      rhythmSimilarityCallback,
+                                                      totalIntervalSimilarityCallback,
+                                                      totalRhythmSimilarityCallback,
+                                                      totalSimilarityCallback, metric,
+                                                      warpingWindow);
+
+            taskRows.rows.reserve(scoreRows.size());
+            for (auto& row : scoreRows) {
+                taskRows.rows.push_back(std::tuple_cat(
+                    std::make_tuple(static_cast<int>(patternIdx)),
+                    extendMelodyPatternRow(score, std::move(row))));
+            }
+        }
+
+        if (!taskRows.rows.empty() || taskRows.isSkipped) {
+            accumulator.add(TaskKey(task.scoreIdx, patternIdx, taskIdx), std::move(taskRows));
+        }
+    }, TaskRowsReducer(), numThreads);
+
+    // ===== STEP 2: JUNÇÃO DOS ACUMULADORES, UMA TABELA POR PARTITURA ===== //
+    std::vector<TaskRows> allTaskRows = results.takeValues(deterministicOrder);
+
+    allResults.resize(_scores.size());
+    std::set<std::pair<size_t, size_t>> skippedSearches;  // (score, pattern)
+    for (TaskRows& taskRows : allTaskRows) {
+        const size_t scoreIdx = tasks[taskRows.taskIdx].scoreIdx;
+        if (taskRows.isSkipped) {
+            // Every stream of the score is skipped: warn once
+            if (skippedSearches.emplace(scoreIdx, taskRows.patternIdx).second) {
+                LOG_WARN("Melody pattern " << taskRows.patternIdx << " skipped in "
+                                           << _scores[scoreIdx]->getFileName()
+                                           << ": it is bigger than the score");
+            }
+            continue;
+        }
+
+        auto& table = allResults[scoreIdx];
+        table.insert(table.end(), std::make_move_iterator(taskRows.rows.begin()),
+                     std::make_move_iterator(taskRows.rows.end()));
+    }
+
     return allResults;
 }
 
+void ScoreCollection::findMelodyPatternMatches(const std::vector<Note>& melodyPattern,
+                                               const MelodyPatternMatchCallback& callback,
+                                               const float totalIntervalsSimilarityThreshold,
+                                               const float totalRhythmSimilarityThreshold,
+                                               const MelodySimilarityMetric metric,
+                                               const int warpingWindow) const {
+    for (size_t scoreIdx = 0; scoreIdx < _scores.size(); scoreIdx++) {
+        _scores[scoreIdx]->findMelodyPatternMatches(
+            melodyPattern,
+            [&callback, scoreIdx](const Score::MelodyPatternMatch& match) {
+                callback(static_cast<int>(scoreIdx), match);
+            },
+            totalIntervalsSimilarityThreshold, totalRhythmSimilarityThreshold, metric,
+            warpingWindow);
+    }
+}
+
+size_t ScoreCollection::countMelodyPattern(const std::vector<Note>& melodyPattern,
+                                           const float totalIntervalsSimilarityThreshold,
+                                           const float totalRhythmSimilarityThreshold,
+                                           const MelodySimilarityMetric metric,
+                                           const int warpingWindow) const {
+    size_t count = 0;
+    for (const auto& score : _scores) {
+        count += score->countMelodyPattern(melodyPattern, totalIntervalsSimilarityThreshold,
+                                           totalRhythmSimilarityThreshold, metric, warpingWindow);
+    }
+    return count;
+}
+
+ScoreCollection::ExtendedMelodyPatternTable ScoreCollection::findTopMelodyPattern(
+    const std::vector<Note>& melodyPattern, const size_t k,
+    const float totalIntervalsSimilarityThreshold, const float totalRhythmSimilarityThreshold,
+    const MelodySimilarityMetric metric, const int warpingWindow) const {
+    struct Candidate {
+        size_t scoreIdx;
+        size_t rowIdx;
+        Score::MelodyPatternRow row;
+    };
+
+    // 'a' ranks before 'b'
+    const auto isBetter = [](const Candidate& a, const Candidate& b) {
+        const float similarityA = std::get<10>(a.row);
+        const float similarityB = std::get<10>(b.row);
+        if (similarityA != similarityB) {
+            return similarityA > similarityB;
+        }
+        return std::tie(a.scoreIdx, a.rowIdx) < std::tie(b.scoreIdx, b.rowIdx);
+    };
+
+    // Bounded heap: the front is the worst kept candidate
+    std::vector<Candidate> heap;
+    for (size_t scoreIdx = 0; scoreIdx < _scores.size() && k > 0; scoreIdx++) {
+        auto scoreResults = _scores[scoreIdx]->findTopMelodyPattern(
+            melodyPattern, k, totalIntervalsSimilarityThreshold, totalRhythmSimilarityThreshold,
+            metric, warpingWindow);
+
+        for (size_t rowIdx = 0; rowIdx < scoreResults.size(); rowIdx++) {
+            Candidate candidate{scoreIdx, rowIdx, std::move(scoreResults[rowIdx])};
+            if (heap.size() == k) {
+                if (!isBetter(candidate, heap.front())) {
+                    break;  // The score rows are sorted: the next ones are not better
+                }
+                std::pop_heap(heap.begin(), heap.end(), isBetter);
+                heap.pop_back();
+            }
+
+            heap.push_back(std::move(candidate));
+            std::push_heap(heap.begin(), heap.end(), isBetter);
+        }
+    }
+
+    std::sort(heap.begin(), heap.end(), isBetter);
+
+    ExtendedMelodyPatternTable results;
+    results.reserve(heap.size());
+    for (auto& candidate : heap) {
+        const Score& score = *_scores[candidate.scoreIdx];
+        auto& row = candidate.row;
+        results.emplace_back(score.getFileName(), score.getComposerName(), score.getTitle(),
+                             std::move(std::get<0>(row)), std::get<1>(row), std::get<2>(row),
+                             std::move(std::get<3>(row)), std::move(std::get<4>(row)),
+                             std::move(std::get<5>(row)), std::move(std::get<6>(row)),
+                             std::move(std::get<7>(row)), std::get<8>(row), std::get<9>(row),
+                             std::get<10>(row));
+    }
+
+    return results;
+}
+
+void ScoreCollection::forEachScoreParallel(const std::function<void(int, const Score&)>& function,
+                                           const int numThreads) const {
+    // One score per chunk: the scores have very different sizes
+    ThreadPool::parallelFor(_scores.size(), [&](const size_t scoreIdx) {
+        function(static_cast<int>(scoreIdx), *_scores[scoreIdx]);
+    }, numThreads, 1);
+}
+
+void ScoreCollection::forEachScoreParallel(const std::function<void(int, Score&)>& function,
+                                           const int numThreads) {
+    // Copy-on-write before the workers start: each position gets its own score
+    for (size_t scoreIdx = 0; scoreIdx < _scores.size(); scoreIdx++) {
+        getScore(scoreIdx);
+    }
+
+    ThreadPool::parallelFor(_scores.size(), [&](const size_t scoreIdx) {
+        function(static_cast<int>(scoreIdx), const_cast<Score&>(*_scores[scoreIdx]));
+    }, numThreads, 1);
+}
+
+std::vector<std::vector<Score::MelodyRegexMatch>> ScoreCollection::findMelodyRegex(
+    const std::string& pattern, const int numThreads) const {
+    const MelodyRegex regex(pattern);
+
+    // One search per distinct score: the search fills the melody search index of the score
+    const std::vector<size_t> distinctScoreIndices = getDistinctScoreIndices();
+    std::vector<std::vector<Score::MelodyRegexMatch>> results(_scores.size());
+    ThreadPool::parallelFor(distinctScoreIndices.size(), [&](const size_t i) {
+        const size_t scoreIdx = distinctScoreIndices[i];
+        results[scoreIdx] = _scores[scoreIdx]->findMelodyRegex(regex, 1);
+    }, numThreads, 1);
+
+    copyDistinctResults(_scores, &results);
+    return results;
+}
+
+std::vector<std::vector<Score::ChordProgressionMatch>> ScoreCollection::findChordProgression(
+    const std::string& progression, const nlohmann::json& config, const bool mergeRepeatedChords,
+    const int numThreads) {
+    const ChordProgressionQuery query(progression);
+
+    // The search fills the harmonic index of the score: copy-on-write before the workers start,
+    // so no other collection or thread sees the score while it changes
+    for (size_t scoreIdx = 0; scoreIdx < _scores.size(); scoreIdx++) {
+        getScore(scoreIdx);
+    }
+
+    std::vector<std::vector<Score::ChordProgressionMatch>> results(_scores.size());
+    ThreadPool::parallelFor(_scores.size(), [&](const size_t scoreIdx) {
+        Score& score = const_cast<Score&>(*_scores[scoreIdx]);
+        results[scoreIdx] = score.findChordProgression(query, config, mergeRepeatedChords);
+    }, numThreads, 1);
+
+    return results;
+}
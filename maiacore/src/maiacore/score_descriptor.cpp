@@ -0,0 +1,449 @@
+#include "maiacore/score_descriptor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+
+#include "maiacore/log.h"
+#include "maiacore/score.h"
+#include "maiacore/thread_pool.h"
+
+namespace {
+
+// Blocks of the descriptor values
+const int PITCH_CLASS_OFFSET = 0;
+const int INTERVAL_OFFSET = PITCH_CLASS_OFFSET + ScoreDescriptor::NUM_PITCH_CLASS_BINS;
+const int RHYTHM_OFFSET = INTERVAL_OFFSET + ScoreDescriptor::NUM_INTERVAL_BINS;
+const int CHORD_QUALITY_OFFSET = RHYTHM_OFFSET + ScoreDescriptor::NUM_RHYTHM_BINS;
+const int TEXTURE_OFFSET = CHORD_QUALITY_OFFSET + ScoreDescriptor::NUM_CHORD_QUALITY_BINS;
+
+const int MAX_INTERVAL = ScoreDescriptor::NUM_INTERVAL_BINS / 2;
+
+// Onsets and durations in ticks of a fixed grid: tuplets and dotted values are exact enough
+const double TICKS_PER_QUARTER = 960.0;
+
+// Scale of the texture values mapped to [0, 1]
+const double MAX_POLYPHONY = 8.0;
+const double MAX_ATTACKS_PER_QUARTER = 8.0;
+const double MAX_PITCH_RANGE = 88.0;
+
+const int K_MEANS_ITERATIONS = 10;
+const int K_MEANS_SAMPLES_PER_LIST = 64;
+
+const char* const PITCH_CLASS_NAMES[] = {"C",  "C#", "D",  "D#", "E",  "F",
+                                         "F#", "G",  "G#", "A",  "A#", "B"};
+const char* const RHYTHM_NAMES[] = {"64th", "32nd", "16th", "eighth",
+                                    "quarter", "half", "whole", "breve"};
+const char* const CHORD_QUALITY_NAMES[] = {"unison_dyad",
+                                           "major",
+                                           "minor",
+                                           "diminished",
+                                           "augmented",
+                                           "dominant_seventh",
+                                           "minor_seventh",
+                                           "major_seventh",
+                                           "half_diminished_seventh",
+                                           "diminished_seventh",
+                                           "other"};
+const char* const TEXTURE_NAMES[] = {"polyphony", "attack_density", "rest_ratio", "pitch_range"};
+
+// Pitch classes above the root of each chord quality (bin 1 on), sevenths first: a set that
+// contains a seventh chord also contains its triad
+const std::vector<std::pair<int, int>> CHORD_TEMPLATES = {
+    {5, (1 << 0) | (1 << 4) | (1 << 7) | (1 << 10)},  // Dominant seventh
+    {6, (1 << 0) | (1 << 3) | (1 << 7) | (1 << 10)},  // Minor seventh
+    {7, (1 << 0) | (1 << 4) | (1 << 7) | (1 << 11)},  // Major seventh
+    {8, (1 << 0) | (1 << 3) | (1 << 6) | (1 << 10)},  // Half-diminished seventh
+    {9, (1 << 0) | (1 << 3) | (1 << 6) | (1 << 9)},   // Diminished seventh
+    {1, (1 << 0) | (1 << 4) | (1 << 7)},              // Major
+    {2, (1 << 0) | (1 << 3) | (1 << 7)},              // Minor
+    {3, (1 << 0) | (1 << 3) | (1 << 6)},              // Diminished
+    {4, (1 << 0) | (1 << 4) | (1 << 8)},              // Augmented
+};
+const int UNISON_DYAD_BIN = 0;
+const int OTHER_CHORD_BIN = 10;
+
+int rotatePitchClassSet(const int pitchClassSet, const int root) {
+    return ((pitchClassSet >> root) | (pitchClassSet << (12 - root))) & 0xFFF;
+}
+
+// Chord-quality bin of a pitch-class set: exact templates first, then the first contained one
+int chordQualityBin(const int pitchClassSet) {
+    int numPitchClasses = 0;
+    for (int pc = 0; pc < 12; pc++) {
+        numPitchClasses += (pitchClassSet >> pc) & 1;
+    }
+    if (numPitchClasses <= 2) {
+        return UNISON_DYAD_BIN;
+    }
+
+    for (const bool exact : {true, false}) {
+        for (const auto& chordTemplate : CHORD_TEMPLATES) {
+            for (int root = 0; root < 12; root++) {
+                if (((pitchClassSet >> root) & 1) == 0) {
+                    continue;
+                }
+
+                const int rotated = rotatePitchClassSet(pitchClassSet, root);
+                const bool isMatch = exact ? rotated == chordTemplate.second
+                                           : (rotated & chordTemplate.second) == chordTemplate.second;
+                if (isMatch) {
+                    return chordTemplate.first;
+                }
+            }
+        }
+    }
+    return OTHER_CHORD_BIN;
+}
+
+void normalizeBlock(std::vector<float>* values, const int offset, const int size) {
+    double sum = 0.0;
+    for (int i = offset; i < offset + size; i++) {
+        sum += (*values)[i];
+    }
+    if (sum <= 0.0) {
+        return;
+    }
+    for (int i = offset; i < offset + size; i++) {
+        (*values)[i] = static_cast<float>((*values)[i] / sum);
+    }
+}
+
+float squaredDistance(const float* a, const float* b) {
+    float sum = 0.0f;
+    for (int i = 0; i < ScoreDescriptor::SIZE; i++) {
+        const float diff = a[i] - b[i];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+}  // namespace
+
+ScoreDescriptor ScoreDescriptor::compute(const Score& score) {
+    ScoreDescriptor descriptor;
+    descriptor.values.assign(SIZE, 0.0f);
+    std::vector<float>& values = descriptor.values;
+
+    // ===== STEP 1: PERCORRE AS NOTAS DE CADA VOZ ===== //
+    // Sounding notes as (time, +1/-1, pitch class) changes
+    std::vector<std::tuple<int64_t, int, int>> changes;
+    int numAttacks = 0;
+    int minMidiNumber = 128;
+    int maxMidiNumber = -1;
+    int64_t scoreEnd = 0;
+
+    for (const Part& part : score._part) {
+        if (!part.isPitched()) {
+            continue;
+        }
+
+        std::map<std::pair<int, int>, int> lastMidiNumber;  // (stave, voice)
+        int64_t measureStart = 0;
+        for (int measureIdx = 0; measureIdx < part.getNumMeasures(); measureIdx++) {
+            const Measure& measure = part.getMeasure(measureIdx);
+            const int64_t measureEnd =
+                measureStart + std::llround(measure.getQuarterDuration() * TICKS_PER_QUARTER);
+
+            // Each voice restarts at the beginning of the measure
+            int64_t lastNoteEnd = measureStart;
+            for (int staveIdx = 0; staveIdx < measure.getNumStaves(); staveIdx++) {
+                std::map<int, std::pair<int64_t, int64_t>> voiceCursor;  // (last onset, next onset)
+                for (int noteIdx = 0; noteIdx < measure.getNumNotes(staveIdx); noteIdx++) {
+                    const Note& note = measure.getNote(noteIdx, staveIdx);
+                    if (note.isGraceNote()) {
+                        continue;
+                    }
+
+                    const int voice = note.getVoice();
+                    auto& cursor = voiceCursor.emplace(voice, std::make_pair(measureStart, measureStart))
+                                       .first->second;
+                    const int64_t duration =
+                        std::llround(note.getQuarterDuration() * TICKS_PER_QUARTER);
+
+                    // Chord notes start with the previous note of the voice
+                    const int64_t onset = note.inChord() ? cursor.first : cursor.second;
+                    if (!note.inChord()) {
+                        cursor = std::make_pair(onset, onset + duration);
+                        lastNoteEnd = std::max(lastNoteEnd, onset + duration);
+                    }
+
+                    if (!note.isNoteOn() || duration <= 0) {
+                        continue;
+                    }
+
+                    const int midiNumber = note.getMidiNumber();
+                    const int pitchClass = ((midiNumber % 12) + 12) % 12;
+                    changes.emplace_back(onset, 1, pitchClass);
+                    changes.emplace_back(onset + duration, -1, pitchClass);
+                    values[PITCH_CLASS_OFFSET + pitchClass] += duration / TICKS_PER_QUARTER;
+                    minMidiNumber = std::min(minMidiNumber, midiNumber);
+                    maxMidiNumber = std::max(maxMidiNumber, midiNumber);
+                    scoreEnd = std::max(scoreEnd, onset + duration);
+
+                    const auto ties = note.getTie();
+                    if (note.inChord() || std::find(ties.begin(), ties.end(), "stop") != ties.end()) {
+                        continue;
+                    }
+
+                    // Attack: interval from the previous attack of the voice and rhythm value
+                    numAttacks++;
+                    const int rhythmBin = static_cast<int>(std::lround(std::log2(
+                                              duration / TICKS_PER_QUARTER))) + 4;
+                    values[RHYTHM_OFFSET + std::max(0, std::min(NUM_RHYTHM_BINS - 1, rhythmBin))] += 1.0f;
+
+                    const auto voiceKey = std::make_pair(staveIdx, voice);
+                    const auto it = lastMidiNumber.find(voiceKey);
+                    if (it != lastMidiNumber.end()) {
+                        const int interval =
+                            std::max(-MAX_INTERVAL, std::min(MAX_INTERVAL, midiNumber - it->second));
+                        values[INTERVAL_OFFSET + interval + MAX_INTERVAL] += 1.0f;
+                    }
+                    lastMidiNumber[voiceKey] = midiNumber;
+                }
+            }
+
+            // The anacrusis measure lasts only its notes
+            measureStart = (measureIdx == 0 && score.haveAnacrusisMeasure()) ? lastNoteEnd : measureEnd;
+        }
+        scoreEnd = std::max(scoreEnd, measureStart);
+    }
+
+    // ===== STEP 2: CONJUNTOS VERTICAIS DE CLASSES DE ALTURA ===== //
+    std::sort(changes.begin(), changes.end());
+    int numSounding[12] = {0};
+    int totalSounding = 0;
+    double soundingTime = 0.0;
+    double soundingNotesTime = 0.0;
+    for (size_t c = 0; c < changes.size();) {
+        const int64_t time = std::get<0>(changes[c]);
+        for (; c < changes.size() && std::get<0>(changes[c]) == time; c++) {
+            numSounding[std::get<2>(changes[c])] += std::get<1>(changes[c]);
+            totalSounding += std::get<1>(changes[c]);
+        }
+        if (c == changes.size() || totalSounding == 0) {
+            continue;
+        }
+
+        int pitchClassSet = 0;
+        for (int pc = 0; pc < 12; pc++) {
+            pitchClassSet |= (numSounding[pc] > 0) ? (1 << pc) : 0;
+        }
+
+        const double sliceDuration = (std::get<0>(changes[c]) - time) / TICKS_PER_QUARTER;
+        values[CHORD_QUALITY_OFFSET + chordQualityBin(pitchClassSet)] += sliceDuration;
+        soundingTime += sliceDuration;
+        soundingNotesTime += sliceDuration * totalSounding;
+    }
+
+    // ===== STEP 3: TEXTURA E NORMALIZAÇÃO ===== //
+    const double totalTime = scoreEnd / TICKS_PER_QUARTER;
+    if (soundingTime > 0.0) {
+        values[TEXTURE_OFFSET] = std::min(1.0, soundingNotesTime / soundingTime / MAX_POLYPHONY);
+    }
+    if (totalTime > 0.0) {
+        values[TEXTURE_OFFSET + 1] = std::min(1.0, numAttacks / totalTime / MAX_ATTACKS_PER_QUARTER);
+        values[TEXTURE_OFFSET + 2] = std::max(0.0, 1.0 - soundingTime / totalTime);
+    }
+    if (maxMidiNumber >= minMidiNumber) {
+        values[TEXTURE_OFFSET + 3] =
+            std::min(1.0, (maxMidiNumber - minMidiNumber) / MAX_PITCH_RANGE);
+    }
+
+    normalizeBlock(&values, PITCH_CLASS_OFFSET, NUM_PITCH_CLASS_BINS);
+    normalizeBlock(&values, INTERVAL_OFFSET, NUM_INTERVAL_BINS);
+    normalizeBlock(&values, RHYTHM_OFFSET, NUM_RHYTHM_BINS);
+    normalizeBlock(&values, CHORD_QUALITY_OFFSET, NUM_CHORD_QUALITY_BINS);
+
+    return descriptor;
+}
+
+std::vector<std::string> ScoreDescriptor::getFeatureNames() {
+    std::vector<std::string> names;
+    names.reserve(SIZE);
+    for (const char* name : PITCH_CLASS_NAMES) {
+        names.push_back(std::string("pitch_class_") + name);
+    }
+    for (int interval = -MAX_INTERVAL; interval <= MAX_INTERVAL; interval++) {
+        names.push_back("interval_" + std::string(interval > 0 ? "+" : "") + std::to_string(interval));
+    }
+    for (const char* name : RHYTHM_NAMES) {
+        names.push_back(std::string("rhythm_") + name);
+    }
+    for (const char* name : CHORD_QUALITY_NAMES) {
+        names.push_back(std::string("chord_") + name);
+    }
+    for (const char* name : TEXTURE_NAMES) {
+        names.push_back(std::string("texture_") + name);
+    }
+    return names;
+}
+
+float ScoreDescriptor::distance(const ScoreDescriptor& other) const {
+    if (values.size() != static_cast<size_t>(SIZE) || other.values.size() != static_cast<size_t>(SIZE)) {
+        LOG_ERROR("Invalid score descriptor size");
+    }
+
+    return std::sqrt(squaredDistance(values.data(), other.values.data()));
+}
+
+ScoreDescriptorIndex::ScoreDescriptorIndex(const std::vector<ScoreDescriptor>& descriptors,
+                                           const int numLists, const int numThreads) {
+    const size_t numValues = ScoreDescriptor::SIZE;
+    const size_t numDescriptors = descriptors.size();
+    for (const auto& descriptor : descriptors) {
+        if (descriptor.values.size() != numValues) {
+            LOG_ERROR("Invalid score descriptor size");
+        }
+    }
+
+    // ===== STEP 1: CENTROIDES INICIAIS ===== //
+    size_t numCentroids = (numLists > 0) ? numLists : std::lround(std::sqrt(numDescriptors));
+    numCentroids = std::max<size_t>(1, std::min(numCentroids, numDescriptors));
+
+    // The k-means runs on evenly spaced samples, and starts from evenly spaced samples
+    const size_t numSamples = std::min(numDescriptors, numCentroids * K_MEANS_SAMPLES_PER_LIST);
+    std::vector<const float*> samples(numSamples);
+    for (size_t s = 0; s < numSamples; s++) {
+        samples[s] = descriptors[s * numDescriptors / numSamples].values.data();
+    }
+
+    _centroids.assign(numCentroids * numValues, 0.0f);
+    _listIds.resize(numCentroids);
+    _listValues.resize(numCentroids);
+    for (size_t c = 0; c < numCentroids && numSamples > 0; c++) {
+        const float* sample = samples[c * numSamples / numCentroids];
+        std::copy(sample, sample + numValues, _centroids.begin() + c * numValues);
+    }
+
+    // ===== STEP 2: K-MEANS ===== //
+    std::vector<int> sampleList(numSamples, 0);
+    for (int iteration = 0; iteration < K_MEANS_ITERATIONS && numCentroids > 1; iteration++) {
+        ThreadPool::parallelFor(numSamples, [&](const size_t s) {
+            sampleList[s] = findNearestCentroid(samples[s]);
+        }, numThreads, 256);
+
+        std::vector<double> sums(numCentroids * numValues, 0.0);
+        std::vector<int> counts(numCentroids, 0);
+        for (size_t s = 0; s < numSamples; s++) {
+            counts[sampleList[s]]++;
+            for (size_t i = 0; i < numValues; i++) {
+                sums[sampleList[s] * numValues + i] += samples[s][i];
+            }
+        }
+
+        // An empty list keeps its centroid
+        for (size_t c = 0; c < numCentroids; c++) {
+            for (size_t i = 0; i < numValues && counts[c] > 0; i++) {
+                _centroids[c * numValues + i] = static_cast<float>(sums[c * numValues + i] / counts[c]);
+            }
+        }
+    }
+
+    // ===== STEP 3: LISTAS ===== //
+    std::vector<int> descriptorList(numDescriptors, 0);
+    ThreadPool::parallelFor(numDescriptors, [&](const size_t id) {
+        descriptorList[id] = findNearestCentroid(descriptors[id].values.data());
+    }, numThreads, 256);
+
+    _listOfId = descriptorList;
+    for (size_t id = 0; id < numDescriptors; id++) {
+        const std::vector<float>& values = descriptors[id].values;
+        _listIds[descriptorList[id]].push_back(id);
+        _listValues[descriptorList[id]].insert(_listValues[descriptorList[id]].end(),
+                                               values.begin(), values.end());
+    }
+}
+
+int ScoreDescriptorIndex::findNearestCentroid(const float* values) const {
+    int nearest = 0;
+    float nearestDistance = INFINITY;
+    for (int c = 0; c < getNumLists(); c++) {
+        const float distance = squaredDistance(values, &_centroids[c * ScoreDescriptor::SIZE]);
+        if (distance < nearestDistance) {
+            nearest = c;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+int ScoreDescriptorIndex::add(const ScoreDescriptor& descriptor) {
+    if (descriptor.values.size() != static_cast<size_t>(ScoreDescriptor::SIZE)) {
+        LOG_ERROR("Invalid score descriptor size");
+    }
+
+    const int id = _listOfId.size();
+    const int list = findNearestCentroid(descriptor.values.data());
+    _listIds[list].push_back(id);
+    _listValues[list].insert(_listValues[list].end(), descriptor.values.begin(),
+                             descriptor.values.end());
+    _listOfId.push_back(list);
+    return id;
+}
+
+void ScoreDescriptorIndex::remove(const int id) {
+    if (id < 0 || id >= getNumDescriptors()) {
+        LOG_ERROR("Invalid descriptor id: " + std::to_string(id));
+    }
+
+    std::vector<int>& ids = _listIds[_listOfId[id]];
+    std::vector<float>& values = _listValues[_listOfId[id]];
+    const size_t position = std::find(ids.begin(), ids.end(), id) - ids.begin();
+    ids.erase(ids.begin() + position);
+    values.erase(values.begin() + position * ScoreDescriptor::SIZE,
+                 values.begin() + (position + 1) * ScoreDescriptor::SIZE);
+    _listOfId.erase(_listOfId.begin() + id);
+
+    for (auto& listIds : _listIds) {
+        for (int& listId : listIds) {
+            listId -= (listId > id) ? 1 : 0;
+        }
+    }
+}
+
+int ScoreDescriptorIndex::getNumDescriptors() const { return _listOfId.size(); }
+
+int ScoreDescriptorIndex::getNumLists() const { return _listIds.size(); }
+
+std::vector<std::pair<int, float>> ScoreDescriptorIndex::findNearest(
+    const ScoreDescriptor& query, const int k, const int numProbes, const int excludedId) const {
+    if (query.values.size() != static_cast<size_t>(ScoreDescriptor::SIZE)) {
+        LOG_ERROR("Invalid score descriptor size");
+    }
+
+    std::vector<std::pair<int, float>> nearest;
+    if (k <= 0) {
+        return nearest;
+    }
+
+    // ===== STEP 1: LISTAS MAIS PRÓXIMAS ===== //
+    std::vector<std::pair<float, int>> lists(getNumLists());
+    for (int c = 0; c < getNumLists(); c++) {
+        lists[c] = {squaredDistance(query.values.data(), &_centroids[c * ScoreDescriptor::SIZE]), c};
+    }
+    const int numScannedLists = std::max(1, std::min(numProbes, getNumLists()));
+    std::partial_sort(lists.begin(), lists.begin() + numScannedLists, lists.end());
+
+    // ===== STEP 2: DESCRITORES DAS LISTAS ===== //
+    std::vector<std::pair<float, int>> candidates;
+    for (int l = 0; l < numScannedLists; l++) {
+        const std::vector<int>& ids = _listIds[lists[l].second];
+        const float* values = _listValues[lists[l].second].data();
+        for (size_t i = 0; i < ids.size(); i++) {
+            if (ids[i] != excludedId) {
+                candidates.emplace_back(
+                    squaredDistance(query.values.data(), values + i * ScoreDescriptor::SIZE), ids[i]);
+            }
+        }
+    }
+
+    const size_t numResults = std::min<size_t>(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + numResults, candidates.end());
+    nearest.reserve(numResults);
+    for (size_t i = 0; i < numResults; i++) {
+        nearest.emplace_back(candidates[i].second, std::sqrt(candidates[i].first));
+    }
+    return nearest;
+}
@@ -0,0 +1,210 @@
+#include "maiacore/score_fingerprint.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+#include "maiacore/log.h"
+#include "maiacore/score.h"
+
+namespace {
+
+// Token kinds, mixed in the token hashes
+const uint64_t INTERVAL_TOKEN = 1;
+const uint64_t RHYTHM_TOKEN = 2;
+
+// Duration ratios are quantized in quarter steps of log2, within +-4 octaves
+const int MAX_RHYTHM_STEP = 16;
+
+// SplitMix64 finalizer: a bijective 64-bit mix
+uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t hashGram(const uint64_t kind, const int* values, const int gramSize) {
+    uint64_t hash = mix64(kind);
+    for (int i = 0; i < gramSize; i++) {
+        hash = mix64(hash ^ static_cast<uint32_t>(values[i]));
+    }
+    return hash;
+}
+
+int rhythmStep(const float duration, const float nextDuration) {
+    if (duration <= 0.0f || nextDuration <= 0.0f) {
+        return 0;
+    }
+
+    const int step = static_cast<int>(std::lround(4.0 * std::log2(nextDuration / duration)));
+    return std::max(-MAX_RHYTHM_STEP, std::min(MAX_RHYTHM_STEP, step));
+}
+
+}  // namespace
+
+ScoreFingerprint ScoreFingerprint::compute(const Score& score) {
+    const Score::MelodySearchIndex& index = score.getMelodySearchIndex();
+
+    // ===== STEP 1: TOKENS DE INTERVALO E DE RITMO DE CADA STREAM ===== //
+    std::vector<uint64_t> tokens;
+    for (size_t streamIdx = 0; streamIdx < index.streams.size(); streamIdx++) {
+        const std::vector<int>& intervals = index.intervals[streamIdx];
+        const std::vector<float>& durations = index.quarterDurations[streamIdx];
+
+        const int numIntervals = intervals.size();
+        for (int i = 0; i + INTERVAL_GRAM_SIZE <= numIntervals; i++) {
+            tokens.push_back(hashGram(INTERVAL_TOKEN, &intervals[i], INTERVAL_GRAM_SIZE));
+        }
+
+        std::vector<int> steps;
+        for (size_t e = 0; e + 1 < durations.size(); e++) {
+            steps.push_back(rhythmStep(durations[e], durations[e + 1]));
+        }
+        const int numSteps = steps.size();
+        for (int i = 0; i + RHYTHM_GRAM_SIZE <= numSteps; i++) {
+            tokens.push_back(hashGram(RHYTHM_TOKEN, &steps[i], RHYTHM_GRAM_SIZE));
+        }
+    }
+
+    std::sort(tokens.begin(), tokens.end());
+    tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+
+    // ===== STEP 2: MINHASH ===== //
+    ScoreFingerprint fingerprint;
+    fingerprint.numTokens = tokens.size();
+    if (tokens.empty()) {
+        return fingerprint;
+    }
+
+    fingerprint.minHashes.assign(NUM_HASHES, UINT32_MAX);
+    for (const uint64_t token : tokens) {
+        for (int h = 0; h < NUM_HASHES; h++) {
+            const uint64_t seed = static_cast<uint64_t>(h) * 0xD6E8FEB86659FD93ULL;
+            const uint32_t value = mix64(token ^ seed) >> 32;
+            fingerprint.minHashes[h] = std::min(fingerprint.minHashes[h], value);
+        }
+    }
+    return fingerprint;
+}
+
+double ScoreFingerprint::estimateSimilarity(const ScoreFingerprint& other) const {
+    if (minHashes.empty() || other.minHashes.empty()) {
+        return 0.0;
+    }
+
+    int numEqual = 0;
+    for (int h = 0; h < NUM_HASHES; h++) {
+        numEqual += (minHashes[h] == other.minHashes[h]) ? 1 : 0;
+    }
+    return static_cast<double>(numEqual) / NUM_HASHES;
+}
+
+NearDuplicateIndex::NearDuplicateIndex(const int numBands) : _numBands(numBands) {
+    if (numBands < 1 || ScoreFingerprint::NUM_HASHES % numBands != 0) {
+        LOG_ERROR("The number of bands must divide " +
+                  std::to_string(ScoreFingerprint::NUM_HASHES));
+    }
+
+    _rowsPerBand = ScoreFingerprint::NUM_HASHES / numBands;
+    _buckets.resize(numBands);
+}
+
+uint64_t NearDuplicateIndex::getBandKey(const ScoreFingerprint& fingerprint,
+                                        const int bandIdx) const {
+    uint64_t key = 0;
+    for (int row = 0; row < _rowsPerBand; row++) {
+        key = mix64(key ^ fingerprint.minHashes[bandIdx * _rowsPerBand + row]);
+    }
+    return key;
+}
+
+int NearDuplicateIndex::add(const ScoreFingerprint& fingerprint) {
+    const int id = _fingerprints.size();
+    _fingerprints.push_back(fingerprint);
+
+    // Fingerprints without tokens are not similar to anything: kept out of the buckets
+    if (!fingerprint.minHashes.empty()) {
+        for (int bandIdx = 0; bandIdx < _numBands; bandIdx++) {
+            _buckets[bandIdx][getBandKey(fingerprint, bandIdx)].push_back(id);
+        }
+    }
+    return id;
+}
+
+int NearDuplicateIndex::getNumFingerprints() const { return _fingerprints.size(); }
+
+std::vector<int> NearDuplicateIndex::findCandidates(const ScoreFingerprint& fingerprint) const {
+    std::vector<int> candidates;
+    if (fingerprint.minHashes.empty()) {
+        return candidates;
+    }
+
+    for (int bandIdx = 0; bandIdx < _numBands; bandIdx++) {
+        const auto it = _buckets[bandIdx].find(getBandKey(fingerprint, bandIdx));
+        if (it != _buckets[bandIdx].end()) {
+            candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    return candidates;
+}
+
+std::vector<std::pair<int, double>> NearDuplicateIndex::findSimilar(
+    const ScoreFingerprint& fingerprint, const double threshold) const {
+    std::vector<std::pair<int, double>> similar;
+    for (const int id : findCandidates(fingerprint)) {
+        const double similarity = fingerprint.estimateSimilarity(_fingerprints[id]);
+        if (similarity >= threshold) {
+            similar.emplace_back(id, similarity);
+        }
+    }
+
+    std::sort(similar.begin(), similar.end(), [](const auto& a, const auto& b) {
+        return (a.second != b.second) ? a.second > b.second : a.first < b.first;
+    });
+    return similar;
+}
+
+std::vector<std::vector<int>> NearDuplicateIndex::getGroups(const double threshold) const {
+    // Union-find over the similar candidate pairs
+    std::vector<int> parent(_fingerprints.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    const std::function<int(int)> findRoot = [&](const int id) {
+        return (parent[id] == id) ? id : (parent[id] = findRoot(parent[id]));
+    };
+
+    for (const auto& bandBuckets : _buckets) {
+        for (const auto& bucket : bandBuckets) {
+            const std::vector<int>& ids = bucket.second;
+            for (size_t i = 0; i < ids.size(); i++) {
+                for (size_t j = i + 1; j < ids.size(); j++) {
+                    const int rootA = findRoot(ids[i]);
+                    const int rootB = findRoot(ids[j]);
+                    if (rootA != rootB &&
+                        _fingerprints[ids[i]].estimateSimilarity(_fingerprints[ids[j]]) >=
+                            threshold) {
+                        parent[std::max(rootA, rootB)] = std::min(rootA, rootB);
+                    }
+                }
+            }
+        }
+    }
+
+    // The root of each group is its smallest id: groups come out ordered by first id
+    std::vector<std::vector<int>> members(_fingerprints.size());
+    for (int id = 0; id < static_cast<int>(_fingerprints.size()); id++) {
+        members[findRoot(id)].push_back(id);
+    }
+
+    std::vector<std::vector<int>> groups;
+    for (auto& group : members) {
+        if (group.size() >= 2) {
+            groups.push_back(std::move(group));
+        }
+    }
+    return groups;
+}
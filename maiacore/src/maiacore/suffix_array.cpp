@@ -0,0 +1,163 @@
+#include "maiacore/suffix_array.h"
+
+#include <algorithm>
+#include <numeric>  // std::iota
+#include <utility>
+
+#include "maiacore/log.h"
+
+SuffixArray::SuffixArray(const std::vector<int>& text) : _text(text) {
+    const int n = static_cast<int>(_text.size());
+    _suffixArray.resize(n);
+    _lcp.assign(n, 0);
+    if (n == 0) {
+        return;
+    }
+
+    for (const int token : _text) {
+        if (token < 0) {
+            LOG_ERROR("Suffix array tokens must be non-negative");
+        }
+    }
+
+    // ===== SUFFIX ARRAY: PREFIX DOUBLING ===== //
+    // Rank 'r' of round 'k' orders the suffixes by their first 2^k tokens
+    std::iota(_suffixArray.begin(), _suffixArray.end(), 0);
+    std::stable_sort(_suffixArray.begin(), _suffixArray.end(),
+                     [this](const int a, const int b) { return _text[a] < _text[b]; });
+
+    std::vector<int> rank(n);
+    rank[_suffixArray[0]] = 0;
+    for (int i = 1; i < n; i++) {
+        const bool isNewClass = _text[_suffixArray[i]] != _text[_suffixArray[i - 1]];
+        rank[_suffixArray[i]] = rank[_suffixArray[i - 1]] + (isNewClass ? 1 : 0);
+    }
+    int numClasses = rank[_suffixArray[n - 1]] + 1;
+
+    std::vector<int> sortedBySecondKey(n);
+    std::vector<int> newRank(n);
+    std::vector<int> count;
+    for (int k = 1; numClasses < n; k <<= 1) {
+        // Second key: suffixes shorter than 'k' come first, then the others in the current order
+        int p = 0;
+        for (int i = std::max(0, n - k); i < n; i++) {
+            sortedBySecondKey[p++] = i;
+        }
+        for (int i = 0; i < n; i++) {
+            if (_suffixArray[i] >= k) {
+                sortedBySecondKey[p++] = _suffixArray[i] - k;
+            }
+        }
+
+        // First key: stable counting sort by the current rank
+        count.assign(numClasses, 0);
+        for (int i = 0; i < n; i++) {
+            count[rank[i]]++;
+        }
+        for (int c = 1; c < numClasses; c++) {
+            count[c] += count[c - 1];
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            const int suffix = sortedBySecondKey[i];
+            _suffixArray[--count[rank[suffix]]] = suffix;
+        }
+
+        newRank[_suffixArray[0]] = 0;
+        for (int i = 1; i < n; i++) {
+            const int a = _suffixArray[i - 1];
+            const int b = _suffixArray[i];
+            const int aSecond = (a + k < n) ? rank[a + k] : -1;
+            const int bSecond = (b + k < n) ? rank[b + k] : -1;
+            const bool isNewClass = rank[a] != rank[b] || aSecond != bSecond;
+            newRank[b] = newRank[a] + (isNewClass ? 1 : 0);
+        }
+        rank.swap(newRank);
+        numClasses = rank[_suffixArray[n - 1]] + 1;
+    }
+
+    // ===== LCP ARRAY: KASAI ===== //
+    // 'rank' is now the inverse of the suffix array
+    int h = 0;
+    for (int i = 0; i < n; i++) {
+        if (rank[i] == 0) {
+            h = 0;
+            continue;
+        }
+
+        const int j = _suffixArray[rank[i] - 1];
+        while (i + h < n && j + h < n && _text[i + h] == _text[j + h]) {
+            h++;
+        }
+        _lcp[rank[i]] = h;
+        if (h > 0) {
+            h--;
+        }
+    }
+}
+
+size_t SuffixArray::size() const { return _text.size(); }
+
+const std::vector<int>& SuffixArray::getText() const { return _text; }
+
+const std::vector<int>& SuffixArray::getSuffixArray() const { return _suffixArray; }
+
+const std::vector<int>& SuffixArray::getLcpArray() const { return _lcp; }
+
+std::vector<SuffixArray::Repeat> SuffixArray::getMaximalRepeats(const int minLength,
+                                                                const int minNumOccurrences) const {
+    std::vector<Repeat> repeats;
+    const int n = static_cast<int>(_text.size());
+    if (n < 2) {
+        return repeats;
+    }
+
+    const int minRepeatLength = std::max(1, minLength);
+    const int minOccurrences = std::max(2, minNumOccurrences);
+
+    // An LCP interval is left-maximal when its suffixes are not all preceded by the same token.
+    // 'leftChanges[k]' counts the neighbours (k - 1, k) of the suffix array, up to k, whose
+    // preceding tokens differ (or one of them starts the text)
+    std::vector<int> leftChanges(n, 0);
+    for (int k = 1; k < n; k++) {
+        const int a = _suffixArray[k - 1];
+        const int b = _suffixArray[k];
+        const bool differs = a == 0 || b == 0 || _text[a - 1] != _text[b - 1];
+        leftChanges[k] = leftChanges[k - 1] + (differs ? 1 : 0);
+    }
+
+    // Bottom-up traversal of the LCP intervals: each interval [lb, rb] with lcp value 'l' is a
+    // right-maximal repeat of length 'l' that occurs rb - lb + 1 times
+    std::vector<std::pair<int, int>> stack;  // (lcp value, left bound)
+    stack.emplace_back(0, 0);
+    for (int i = 1; i <= n; i++) {
+        const int currentLcp = (i < n) ? _lcp[i] : 0;
+        int leftBound = i - 1;
+
+        while (currentLcp < stack.back().first) {
+            const std::pair<int, int> interval = stack.back();
+            stack.pop_back();
+
+            const int lb = interval.second;
+            const int rb = i - 1;
+            leftBound = lb;
+
+            const bool isLeftMaximal = leftChanges[rb] - leftChanges[lb] > 0;
+            if (interval.first < minRepeatLength || rb - lb + 1 < minOccurrences ||
+                !isLeftMaximal) {
+                continue;
+            }
+
+            Repeat repeat;
+            repeat.length = interval.first;
+            repeat.positions.assign(_suffixArray.begin() + lb, _suffixArray.begin() + rb + 1);
+            std::sort(repeat.positions.begin(), repeat.positions.end());
+            repeats.push_back(std::move(repeat));
+        }
+
+        if (currentLcp > stack.back().first) {
+            stack.emplace_back(currentLcp, leftBound);
+        }
+    }
+
+    return repeats;
+}
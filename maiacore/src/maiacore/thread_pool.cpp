@@ -0,0 +1,167 @@
+#include "maiacore/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>  // std::exception_ptr
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "maiacore/log.h"
+
+namespace {
+
+// Task range [begin, end) of a worker, packed in a single atomic word:
+// the owner and the thieves update it with compare-and-swap
+class TaskRange {
+   public:
+    void set(const uint32_t begin, const uint32_t end) { _range.store(pack(begin, end)); }
+
+    // Owner: takes up to 'chunkSize' tasks from the front
+    bool pop(const uint32_t chunkSize, uint32_t* begin, uint32_t* end) {
+        uint64_t current = _range.load();
+        while (true) {
+            const uint32_t first = current >> 32;
+            const uint32_t last = current & 0xFFFFFFFF;
+            if (first >= last) {
+                return false;
+            }
+
+            const uint32_t next = std::min(last, first + chunkSize);
+            if (_range.compare_exchange_weak(current, pack(next, last))) {
+                *begin = first;
+                *end = next;
+                return true;
+            }
+        }
+    }
+
+    // Thief: takes the back half of the remaining tasks
+    bool steal(uint32_t* begin, uint32_t* end) {
+        uint64_t current = _range.load();
+        while (true) {
+            const uint32_t first = current >> 32;
+            const uint32_t last = current & 0xFFFFFFFF;
+            if (first >= last) {
+                return false;
+            }
+
+            const uint32_t middle = first + (last - first) / 2;
+            if (_range.compare_exchange_weak(current, pack(first, middle))) {
+                *begin = middle;
+                *end = last;
+                return true;
+            }
+        }
+    }
+
+   private:
+    static uint64_t pack(const uint32_t begin, const uint32_t end) {
+        return (static_cast<uint64_t>(begin) << 32) | end;
+    }
+
+    std::atomic<uint64_t> _range{0};
+};
+
+}  // namespace
+
+int ThreadPool::getNumThreads(const int numThreads) {
+    if (numThreads > 0) {
+        return numThreads;
+    }
+
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::parallelFor(const size_t numTasks, const std::function<void(size_t)>& task,
+                             const int numThreads, const size_t chunkSize) {
+    parallelForWithWorker(numTasks, [&task](const size_t taskIdx, const size_t) { task(taskIdx); },
+                          numThreads, chunkSize);
+}
+
+void ThreadPool::parallelForWithWorker(const size_t numTasks,
+                                       const std::function<void(size_t, size_t)>& task,
+                                       const int numThreads, const size_t chunkSize) {
+    if (numTasks == 0) {
+        return;
+    }
+
+    if (numTasks > UINT32_MAX) {
+        LOG_ERROR("Too many tasks: " + std::to_string(numTasks));
+    }
+
+    const size_t numWorkers = std::min(static_cast<size_t>(getNumThreads(numThreads)), numTasks);
+
+    // Sequential: no threads, exceptions are thrown directly
+    if (numWorkers == 1) {
+        for (size_t taskIdx = 0; taskIdx < numTasks; taskIdx++) {
+            task(taskIdx, 0);
+        }
+        return;
+    }
+
+    // Small chunks keep the load balanced, big enough to amortize the atomic operations
+    const uint32_t chunk = static_cast<uint32_t>(
+        (chunkSize > 0) ? chunkSize : std::max<size_t>(1, numTasks / (numWorkers * 16)));
+
+    std::unique_ptr<TaskRange[]> ranges(new TaskRange[numWorkers]);
+    for (size_t w = 0; w < numWorkers; w++) {
+        ranges[w].set(numTasks * w / numWorkers, numTasks * (w + 1) / numWorkers);
+    }
+
+    std::atomic<bool> failed(false);
+    std::exception_ptr firstException = nullptr;
+    std::mutex exceptionMutex;
+
+    auto worker = [&](const size_t workerIdx) {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+
+        while (!failed.load()) {
+            if (!ranges[workerIdx].pop(chunk, &begin, &end)) {
+                // Own range is empty: steal from the other workers
+                bool stolen = false;
+                for (size_t i = 1; i < numWorkers && !stolen; i++) {
+                    stolen = ranges[(workerIdx + i) % numWorkers].steal(&begin, &end);
+                }
+
+                if (!stolen) {
+                    return;
+                }
+
+                ranges[workerIdx].set(begin, end);
+                continue;
+            }
+
+            try {
+                for (uint32_t taskIdx = begin; taskIdx < end; taskIdx++) {
+                    task(taskIdx, workerIdx);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(exceptionMutex);
+                if (firstException == nullptr) {
+                    firstException = std::current_exception();
+                }
+                failed.store(true);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numWorkers - 1);
+    for (size_t w = 1; w < numWorkers; w++) {
+        threads.emplace_back(worker, w);
+    }
+
+    worker(0);
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (firstException != nullptr) {
+        std::rethrow_exception(firstException);
+    }
+}
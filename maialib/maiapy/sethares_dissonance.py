@@ -300,7 +300,9 @@ def plotScoreSetharesDissonance(
        numPoints (int): Number of interpolated points
 
     Returns:
-       A list: [Plotly Figure, The plot data as a Pandas Dataframe]
+       A list: [Plotly Figure, The plot data as a Pandas Dataframe]. The DataFrame columns are
+       'measure', 'floatMeasure', 'key' (key name), 'quarterDuration', 'chordSize', 'chordNotes',
+       'dissonance' and 'isHomophonic'. Use score.getChordsDataFrame() to get the Chord objects.
 
     Raises:
        RuntimeError, KeyError
@@ -319,18 +321,10 @@ def plotScoreSetharesDissonance(
     plotTitle = f"<b>Sethares Sensory Dissonance</b><br><i>{workTitle}</i>"
 
     # ===== COMPUTE THE SETHARES DISSONANCE ===== #
-    df = score.getChordsDataFrame(kwargs)
-
-    df["dissonance"] = df.apply(
-        lambda row: row.chord.getSetharesDissonance(
-            numPartialsPerNote, useMinModel, amplCallback, partialsDecayExpRate, dissCallback
-        ),
-        axis=1,
-    )
-    df["chordNotes"] = df.apply(
-        lambda row: ", ".join([str(x.getPitch()) for x in row.chord.getNotes()]), axis=1
+    timeline = score.getSetharesDissonanceTimeline(
+        kwargs, numPartialsPerNote, useMinModel, amplCallback, partialsDecayExpRate, dissCallback
     )
-    df["chordSize"] = df.apply(lambda row: row.chord.size(), axis=1)
+    df = pd.DataFrame(timeline)
     dissonanceMean = df.dissonance.mean()
 
     # ===== CHECK THE INTERPOLATION POINTS ===== #
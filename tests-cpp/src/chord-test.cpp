@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include <map>
+
 #include "maiacore/note.h"
 using namespace testing;
 
@@ -186,3 +188,157 @@ EXPECT_EQ(myChord02.isInRootPosition(), true);
 Chord myChord03({"F4", "C4", "Bb4"});
 EXPECT_EQ(myChord03.isInRootPosition(), false);
 }
+
+static float setharesTableSum(const Chord& chord, const int numPartials, const bool useMinModel) {
+const SetharesDissonanceTable table = chord.getSetharesDyadsDissonanceValue(numPartials, useMinModel);
+float sum = 0.0f;
+for (const auto& row : table) {
+    sum += std::get<12>(row);
+}
+return sum;
+}
+
+TEST(getSetharesDissonance, matchesDyadsTableMinModel) {
+Chord chord({"C4", "E4", "G4", "Bb4", "D5"});
+const float expected = setharesTableSum(chord, 6, true);
+EXPECT_NEAR(chord.getSetharesDissonance(6, true), expected, expected * 1e-4f);
+}
+
+TEST(getSetharesDissonance, matchesDyadsTableProductModel) {
+Chord chord({"C3", "C#3", "G4", "F#5"});
+const float expected = setharesTableSum(chord, 10, false);
+EXPECT_NEAR(chord.getSetharesDissonance(10, false), expected, expected * 1e-4f);
+}
+
+TEST(getSetharesDissonance, dissCallbackReceivesAllDyads) {
+Chord chord({"C4", "Eb4", "G4"});
+const size_t tableSize = chord.getSetharesDyadsDissonanceValue(6).size();
+
+size_t numValues = 0;
+const float maxValue = chord.getSetharesDissonance(6, true, nullptr, 0.88f, [&numValues](std::vector<float> v) {
+    numValues = v.size();
+    return *std::max_element(v.begin(), v.end());
+});
+
+EXPECT_EQ(numValues, tableSize);
+EXPECT_GT(maxValue, 0.0f);
+}
+
+TEST(getSetharesDissonance, dyadsTableMatchesExactPath) {
+// The identity 'amplCallback' forces the exact path with the same spectrum amplitudes
+const auto defaultAmpls = [](std::vector<float> freqs) {
+    std::vector<float> ampls(freqs.size());
+    for (size_t i = 0; i < freqs.size(); i++) {
+        ampls[i] = std::pow(0.88f, static_cast<float>(i));
+    }
+    return ampls;
+};
+
+const std::vector<std::vector<std::string>> chords = {
+    {"C4", "E4", "G4"}, {"C3", "C4", "G4", "E5"}, {"D4", "D4", "F#4", "A4"},
+    {"C4", "C4", "C4", "Db4"}, {"B2", "F3", "A3", "D4", "G#4"}};
+
+for (const auto& pitches : chords) {
+    Chord chord(pitches);
+    for (const bool useMinModel : {true, false}) {
+        const float expected = chord.getSetharesDissonance(6, useMinModel, defaultAmpls);
+        EXPECT_NEAR(chord.getSetharesDissonance(6, useMinModel), expected, expected * 1e-4f);
+    }
+}
+}
+
+TEST(getSetharesDissonance, analysisContextTuning) {
+const auto defaultAmpls = [](std::vector<float> freqs) {
+    std::vector<float> ampls(freqs.size());
+    for (size_t i = 0; i < freqs.size(); i++) {
+        ampls[i] = std::pow(0.88f, static_cast<float>(i));
+    }
+    return ampls;
+};
+
+Chord chord({"C4", "E4", "G4"});
+const AnalysisContext equal;
+const AnalysisContext just(TuningSystem::JUST_INTONATION);
+
+// Default context: same result as before the context parameter existed
+EXPECT_EQ(chord.getSetharesDissonance(6, true, nullptr, 0.88f, nullptr, equal),
+          chord.getSetharesDissonance());
+
+// Pure major third and fifth: less roughness than equal temperament
+const float justDissonance = chord.getSetharesDissonance(6, false, nullptr, 0.88f, nullptr, just);
+EXPECT_LT(justDissonance, chord.getSetharesDissonance(6, false, nullptr, 0.88f, nullptr, equal));
+
+// Cached tables use the context frequencies
+const float expected = chord.getSetharesDissonance(6, false, defaultAmpls, 0.88f, nullptr, just);
+EXPECT_NEAR(justDissonance, expected, expected * 1e-4f);
+
+const auto spectrum = chord.getHarmonicSpectrum(6, nullptr, 0.88f, just);
+EXPECT_FLOAT_EQ(spectrum.first.front(), just.getFrequency(60));
+}
+
+TEST(getHarmonicSpectrumBatch, matchesNotesSpectra) {
+const std::vector<Chord> chords = {Chord({"C4", "E4", "G4"}), Chord({"A3"}),
+                                   Chord({"D4", "D4", "F#4", "A4"})};
+const AnalysisContext context(TuningSystem::PYTHAGOREAN_TUNING, 442.0f);
+
+HarmonicSpectrumBuffer buffer;
+Chord::getHarmonicSpectrumBatch(chords, &buffer, 5, 0.8f, nullptr, context);
+
+EXPECT_EQ(buffer.numPartials, 5);
+EXPECT_EQ(buffer.chordNoteOffsets, std::vector<size_t>({0, 3, 4, 8}));
+ASSERT_EQ(buffer.frequencies.size(), 8u * 5u);
+ASSERT_EQ(buffer.amplitudes.size(), 8u * 5u);
+
+size_t n = 0;
+for (const auto& chord : chords) {
+    for (int i = 0; i < chord.size(); i++, n++) {
+        const auto spectrum = chord.getNote(i).getHarmonicSpectrum(5, nullptr, 0.8f, context);
+        for (int p = 0; p < 5; p++) {
+            EXPECT_EQ(buffer.frequencies[n * 5 + p], spectrum.first[p]);
+            EXPECT_EQ(buffer.amplitudes[n * 5 + p], spectrum.second[p]);
+        }
+    }
+}
+}
+
+TEST(getHarmonicSpectrumBatch, batchAmplCallbackIsCalledOnce) {
+const std::vector<Chord> chords = {Chord(std::vector<std::string>{"C4", "E4"}), Chord({"G4", "B4", "D5"})};
+
+int numCalls = 0;
+HarmonicSpectrumBuffer buffer;
+Chord::getHarmonicSpectrumBatch(chords, &buffer, 4, 0.88f, [&numCalls](const std::vector<float>& freqs) {
+    numCalls++;
+    return std::vector<float>(freqs.size(), 0.5f);
+});
+
+EXPECT_EQ(numCalls, 1);
+EXPECT_EQ(buffer.amplitudes, std::vector<float>(20, 0.5f));
+
+EXPECT_THROW(Chord::getHarmonicSpectrumBatch(chords, &buffer, 4, 0.88f,
+                                             [](const std::vector<float>&) {
+                                                 return std::vector<float>(3, 1.0f);
+                                             }),
+             std::runtime_error);
+}
+
+TEST(getHarmonicSpectrum, mergesCoincidentPartials) {
+// C3 and C4 share the partials of C4: amplitudes summed in notes order
+Chord chord(std::vector<std::string>{"C4", "C3"});
+const auto spectrum = chord.getHarmonicSpectrum(4, nullptr, 0.5f);
+
+std::map<float, float> expected;
+for (const auto& note : {Note("C4"), Note("C3")}) {
+    const auto noteSpectrum = note.getHarmonicSpectrum(4, nullptr, 0.5f);
+    for (size_t i = 0; i < noteSpectrum.first.size(); i++) {
+        expected[noteSpectrum.first[i]] += noteSpectrum.second[i];
+    }
+}
+
+ASSERT_EQ(spectrum.first.size(), expected.size());
+size_t i = 0;
+for (const auto& freqAmpl : expected) {
+    EXPECT_EQ(spectrum.first[i], freqAmpl.first);
+    EXPECT_EQ(spectrum.second[i], freqAmpl.second);
+    i++;
+}
+}
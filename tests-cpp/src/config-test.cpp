@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
+#include <stdexcept>
+
 #include "maiacore/config.h"
+#include "maiacore/helper.h"
 
 // ============================================================================
 // Initial State Tests
@@ -181,3 +185,88 @@ TEST(ConfigTuningSystem, MultipleGetsSameResult) {
         EXPECT_EQ(getTuningSystem(), TuningSystem::MEANTONE_TEMPERAMENT);
     }
 }
+
+// ============================================================================
+// AnalysisContext Tests
+// ============================================================================
+
+TEST(ConfigAnalysisContext, DefaultIsEqualTemperament440) {
+    const AnalysisContext context;
+
+    EXPECT_EQ(context.getTuningSystem(), TuningSystem::EQUAL_TEMPERAMENT);
+    EXPECT_FLOAT_EQ(context.getFreqA4(), 440.0f);
+}
+
+TEST(ConfigAnalysisContext, EqualTemperamentMatchesMidiNote2Freq) {
+    const AnalysisContext context440;
+    const AnalysisContext context415(TuningSystem::EQUAL_TEMPERAMENT, 415.0f);
+
+    for (int midi = 0; midi < 140; midi++) {
+        EXPECT_EQ(context440.getFrequency(midi), Helper::midiNote2freq(midi, 440.0f));
+        EXPECT_EQ(context415.getFrequency(midi), Helper::midiNote2freq(midi, 415.0f));
+    }
+
+    EXPECT_EQ(context440.getFrequency(-1), 0.0f);
+}
+
+TEST(ConfigAnalysisContext, EqualTemperamentFrequencyTable) {
+    const AnalysisContext context415(TuningSystem::EQUAL_TEMPERAMENT, 415.0f);
+    const auto table = context415.getFrequencyTable();
+
+    for (int midi = 0; midi < 128; midi++) {
+        EXPECT_EQ(table[midi], Helper::midiNote2freq(midi, 415.0f));
+    }
+}
+
+TEST(ConfigAnalysisContext, RejectsInvalidA4) {
+    EXPECT_THROW(AnalysisContext(TuningSystem::EQUAL_TEMPERAMENT, 0.0f), std::runtime_error);
+    EXPECT_THROW(AnalysisContext(TuningSystem::JUST_INTONATION, -440.0f), std::runtime_error);
+    EXPECT_THROW(AnalysisContext(TuningSystem::EQUAL_TEMPERAMENT, std::nanf("")),
+                 std::runtime_error);
+    EXPECT_THROW(AnalysisContext(TuningSystem::WELL_TEMPERAMENT, INFINITY), std::runtime_error);
+}
+
+TEST(ConfigAnalysisContext, A4SweepKeepsTablesCorrect) {
+    // More A4 values than the cache holds: evicted tables must still be rebuilt correctly
+    for (int step = 0; step < 100; step++) {
+        const float freqA4 = 400.0f + 0.5f * step;
+        const AnalysisContext context(TuningSystem::JUST_INTONATION, freqA4);
+        EXPECT_FLOAT_EQ(context.getFrequency(69), freqA4);
+        EXPECT_FLOAT_EQ(context.getFrequency(76) / context.getFrequency(69), 3.0f / 2.0f);
+    }
+}
+
+TEST(ConfigAnalysisContext, A4IsTheReferenceInAllTunings) {
+    const TuningSystem systems[] = {
+        TuningSystem::EQUAL_TEMPERAMENT, TuningSystem::JUST_INTONATION,
+        TuningSystem::PYTHAGOREAN_TUNING, TuningSystem::MEANTONE_TEMPERAMENT,
+        TuningSystem::WELL_TEMPERAMENT};
+
+    for (const auto& system : systems) {
+        const AnalysisContext context(system, 430.0f);
+        EXPECT_FLOAT_EQ(context.getFrequency(69), 430.0f);
+        EXPECT_FLOAT_EQ(context.getFrequency(81), 860.0f);
+        EXPECT_FLOAT_EQ(context.getFrequency(141), 4.0f * context.getFrequency(117));
+    }
+}
+
+TEST(ConfigAnalysisContext, TuningRatios) {
+    const AnalysisContext just(TuningSystem::JUST_INTONATION);
+    EXPECT_FLOAT_EQ(just.getFrequency(64) / just.getFrequency(60), 5.0f / 4.0f);  // C4-E4
+    EXPECT_FLOAT_EQ(just.getFrequency(67) / just.getFrequency(60), 3.0f / 2.0f);  // C4-G4
+
+    const AnalysisContext pythagorean(TuningSystem::PYTHAGOREAN_TUNING);
+    EXPECT_FLOAT_EQ(pythagorean.getFrequency(64) / pythagorean.getFrequency(60), 81.0f / 64.0f);
+
+    const AnalysisContext meantone(TuningSystem::MEANTONE_TEMPERAMENT);
+    EXPECT_FLOAT_EQ(meantone.getFrequency(64) / meantone.getFrequency(60), 5.0f / 4.0f);
+}
+
+TEST(ConfigAnalysisContext, GlobalTuningSystemIsNotUsed) {
+    setTuningSystem(TuningSystem::JUST_INTONATION);
+    const AnalysisContext context;
+    setTuningSystem(TuningSystem::EQUAL_TEMPERAMENT);
+
+    EXPECT_EQ(context.getTuningSystem(), TuningSystem::EQUAL_TEMPERAMENT);
+    EXPECT_EQ(context.getFrequency(64), Helper::midiNote2freq(64));
+}
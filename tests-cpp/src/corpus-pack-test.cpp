@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "maiacore/corpus_pack.h"
+#include "maiacore/score_collection.h"
+
+namespace {
+
+const std::string BACH_DIR = "./test/xml_examples/Bach";
+const std::string QUARTET_FILE = "./test/xml_examples/Beethoven/Beethoven_quartet_133.xml";
+const std::string COMPRESSED_FILE = "./test/xml_examples/unit_test/test_compressed_file.mxl";
+
+std::string tempPackPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+void expectSameScore(const Score& loaded, const Score& original) {
+    EXPECT_EQ(loaded.getFilePath(), original.getFilePath());
+    EXPECT_EQ(loaded.getFileName(), original.getFileName());
+    EXPECT_EQ(loaded.getTitle(), original.getTitle());
+    EXPECT_EQ(loaded.getComposerName(), original.getComposerName());
+    EXPECT_EQ(loaded.getPartsNames(), original.getPartsNames());
+    EXPECT_EQ(loaded.getNumMeasures(), original.getNumMeasures());
+    EXPECT_EQ(loaded.getNumNotes(), original.getNumNotes());
+}
+
+}  // namespace
+
+TEST(CorpusPack, BuildFromDirectory) {
+    const std::string packPath = tempPackPath("maiacore-corpus-pack-test.mpk");
+    ASSERT_EQ(CorpusPack::build(BACH_DIR, packPath, DirectoryScanner(), 2), 2);
+
+    const CorpusPack pack(packPath);
+    ASSERT_EQ(pack.getNumScores(), 2);
+
+    // Path order, same metadata and scores of the files
+    const ScoreCollection collection(BACH_DIR);
+    for (int scoreIdx = 0; scoreIdx < 2; scoreIdx++) {
+        const Score& original = collection.getScore(scoreIdx);
+        const CorpusPack::Entry entry = pack.getEntry(scoreIdx);
+        EXPECT_EQ(entry.filePath, original.getFilePath());
+        EXPECT_EQ(entry.fileName, original.getFileName());
+        EXPECT_EQ(entry.title, original.getTitle());
+        EXPECT_EQ(entry.composerName, original.getComposerName());
+        EXPECT_EQ(entry.partsNames, original.getPartsNames());
+        EXPECT_EQ(entry.numParts, original.getNumParts());
+        EXPECT_EQ(entry.numMeasures, original.getNumMeasures());
+        EXPECT_EQ(entry.numNotes, original.getNumNotes());
+
+        const auto loaded = pack.loadScore(scoreIdx);
+        expectSameScore(*loaded, original);
+
+        const std::vector<Note> pattern = {Note("C4"), Note("E4"), Note("G4")};
+        EXPECT_EQ(loaded->findMelodyPattern(pattern, 0.3f, 0.3f),
+                  original.findMelodyPattern(pattern, 0.3f, 0.3f));
+    }
+
+    EXPECT_EQ(pack.findScore("prelude_1_BWV_846.xml"), 1);
+    EXPECT_EQ(pack.findScore("missing.xml"), -1);
+    EXPECT_THROW(pack.getEntry(2), std::runtime_error);
+
+    std::remove(packPath.c_str());
+}
+
+TEST(CorpusPack, CollectionRoundTrip) {
+    const std::string packPath = tempPackPath("maiacore-corpus-pack-collection.mpk");
+
+    ScoreCollection collection(BACH_DIR);
+    collection.addScore(QUARTET_FILE);
+    collection.addScore(COMPRESSED_FILE);
+    collection.savePack(packPath, 2);
+
+    ScoreCollection loaded(std::vector<std::string>{});
+    loaded.loadPack(packPath, {}, 2);
+    ASSERT_EQ(loaded.getNumScores(), collection.getNumScores());
+    for (int scoreIdx = 0; scoreIdx < collection.getNumScores(); scoreIdx++) {
+        expectSameScore(loaded.getScore(scoreIdx), collection.getScore(scoreIdx));
+    }
+
+    // Selection by metadata: only the selected scores are parsed
+    const CorpusPack pack(packPath);
+    const std::vector<int> quartets = pack.selectScores(
+        [](const CorpusPack::Entry& entry) { return entry.numParts == 4; });
+    ASSERT_FALSE(quartets.empty());
+
+    ScoreCollection selected(std::vector<std::string>{});
+    selected.loadPack(pack, quartets);
+    ASSERT_EQ(selected.getNumScores(), static_cast<int>(quartets.size()));
+    for (size_t i = 0; i < quartets.size(); i++) {
+        EXPECT_EQ(selected.getScore(i).getFileName(), pack.getEntry(quartets[i]).fileName);
+    }
+    EXPECT_THROW(selected.loadPack(pack, {collection.getNumScores()}), std::runtime_error);
+
+    std::remove(packPath.c_str());
+}
+
+TEST(CorpusPack, SavesEditedScores) {
+    const std::string packPath = tempPackPath("maiacore-corpus-pack-edited.mpk");
+
+    ScoreCollection collection(std::vector<std::string>{});
+    collection.addScore(BACH_DIR + "/prelude_1_BWV_846.xml");
+    Score& score = collection.getScore(0);
+    const int numMeasures = score.getNumMeasures();
+    score.setTitle("Edited prelude");
+    score.removeMeasure(numMeasures - 1, numMeasures - 1);
+    score.getPart(0).getMeasure(0).getNote(0).setPitch("D#4");
+    collection.savePack(packPath);
+
+    // The document is written from the edited score, so it matches the metadata
+    const CorpusPack pack(packPath);
+    const CorpusPack::Entry entry = pack.getEntry(0);
+    EXPECT_EQ(entry.title, "Edited prelude");
+    EXPECT_EQ(entry.numMeasures, numMeasures - 1);
+
+    const auto loaded = pack.loadScore(0);
+    EXPECT_EQ(loaded->getTitle(), entry.title);
+    EXPECT_EQ(loaded->getNumMeasures(), entry.numMeasures);
+    EXPECT_EQ(loaded->getNumNotes(), entry.numNotes);
+    EXPECT_EQ(loaded->getPartsNames(), score.getPartsNames());
+    EXPECT_EQ(loaded->getPart(0).getMeasure(0).getNote(0).getPitch(), "D#4");
+
+    std::remove(packPath.c_str());
+}
+
+TEST(CorpusPack, RejectsInvalidFiles) {
+    const std::string packPath = tempPackPath("maiacore-corpus-pack-invalid.mpk");
+    {
+        std::ofstream file(packPath, std::ios::binary);
+        file << "not a corpus pack, only some text long enough for a header";
+    }
+    EXPECT_THROW(CorpusPack pack(packPath), std::runtime_error);
+
+    // Destination that cannot be written
+    EXPECT_THROW(CorpusPack::save({}, "/nonexistent-directory/pack.mpk"), std::runtime_error);
+
+    std::remove(packPath.c_str());
+}
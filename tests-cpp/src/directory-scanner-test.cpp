@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "maiacore/directory_scanner.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Temporary directory tree, removed at the end of the test
+class ScannerTree {
+   public:
+    explicit ScannerTree(const std::string& name)
+        : _root(fs::temp_directory_path() / name) {
+        fs::remove_all(_root);
+        fs::create_directories(_root / "baroque" / "drafts");
+        fs::create_directories(_root / ".cache");
+        write("a.xml");
+        write("b.musicxml");
+        write("notes.txt");
+        write("baroque/c.mxl");
+        write("baroque/drafts/d.xml");
+        write(".cache/e.xml");
+    }
+
+    ~ScannerTree() { fs::remove_all(_root); }
+
+    std::string path() const { return _root.string(); }
+
+    void write(const std::string& relativePath, const std::string& content = "<score/>") const {
+        std::ofstream(_root / relativePath) << content;
+    }
+
+    std::vector<std::string> relativePaths(const std::vector<DirectoryScanner::FileInfo>& files) const {
+        std::vector<std::string> paths;
+        for (const auto& file : files) {
+            paths.push_back(fs::path(file.filePath).lexically_relative(_root).generic_string());
+        }
+        return paths;
+    }
+
+   private:
+    fs::path _root;
+};
+
+}  // namespace
+
+// ============================================================================
+// Glob Tests
+// ============================================================================
+
+TEST(DirectoryScannerGlob, Wildcards) {
+    EXPECT_TRUE(DirectoryScanner::matchGlob("*.xml", "bach.xml"));
+    EXPECT_FALSE(DirectoryScanner::matchGlob("*.xml", "bach.mxl"));
+    EXPECT_FALSE(DirectoryScanner::matchGlob("*.xml", "dir/bach.xml"));
+    EXPECT_TRUE(DirectoryScanner::matchGlob("bwv_8??.xml", "bwv_846.xml"));
+    EXPECT_TRUE(DirectoryScanner::matchGlob("[a-c]*.xml", "bach.xml"));
+    EXPECT_FALSE(DirectoryScanner::matchGlob("[!a-c]*.xml", "bach.xml"));
+    EXPECT_TRUE(DirectoryScanner::matchGlob("**/*.xml", "bach.xml"));
+    EXPECT_TRUE(DirectoryScanner::matchGlob("**/*.xml", "baroque/bach/bwv.xml"));
+    EXPECT_TRUE(DirectoryScanner::matchGlob("baroque/**", "baroque/bach/bwv.xml"));
+    EXPECT_FALSE(DirectoryScanner::matchGlob("baroque/*", "baroque/bach/bwv.xml"));
+}
+
+// ============================================================================
+// Scan Tests
+// ============================================================================
+
+TEST(DirectoryScannerScan, DefaultIsFlatMusicXml) {
+    const ScannerTree tree("maiacore-scanner-flat-test");
+    const DirectoryScanner scanner;
+
+    const auto files = scanner.scan(tree.path());
+    EXPECT_EQ(tree.relativePaths(files), std::vector<std::string>({"a.xml", "b.musicxml"}));
+    EXPECT_EQ(files[0].size, 8u);
+    EXPECT_EQ(files[0].hash, 0u);  // Only metadata
+
+    EXPECT_THROW(scanner.scan(tree.path() + "/missing"), std::runtime_error);
+}
+
+TEST(DirectoryScannerScan, RecursiveWithExcludes) {
+    const ScannerTree tree("maiacore-scanner-recursive-test");
+
+    const DirectoryScanner all(true, {"*.xml", "*.mxl", "*.musicxml"});
+    EXPECT_EQ(tree.relativePaths(all.scan(tree.path())),
+              std::vector<std::string>({".cache/e.xml", "a.xml", "b.musicxml", "baroque/c.mxl",
+                                        "baroque/drafts/d.xml"}));
+
+    // Hidden and draft directories are skipped; relative path patterns
+    const DirectoryScanner filtered(true, {"*.xml", "baroque/*.mxl"}, {".*", "drafts"});
+    EXPECT_EQ(tree.relativePaths(filtered.scan(tree.path())),
+              std::vector<std::string>({"a.xml", "baroque/c.mxl"}));
+}
+
+TEST(DirectoryScannerScan, HashFollowsContent) {
+    const ScannerTree tree("maiacore-scanner-hash-test");
+    const std::string filePath = tree.path() + "/a.xml";
+
+    const uint64_t hash = DirectoryScanner::hashFile(filePath);
+    EXPECT_NE(hash, 0u);
+    EXPECT_EQ(DirectoryScanner::hashFile(filePath), hash);
+
+    tree.write("a.xml", "<score></score>");
+    EXPECT_NE(DirectoryScanner::hashFile(filePath), hash);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "maiacore/harmonic_index.h"
+
+namespace {
+
+HarmonicSlice makeSlice(const int degree, const int rootPitchClass, const std::string& quality) {
+    HarmonicSlice slice;
+    slice.degree = degree;
+    slice.rootPitchClass = rootPitchClass;
+    slice.quality = quality;
+    return slice;
+}
+
+std::vector<int> starts(const std::vector<ChordProgressionQuery::Match>& matches) {
+    std::vector<int> result;
+    for (const auto& match : matches) {
+        result.push_back(match.start);
+    }
+    return result;
+}
+
+// C major: ii V I vi ii V vi I
+const std::vector<HarmonicSlice> C_MAJOR_SEQUENCE = {
+    makeSlice(2, 2, "minor"), makeSlice(5, 7, "major"), makeSlice(1, 0, "major"),
+    makeSlice(6, 9, "minor"), makeSlice(2, 2, "minor"), makeSlice(5, 7, "major"),
+    makeSlice(6, 9, "minor"), makeSlice(1, 0, "major")};
+
+}  // namespace
+
+// ============================================================================
+// Chord Progression Query Tests
+// ============================================================================
+
+TEST(ChordProgressionQuery, RomanNumeralsAndQualities) {
+    const ChordProgressionQuery query("ii:minor V:major I");
+    EXPECT_EQ(query.size(), 3);
+    EXPECT_EQ(query.getProgression(), "ii:minor V:major I");
+    EXPECT_EQ(starts(query.findAll(C_MAJOR_SEQUENCE)), std::vector<int>({0}));
+
+    // Deceptive cadence
+    EXPECT_EQ(starts(ChordProgressionQuery("V VI").findAll(C_MAJOR_SEQUENCE)),
+              std::vector<int>({5}));
+    EXPECT_EQ(starts(ChordProgressionQuery("V VI:major").findAll(C_MAJOR_SEQUENCE)),
+              std::vector<int>());
+
+    const auto matches = ChordProgressionQuery("II V").findAll(C_MAJOR_SEQUENCE);
+    EXPECT_EQ(starts(matches), std::vector<int>({0, 4}));
+    EXPECT_EQ(matches[0].length, 2);
+}
+
+TEST(ChordProgressionQuery, WildcardsAndRelativeRoots) {
+    EXPECT_EQ(starts(ChordProgressionQuery("* V").findAll(C_MAJOR_SEQUENCE)),
+              std::vector<int>({0, 4}));
+    EXPECT_EQ(starts(ChordProgressionQuery("*:minor *:major *:major").findAll(C_MAJOR_SEQUENCE)),
+              std::vector<int>({0}));
+
+    // ii-V-I as root motion: the same query matches the progression in G major
+    const ChordProgressionQuery iiVI("@:minor @+5:major @-7:major");
+    EXPECT_EQ(starts(iiVI.findAll(C_MAJOR_SEQUENCE)), std::vector<int>({0}));
+
+    const std::vector<HarmonicSlice> gMajorInC = {
+        makeSlice(6, 9, "minor"), makeSlice(2, 2, "major"), makeSlice(5, 7, "major")};
+    EXPECT_EQ(starts(iiVI.findAll(gMajorInC)), std::vector<int>({0}));
+    EXPECT_TRUE(ChordProgressionQuery("II V I").findAll(gMajorInC).empty());
+
+    // Chords without a root only match '*'
+    const std::vector<HarmonicSlice> unknownRoot = {makeSlice(0, -1, "indeterminate"),
+                                                    makeSlice(5, 7, "major")};
+    EXPECT_TRUE(ChordProgressionQuery("@ V").findAll(unknownRoot).empty());
+    EXPECT_EQ(starts(ChordProgressionQuery("* V").findAll(unknownRoot)), std::vector<int>({0}));
+    EXPECT_TRUE(ChordProgressionQuery("* @+5").findAll(unknownRoot).empty());
+}
+
+TEST(ChordProgressionQuery, InvalidQueriesThrow) {
+    EXPECT_THROW(ChordProgressionQuery(""), std::runtime_error);
+    EXPECT_THROW(ChordProgressionQuery("II VIII"), std::runtime_error);
+    EXPECT_THROW(ChordProgressionQuery("@+5 I"), std::runtime_error);
+    EXPECT_THROW(ChordProgressionQuery("I @5"), std::runtime_error);
+    EXPECT_THROW(ChordProgressionQuery("I @+x"), std::runtime_error);
+    EXPECT_THROW(ChordProgressionQuery("I V:"), std::runtime_error);
+}
@@ -343,3 +343,40 @@ EXPECT_EQ(Helper::midiNote2octave(MUSIC_XML::MIDI::NUMBER::MIDI_069), 4);
 EXPECT_EQ(Helper::midiNote2octave(MUSIC_XML::MIDI::NUMBER::MIDI_070), 4);
 EXPECT_EQ(Helper::midiNote2octave(MUSIC_XML::MIDI::NUMBER::MIDI_071), 4);
 }
+
+TEST(setharesDissonance, unisonHasNoRoughness) {
+EXPECT_FLOAT_EQ(Helper::setharesDissonance({440.0f, 440.0f}, {1.0f, 1.0f}), 0.0f);
+}
+
+TEST(setharesDissonance, unsortedPartials) {
+const std::vector<float> freqs = {880.0f, 440.0f, 466.16f, 1320.0f, 932.33f};
+const std::vector<float> ampls = {0.88f, 1.0f, 1.0f, 0.77f, 0.88f};
+const std::vector<float> sortedFreqs = {440.0f, 466.16f, 880.0f, 932.33f, 1320.0f};
+const std::vector<float> sortedAmpls = {1.0f, 1.0f, 0.88f, 0.88f, 0.77f};
+
+const float expected = Helper::setharesDissonance(sortedFreqs, sortedAmpls);
+EXPECT_GT(expected, 0.0f);
+EXPECT_NEAR(Helper::setharesDissonance(freqs, ampls), expected, 1e-5f);
+}
+
+TEST(setharesDissonance, dyadsDissonanceOutput) {
+std::vector<float> freqs;
+std::vector<float> ampls;
+for (int i = 1; i <= 20; i++) {
+    freqs.push_back(261.63f * i);
+    ampls.push_back(std::pow(0.88f, i - 1));
+    freqs.push_back(277.18f * i);
+    ampls.push_back(std::pow(0.88f, i - 1));
+}
+
+std::vector<float> dyads;
+const float total = Helper::setharesDissonance(freqs, ampls, false, &dyads);
+
+EXPECT_EQ(dyads.size(), freqs.size() * (freqs.size() - 1) / 2);
+EXPECT_NEAR(std::accumulate(dyads.begin(), dyads.end(), 0.0f), total, total * 1e-4f);
+EXPECT_NEAR(Helper::setharesDissonance(freqs, ampls, false), total, total * 1e-4f);
+}
+
+TEST(setharesDissonance, sizeMismatchThrows) {
+EXPECT_THROW(Helper::setharesDissonance({440.0f, 880.0f}, {1.0f}), std::runtime_error);
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "maiacore/melody_corpus_index.h"
+#include "maiacore/score_collection.h"
+
+namespace {
+
+const std::string BACH_DIR = "./test/xml_examples/Bach";
+const std::string QUARTET_FILE = "./test/xml_examples/Beethoven/Beethoven_quartet_133.xml";
+
+std::string tempIndexPath(const std::string& name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+// Same arguments of the scan of the scores, with 1 thread
+auto search(const ScoreCollection& collection, const std::vector<Note>& pattern,
+            const float threshold) {
+    return collection.findMelodyPattern(pattern, threshold, threshold, nullptr, nullptr, nullptr,
+                                        nullptr, nullptr, MelodySimilarityMetric::EUCLIDEAN, 2, 1);
+}
+
+const std::vector<Note> SHORT_PATTERN = {Note("C4"), Note("E4"), Note("G4")};
+
+// 4 intervals: with a high threshold the candidates come from the posting lists
+const std::vector<Note> LONG_PATTERN = {Note("G4"), Note("F4"), Note("E4"), Note("D4"),
+                                        Note("C4")};
+
+}  // namespace
+
+TEST(MelodyCorpusIndex, IndexedSearchMatchesScan) {
+    ScoreCollection collection(BACH_DIR);
+    collection.addScore(QUARTET_FILE);
+    ASSERT_EQ(collection.getNumScores(), 3);
+
+    const auto shortScan = search(collection, SHORT_PATTERN, 0.3f);
+    const auto longScan = search(collection, LONG_PATTERN, 0.6f);
+    ASSERT_GT(shortScan.size(), 5u);
+    ASSERT_GT(longScan.size(), 0u);
+
+    collection.buildMelodyIndex();
+    ASSERT_TRUE(collection.hasMelodyIndex());
+    EXPECT_EQ(collection.getMelodyIndex()->getNumScores(), 3);
+
+    EXPECT_EQ(search(collection, SHORT_PATTERN, 0.3f), shortScan);
+    EXPECT_EQ(search(collection, LONG_PATTERN, 0.6f), longScan);
+
+    // Multiple patterns: same tables
+    const std::vector<std::vector<Note>> patterns = {SHORT_PATTERN, LONG_PATTERN};
+    const auto indexedTables = collection.findMelodyPattern(patterns, 0.5f, 0.5f);
+    collection.clearMelodyIndex();
+    EXPECT_FALSE(collection.hasMelodyIndex());
+    EXPECT_EQ(collection.findMelodyPattern(patterns, 0.5f, 0.5f), indexedTables);
+}
+
+TEST(MelodyCorpusIndex, SaveAndSearchWithoutScores) {
+    const std::string indexPath = tempIndexPath("maiacore-melody-index-test.mci");
+
+    ScoreCollection collection(BACH_DIR);
+    collection.addScore(QUARTET_FILE);
+    const auto scan = search(collection, LONG_PATTERN, 0.6f);
+
+    collection.buildMelodyIndex(2);
+    collection.saveMelodyIndex(indexPath);
+
+    // Index-only collection: the file is mapped, no score is loaded
+    ScoreCollection indexOnly(std::vector<std::string>{});
+    indexOnly.loadMelodyIndex(indexPath);
+    EXPECT_EQ(indexOnly.getNumScores(), 0);
+    EXPECT_EQ(indexOnly.getMelodyIndex()->getNumScores(), 3);
+    EXPECT_EQ(indexOnly.getMelodyIndex()->getNumSegments(), 1);
+    EXPECT_EQ(indexOnly.getMelodyIndex()->getScoreInfo(2).fileName,
+              collection.getScores()[2]->getFileName());
+    EXPECT_EQ(search(indexOnly, LONG_PATTERN, 0.6f), scan);
+
+    // The scores are needed for custom similarities
+    EXPECT_THROW(indexOnly.findMelodyPattern(LONG_PATTERN, 0.6f, 0.6f, nullptr, nullptr, nullptr,
+                                             nullptr, nullptr, MelodySimilarityMetric::DTW),
+                 std::runtime_error);
+
+    std::remove(indexPath.c_str());
+}
+
+TEST(MelodyCorpusIndex, IncrementalUpdates) {
+    const std::string indexPath = tempIndexPath("maiacore-melody-index-update-test.mci");
+
+    ScoreCollection full(BACH_DIR);
+    full.addScore(QUARTET_FILE);
+    full.buildMelodyIndex();
+    full.saveMelodyIndex(indexPath);
+
+    // Opened by a collection without the quartet: its entry is removed
+    ScoreCollection collection(BACH_DIR);
+    collection.loadMelodyIndex(indexPath);
+    EXPECT_EQ(collection.getMelodyIndex()->getNumScores(), 2);
+    EXPECT_EQ(collection.getMelodyIndex()->getNumSegments(), 1);
+
+    ScoreCollection reference(BACH_DIR);
+    EXPECT_EQ(search(collection, SHORT_PATTERN, 0.3f), search(reference, SHORT_PATTERN, 0.3f));
+
+    // Copies share the index until one of them changes
+    ScoreCollection copy = collection;
+    copy.addScore(QUARTET_FILE);
+    EXPECT_EQ(copy.getMelodyIndex()->getNumScores(), 3);
+    EXPECT_EQ(copy.getMelodyIndex()->getNumSegments(), 2);
+    EXPECT_EQ(collection.getMelodyIndex()->getNumScores(), 2);
+    EXPECT_EQ(search(copy, LONG_PATTERN, 0.6f), search(full, LONG_PATTERN, 0.6f));
+
+    copy.removeScore(0);
+    reference.addScore(QUARTET_FILE);
+    reference.removeScore(0);
+    EXPECT_EQ(copy.getMelodyIndex()->getNumScores(), 2);
+    EXPECT_EQ(search(copy, SHORT_PATTERN, 0.3f), search(reference, SHORT_PATTERN, 0.3f));
+
+    // Saving compacts the live entries in a single segment
+    copy.saveMelodyIndex(indexPath);
+    const MelodyCorpusIndex reopened(indexPath);
+    EXPECT_EQ(reopened.getNumScores(), 2);
+    EXPECT_EQ(reopened.getNumSegments(), 1);
+    EXPECT_EQ(reopened.getScoreInfo(1).fileName, copy.getScores()[1]->getFileName());
+
+    std::remove(indexPath.c_str());
+}
+
+TEST(MelodyCorpusIndex, InvalidFiles) {
+    const std::string indexPath = tempIndexPath("maiacore-melody-index-invalid-test.mci");
+    {
+        std::ofstream file(indexPath, std::ios::binary);
+        file << "not a melody index, just some text";
+    }
+
+    EXPECT_THROW(MelodyCorpusIndex{indexPath}, std::runtime_error);
+    EXPECT_THROW(MelodyCorpusIndex{indexPath + ".missing"}, std::runtime_error);
+
+    ScoreCollection collection(std::vector<std::string>{});
+    EXPECT_THROW(collection.saveMelodyIndex(indexPath), std::runtime_error);
+
+    MelodyCorpusIndex index;
+    EXPECT_THROW(index.removeScore(0), std::runtime_error);
+
+    std::remove(indexPath.c_str());
+}
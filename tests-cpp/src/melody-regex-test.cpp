@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "maiacore/melody_regex.h"
+
+namespace {
+
+// Melody from MIDI numbers (0 = rest), one quarter note each
+std::vector<MelodyRegex::Event> toEvents(const std::vector<int>& midiNumbers) {
+    std::vector<MelodyRegex::Event> events;
+    int previousMidi = -1;
+    for (const int midi : midiNumbers) {
+        MelodyRegex::Event event;
+        event.quarterDuration = 1.0f;
+        event.isRest = midi == 0;
+        if (!event.isRest) {
+            event.hasInterval = previousMidi >= 0;
+            event.interval = event.hasInterval ? midi - previousMidi : 0;
+            previousMidi = midi;
+        }
+        events.push_back(event);
+    }
+    return events;
+}
+
+std::vector<std::pair<int, int>> toPairs(const std::vector<MelodyRegex::Match>& matches) {
+    std::vector<std::pair<int, int>> pairs;
+    for (const auto& match : matches) {
+        pairs.emplace_back(match.start, match.length);
+    }
+    return pairs;
+}
+
+}  // namespace
+
+// ============================================================================
+// Melody Regex Parsing Tests
+// ============================================================================
+
+TEST(MelodyRegexParsing, EventConditions) {
+    MelodyRegex::Event event;
+    event.hasInterval = true;
+    event.interval = -2;
+    event.quarterDuration = 1.5f;
+    event.numDots = 1;
+
+    EXPECT_TRUE(MelodyRegex("[i=-2]").matchesEvent(event));
+    EXPECT_TRUE(MelodyRegex("[i=-2..-1 down note]").matchesEvent(event));
+    EXPECT_TRUE(MelodyRegex("[i<0 d>=1.5 dotted]").matchesEvent(event));
+    EXPECT_TRUE(MelodyRegex("N").matchesEvent(event));
+    EXPECT_TRUE(MelodyRegex(".").matchesEvent(event));
+    EXPECT_FALSE(MelodyRegex("[up]").matchesEvent(event));
+    EXPECT_FALSE(MelodyRegex("[i<-2]").matchesEvent(event));
+    EXPECT_FALSE(MelodyRegex("[d<1.5]").matchesEvent(event));
+    EXPECT_FALSE(MelodyRegex("R").matchesEvent(event));
+
+    // The first note of a melody has no interval
+    event.hasInterval = false;
+    EXPECT_FALSE(MelodyRegex("[same]").matchesEvent(event));
+    EXPECT_TRUE(MelodyRegex("[d=1.5]").matchesEvent(event));
+}
+
+TEST(MelodyRegexParsing, InvalidExpressionsThrow) {
+    EXPECT_THROW(MelodyRegex(""), std::runtime_error);
+    EXPECT_THROW(MelodyRegex("[i=+3"), std::runtime_error);
+    EXPECT_THROW(MelodyRegex("(N N"), std::runtime_error);
+    EXPECT_THROW(MelodyRegex("[foo]"), std::runtime_error);
+    EXPECT_THROW(MelodyRegex("[i=1.5]"), std::runtime_error);
+    EXPECT_THROW(MelodyRegex("[note rest]"), std::runtime_error);
+    EXPECT_THROW(MelodyRegex("N{3,1}"), std::runtime_error);
+    EXPECT_THROW(MelodyRegex("N|"), std::runtime_error);
+    EXPECT_THROW(MelodyRegex("*N"), std::runtime_error);
+
+    // Expressions that match an empty melody
+    EXPECT_THROW(MelodyRegex("N*"), std::runtime_error);
+    EXPECT_THROW(MelodyRegex("[up]? R{0,2}"), std::runtime_error);
+}
+
+// ============================================================================
+// Melody Regex Search Tests
+// ============================================================================
+
+TEST(MelodyRegexSearch, TranspositionInvariantMatches) {
+    // C E E E D | G B A : rising minor/major third, repeated notes, descending step
+    const auto events = toEvents({60, 64, 64, 64, 62, 67, 70, 68});
+    const MelodyRegex regex("[i=+3..+4] [same]* [i=-2..-1]");
+
+    // The match starts at the note that completes the first interval
+    EXPECT_EQ(toPairs(regex.findAll(events)),
+              (std::vector<std::pair<int, int>>{{1, 4}, {6, 2}}));
+}
+
+TEST(MelodyRegexSearch, LeftmostLongestNonOverlapping) {
+    const auto events = toEvents({60, 62, 64, 65, 67, 65});
+
+    EXPECT_EQ(toPairs(MelodyRegex("[up]+").findAll(events)),
+              (std::vector<std::pair<int, int>>{{1, 4}}));
+    EXPECT_EQ(toPairs(MelodyRegex("[up]{2}").findAll(events)),
+              (std::vector<std::pair<int, int>>{{1, 2}, {3, 2}}));
+    EXPECT_EQ(toPairs(MelodyRegex("[up]{1,2} [down]").findAll(events)),
+              (std::vector<std::pair<int, int>>{{3, 3}}));
+    EXPECT_EQ(toPairs(MelodyRegex(". .").findAll(events)),
+              (std::vector<std::pair<int, int>>{{0, 2}, {2, 2}, {4, 2}}));
+}
+
+TEST(MelodyRegexSearch, RestsAndAlternation) {
+    // Intervals skip the rests: 64 -> rest -> 62 is a descending step
+    const auto events = toEvents({60, 64, 0, 62, 0, 0, 65});
+
+    EXPECT_EQ(toPairs(MelodyRegex("R+").findAll(events)),
+              (std::vector<std::pair<int, int>>{{2, 1}, {4, 2}}));
+    EXPECT_EQ(toPairs(MelodyRegex("[up] R [i=-2]").findAll(events)),
+              (std::vector<std::pair<int, int>>{{1, 3}}));
+    EXPECT_EQ(toPairs(MelodyRegex("([i=+3] | [i=+4]) (R | [down])*").findAll(events)),
+              (std::vector<std::pair<int, int>>{{1, 5}, {6, 1}}));
+    EXPECT_TRUE(MelodyRegex("[i=+7]").findAll(events).empty());
+}
+
+TEST(MelodyRegexSearch, MatchesBruteForceOnRandomMelody) {
+    // Every match must be a leftmost-longest one: compare with all (start, end) anchored checks
+    std::vector<int> midiNumbers;
+    unsigned int seed = 7;
+    for (int i = 0; i < 200; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const int step = static_cast<int>((seed >> 16) % 7) - 3;
+        midiNumbers.push_back((seed >> 8) % 11 == 0 ? 0 : 60 + step);
+    }
+    const auto events = toEvents(midiNumbers);
+    const MelodyRegex regex("[up] ([same] | R)* [down]{1,2}");
+
+    // Reference: the longest anchored match at each start, scanning left to right
+    std::vector<std::pair<int, int>> expected;
+    int pos = 0;
+    while (pos < static_cast<int>(events.size())) {
+        int bestLength = 0;
+        for (int end = pos + 1; end <= static_cast<int>(events.size()); end++) {
+            const std::vector<MelodyRegex::Event> window(events.begin() + pos, events.begin() + end);
+            const auto windowMatches = regex.findAll(window);
+            if (!windowMatches.empty() && windowMatches.front().start == 0 &&
+                windowMatches.front().length == end - pos) {
+                bestLength = end - pos;
+            }
+        }
+
+        if (bestLength > 0) {
+            expected.emplace_back(pos, bestLength);
+            pos += bestLength;
+        } else {
+            pos++;
+        }
+    }
+
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(toPairs(regex.findAll(events)), expected);
+}
@@ -748,6 +748,18 @@ TEST(NoteFrequency, GetFrequencyWithCustomA4) {
   EXPECT_NEAR(freq, 442.0f, 0.01f);
 }
 
+TEST(NoteFrequency, GetFrequencyWithAnalysisContext) {
+  Note e4("E4");
+  const AnalysisContext just(TuningSystem::JUST_INTONATION, 442.0f);
+
+  // E4 is a pure fourth below A4 in just intonation
+  EXPECT_FLOAT_EQ(e4.getFrequency(just), 442.0f * 3.0f / 4.0f);
+  EXPECT_EQ(e4.getFrequency(AnalysisContext()), e4.getFrequency());
+
+  const auto spectrum = e4.getHarmonicSpectrum(4, nullptr, 0.88f, just);
+  EXPECT_FLOAT_EQ(spectrum.first[3], 4.0f * e4.getFrequency(just));
+}
+
 // ===================================================================================================
 // ALTER SYMBOL
 // ===================================================================================================
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "maiacore/reducers.h"
+
+// ============================================================================
+// Counter Tests
+// ============================================================================
+
+TEST(CounterReducer, AddAndMerge) {
+    CounterReducer<std::string> first;
+    first.add("C");
+    first.add("G", 3);
+
+    CounterReducer<std::string> second;
+    second.add("C", 2);
+    second.add("E");
+
+    first.merge(std::move(second));
+    EXPECT_EQ(first.getTotal(), 7);
+    EXPECT_EQ(first.getCount("C"), 3);
+    EXPECT_EQ(first.getCount("D"), 0);
+    EXPECT_EQ(first.getCounts().size(), 3u);
+
+    // Ties keep the key order
+    const auto mostCommon = first.getMostCommon(2);
+    ASSERT_EQ(mostCommon.size(), 2u);
+    EXPECT_EQ(mostCommon[0], std::make_pair(std::string("C"), 3LL));
+    EXPECT_EQ(mostCommon[1], std::make_pair(std::string("G"), 3LL));
+}
+
+// ============================================================================
+// Histogram Tests
+// ============================================================================
+
+TEST(HistogramReducer, BinsAndOutOfRange) {
+    HistogramReducer histogram(0.0, 4.0, 4);
+    histogram.add(0.0);
+    histogram.add(0.5);
+    histogram.add(3.99);
+    histogram.add(4.0);
+    histogram.add(-1.0, 2.0);
+
+    EXPECT_EQ(histogram.getBins(), std::vector<double>({2.0, 0.0, 0.0, 1.0}));
+    EXPECT_EQ(histogram.getBinEdges(), std::vector<double>({0.0, 1.0, 2.0, 3.0, 4.0}));
+    EXPECT_DOUBLE_EQ(histogram.getUnderflow(), 2.0);
+    EXPECT_DOUBLE_EQ(histogram.getOverflow(), 1.0);
+    EXPECT_DOUBLE_EQ(histogram.getTotal(), 6.0);
+
+    const std::vector<double> normalized = histogram.getNormalizedBins();
+    EXPECT_NEAR(normalized[0], 2.0 / 3.0, 1e-12);
+    EXPECT_NEAR(normalized[3], 1.0 / 3.0, 1e-12);
+
+    HistogramReducer other(0.0, 4.0, 4);
+    other.add(1.5);
+    histogram.merge(std::move(other));
+    EXPECT_DOUBLE_EQ(histogram.getBins()[1], 1.0);
+
+    EXPECT_THROW(histogram.merge(HistogramReducer(0.0, 4.0, 8)), std::runtime_error);
+    EXPECT_THROW(HistogramReducer(1.0, 1.0, 4), std::runtime_error);
+    EXPECT_THROW(HistogramReducer(0.0, 1.0, 0), std::runtime_error);
+}
+
+// ============================================================================
+// Concatenation Tests
+// ============================================================================
+
+TEST(ConcatenationReducer, OrderedByKey) {
+    ConcatenationReducer<std::string, int> first;
+    first.add(2, "c");
+    first.add(0, "a");
+
+    ConcatenationReducer<std::string, int> second;
+    second.add(1, "b1");
+    second.add(1, "b2");
+    second.add(3, "d");
+
+    first.merge(std::move(second));
+    EXPECT_EQ(first.getNumValues(), 5u);
+    EXPECT_EQ(first.getValues(), std::vector<std::string>({"a", "b1", "b2", "c", "d"}));
+    EXPECT_EQ(first.takeValues(false), std::vector<std::string>({"c", "a", "b1", "b2", "d"}));
+    EXPECT_EQ(first.getNumValues(), 0u);
+}
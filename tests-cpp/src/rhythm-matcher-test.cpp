@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "maiacore/rhythm_matcher.h"
+
+namespace {
+
+std::vector<int> starts(const std::vector<RhythmMatcher::Match>& matches) {
+    std::vector<int> result;
+    for (const auto& match : matches) {
+        result.push_back(match.start);
+    }
+    return result;
+}
+
+}  // namespace
+
+// ============================================================================
+// Rhythm Matcher Tests
+// ============================================================================
+
+TEST(RhythmMatcher, ExactMatchesOverlap) {
+    // Dotted eighth + sixteenth on a grid of 4 ticks per quarter
+    const RhythmMatcher matcher({3, 1});
+    EXPECT_EQ(matcher.getNumIntervals(), 2);
+
+    const std::vector<int64_t> intervals = {3, 1, 4, 3, 1, 3, 1, 8};
+    EXPECT_EQ(starts(matcher.findAll(intervals)), std::vector<int>({0, 3, 5}));
+
+    const RhythmMatcher repeated({2, 2});
+    EXPECT_EQ(starts(repeated.findAll({2, 2, 2, 2})), std::vector<int>({0, 1, 2}));
+
+    EXPECT_TRUE(matcher.findAll({3}).empty());
+    EXPECT_TRUE(matcher.findAll({}).empty());
+}
+
+TEST(RhythmMatcher, ToleranceAcceptsSwing) {
+    // Straight eighths (6 + 6 ticks) against swung eighths (8 + 4 ticks)
+    const std::vector<int64_t> swung = {8, 4, 8, 4, 12};
+
+    EXPECT_TRUE(RhythmMatcher({6, 6}).findAll(swung).empty());
+
+    const auto matches = RhythmMatcher({6, 6}, 0.35f).findAll(swung);
+    EXPECT_EQ(starts(matches), std::vector<int>({0, 1, 2}));
+    EXPECT_NEAR(matches[0].maxDeviation, 1.0f / 3.0f, 1e-6);
+
+    EXPECT_TRUE(RhythmMatcher({6, 6}, 0.3f).findAll(swung).empty());
+}
+
+TEST(RhythmMatcher, LongCellsMatchBothModes) {
+    // 70 intervals: longer than the Shift-And word
+    std::vector<int64_t> cell;
+    for (int i = 0; i < 70; i++) {
+        cell.push_back(1 + i % 3);
+    }
+
+    std::vector<int64_t> intervals = {5, 5};
+    intervals.insert(intervals.end(), cell.begin(), cell.end());
+    intervals.push_back(5);
+
+    EXPECT_EQ(starts(RhythmMatcher(cell).findAll(intervals)), std::vector<int>({2}));
+    EXPECT_EQ(starts(RhythmMatcher(cell, 0.1f).findAll(intervals)), std::vector<int>({2}));
+
+    intervals[10] += 1;
+    EXPECT_TRUE(RhythmMatcher(cell).findAll(intervals).empty());
+    EXPECT_TRUE(RhythmMatcher(cell, 0.1f).findAll(intervals).empty());
+}
+
+TEST(RhythmMatcher, InvalidCellsThrow) {
+    EXPECT_THROW(RhythmMatcher({}), std::runtime_error);
+    EXPECT_THROW(RhythmMatcher({2, 0}), std::runtime_error);
+    EXPECT_THROW(RhythmMatcher({2, 2}, -0.1f), std::runtime_error);
+}
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
 #include "maiacore/score_collection.h"
 
 // Test directories with XML files
@@ -95,13 +100,17 @@ TEST(ScoreCollectionDirectories, AddDirectory) {
     EXPECT_EQ(collection.getNumDirectories(), 2);
 }
 
-TEST(ScoreCollectionDirectories, AddDirectoryDoesNotAutoLoad) {
+TEST(ScoreCollectionDirectories, AddDirectoryLoadsFiles) {
     ScoreCollection collection(std::vector<std::string>{});
-    collection.addDirectory(BACH_DIR);
+    const auto summary = collection.addDirectory(BACH_DIR);
 
-    // addDirectory only adds to list, doesn't load files
-    EXPECT_EQ(collection.getNumScores(), 0);
-    EXPECT_TRUE(collection.isEmpty());
+    EXPECT_EQ(collection.getNumScores(), 2);
+    EXPECT_EQ(summary.addedFiles.size(), 2u);
+    EXPECT_EQ(collection.getManifest().size(), 2u);
+
+    // Already loaded files are not loaded again
+    EXPECT_TRUE(collection.addDirectory(BACH_DIR).addedFiles.empty());
+    EXPECT_EQ(collection.getNumScores(), 2);
 }
 
 TEST(ScoreCollectionDirectories, GetNumDirectories) {
@@ -115,6 +124,50 @@ TEST(ScoreCollectionDirectories, GetNumDirectories) {
     EXPECT_EQ(collection.getNumDirectories(), 2);
 }
 
+TEST(ScoreCollectionDirectories, RefreshAppliesOnlyChanges) {
+    namespace fs = std::filesystem;
+    const fs::path dir = fs::temp_directory_path() / "maiacore-collection-refresh-test";
+    fs::remove_all(dir);
+    fs::create_directories(dir / "sub");
+    fs::copy_file(BACH_DIR + "/prelude_1_BWV_846.xml", dir / "prelude.xml");
+    fs::copy_file(BACH_DIR + "/cello_suite_1_violin.xml", dir / "sub" / "cello.xml");
+
+    ScoreCollection collection(dir.string());
+    EXPECT_EQ(collection.getNumScores(), 1);  // Not recursive by default
+
+    collection.setScanOptions(true);
+    auto summary = collection.refresh();
+    EXPECT_EQ(summary.addedFiles, std::vector<std::string>({(dir / "sub" / "cello.xml").string()}));
+    ASSERT_EQ(collection.getNumScores(), 2);
+    const int preludeNumNotes = collection.getScores()[0]->getNumNotes();
+
+    // Same content with a new write time: hashed, not parsed again
+    const fs::path prelude = dir / "prelude.xml";
+    fs::last_write_time(prelude, fs::last_write_time(prelude) + std::chrono::hours(1));
+    summary = collection.refresh();
+    EXPECT_TRUE(summary.addedFiles.empty());
+    EXPECT_TRUE(summary.reloadedFiles.empty());
+    EXPECT_TRUE(summary.removedFiles.empty());
+
+    // Modified file: parsed again in place
+    fs::copy_file(BACH_DIR + "/cello_suite_1_violin.xml", prelude,
+                  fs::copy_options::overwrite_existing);
+    summary = collection.refresh();
+    EXPECT_EQ(summary.reloadedFiles, std::vector<std::string>({prelude.string()}));
+    EXPECT_EQ(collection.getScores()[0]->getFilePath(), prelude.string());
+    EXPECT_NE(collection.getScores()[0]->getNumNotes(), preludeNumNotes);
+
+    // Deleted file: its score is removed, the others are kept
+    fs::remove(dir / "sub" / "cello.xml");
+    summary = collection.refresh();
+    EXPECT_EQ(summary.removedFiles.size(), 1u);
+    EXPECT_EQ(collection.getNumScores(), 1);
+    EXPECT_EQ(collection.getManifest().size(), 1u);
+    EXPECT_NE(collection.getManifest()[0].hash, 0u);
+
+    fs::remove_all(dir);
+}
+
 // ============================================================================
 // Score Management Tests
 // ============================================================================
@@ -165,16 +218,25 @@ TEST(ScoreCollectionScores, GetNumScores) {
     EXPECT_GT(num_scores, 0);  // Bach dir should have at least 1 file
 }
 
-TEST(ScoreCollectionScores, GetScoresNonConst) {
+TEST(ScoreCollectionScores, GetScoreCopyOnWrite) {
     ScoreCollection collection(std::vector<std::string>{});
     collection.addScore("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
 
-    std::vector<Score>& scores = collection.getScores();
-    EXPECT_EQ(scores.size(), 1);
+    // A held handle shares the score: the change copies it first
+    const ScoreCollection::ScoreHandle handle = collection.getScores()[0];
+    const std::string title = handle->getTitle();
+    collection.getScore(0).setTitle("Changed");
 
-    // Can modify through reference
-    scores.clear();
-    EXPECT_EQ(collection.getNumScores(), 0);
+    EXPECT_EQ(collection.getScore(0).getTitle(), "Changed");
+    EXPECT_EQ(handle->getTitle(), title);
+    EXPECT_NE(collection.getScores()[0], handle);
+
+    // Not shared anymore: changed in place
+    const Score* owned = collection.getScores()[0].get();
+    collection.getScore(0).setTitle("Changed again");
+    EXPECT_EQ(collection.getScores()[0].get(), owned);
+
+    EXPECT_THROW(collection.getScore(1), std::runtime_error);
 }
 
 TEST(ScoreCollectionScores, GetScoresConst) {
@@ -182,7 +244,7 @@ TEST(ScoreCollectionScores, GetScoresConst) {
     collection.addScore("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
 
     const ScoreCollection& const_ref = collection;
-    const std::vector<Score>& scores = const_ref.getScores();
+    const std::vector<ScoreCollection::ScoreHandle>& scores = const_ref.getScores();
 
     EXPECT_EQ(scores.size(), 1);
 }
@@ -304,6 +366,114 @@ TEST(ScoreCollectionMerge, MergeIntoEmptyCollection) {
     EXPECT_EQ(empty_collection.getNumScores(), count);
 }
 
+TEST(ScoreCollectionMerge, MergeSharesScores) {
+    ScoreCollection collection1(std::vector<std::string>{});
+    collection1.addScore("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+    ScoreCollection collection2(std::vector<std::string>{});
+    collection2.addScore("./test/xml_examples/Bach/cello_suite_1_violin.xml");
+
+    collection1.merge(collection2);
+    EXPECT_EQ(collection1.getScores()[1], collection2.getScores()[0]);
+
+    const ScoreCollection sum = collection1 + collection2;
+    EXPECT_EQ(sum.getScores()[0], collection1.getScores()[0]);
+    EXPECT_EQ(sum.getScores()[2], collection2.getScores()[0]);
+
+    // Self-merge: each score twice, still shared
+    collection1.merge(collection1);
+    ASSERT_EQ(collection1.getNumScores(), 4);
+    EXPECT_EQ(collection1.getScores()[0], collection1.getScores()[2]);
+    EXPECT_EQ(collection1.getScores()[1], collection1.getScores()[3]);
+
+    // A change through one collection is not seen by the others
+    collection2.getScore(0).setTitle("Changed");
+    EXPECT_NE(collection1.getScore(1).getTitle(), "Changed");
+}
+
+TEST(ScoreCollectionMerge, SubCollectionAndFilter) {
+    ScoreCollection collection(std::vector<std::string>{});
+    collection.addDirectory(BACH_DIR);
+    collection.addDirectory(BEETHOVEN_DIR);
+    ASSERT_GE(collection.getNumScores(), 3);
+
+    const ScoreCollection sub = collection.getSubCollection({2, 0});
+    ASSERT_EQ(sub.getNumScores(), 2);
+    EXPECT_EQ(sub.getScores()[0], collection.getScores()[2]);
+    EXPECT_EQ(sub.getScores()[1], collection.getScores()[0]);
+    EXPECT_EQ(sub.getNumDirectories(), 0);
+    EXPECT_THROW(collection.getSubCollection({-1}), std::runtime_error);
+
+    const std::string composer = collection.getScore(0).getComposerName();
+    const ScoreCollection byComposer = collection.filter(
+        [&composer](const Score& score) { return score.getComposerName() == composer; }, 4);
+
+    int scoreIdx = 0;
+    for (const auto& score : collection.getScores()) {
+        if (score->getComposerName() == composer) {
+            ASSERT_LT(scoreIdx, byComposer.getNumScores());
+            EXPECT_EQ(byComposer.getScores()[scoreIdx++], score);
+        }
+    }
+    EXPECT_EQ(scoreIdx, byComposer.getNumScores());
+}
+
+TEST(ScoreCollectionMerge, SharedScoreSearchedFromTwoThreads) {
+    ScoreCollection collection(std::vector<std::string>{});
+    collection.addScore("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+    const ScoreCollection first = collection;
+    const ScoreCollection second = collection;
+    ASSERT_EQ(first.getScores()[0], second.getScores()[0]);
+
+    // Both threads build the lazy caches of the same score at once (run under TSan to catch races)
+    const std::vector<Note> pattern = {Note("C4"), Note("E4"), Note("G4")};
+    Score::MelodyPatternTable firstRows;
+    Score::MelodyPatternTable secondRows;
+    std::atomic<int> numReady(0);
+    const auto search = [&numReady, &pattern](const ScoreCollection& collection,
+                                              Score::MelodyPatternTable* rows) {
+        numReady++;
+        while (numReady < 2) {
+        }
+        *rows = collection.getScore(0).findMelodyPattern(pattern, 0.3f, 0.3f);
+        collection.getScore(0).getFingerprint();
+    };
+    std::thread firstThread(search, std::cref(first), &firstRows);
+    std::thread secondThread(search, std::cref(second), &secondRows);
+    firstThread.join();
+    secondThread.join();
+
+    EXPECT_FALSE(firstRows.empty());
+    EXPECT_EQ(firstRows, secondRows);
+    EXPECT_EQ(first.getScores()[0], second.getScores()[0]);
+}
+
+TEST(ScoreCollectionMerge, SharedScoresSearchedOncePerScore) {
+    ScoreCollection collection(std::vector<std::string>{});
+    collection.addScore("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+    collection.addScore(collection.getScores()[0]);
+    ASSERT_EQ(collection.getScores()[0], collection.getScores()[1]);
+
+    const auto regex = collection.findMelodyRegex("[up]{3} [down]", 4);
+    ASSERT_EQ(regex.size(), 2);
+    EXPECT_EQ(regex[0].size(), regex[1].size());
+
+    // The chord search fills the harmonic index: the shared scores are copied first
+    const ScoreCollection copy = collection;
+    const auto chords = collection.findChordProgression("@ @+5", {}, true, 4);
+    ASSERT_EQ(chords.size(), 2);
+    EXPECT_EQ(chords[0].size(), chords[1].size());
+    EXPECT_NE(collection.getScores()[0], collection.getScores()[1]);
+    EXPECT_NE(collection.getScores()[0], copy.getScores()[0]);
+    EXPECT_EQ(copy.getScores()[0], copy.getScores()[1]);
+
+    const std::vector<Note> pattern = {Note("C4"), Note("E4"), Note("G4")};
+    const auto rows = collection.findMelodyPattern(pattern, 0.3f, 0.3f);
+    EXPECT_EQ(rows.size() % 2, 0);
+
+    collection.buildMelodyIndex(4);
+    EXPECT_EQ(collection.findMelodyPattern(pattern, 0.3f, 0.3f), rows);
+}
+
 // ============================================================================
 // Operator Tests
 // ============================================================================
@@ -400,6 +570,115 @@ TEST(ScoreCollectionPatternFinding, FindMelodyPatternEmptyCollection) {
     EXPECT_EQ(results.size(), 0);  // No scores = no results
 }
 
+TEST(ScoreCollectionPatternFinding, FindMelodyPatternDtwMetric) {
+    ScoreCollection collection(std::vector<std::string>{});
+    collection.addScore("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+
+    std::vector<Note> pattern = {
+        Note("C4"),
+        Note("E4"),
+        Note("G4"),
+        Note("C5")
+    };
+
+    auto dtwResults = collection.findMelodyPattern(pattern, 0.3f, 0.0f, nullptr, nullptr, nullptr,
+                                                   nullptr, nullptr, MelodySimilarityMetric::DTW);
+    auto euclideanResults = collection.findMelodyPattern(pattern, 0.3f, 0.0f);
+
+    // Same rows as the score-level search, with the file metadata
+    const Score score("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+    const auto scoreResults = score.findMelodyPattern(pattern, 0.3f, 0.0f, nullptr, nullptr, nullptr,
+                                                      nullptr, nullptr, MelodySimilarityMetric::DTW);
+    ASSERT_EQ(dtwResults.size(), scoreResults.size());
+    EXPECT_FALSE(dtwResults.empty());
+    EXPECT_NE(dtwResults.size(), euclideanResults.size());
+}
+
+TEST(ScoreCollectionPatternFinding, CountStreamAndTopK) {
+    ScoreCollection collection(BACH_DIR);
+    ASSERT_GT(collection.getNumScores(), 1);
+
+    std::vector<Note> pattern = {
+        Note("C4"),
+        Note("E4"),
+        Note("G4")
+    };
+
+    auto results = collection.findMelodyPattern(pattern, 0.3f, 0.3f);
+    ASSERT_GT(results.size(), 5u);
+
+    EXPECT_EQ(collection.countMelodyPattern(pattern, 0.3f, 0.3f), results.size());
+
+    size_t numMatches = 0;
+    int lastScoreIdx = 0;
+    collection.findMelodyPatternMatches(pattern, [&](int scoreIdx, const Score::MelodyPatternMatch&) {
+        EXPECT_GE(scoreIdx, lastScoreIdx);
+        lastScoreIdx = scoreIdx;
+        numMatches++;
+    }, 0.3f, 0.3f);
+    EXPECT_EQ(numMatches, results.size());
+
+    // Top-k: best rows of the whole collection, collection order for the ties
+    std::stable_sort(results.begin(), results.end(), [](const auto& a, const auto& b) {
+        return std::get<13>(a) > std::get<13>(b);
+    });
+
+    auto top = collection.findTopMelodyPattern(pattern, 5, 0.3f, 0.3f);
+    ASSERT_EQ(top.size(), 5u);
+    EXPECT_TRUE(std::equal(top.begin(), top.end(), results.begin()));
+}
+
+TEST(ScoreCollectionPatternFinding, FindMelodyPatternInParallel) {
+    // The quartet is split in one task per part
+    ScoreCollection collection(BACH_DIR);
+    collection.addScore("./test/xml_examples/Beethoven/Beethoven_quartet_133.xml");
+    ASSERT_EQ(collection.getNumScores(), 3);
+
+    std::vector<Note> pattern = {
+        Note("C4"),
+        Note("E4"),
+        Note("G4")
+    };
+
+    const auto sequential = collection.findMelodyPattern(pattern, 0.3f, 0.3f, nullptr, nullptr,
+                                                         nullptr, nullptr, nullptr,
+                                                         MelodySimilarityMetric::EUCLIDEAN, 2, 1);
+    ASSERT_GT(sequential.size(), 5u);
+    EXPECT_EQ(std::get<0>(sequential.back()), collection.getScores()[2]->getFileName());
+
+    const auto parallel = collection.findMelodyPattern(pattern, 0.3f, 0.3f, nullptr, nullptr,
+                                                       nullptr, nullptr, nullptr,
+                                                       MelodySimilarityMetric::EUCLIDEAN, 2, 4);
+    EXPECT_EQ(parallel, sequential);
+
+    // Completion order: same rows
+    auto unordered = collection.findMelodyPattern(pattern, 0.3f, 0.3f, nullptr, nullptr, nullptr,
+                                                  nullptr, nullptr,
+                                                  MelodySimilarityMetric::EUCLIDEAN, 2, 4, false);
+    auto sortedSequential = sequential;
+    std::sort(unordered.begin(), unordered.end());
+    std::sort(sortedSequential.begin(), sortedSequential.end());
+    EXPECT_EQ(unordered, sortedSequential);
+
+    // Multiple patterns: one table per score, sorted by pattern
+    const std::vector<std::vector<Note>> patterns = {pattern, {Note("G4"), Note("F4"), Note("E4")}};
+    const auto tables = collection.findMelodyPattern(patterns, 0.3f, 0.3f, nullptr, nullptr,
+                                                     nullptr, nullptr, nullptr,
+                                                     MelodySimilarityMetric::EUCLIDEAN, 2, 4);
+    ASSERT_EQ(tables.size(), 3u);
+
+    size_t numFirstPatternRows = 0;
+    for (const auto& table : tables) {
+        EXPECT_TRUE(std::is_sorted(table.begin(), table.end(), [](const auto& a, const auto& b) {
+            return std::get<0>(a) < std::get<0>(b);
+        }));
+        numFirstPatternRows += std::count_if(table.begin(), table.end(), [](const auto& row) {
+            return std::get<0>(row) == 0;
+        });
+    }
+    EXPECT_EQ(numFirstPatternRows, sequential.size());
+}
+
 // ============================================================================
 // Pattern Finding Tests - Multiple Patterns
 // ============================================================================
@@ -458,6 +737,53 @@ TEST(ScoreCollectionMultiPattern, EmptyPatternList) {
     EXPECT_EQ(results.size(), 0);
 }
 
+TEST(ScoreCollectionMultiPattern, CallbackErrorIsRethrown) {
+    ScoreCollection collection(BACH_DIR);
+
+    const std::vector<std::vector<Note>> patterns = {{Note("C4"), Note("D4"), Note("E4")}};
+    const auto throwingCallback = [](const std::vector<Note>&, const std::vector<Note>&)
+        -> std::vector<float> { throw std::runtime_error("callback error"); };
+    EXPECT_THROW(collection.findMelodyPattern(patterns, 0.5f, 0.5f, throwingCallback),
+                 std::runtime_error);
+}
+
+// ============================================================================
+// Map/Reduce Tests
+// ============================================================================
+
+TEST(ScoreCollectionMapReduce, CountersAndConcatenation) {
+    ScoreCollection collection(BACH_DIR);
+    collection.addScore("./test/xml_examples/Beethoven/Beethoven_quartet_133.xml");
+    ASSERT_EQ(collection.getNumScores(), 3);
+
+    const auto composers = collection.mapReduce(
+        [](int, const Score& score, CounterReducer<std::string>& counter) {
+            counter.add(score.getComposerName());
+        },
+        CounterReducer<std::string>(), 4);
+    EXPECT_EQ(composers.getTotal(), 3);
+
+    auto numNotes = collection.mapReduce(
+        [](const int scoreIdx, const Score& score, ConcatenationReducer<int, int>& concatenation) {
+            concatenation.add(scoreIdx, score.getNumNotes());
+        },
+        ConcatenationReducer<int, int>(), 4).takeValues();
+
+    std::vector<int> sequential;
+    for (const auto& score : collection.getScores()) {
+        sequential.push_back(score->getNumNotes());
+    }
+    EXPECT_EQ(numNotes, sequential);
+
+    std::vector<int> numParts(collection.getNumScores(), 0);
+    collection.forEachScoreParallel(
+        [&numParts](const int scoreIdx, const Score& score) {
+            numParts[scoreIdx] = score.getNumParts();
+        },
+        2);
+    EXPECT_EQ(numParts[2], collection.getScores()[2]->getNumParts());
+}
+
 // ============================================================================
 // Integration Tests
 // ============================================================================
@@ -548,3 +874,64 @@ TEST(ScoreCollectionEdgeCases, LargeCollection) {
     collection.clear();
     EXPECT_TRUE(collection.isEmpty());
 }
+
+TEST(ScoreCollectionPatternFinding, FindMelodyRegexInParallel) {
+    ScoreCollection collection(BACH_DIR);
+    ASSERT_GT(collection.getNumScores(), 1);
+
+    const std::string pattern = "[up]{3} [down]";
+    const auto results = collection.findMelodyRegex(pattern, 2);
+    ASSERT_EQ(static_cast<int>(results.size()), collection.getNumScores());
+
+    // Same matches of the sequential search, indexed by score
+    size_t numMatches = 0;
+    for (int scoreIdx = 0; scoreIdx < collection.getNumScores(); scoreIdx++) {
+        const auto expected = collection.getScores()[scoreIdx]->findMelodyRegex(pattern);
+        ASSERT_EQ(results[scoreIdx].size(), expected.size());
+        for (size_t m = 0; m < expected.size(); m++) {
+            EXPECT_EQ(results[scoreIdx][m].partIdx, expected[m].partIdx);
+            EXPECT_EQ(results[scoreIdx][m].noteEventIdx, expected[m].noteEventIdx);
+            EXPECT_EQ(results[scoreIdx][m].numNotes, 4);
+        }
+        numMatches += expected.size();
+    }
+    EXPECT_GT(numMatches, 0u);
+
+    EXPECT_THROW(collection.findMelodyRegex("(N"), std::runtime_error);
+}
+
+TEST(ScoreCollectionPatternFinding, FindChordProgressionInParallel) {
+    // ii V I vi in C major, then the same progression in G major (written without key signature)
+    Score cMajor({"Soprano", "Alto", "Bass"}, 1);
+    cMajor.getPart(0).getMeasure(0).addNote(std::vector<std::string>{"A4", "B4", "G4", "C5"}, 0);
+    cMajor.getPart(1).getMeasure(0).addNote(std::vector<std::string>{"F4", "D4", "E4", "E4"}, 0);
+    cMajor.getPart(2).getMeasure(0).addNote(std::vector<std::string>{"D3", "G2", "C3", "A2"}, 0);
+
+    Score gMajor({"Soprano", "Alto", "Bass"}, 1);
+    gMajor.getPart(0).getMeasure(0).addNote(std::vector<std::string>{"E4", "F#4", "D4", "G4"}, 0);
+    gMajor.getPart(1).getMeasure(0).addNote(std::vector<std::string>{"C4", "A3", "B3", "B3"}, 0);
+    gMajor.getPart(2).getMeasure(0).addNote(std::vector<std::string>{"A2", "D3", "G2", "E3"}, 0);
+
+    ScoreCollection collection(std::vector<std::string>{});
+    collection.addScore(cMajor);
+    collection.addScore(gMajor);
+
+    // Roman numerals follow the key signature (C major in both scores)
+    const auto roman = collection.findChordProgression("II V I", {}, true, 2);
+    ASSERT_EQ(roman.size(), 2u);
+    ASSERT_EQ(roman[0].size(), 1u);
+    EXPECT_EQ(roman[0][0].startMeasure, 1);
+    EXPECT_TRUE(roman[1].empty());
+
+    // Root motion is transposition invariant
+    const auto relative = collection.findChordProgression("@:minor @+5:major @+5:major", {}, true, 2);
+    ASSERT_EQ(relative.size(), 2u);
+    for (const auto& matches : relative) {
+        ASSERT_EQ(matches.size(), 1u);
+        EXPECT_EQ(matches[0].firstSliceIdx, 0);
+        EXPECT_EQ(matches[0].numSlices, 3);
+    }
+    EXPECT_EQ(relative[1][0].romanDegrees, std::vector<std::string>({"VI", "II", "V"}));
+
+    EXPECT_THROW(collection.findChordProgression("@-2 V"), std::runtime_error);
+}
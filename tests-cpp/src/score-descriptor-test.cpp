@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <set>
+
+#include "maiacore/score_collection.h"
+#include "maiacore/score_descriptor.h"
+
+namespace {
+
+const std::string PRELUDE_FILE = "./test/xml_examples/Bach/prelude_1_BWV_846.xml";
+const std::string CELLO_FILE = "./test/xml_examples/Bach/cello_suite_1_violin.xml";
+const std::string QUARTET_FILE = "./test/xml_examples/Beethoven/Beethoven_quartet_133.xml";
+
+typedef std::vector<std::pair<int, float>> Neighbors;
+
+float getFeature(const ScoreDescriptor& descriptor, const std::string& name) {
+    const std::vector<std::string> names = ScoreDescriptor::getFeatureNames();
+    const auto it = std::find(names.begin(), names.end(), name);
+    EXPECT_NE(it, names.end()) << name;
+    return descriptor.values[it - names.begin()];
+}
+
+float sumBlock(const ScoreDescriptor& descriptor, const int offset, const int size) {
+    return std::accumulate(descriptor.values.begin() + offset,
+                           descriptor.values.begin() + offset + size, 0.0f);
+}
+
+ScoreDescriptor randomDescriptor(std::mt19937* generator) {
+    std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+    ScoreDescriptor descriptor;
+    for (int i = 0; i < ScoreDescriptor::SIZE; i++) {
+        descriptor.values.push_back(distribution(*generator));
+    }
+    return descriptor;
+}
+
+}  // namespace
+
+TEST(ScoreDescriptor, Features) {
+    const std::vector<std::string> names = ScoreDescriptor::getFeatureNames();
+    ASSERT_EQ(names.size(), static_cast<size_t>(ScoreDescriptor::SIZE));
+    EXPECT_EQ(std::set<std::string>(names.begin(), names.end()).size(), names.size());
+    EXPECT_EQ(names.front(), "pitch_class_C");
+    EXPECT_EQ(names.back(), "texture_pitch_range");
+
+    // C major triad of whole notes in 3 parts, then an empty measure
+    Score score({"Soprano", "Alto", "Tenor"}, 2);
+    score.getPart(0).getMeasure(0).addNote(Note("G4", RhythmFigure::WHOLE));
+    score.getPart(1).getMeasure(0).addNote(Note("E4", RhythmFigure::WHOLE));
+    score.getPart(2).getMeasure(0).addNote(Note("C4", RhythmFigure::WHOLE));
+
+    const ScoreDescriptor& descriptor = score.getDescriptor();
+    ASSERT_EQ(descriptor.values.size(), static_cast<size_t>(ScoreDescriptor::SIZE));
+    EXPECT_FLOAT_EQ(getFeature(descriptor, "pitch_class_C"), 1.0f / 3.0f);
+    EXPECT_FLOAT_EQ(getFeature(descriptor, "pitch_class_E"), 1.0f / 3.0f);
+    EXPECT_FLOAT_EQ(getFeature(descriptor, "pitch_class_G"), 1.0f / 3.0f);
+    EXPECT_FLOAT_EQ(getFeature(descriptor, "rhythm_whole"), 1.0f);
+    EXPECT_FLOAT_EQ(getFeature(descriptor, "chord_major"), 1.0f);
+    EXPECT_FLOAT_EQ(getFeature(descriptor, "texture_polyphony"), 3.0f / 8.0f);
+    EXPECT_FLOAT_EQ(getFeature(descriptor, "texture_rest_ratio"), 0.5f);
+    EXPECT_FLOAT_EQ(getFeature(descriptor, "texture_pitch_range"), 7.0f / 88.0f);
+
+    // Single attacks: no intervals
+    EXPECT_EQ(sumBlock(descriptor, ScoreDescriptor::NUM_PITCH_CLASS_BINS,
+                       ScoreDescriptor::NUM_INTERVAL_BINS), 0.0f);
+
+    // Then a diminished triad: the tenor moves a semitone up, the other voices repeat
+    score.getPart(0).getMeasure(1).addNote(Note("G4", RhythmFigure::WHOLE));
+    score.getPart(1).getMeasure(1).addNote(Note("E4", RhythmFigure::WHOLE));
+    score.getPart(2).getMeasure(1).addNote(Note("C#4", RhythmFigure::WHOLE));
+    const ScoreDescriptor diminished = ScoreDescriptor::compute(score);
+    EXPECT_FLOAT_EQ(getFeature(diminished, "chord_major"), 0.5f);
+    EXPECT_FLOAT_EQ(getFeature(diminished, "chord_diminished"), 0.5f);
+    EXPECT_FLOAT_EQ(getFeature(diminished, "interval_0"), 2.0f / 3.0f);
+    EXPECT_FLOAT_EQ(getFeature(diminished, "interval_+1"), 1.0f / 3.0f);
+    EXPECT_FLOAT_EQ(getFeature(diminished, "texture_rest_ratio"), 0.0f);
+    EXPECT_GT(diminished.distance(descriptor), 0.0f);
+}
+
+TEST(ScoreDescriptor, LoadedScores) {
+    const Score prelude(PRELUDE_FILE);
+    const Score cello(CELLO_FILE);
+
+    const ScoreDescriptor& descriptor = prelude.getDescriptor();
+    const int intervalOffset = ScoreDescriptor::NUM_PITCH_CLASS_BINS;
+    const int rhythmOffset = intervalOffset + ScoreDescriptor::NUM_INTERVAL_BINS;
+    const int chordOffset = rhythmOffset + ScoreDescriptor::NUM_RHYTHM_BINS;
+    EXPECT_NEAR(sumBlock(descriptor, 0, ScoreDescriptor::NUM_PITCH_CLASS_BINS), 1.0f, 1e-5f);
+    EXPECT_NEAR(sumBlock(descriptor, intervalOffset, ScoreDescriptor::NUM_INTERVAL_BINS), 1.0f, 1e-5f);
+    EXPECT_NEAR(sumBlock(descriptor, rhythmOffset, ScoreDescriptor::NUM_RHYTHM_BINS), 1.0f, 1e-5f);
+    EXPECT_NEAR(sumBlock(descriptor, chordOffset, ScoreDescriptor::NUM_CHORD_QUALITY_BINS), 1.0f, 1e-5f);
+    for (const float value : descriptor.values) {
+        EXPECT_GE(value, 0.0f);
+        EXPECT_LE(value, 1.0f);
+    }
+
+    // The prelude in C major: C is the most sounding pitch class, more major than minor chords
+    EXPECT_EQ(std::max_element(descriptor.values.begin(), descriptor.values.begin() + 12) -
+                  descriptor.values.begin(), 0);
+    EXPECT_GT(getFeature(descriptor, "chord_major"), getFeature(descriptor, "chord_minor"));
+    EXPECT_GT(getFeature(descriptor, "texture_polyphony"), getFeature(cello.getDescriptor(), "texture_polyphony"));
+
+    EXPECT_FLOAT_EQ(descriptor.distance(Score(PRELUDE_FILE).getDescriptor()), 0.0f);
+    EXPECT_GT(descriptor.distance(cello.getDescriptor()), 0.1f);
+}
+
+TEST(ScoreDescriptor, DescriptorIndex) {
+    std::mt19937 generator(7);
+    std::vector<ScoreDescriptor> descriptors;
+    for (int i = 0; i < 500; i++) {
+        descriptors.push_back(randomDescriptor(&generator));
+    }
+
+    const ScoreDescriptorIndex index(descriptors, 10, 2);
+    EXPECT_EQ(index.getNumDescriptors(), 500);
+    EXPECT_EQ(index.getNumLists(), 10);
+
+    // All the lists probed: exact search
+    const ScoreDescriptor& query = descriptors[42];
+    const Neighbors exact = index.findNearest(query, 5, 10);
+    ASSERT_EQ(exact.size(), 5u);
+    EXPECT_EQ(exact[0], std::make_pair(42, 0.0f));
+    std::vector<float> distances;
+    for (const auto& descriptor : descriptors) {
+        distances.push_back(query.distance(descriptor));
+    }
+    std::sort(distances.begin(), distances.end());
+    for (size_t i = 0; i < exact.size(); i++) {
+        EXPECT_NEAR(exact[i].second, distances[i], 1e-5f);
+    }
+
+    // Fewer lists probed: the query is still found in its own list
+    const Neighbors approximate = index.findNearest(query, 5, 2);
+    ASSERT_EQ(approximate.size(), 5u);
+    EXPECT_EQ(approximate[0].first, 42);
+    const size_t numInList = index.findNearest(query, 500, 1).size();
+    EXPECT_GT(numInList, 0u);
+    EXPECT_LT(numInList, 500u);
+    EXPECT_NE(index.findNearest(query, 5, 10, 42)[0].first, 42);
+
+    // Added and removed descriptors, with the ids of a vector
+    ScoreDescriptorIndex updated(index);
+    EXPECT_EQ(updated.add(descriptors[7]), 500);
+    EXPECT_EQ(updated.findNearest(descriptors[7], 2, 10), Neighbors({{7, 0.0f}, {500, 0.0f}}));
+    updated.remove(7);
+    EXPECT_EQ(updated.getNumDescriptors(), 500);
+    EXPECT_EQ(updated.findNearest(descriptors[7], 1, 10)[0], std::make_pair(499, 0.0f));
+    EXPECT_EQ(updated.findNearest(descriptors[42], 1, 10)[0], std::make_pair(41, 0.0f));
+    EXPECT_THROW(updated.remove(500), std::runtime_error);
+
+    // Empty index
+    ScoreDescriptorIndex empty({});
+    EXPECT_EQ(empty.getNumLists(), 1);
+    EXPECT_TRUE(empty.findNearest(query, 5).empty());
+    EXPECT_EQ(empty.add(query), 0);
+    EXPECT_EQ(empty.findNearest(query, 5)[0].first, 0);
+}
+
+TEST(ScoreDescriptor, CollectionSimilarScores) {
+    ScoreCollection collection(std::vector<std::string>{});
+    collection.addScore(PRELUDE_FILE);
+    collection.addScore(CELLO_FILE);
+    collection.addScore(QUARTET_FILE);
+
+    // Exact search, without an index
+    EXPECT_FALSE(collection.hasDescriptorIndex());
+    const Neighbors similar = collection.findSimilarScores(Score(CELLO_FILE), 20, 8, 2);
+    ASSERT_EQ(similar.size(), 3u);
+    EXPECT_EQ(similar[0], std::make_pair(1, 0.0f));
+
+    const Neighbors others = collection.findSimilarScores(1, 20, 8, 2);
+    ASSERT_EQ(others.size(), 2u);
+    EXPECT_NE(others[0].first, 1);
+    EXPECT_NE(others[1].first, 1);
+
+    // The index gives the same results with every list probed, and follows the changes
+    collection.buildDescriptorIndex(2, 2);
+    EXPECT_TRUE(collection.hasDescriptorIndex());
+    EXPECT_EQ(collection.findSimilarScores(1, 20, 2), others);
+
+    collection.addScore(CELLO_FILE);
+    EXPECT_EQ(collection.findSimilarScores(1, 1, 2), Neighbors({{3, 0.0f}}));
+    collection.removeScore(0);
+    EXPECT_EQ(collection.findSimilarScores(0, 1, 2), Neighbors({{2, 0.0f}}));
+
+    collection.clearDescriptorIndex();
+    EXPECT_FALSE(collection.hasDescriptorIndex());
+    EXPECT_EQ(collection.findSimilarScores(0, 1), Neighbors({{2, 0.0f}}));
+
+    // Descriptors on load
+    ScoreCollection loaded(std::vector<std::string>{});
+    loaded.setDescriptorOnLoad(true, 2);
+    EXPECT_TRUE(loaded.getDescriptorOnLoad());
+    loaded.merge(collection);
+    EXPECT_EQ(loaded.findSimilarScores(0, 1), Neighbors({{2, 0.0f}}));
+}
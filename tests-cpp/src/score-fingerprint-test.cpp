@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include "maiacore/score_collection.h"
+#include "maiacore/score_fingerprint.h"
+
+namespace {
+
+const std::string PRELUDE_FILE = "./test/xml_examples/Bach/prelude_1_BWV_846.xml";
+const std::string CELLO_FILE = "./test/xml_examples/Bach/cello_suite_1_violin.xml";
+const std::string QUARTET_FILE = "./test/xml_examples/Beethoven/Beethoven_quartet_133.xml";
+
+}  // namespace
+
+TEST(ScoreFingerprint, Similarity) {
+    const Score prelude(PRELUDE_FILE);
+    const Score cello(CELLO_FILE);
+
+    const ScoreFingerprint& fingerprint = prelude.getFingerprint();
+    ASSERT_EQ(fingerprint.minHashes.size(), static_cast<size_t>(ScoreFingerprint::NUM_HASHES));
+    EXPECT_GT(fingerprint.numTokens, 0);
+
+    // Same content, other object: same fingerprint
+    const Score reloaded(PRELUDE_FILE);
+    EXPECT_EQ(reloaded.getFingerprint().minHashes, fingerprint.minHashes);
+    EXPECT_DOUBLE_EQ(fingerprint.estimateSimilarity(reloaded.getFingerprint()), 1.0);
+
+    // A few measures less: near duplicate
+    Score shortened(prelude);
+    shortened.removeMeasure(prelude.getNumMeasures() - 3, prelude.getNumMeasures() - 1);
+    const double shortenedSimilarity = fingerprint.estimateSimilarity(shortened.getFingerprint());
+    EXPECT_GT(shortenedSimilarity, 0.8);
+    EXPECT_LT(shortenedSimilarity, 1.0);
+
+    // Other work
+    EXPECT_LT(fingerprint.estimateSimilarity(cello.getFingerprint()), 0.3);
+
+    // No notes: no tokens, not similar to anything
+    const Score empty({"Violin"}, 4);
+    EXPECT_EQ(empty.getFingerprint().numTokens, 0);
+    EXPECT_TRUE(empty.getFingerprint().minHashes.empty());
+    EXPECT_EQ(empty.getFingerprint().estimateSimilarity(empty.getFingerprint()), 0.0);
+}
+
+TEST(ScoreFingerprint, NearDuplicateIndex) {
+    EXPECT_THROW(NearDuplicateIndex(0), std::runtime_error);
+    EXPECT_THROW(NearDuplicateIndex(3), std::runtime_error);
+
+    const Score prelude(PRELUDE_FILE);
+    Score shortened(prelude);
+    shortened.removeMeasure(prelude.getNumMeasures() - 3, prelude.getNumMeasures() - 1);
+    const Score cello(CELLO_FILE);
+    const Score quartet(QUARTET_FILE);
+
+    NearDuplicateIndex index;
+    EXPECT_EQ(index.add(prelude.getFingerprint()), 0);
+    EXPECT_EQ(index.add(cello.getFingerprint()), 1);
+    EXPECT_EQ(index.add(quartet.getFingerprint()), 2);
+    EXPECT_EQ(index.add(shortened.getFingerprint()), 3);
+    EXPECT_EQ(index.add(cello.getFingerprint()), 4);
+    EXPECT_EQ(index.getNumFingerprints(), 5);
+
+    const std::vector<std::pair<int, double>> similar = index.findSimilar(prelude.getFingerprint(), 0.8);
+    ASSERT_EQ(similar.size(), 2u);
+    EXPECT_EQ(similar[0], std::make_pair(0, 1.0));
+    EXPECT_EQ(similar[1].first, 3);
+
+    EXPECT_EQ(index.getGroups(0.8), std::vector<std::vector<int>>({{0, 3}, {1, 4}}));
+}
+
+TEST(ScoreFingerprint, CollectionNearDuplicates) {
+    ScoreCollection collection(std::vector<std::string>{});
+    collection.addScore(PRELUDE_FILE);
+    collection.addScore(CELLO_FILE);
+    collection.addScore(QUARTET_FILE);
+    collection.addScore(PRELUDE_FILE);
+    collection.addScore(collection.getScores()[1]);  // Shared handle
+    EXPECT_FALSE(collection.getFingerprintOnLoad());
+
+    const std::vector<std::vector<int>> groups = collection.findNearDuplicates(0.8, 2);
+    EXPECT_EQ(groups, std::vector<std::vector<int>>({{0, 3}, {1, 4}}));
+
+    const std::vector<std::pair<int, double>> similar =
+        collection.findNearDuplicatesOf(Score(QUARTET_FILE), 0.8, 2);
+    ASSERT_EQ(similar.size(), 1u);
+    EXPECT_EQ(similar[0], std::make_pair(2, 1.0));
+
+    const ScoreCollection distinct = collection.withoutNearDuplicates(0.8, 2);
+    ASSERT_EQ(distinct.getNumScores(), 3);
+    EXPECT_EQ(distinct.getScores()[0], collection.getScores()[0]);
+    EXPECT_EQ(distinct.getScores()[1], collection.getScores()[1]);
+    EXPECT_EQ(distinct.getScores()[2], collection.getScores()[2]);
+    EXPECT_TRUE(distinct.findNearDuplicates(0.8, 2).empty());
+
+    // Fingerprinting stage of the loading: the new scores are fingerprinted when added
+    ScoreCollection loaded(std::vector<std::string>{});
+    loaded.setFingerprintOnLoad(true, 2);
+    EXPECT_TRUE(loaded.getFingerprintOnLoad());
+    loaded.merge(collection);
+    EXPECT_EQ(loaded.findNearDuplicates(0.8, 2), groups);
+}
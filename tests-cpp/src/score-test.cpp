@@ -728,3 +728,705 @@ TEST(ScoreCopySemantics, AssignmentOperatorSelfAssignment) {
   EXPECT_EQ(score.getNumParts(), 1);
   EXPECT_EQ(score.getNumMeasures(), 4);
 }
+
+// ====================
+// Sethares Dissonance Timeline Tests
+// ====================
+
+TEST(ScoreSetharesDissonanceTimeline, MatchesPerChordDissonance) {
+  Score score("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+
+  const auto chords = score.getChords();
+  const auto timeline = score.getSetharesDissonanceTimeline();
+
+  ASSERT_EQ(timeline.dissonance.size(), chords.size());
+  ASSERT_EQ(timeline.floatMeasure.size(), chords.size());
+  ASSERT_EQ(timeline.quarterDuration.size(), chords.size());
+  ASSERT_GT(chords.size(), 32u);
+
+  for (size_t i = 0; i < chords.size(); i++) {
+    const Chord& chord = std::get<3>(chords[i]);
+    EXPECT_EQ(timeline.measure[i], std::get<0>(chords[i]));
+    EXPECT_FLOAT_EQ(timeline.floatMeasure[i], std::get<1>(chords[i]));
+    EXPECT_EQ(timeline.keyName[i], std::get<2>(chords[i]).getName());
+    EXPECT_EQ(timeline.isHomophonic[i] != 0, std::get<4>(chords[i]));
+    EXPECT_FLOAT_EQ(timeline.quarterDuration[i], chord.getQuarterDuration());
+    EXPECT_EQ(timeline.chordSize[i], static_cast<int>(chord.size()));
+    EXPECT_FLOAT_EQ(timeline.dissonance[i], chord.getSetharesDissonance());
+  }
+
+  // Same values on a single thread
+  const auto serial = score.getSetharesDissonanceTimeline({}, 6, true, nullptr, 0.88f, nullptr,
+                                                          AnalysisContext(), 1);
+  EXPECT_EQ(serial.dissonance, timeline.dissonance);
+}
+
+TEST(ScoreSetharesDissonanceTimeline, CallbackExceptionIsPropagated) {
+  Score score("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+
+  const auto throwingCallback = [](std::vector<float>) -> float {
+    throw std::runtime_error("dissCallback error");
+  };
+
+  EXPECT_THROW(score.getSetharesDissonanceTimeline({}, 6, true, nullptr, 0.88f, throwingCallback),
+               std::runtime_error);
+}
+
+// ===================================================================================================
+// MELODY PATTERN SEARCH
+// ===================================================================================================
+
+TEST(ScoreFindMelodyPattern, FastSearchMatchesFullScan) {
+  Score score("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+
+  // First melody notes of the score
+  std::vector<Note> melody;
+  const Measure& measure = score.getPart(0).getMeasure(1);
+  for (int i = 0; i < measure.getNumNotes(0) && melody.size() < 10; i++) {
+    const Note& note = measure.getNote(i, 0);
+    if (!note.inChord() && note.getVoice() == 1) {
+      melody.push_back(note);
+    }
+  }
+  ASSERT_EQ(melody.size(), 10u);
+
+  // Same default similarity, computed by callbacks: forces the full scan
+  const auto semitonesCallback = [](const std::vector<Note>& a, const std::vector<Note>& b) {
+    return Helper::getSemitonesDifferenceBetweenMelodies(a, b);
+  };
+  const auto totalIntervalCallback = [](const std::vector<float>& diffs) {
+    return Helper::calculateMelodyEuclideanSimilarity(diffs);
+  };
+
+  const std::vector<std::vector<Note>> patterns = {
+      melody, std::vector<Note>(melody.begin(), melody.begin() + 5),
+      std::vector<Note>(melody.begin() + 2, melody.end())};
+
+  const auto durationsCallback = [](const std::vector<Note>& a, const std::vector<Note>& b) {
+    return Helper::getDurationDifferenceBetweenRhythms(a, b);
+  };
+  const auto totalRhythmCallback = [](const std::vector<float>& diffs) {
+    return Helper::calculateRhythmicEuclideanSimilarity(diffs);
+  };
+
+  for (const auto& pattern : patterns) {
+    for (const float threshold : {1.0f, 0.5f, 0.3f, 0.0f}) {
+      for (const float rhythmThreshold : {1.0f, 0.5f, 0.2f}) {
+        const auto indexed = score.findMelodyPattern(pattern, threshold, rhythmThreshold);
+        const auto scanned = score.findMelodyPattern(pattern, threshold, rhythmThreshold,
+                                                     semitonesCallback, durationsCallback,
+                                                     totalIntervalCallback, totalRhythmCallback);
+        EXPECT_EQ(indexed, scanned);
+      }
+    }
+  }
+
+  // The pattern itself is found
+  const auto exact = score.findMelodyPattern(melody, 1.0f, 1.0f);
+  ASSERT_FALSE(exact.empty());
+  EXPECT_FLOAT_EQ(std::get<10>(exact.front()), 1.0f);
+}
+
+TEST(ScoreFindMelodyPattern, MultiplePatternsSearchEveryPattern) {
+  Score score("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+
+  std::vector<Note> melody;
+  const Measure& measure = score.getPart(0).getMeasure(1);
+  for (int i = 0; i < measure.getNumNotes(0); i++) {
+    const Note& note = measure.getNote(i, 0);
+    if (!note.inChord() && note.getVoice() == 1) {
+      melody.push_back(note);
+    }
+  }
+
+  // Many more patterns than threads
+  std::vector<std::vector<Note>> patterns;
+  for (size_t size = 3; size <= 6; size++) {
+    for (size_t start = 0; start + size <= melody.size(); start++) {
+      patterns.emplace_back(melody.begin() + start, melody.begin() + start + size);
+    }
+  }
+  patterns.push_back({});  // Empty pattern: empty table
+
+  for (const int numThreads : {1, 3}) {
+    const auto results = score.findMelodyPattern(patterns, 0.5f, 0.5f, nullptr, nullptr, nullptr,
+                                                 nullptr, nullptr, numThreads);
+    ASSERT_EQ(results.size(), patterns.size());
+
+    for (size_t p = 0; p < patterns.size(); p++) {
+      EXPECT_EQ(results[p], score.findMelodyPattern(patterns[p], 0.5f, 0.5f));
+      if (!patterns[p].empty()) {
+        EXPECT_FALSE(results[p].empty());
+      }
+    }
+  }
+}
+
+TEST(ScoreFindMelodyPattern, MultiplePatternsErrors) {
+  Score score("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+  const std::vector<Note> pattern = {Note("C4"), Note("E4"), Note("G4")};
+
+  // A pattern bigger than the score is skipped
+  const std::vector<std::vector<Note>> patterns = {
+      pattern, std::vector<Note>(score.getNumNotes() + 1, Note("C4"))};
+  const auto results = score.findMelodyPattern(patterns, 0.5f, 0.5f, nullptr, nullptr, nullptr,
+                                               nullptr, nullptr, 4);
+  ASSERT_EQ(results.size(), 2u);
+  EXPECT_EQ(results[0], score.findMelodyPattern(pattern, 0.5f, 0.5f));
+  EXPECT_TRUE(results[1].empty());
+
+  // An exception of a callback, raised in every stream at the same time, is rethrown
+  const auto throwingCallback = [](const std::vector<Note>&, const std::vector<Note>&)
+      -> std::vector<float> { throw std::runtime_error("callback error"); };
+  EXPECT_THROW(score.findMelodyPattern(std::vector<std::vector<Note>>{pattern, pattern}, 0.5f,
+                                       0.5f, throwingCallback, nullptr, nullptr, nullptr, nullptr,
+                                       4),
+               std::runtime_error);
+}
+
+TEST(ScoreFindMelodyPattern, AnyPatternSkipsTransposedDuplicates) {
+  Score score({"Flute"}, 2);
+  Part& part = score.getPart(0);
+  part.getMeasure(0).addNote(std::vector<std::string>{"C4", "D4", "E4", "F4"}, 0);
+  part.getMeasure(1).addNote(std::vector<std::string>{"D4", "E4", "F#4", "G4"}, 0);
+
+  // Windows: C-D-E, D-E-F, E-F-D, F-D-E, D-E-F#. 'D-E-F#' is 'C-D-E' transposed
+  const auto results = score.findAnyMelodyPattern(3, 1.0f, 1.0f);
+  ASSERT_EQ(results.size(), 4u);
+
+  // The kept 'C-D-E' pattern finds both occurrences
+  EXPECT_EQ(results[0].size(), 2u);
+  for (const auto& table : results) {
+    EXPECT_FALSE(table.empty());
+  }
+}
+
+TEST(ScoreFindRepeatedMotifs, FindsTransposedMotifAtMaximalLength) {
+  Score score({"Flute", "Oboe"}, 2);
+  score.getPart(0).getMeasure(0).addNote(std::vector<std::string>{"C4", "D4", "E4", "C4"}, 0);
+  score.getPart(0).getMeasure(1).addNote(std::vector<std::string>{"G4", "A4", "B4", "G4"}, 0);
+  score.getPart(1).getMeasure(0).addNote(std::vector<std::string>{"F4", "G4", "A4", "F4"}, 0);
+  score.getPart(1).getMeasure(1).addNote(std::vector<std::string>{"E5", "E5", "E5", "E5"}, 0);
+
+  const auto motifs = score.findRepeatedMotifs(3);
+  ASSERT_FALSE(motifs.empty());
+
+  // 'C-D-E-C' (+2, +2, -4) in both measures of the flute and in the first one of the oboe.
+  // The last note of each occurrence is followed by different intervals, so it is maximal
+  const auto& motif = motifs.front();
+  EXPECT_EQ(motif.numNotes, 4);
+  EXPECT_EQ(motif.intervals, std::vector<int>({2, 2, -4}));
+  ASSERT_EQ(motif.occurrences.size(), 3u);
+
+  EXPECT_EQ(motif.occurrences[0].partIdx, 0);
+  EXPECT_EQ(motif.occurrences[0].noteEventIdx, 0);
+  EXPECT_EQ(motif.occurrences[0].pitches, std::vector<std::string>({"C4", "D4", "E4", "C4"}));
+  EXPECT_EQ(motif.occurrences[1].partIdx, 0);
+  EXPECT_EQ(motif.occurrences[1].noteEventIdx, 4);
+  EXPECT_EQ(motif.occurrences[1].measureIdx, 1);
+  EXPECT_EQ(motif.occurrences[2].partIdx, 1);
+  EXPECT_EQ(motif.occurrences[2].partName, "Oboe");
+  EXPECT_EQ(motif.occurrences[2].pitches, std::vector<std::string>({"F4", "G4", "A4", "F4"}));
+
+  // Every motif is exact: the intervals of each occurrence match the motif
+  for (const auto& m : motifs) {
+    EXPECT_GE(m.numNotes, 3);
+    EXPECT_GE(m.occurrences.size(), 2u);
+  }
+
+  EXPECT_THROW(score.findRepeatedMotifs(1), std::runtime_error);
+}
+
+TEST(ScoreFindRepeatedMotifs, RhythmCanBeIgnored) {
+  Score score({"Flute"}, 2);
+  Part& part = score.getPart(0);
+  part.getMeasure(0).addNote(std::vector<std::string>{"C4", "D4", "E4", "F4"}, 0);
+  part.getMeasure(1).addNote(Note("D4", RhythmFigure::HALF), 0);
+  part.getMeasure(1).addNote(std::vector<std::string>{"E4", "F#4"}, 0);
+
+  // Same contour (+2, +2) with a different first duration
+  EXPECT_TRUE(score.findRepeatedMotifs(3, 2, true).empty());
+
+  const auto motifs = score.findRepeatedMotifs(3, 2, false);
+  ASSERT_EQ(motifs.size(), 1u);
+  EXPECT_EQ(motifs[0].numNotes, 3);
+  EXPECT_EQ(motifs[0].occurrences.size(), 2u);
+}
+
+TEST(ScoreFindRepeatedMotifs, ComparesTheLastNoteOfTheMotif) {
+  // 'C D D' and 'C D rest' have the same intervals (+2, 0)
+  Score restScore({"Flute"}, 2);
+  restScore.getPart(0).getMeasure(0).addNote(std::vector<std::string>{"C4", "D4", "D4", "A5"}, 0);
+  restScore.getPart(0).getMeasure(1).addNote(std::vector<std::string>{"C4", "D4", "rest", "B3"}, 0);
+  EXPECT_TRUE(restScore.findRepeatedMotifs(3, 2, false).empty());
+
+  // Same notes, but the last D of the second statement is longer
+  Score rhythmScore({"Flute"}, 2);
+  Part& part = rhythmScore.getPart(0);
+  part.getMeasure(0).addNote(std::vector<std::string>{"C4", "D4", "D4", "A5"}, 0);
+  part.getMeasure(1).addNote(Note("C4"), 0);
+  part.getMeasure(1).addNote(Note("D4"), 0);
+  part.getMeasure(1).addNote(Note("D4", RhythmFigure::HALF), 0);
+  EXPECT_TRUE(rhythmScore.findRepeatedMotifs(3, 2, true).empty());
+
+  const auto motifs = rhythmScore.findRepeatedMotifs(3, 2, false);
+  ASSERT_EQ(motifs.size(), 1u);
+  EXPECT_EQ(motifs[0].occurrences.size(), 2u);
+  EXPECT_EQ(motifs[0].occurrences[1].measureIdx, 1);
+}
+
+TEST(ScoreFindMelodyPatternDtw, FindsOrnamentedStatement) {
+  Score score({"Violin"}, 3);
+  Part& part = score.getPart(0);
+  part.getMeasure(0).addNote(std::vector<std::string>{"C4", "E4", "G4", "C5"}, 0);
+  // Same arpeggio in G, with a passing tone between the first two notes
+  part.getMeasure(1).addNote(std::vector<std::string>{"G4", "A4", "B4", "D5"}, 0);
+  part.getMeasure(2).addNote(std::vector<std::string>{"G5", "A4", "A4", "A4"}, 0);
+
+  const std::vector<Note> pattern = {Note("C4"), Note("E4"), Note("G4"), Note("C5")};
+  const std::vector<std::string> exact = {"C4", "E4", "G4", "C5"};
+  const std::vector<std::string> ornamented = {"G4", "A4", "B4", "D5", "G5"};
+
+  const auto findSegment = [](const Score::MelodyPatternTable& table,
+                              const std::vector<std::string>& pitches) {
+    return std::find_if(table.begin(), table.end(), [&pitches](const Score::MelodyPatternRow& row) {
+      return std::get<5>(row) == pitches;
+    });
+  };
+
+  // One-to-one alignment: the ornamented statement is missed
+  const auto euclidean = score.findMelodyPattern(pattern, 0.3f, 0.0f);
+  EXPECT_NE(findSegment(euclidean, exact), euclidean.end());
+  EXPECT_EQ(findSegment(euclidean, {"G4", "A4", "B4", "D5"}), euclidean.end());
+
+  // DTW: the passing tone is aligned with its neighbour (4 semitones away, squared)
+  const auto dtw = score.findMelodyPattern(pattern, 0.3f, 0.0f, nullptr, nullptr, nullptr, nullptr,
+                                           nullptr, MelodySimilarityMetric::DTW, 1);
+  const auto exactRow = findSegment(dtw, exact);
+  ASSERT_NE(exactRow, dtw.end());
+  EXPECT_FLOAT_EQ(std::get<8>(*exactRow), 1.0f);
+
+  const auto ornamentedRow = findSegment(dtw, ornamented);
+  ASSERT_NE(ornamentedRow, dtw.end());
+  EXPECT_FLOAT_EQ(std::get<8>(*ornamentedRow), 1.0f / 3.0f);
+  EXPECT_EQ(std::get<1>(*ornamentedRow), 1);
+  EXPECT_EQ(std::get<6>(*ornamentedRow).size(), 5u);  // One entry per warping path step
+
+  // Custom similarity callbacks are Euclidean only
+  const auto callback = [](const std::vector<Note>& a, const std::vector<Note>& b) {
+    return Helper::getSemitonesDifferenceBetweenMelodies(a, b);
+  };
+  EXPECT_THROW(score.findMelodyPattern(pattern, 0.3f, 0.0f, callback, nullptr, nullptr, nullptr,
+                                       nullptr, MelodySimilarityMetric::DTW),
+               std::runtime_error);
+}
+
+TEST(ScoreFindMelodyPatternDtw, LowerBoundPruningKeepsResults) {
+  Score score("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+
+  std::vector<Note> melody;
+  const Measure& measure = score.getPart(0).getMeasure(1);
+  for (int i = 0; i < measure.getNumNotes(0) && melody.size() < 6; i++) {
+    const Note& note = measure.getNote(i, 0);
+    if (!note.inChord() && note.getVoice() == 1) {
+      melody.push_back(note);
+    }
+  }
+
+  for (const int warpingWindow : {0, 2}) {
+    // Threshold 0: no pruning at all
+    const auto all = score.findMelodyPattern(melody, 0.0f, 0.0f, nullptr, nullptr, nullptr,
+                                             nullptr, nullptr, MelodySimilarityMetric::DTW,
+                                             warpingWindow);
+
+    for (const float threshold : {0.2f, 0.3f, 0.5f, 1.0f}) {
+      Score::MelodyPatternTable expected;
+      for (const auto& row : all) {
+        if (std::get<8>(row) >= threshold) {
+          expected.push_back(row);
+        }
+      }
+
+      const auto pruned = score.findMelodyPattern(melody, threshold, 0.0f, nullptr, nullptr,
+                                                  nullptr, nullptr, nullptr,
+                                                  MelodySimilarityMetric::DTW, warpingWindow);
+      EXPECT_EQ(pruned, expected);
+      EXPECT_FALSE(pruned.empty());
+    }
+  }
+}
+
+TEST(ScoreMelodyPatternSinks, MatchCountAndTopK) {
+  Score score("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+
+  std::vector<Note> melody;
+  const Measure& measure = score.getPart(0).getMeasure(1);
+  for (int i = 0; i < measure.getNumNotes(0) && melody.size() < 5; i++) {
+    const Note& note = measure.getNote(i, 0);
+    if (!note.inChord() && note.getVoice() == 1) {
+      melody.push_back(note);
+    }
+  }
+
+  for (const auto metric : {MelodySimilarityMetric::EUCLIDEAN, MelodySimilarityMetric::DTW}) {
+    const auto table = score.findMelodyPattern(melody, 0.3f, 0.3f, nullptr, nullptr, nullptr,
+                                               nullptr, nullptr, metric);
+    ASSERT_GT(table.size(), 10u);
+
+    // Count-only
+    EXPECT_EQ(score.countMelodyPattern(melody, 0.3f, 0.3f, metric), table.size());
+
+    // Streaming: compact rows in the same order of the table
+    std::vector<Score::MelodyPatternMatch> matches;
+    score.findMelodyPatternMatches(
+        melody, [&matches](const Score::MelodyPatternMatch& match) { matches.push_back(match); },
+        0.3f, 0.3f, metric);
+    ASSERT_EQ(matches.size(), table.size());
+
+    const auto& keyNames = score.getMelodySearchKeyNames();
+    for (size_t i = 0; i < table.size(); i++) {
+      EXPECT_EQ(score.getPart(matches[i].partIdx).getName(), std::get<0>(table[i]));
+      EXPECT_EQ(matches[i].measureIdx, std::get<1>(table[i]));
+      EXPECT_EQ(matches[i].staveIdx, std::get<2>(table[i]));
+      EXPECT_EQ(keyNames[matches[i].keyIdx], std::get<3>(table[i]));
+      EXPECT_EQ(matches[i].numNotes, static_cast<int>(std::get<5>(table[i]).size()));
+      EXPECT_FLOAT_EQ(matches[i].totalSimilarity, std::get<10>(table[i]));
+    }
+
+    // Top-k: the first k rows of the table ranked by total similarity (stable)
+    auto ranked = table;
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const Score::MelodyPatternRow& a, const Score::MelodyPatternRow& b) {
+                       return std::get<10>(a) > std::get<10>(b);
+                     });
+
+    for (const size_t k : {size_t(0), size_t(1), size_t(7), table.size() + 5}) {
+      const auto top = score.findTopMelodyPattern(melody, k, 0.3f, 0.3f, metric);
+      const size_t expectedSize = std::min(k, ranked.size());
+      ASSERT_EQ(top.size(), expectedSize);
+      EXPECT_TRUE(std::equal(top.begin(), top.end(), ranked.begin()));
+    }
+  }
+}
+
+TEST(ScoreMelodyPatternBatched, BatchCallbackMatchesDefaultSimilarity) {
+  Score score("./test/xml_examples/Bach/prelude_1_BWV_846.xml");
+
+  std::vector<Note> melody;
+  const Measure& measure = score.getPart(0).getMeasure(1);
+  for (int i = 0; i < measure.getNumNotes(0) && melody.size() < 6; i++) {
+    const Note& note = measure.getNote(i, 0);
+    if (!note.inChord() && note.getVoice() == 1) {
+      melody.push_back(note);
+    }
+  }
+
+  // Default Euclidean similarities, computed for all windows of a part at once
+  int numCalls = 0;
+  const auto batchCallback = [&numCalls](const Score::MelodyWindowBatch& pattern,
+                                         const Score::MelodyWindowBatch& windows) {
+    numCalls++;
+    const int size = windows.windowSize;
+    const auto interval = [size](const Score::MelodyWindowBatch& batch, int row, int k) {
+      const int idx = row * size + k;
+      if (batch.restMask[idx] || batch.restMask[idx + 1]) {
+        return 0;
+      }
+      return batch.midiNumbers[idx + 1] - batch.midiNumbers[idx];
+    };
+    const auto maxDuration = [size](const Score::MelodyWindowBatch& batch, int row) {
+      float maxValue = 0.0f;
+      for (int k = 0; k < size; k++) {
+        maxValue = std::max(maxValue, batch.quarterDurations[row * size + k]);
+      }
+      return maxValue;
+    };
+
+    std::vector<float> intervalSimilarity(windows.numWindows);
+    std::vector<float> rhythmSimilarity(windows.numWindows);
+    const float patternMax = maxDuration(pattern, 0);
+    for (int w = 0; w < windows.numWindows; w++) {
+      float intervalSum = 0.0f;
+      for (int k = 0; k + 1 < size; k++) {
+        const float semitone = (float)interval(pattern, 0, k) - (float)interval(windows, w, k);
+        intervalSum += std::pow(semitone, 2);
+      }
+      intervalSimilarity[w] = 1.0f / (1.0f + std::sqrt(intervalSum));
+
+      const float windowMax = maxDuration(windows, w);
+      float rhythmSum = 0.0f;
+      for (int k = 0; k < size; k++) {
+        const float diff = pattern.quarterDurations[k] / patternMax -
+                           windows.quarterDurations[w * size + k] / windowMax;
+        rhythmSum += std::pow(diff, 2);
+      }
+      rhythmSimilarity[w] = 1.0f / (1.0f + std::sqrt(rhythmSum));
+    }
+    return std::make_pair(intervalSimilarity, rhythmSimilarity);
+  };
+
+  for (const float threshold : {1.0f, 0.5f, 0.3f}) {
+    numCalls = 0;
+    const auto batched = score.findMelodyPatternBatched(melody, batchCallback, threshold, 0.3f);
+    EXPECT_EQ(batched, score.findMelodyPattern(melody, threshold, 0.3f));
+    EXPECT_EQ(numCalls, score.getNumParts());  // One call per part
+  }
+
+  const auto wrongSize = [](const Score::MelodyWindowBatch&, const Score::MelodyWindowBatch&) {
+    return std::make_pair(std::vector<float>{1.0f}, std::vector<float>{1.0f});
+  };
+  EXPECT_THROW(score.findMelodyPatternBatched(melody, wrongSize), std::runtime_error);
+}
+
+TEST(ScoreFindMelodyRegex, FindsTransposedStructure) {
+  Score score({"Flute", "Oboe"}, 2);
+  score.getPart(0).getMeasure(0).addNote(std::vector<std::string>{"C4", "Eb4", "Eb4", "D4"}, 0);
+  score.getPart(0).getMeasure(1).addNote(std::vector<std::string>{"G4", "Bb4", "Bb4", "A4"}, 0);
+  score.getPart(1).getMeasure(0).addNote(std::vector<std::string>{"F4", "Ab4", "G4", "F4"}, 0);
+  score.getPart(1).getMeasure(1).addNote(std::vector<std::string>{"E5", "E5", "E5", "E5"}, 0);
+
+  // Rising minor third, any number of repeated notes, then a descending step
+  const auto matches = score.findMelodyRegex("[i=+3] [same]* [i=-2..-1]");
+  ASSERT_EQ(matches.size(), 3u);
+
+  EXPECT_EQ(matches[0].partIdx, 0);
+  EXPECT_EQ(matches[0].noteEventIdx, 1);
+  EXPECT_EQ(matches[0].numNotes, 3);
+  EXPECT_EQ(matches[0].pitches, std::vector<std::string>({"Eb4", "Eb4", "D4"}));
+  EXPECT_EQ(matches[1].measureIdx, 1);
+  EXPECT_EQ(matches[1].noteEventIdx, 5);
+  EXPECT_EQ(matches[2].partName, "Oboe");
+  EXPECT_EQ(matches[2].pitches, std::vector<std::string>({"Ab4", "G4"}));
+
+  EXPECT_EQ(score.findMelodyRegex("[same]{3}").size(), 1u);
+  EXPECT_THROW(score.findMelodyRegex("[i=+3"), std::runtime_error);
+}
+
+TEST(ScoreFindRhythmPattern, FindsCellAcrossMeasuresAndRests) {
+  Score score({"Flute"}, 2);
+  Measure& first = score.getPart(0).getMeasure(0);
+  Measure& second = score.getPart(0).getMeasure(1);
+
+  Note dottedEighth("C4", RhythmFigure::EIGHTH);
+  dottedEighth.setDuration(0.75f);
+  const Note sixteenth("D4", RhythmFigure::N16TH);
+  first.addNote({dottedEighth, sixteenth, Note("E4"), dottedEighth, sixteenth, Note("A4")}, 0);
+  second.addNote({Note("rest"), dottedEighth, sixteenth, Note("F5", RhythmFigure::HALF)}, 0);
+
+  // Onsets: 0, 0.75, 1, 2, 2.75, 3 | 5, 5.75, 6 (the rest extends the IOI 3 -> 5)
+  const auto matches = score.findRhythmPattern(std::vector<float>{0.75f, 0.25f});
+  ASSERT_EQ(matches.size(), 3u);
+  EXPECT_FLOAT_EQ(matches[0].quarterOnset, 0.0f);
+  EXPECT_FLOAT_EQ(matches[1].quarterOnset, 2.0f);
+  EXPECT_EQ(matches[2].onsetIdx, 6);
+  EXPECT_EQ(matches[2].measureIdx, 1);
+  EXPECT_FLOAT_EQ(matches[2].quarterOnset, 5.0f);
+  EXPECT_EQ(matches[2].interOnsetIntervals, std::vector<float>({0.75f, 0.25f}));
+  EXPECT_EQ(matches[0].partName, "Flute");
+  EXPECT_EQ(matches[0].voice, 1);
+
+  // Same cell given as notes: pitches and the last duration are ignored
+  const auto noteMatches = score.findRhythmPattern({dottedEighth, sixteenth, Note("G5", RhythmFigure::WHOLE)});
+  ASSERT_EQ(noteMatches.size(), matches.size());
+  EXPECT_EQ(noteMatches[1].onsetIdx, matches[1].onsetIdx);
+
+  EXPECT_EQ(score.findRhythmPattern(std::vector<float>{0.25f, 2.0f}).size(), 1u);
+  EXPECT_THROW(score.findRhythmPattern(std::vector<Note>{Note("C4")}), std::runtime_error);
+}
+
+TEST(ScoreFindRhythmPattern, TiesAndToleranceForTriplets) {
+  Score score({"Drums"}, 2);
+
+  // Measure 1: a tied quarter pair is a single onset
+  Note tieStart("C4");
+  tieStart.setTieStart();
+  Note tieStop("C4");
+  tieStop.setTieStop();
+  score.getPart(0).getMeasure(0).addNote({tieStart, tieStop, Note("D4", RhythmFigure::HALF)}, 0);
+
+  // Measure 2: swung eighths as triplet quarter + triplet eighth (2/3 + 1/3)
+  Note longSwing("C4");
+  longSwing.setDuration(Duration(8, 12, 3, 2));
+  Note shortSwing("C4");
+  shortSwing.setDuration(Duration(4, 12, 3, 2));
+  score.getPart(0).getMeasure(1).addNote(
+      {longSwing, shortSwing, longSwing, shortSwing, longSwing, shortSwing, longSwing, shortSwing}, 0);
+
+  // Onsets: 0, 2 | 4, 4.67, 5, 5.67, 6, 6.67, 7, 7.67
+  EXPECT_EQ(score.findRhythmPattern(std::vector<float>{2.0f, 2.0f}).size(), 1u);
+  EXPECT_TRUE(score.findRhythmPattern(std::vector<float>{1.0f, 1.0f}).empty());
+
+  // Exact triplet cell: the grid is the LCM of 256 and 12 divisions per quarter
+  const auto triplets = score.findRhythmPattern({longSwing, shortSwing, longSwing});
+  ASSERT_EQ(triplets.size(), 3u);
+  EXPECT_NEAR(triplets[0].interOnsetIntervals[0], 2.0f / 3.0f, 1e-6);
+  EXPECT_FLOAT_EQ(triplets[0].maxDeviation, 0.0f);
+
+  // Straight eighths match the swung pairs only with a tolerance
+  EXPECT_TRUE(score.findRhythmPattern(std::vector<float>{0.5f, 0.5f}).empty());
+  const auto swing = score.findRhythmPattern(std::vector<float>{0.5f, 0.5f}, 0.35f);
+  EXPECT_EQ(swing.size(), 6u);
+  EXPECT_NEAR(swing[0].maxDeviation, 1.0f / 3.0f, 1e-3);
+}
+
+TEST(ScoreFindRhythmPattern, SearchesEveryVoiceOfUnpitchedParts) {
+  Score score("./test/xml_examples/unit_test/test_unpitched.xml");
+
+  // The percussion voice 2 plays four quarters, the other voices two
+  const auto matches = score.findRhythmPattern(std::vector<float>{1.0f, 1.0f});
+  ASSERT_EQ(matches.size(), 2u);
+  EXPECT_EQ(matches[0].partIdx, 1);
+  EXPECT_EQ(matches[0].voice, 2);
+  EXPECT_EQ(matches[1].onsetIdx, 1);
+
+  EXPECT_TRUE(score.findRhythmPattern(std::vector<float>{1.0f, 1.0f}, 0.0f, false).empty());
+}
+
+TEST(ScoreFindChordProgression, FindsCadencesInAnyInversion) {
+  // C major, quarter-note chords: ii V I vi | ii6 V vi I
+  Score score({"Soprano", "Alto", "Bass"}, 2);
+  score.getPart(0).getMeasure(0).addNote(std::vector<std::string>{"A4", "B4", "G4", "C5"}, 0);
+  score.getPart(1).getMeasure(0).addNote(std::vector<std::string>{"F4", "D4", "E4", "E4"}, 0);
+  score.getPart(2).getMeasure(0).addNote(std::vector<std::string>{"D3", "G2", "C3", "A2"}, 0);
+  score.getPart(0).getMeasure(1).addNote(std::vector<std::string>{"D5", "D5", "E5", "E5"}, 0);
+  score.getPart(1).getMeasure(1).addNote(std::vector<std::string>{"A4", "B4", "C5", "G4"}, 0);
+  score.getPart(2).getMeasure(1).addNote(std::vector<std::string>{"F3", "G3", "A3", "C3"}, 0);
+
+  const auto& slices = score.getHarmonicIndex();
+  ASSERT_EQ(slices.size(), 8u);
+  EXPECT_EQ(&slices, &score.getHarmonicIndex());  // Cached
+  const std::vector<int> expectedDegrees = {2, 5, 1, 6, 2, 5, 6, 1};
+  for (size_t s = 0; s < slices.size(); s++) {
+    EXPECT_EQ(slices[s].degree, expectedDegrees[s]);
+    EXPECT_EQ(slices[s].measure, static_cast<int>(s / 4) + 1);
+  }
+  EXPECT_EQ(slices[0].rootPitchClass, 2);
+  EXPECT_EQ(slices[0].quality, "minor");
+  EXPECT_EQ(slices[0].romanDegree, "II");
+  EXPECT_TRUE(slices[0].isInRootPosition);
+  EXPECT_FALSE(slices[4].isInRootPosition);  // ii6
+
+  const auto iiVI = score.findChordProgression("ii:minor V:major I:major");
+  ASSERT_EQ(iiVI.size(), 1u);
+  EXPECT_EQ(iiVI[0].firstSliceIdx, 0);
+  EXPECT_EQ(iiVI[0].numSlices, 3);
+  EXPECT_EQ(iiVI[0].startMeasure, 1);
+  EXPECT_EQ(iiVI[0].romanDegrees, std::vector<std::string>({"II", "V", "I"}));
+  EXPECT_EQ(iiVI[0].qualities, std::vector<std::string>({"minor", "major", "major"}));
+
+  // Deceptive cadence after the inverted ii
+  const auto deceptive = score.findChordProgression("II V VI");
+  ASSERT_EQ(deceptive.size(), 1u);
+  EXPECT_EQ(deceptive[0].firstSliceIdx, 4);
+  EXPECT_EQ(deceptive[0].startMeasure, 2);
+  EXPECT_EQ(deceptive[0].endMeasure, 2);
+  EXPECT_FLOAT_EQ(deceptive[0].startFloatMeasure, 2.0f);
+  EXPECT_FLOAT_EQ(deceptive[0].endFloatMeasure, 2.5f);
+
+  EXPECT_EQ(score.findChordProgression("@:minor @+5:major @+5").size(), 1u);
+  EXPECT_EQ(score.findChordProgression("* V").size(), 2u);
+  EXPECT_THROW(score.findChordProgression("II X"), std::runtime_error);
+}
+
+TEST(ScoreFindChordProgression, MergesRepeatedChords) {
+  // V is re-attacked in another inversion before resolving
+  Score score({"Soprano", "Alto", "Bass"}, 1);
+  score.getPart(0).getMeasure(0).addNote(std::vector<std::string>{"D5", "G4", "B4", "G4"}, 0);
+  score.getPart(1).getMeasure(0).addNote(std::vector<std::string>{"B3", "D4", "D4", "E4"}, 0);
+  score.getPart(2).getMeasure(0).addNote(std::vector<std::string>{"G2", "B2", "G2", "C3"}, 0);
+
+  ASSERT_EQ(score.getHarmonicIndex().size(), 4u);
+
+  const auto merged = score.findChordProgression("V I");
+  ASSERT_EQ(merged.size(), 1u);
+  EXPECT_EQ(merged[0].firstSliceIdx, 0);
+  EXPECT_EQ(merged[0].numSlices, 4);
+
+  const auto unmerged = score.findChordProgression("V I", {}, false);
+  ASSERT_EQ(unmerged.size(), 1u);
+  EXPECT_EQ(unmerged[0].firstSliceIdx, 2);
+  EXPECT_EQ(unmerged[0].numSlices, 2);
+  EXPECT_EQ(score.findChordProgression("V V V I", {}, false).size(), 1u);
+}
+
+TEST(ScoreMelodyStreams, SplitsVoicesAndOuterLines) {
+  Score score({"Violin"}, 1);
+  score.addPart("Piano", 2);
+  Measure& measure = score.getPart(1).getMeasure(0);
+
+  // Staff 1, voice 1: a chord (highest note G5) and three notes
+  Note chordThird("E4");
+  chordThird.setIsInChord(true);
+  Note chordTop("G5");
+  chordTop.setIsInChord(true);
+  measure.addNote({Note("C4"), chordThird, chordTop, Note("D5"), Note("E5"), Note("F5")}, 0);
+
+  // Staff 1, voice 2
+  for (const std::string pitch : {"A3", "B3", "C4", "D4"}) {
+    Note note(pitch);
+    note.setVoice(2);
+    measure.addNote(note, 0);
+  }
+
+  // Staff 2, voice 1
+  measure.addNote({Note("C3", RhythmFigure::HALF), Note("G2", RhythmFigure::HALF)}, 1);
+
+  const std::string pattern = "N [i=+2] [i=+1] [i=+2]";
+
+  // Default: one stream per part, without chord notes and voice 2
+  auto streams = score.getMelodyStreams();
+  ASSERT_EQ(streams.size(), 2u);
+  EXPECT_EQ(streams[1].type, MelodyStreamType::PART);
+  EXPECT_EQ(streams[1].numNoteEvents, 6);
+  EXPECT_TRUE(score.findMelodyRegex(pattern).empty());
+
+  score.setMelodyStreams(true, true, true);
+  streams = score.getMelodyStreams();
+  ASSERT_EQ(streams.size(), 5u);  // The empty violin part has no voices
+  EXPECT_EQ(streams[0].type, MelodyStreamType::VOICE);
+  EXPECT_EQ(streams[0].partName, "Piano");
+  EXPECT_EQ(streams[1].staveIdx, 0);
+  EXPECT_EQ(streams[1].voice, 2);
+  EXPECT_EQ(streams[2].staveIdx, 1);
+  EXPECT_EQ(streams[3].type, MelodyStreamType::SKYLINE);
+  EXPECT_EQ(streams[4].type, MelodyStreamType::BASSLINE);
+
+  const auto matches = score.findMelodyRegex(pattern);
+  ASSERT_EQ(matches.size(), 1u);
+  EXPECT_EQ(matches[0].partIdx, 1);
+  EXPECT_EQ(matches[0].streamIdx, 1);
+  EXPECT_EQ(matches[0].pitches, std::vector<std::string>({"A3", "B3", "C4", "D4"}));
+
+  const auto streamPitches = [&score](const std::string& regex) {
+    std::vector<std::vector<std::string>> pitches;
+    for (const auto& match : score.findMelodyRegex(regex)) {
+      pitches.push_back(match.pitches);
+    }
+    return pitches;
+  };
+  const std::vector<std::vector<std::string>> expected = {
+      {"G5", "D5", "E5", "F5"}, {"A3", "B3", "C4", "D4"}, {"C3", "G2"},
+      {"G5", "D5", "E5", "F5"}, {"C3", "B3", "G2", "D4"}};
+  EXPECT_EQ(streamPitches("N+"), expected);
+
+  // The other engines share the same streams
+  std::vector<Score::MelodyPatternMatch> patternMatches;
+  score.findMelodyPatternMatches(
+      {Note("D4"), Note("E4"), Note("F4")},
+      [&patternMatches](const Score::MelodyPatternMatch& match) { patternMatches.push_back(match); },
+      0.99f, 0.99f);
+  ASSERT_EQ(patternMatches.size(), 1u);
+  EXPECT_EQ(patternMatches[0].streamIdx, 1);
+  EXPECT_EQ(patternMatches[0].partIdx, 1);
+
+  const auto tables = score.findMelodyPattern(
+      std::vector<std::vector<Note>>{{Note("D4"), Note("E4"), Note("F4")}}, 0.99f,
+      0.99f, nullptr, nullptr, nullptr, nullptr, nullptr, 2);
+  ASSERT_EQ(tables.size(), 1u);
+  ASSERT_EQ(tables[0].size(), 1u);
+  EXPECT_EQ(std::get<0>(tables[0][0]), "Piano");
+
+  // Copies keep the selection
+  const Score copy = score;
+  EXPECT_EQ(copy.getMelodyStreams().size(), 5u);
+}
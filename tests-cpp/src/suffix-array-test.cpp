@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "maiacore/suffix_array.h"
+
+namespace {
+
+std::vector<int> toTokens(const std::string& text) {
+    return std::vector<int>(text.begin(), text.end());
+}
+
+// Reference suffix array: sorts the suffixes by direct comparison
+std::vector<int> naiveSuffixArray(const std::vector<int>& text) {
+    std::vector<int> sa(text.size());
+    std::iota(sa.begin(), sa.end(), 0);
+    std::sort(sa.begin(), sa.end(), [&text](const int a, const int b) {
+        return std::lexicographical_compare(text.begin() + a, text.end(), text.begin() + b,
+                                            text.end());
+    });
+    return sa;
+}
+
+}  // namespace
+
+// ============================================================================
+// Suffix Array Construction Tests
+// ============================================================================
+
+TEST(SuffixArrayConstruction, Banana) {
+    const SuffixArray suffixArray(toTokens("banana"));
+
+    EXPECT_EQ(suffixArray.size(), 6u);
+    EXPECT_EQ(suffixArray.getSuffixArray(), std::vector<int>({5, 3, 1, 0, 4, 2}));
+    EXPECT_EQ(suffixArray.getLcpArray(), std::vector<int>({0, 1, 3, 0, 0, 2}));
+}
+
+TEST(SuffixArrayConstruction, EmptyAndSingleToken) {
+    const SuffixArray empty({});
+    EXPECT_EQ(empty.size(), 0u);
+    EXPECT_TRUE(empty.getSuffixArray().empty());
+    EXPECT_TRUE(empty.getMaximalRepeats().empty());
+
+    const SuffixArray single({7});
+    EXPECT_EQ(single.getSuffixArray(), std::vector<int>({0}));
+    EXPECT_TRUE(single.getMaximalRepeats().empty());
+}
+
+TEST(SuffixArrayConstruction, MatchesNaiveSort) {
+    std::mt19937 generator(42);
+    for (const int alphabetSize : {1, 2, 4, 50}) {
+        std::uniform_int_distribution<int> distribution(0, alphabetSize - 1);
+        std::vector<int> text(300);
+        for (int& token : text) {
+            token = distribution(generator);
+        }
+
+        const SuffixArray suffixArray(text);
+        const auto& sa = suffixArray.getSuffixArray();
+        EXPECT_EQ(sa, naiveSuffixArray(text));
+
+        const auto& lcp = suffixArray.getLcpArray();
+        for (size_t i = 1; i < sa.size(); i++) {
+            int h = 0;
+            while (sa[i] + h < static_cast<int>(text.size()) &&
+                   sa[i - 1] + h < static_cast<int>(text.size()) &&
+                   text[sa[i] + h] == text[sa[i - 1] + h]) {
+                h++;
+            }
+            EXPECT_EQ(lcp[i], h);
+        }
+    }
+}
+
+TEST(SuffixArrayConstruction, NegativeTokenThrows) {
+    EXPECT_THROW(SuffixArray({1, -2, 3}), std::runtime_error);
+}
+
+// ============================================================================
+// Maximal Repeats Tests
+// ============================================================================
+
+TEST(SuffixArrayMaximalRepeats, Banana) {
+    const SuffixArray suffixArray(toTokens("banana"));
+    auto repeats = suffixArray.getMaximalRepeats();
+    std::sort(repeats.begin(), repeats.end(),
+              [](const SuffixArray::Repeat& a, const SuffixArray::Repeat& b) {
+                  return a.length < b.length;
+              });
+
+    // "a" (1, 3, 5) and "ana" (1, 3). "an" and "na" always extend to "ana"
+    ASSERT_EQ(repeats.size(), 2u);
+    EXPECT_EQ(repeats[0].length, 1);
+    EXPECT_EQ(repeats[0].positions, std::vector<int>({1, 3, 5}));
+    EXPECT_EQ(repeats[1].length, 3);
+    EXPECT_EQ(repeats[1].positions, std::vector<int>({1, 3}));
+}
+
+TEST(SuffixArrayMaximalRepeats, FiltersByLengthAndOccurrences) {
+    const SuffixArray suffixArray(toTokens("banana"));
+
+    const auto longRepeats = suffixArray.getMaximalRepeats(2);
+    ASSERT_EQ(longRepeats.size(), 1u);
+    EXPECT_EQ(longRepeats[0].length, 3);
+
+    const auto frequentRepeats = suffixArray.getMaximalRepeats(1, 3);
+    ASSERT_EQ(frequentRepeats.size(), 1u);
+    EXPECT_EQ(frequentRepeats[0].length, 1);
+}
+
+TEST(SuffixArrayMaximalRepeats, UniqueSeparatorsSplitSequences) {
+    // "abcd" + "#" + "xbcy": "bc" repeats, but nothing crosses the separator
+    const SuffixArray suffixArray(toTokens("abcd#xbcy"));
+    const auto repeats = suffixArray.getMaximalRepeats(2);
+
+    ASSERT_EQ(repeats.size(), 1u);
+    EXPECT_EQ(repeats[0].length, 2);
+    EXPECT_EQ(repeats[0].positions, std::vector<int>({1, 6}));
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "maiacore/reducers.h"
+#include "maiacore/thread_pool.h"
+
+// ============================================================================
+// Thread Count Tests
+// ============================================================================
+
+TEST(ThreadPoolNumThreads, ExplicitValue) {
+    EXPECT_EQ(ThreadPool::getNumThreads(3), 3);
+    EXPECT_EQ(ThreadPool::getNumThreads(1), 1);
+}
+
+TEST(ThreadPoolNumThreads, DefaultIsHardwareConcurrency) {
+    EXPECT_GE(ThreadPool::getNumThreads(), 1);
+    EXPECT_GE(ThreadPool::getNumThreads(0), 1);
+    EXPECT_GE(ThreadPool::getNumThreads(-2), 1);
+}
+
+// ============================================================================
+// parallelFor Tests
+// ============================================================================
+
+TEST(ThreadPoolParallelFor, RunsEveryTaskOnce) {
+    for (const int numThreads : {1, 2, 4, 7}) {
+        for (const size_t chunkSize : {0, 1, 3, 64}) {
+            std::vector<std::atomic<int>> counts(1000);
+            ThreadPool::parallelFor(counts.size(), [&counts](const size_t idx) { counts[idx]++; },
+                                    numThreads, chunkSize);
+
+            for (const auto& count : counts) {
+                EXPECT_EQ(count.load(), 1);
+            }
+        }
+    }
+}
+
+TEST(ThreadPoolParallelFor, MoreThreadsThanTasks) {
+    std::vector<int> values(3, 0);
+    ThreadPool::parallelFor(values.size(), [&values](const size_t idx) { values[idx] = idx + 1; }, 16);
+
+    EXPECT_EQ(values, std::vector<int>({1, 2, 3}));
+}
+
+TEST(ThreadPoolParallelFor, UnbalancedTasks) {
+    // The first tasks are much more expensive: the other workers must steal them
+    std::vector<double> values(64, 0.0);
+    ThreadPool::parallelFor(values.size(), [&values](const size_t idx) {
+        const int numIterations = (idx < 4) ? 200000 : 10;
+        double sum = 0.0;
+        for (int i = 0; i < numIterations; i++) {
+            sum += 1.0;
+        }
+        values[idx] = sum;
+    }, 4, 1);
+
+    for (size_t i = 0; i < values.size(); i++) {
+        EXPECT_DOUBLE_EQ(values[i], (i < 4) ? 200000.0 : 10.0);
+    }
+}
+
+TEST(ThreadPoolParallelFor, ZeroTasks) {
+    bool called = false;
+    ThreadPool::parallelFor(0, [&called](const size_t) { called = true; });
+
+    EXPECT_FALSE(called);
+}
+
+TEST(ThreadPoolParallelFor, ExceptionIsPropagated) {
+    for (const int numThreads : {1, 4}) {
+        EXPECT_THROW(ThreadPool::parallelFor(100, [](const size_t idx) {
+            if (idx == 42) {
+                throw std::runtime_error("task error");
+            }
+        }, numThreads), std::runtime_error);
+    }
+}
+
+TEST(ThreadPoolParallelFor, WorkerBuffersWithoutLocks) {
+    const int numThreads = 4;
+    std::vector<std::vector<size_t>> buffers(ThreadPool::getNumThreads(numThreads));
+    ThreadPool::parallelForWithWorker(1000, [&buffers](const size_t idx, const size_t workerIdx) {
+        buffers.at(workerIdx).push_back(idx);
+    }, numThreads, 1);
+
+    std::vector<size_t> merged;
+    for (const auto& buffer : buffers) {
+        merged.insert(merged.end(), buffer.begin(), buffer.end());
+    }
+    std::sort(merged.begin(), merged.end());
+
+    ASSERT_EQ(merged.size(), 1000u);
+    for (size_t i = 0; i < merged.size(); i++) {
+        EXPECT_EQ(merged[i], i);
+    }
+}
+
+// ============================================================================
+// Map/Reduce Tests
+// ============================================================================
+
+TEST(ThreadPoolMapReduce, PerWorkerAccumulators) {
+    const auto counter = ThreadPool::mapReduce(1000, [](const size_t idx, CounterReducer<int>& count) {
+        count.add(idx % 3);
+    }, CounterReducer<int>(), 4, 1);
+
+    EXPECT_EQ(counter.getTotal(), 1000);
+    EXPECT_EQ(counter.getCount(0), 334);
+    EXPECT_EQ(counter.getCount(1), 333);
+    EXPECT_EQ(counter.getCount(2), 333);
+
+    // The concatenation restores the task order
+    auto values = ThreadPool::mapReduce(500, [](const size_t idx,
+                                                ConcatenationReducer<size_t>& concatenation) {
+        concatenation.add(idx, idx * 2);
+        concatenation.add(idx, idx * 2 + 1);
+    }, ConcatenationReducer<size_t>(), 4, 1).takeValues();
+
+    ASSERT_EQ(values.size(), 1000u);
+    for (size_t i = 0; i < values.size(); i++) {
+        EXPECT_EQ(values[i], i);
+    }
+}